@@ -0,0 +1,184 @@
+/*
+ * @brief   指令协议命令行工具
+ * @note    编译: gcc -O2 -I../libs/include -o cmd_tool cmd_tool.c host_cmd.c host_serial.c ../libs/source/lib_frame.c
+ *          用法: cmd_tool <设备> [-b 波特率] [-n 协商的波特率] [-r] rtc [Unix 时间戳]
+ *                cmd_tool <设备> [-b 波特率] [-n 协商的波特率] [-r] ping <次数> [同时未应答的帧数] [负载字节数]
+ *                -b 为单片机当前的波特率, 默认 115200; -n 先协商到更高的波特率再执行指令, 失败时以原波特率执行
+ *                cmd_tool <设备> [-b 波特率] [-r] stat
+ *                -r 开启 RTS/CTS 硬件流控 (单片机需要 LIB_USART_FLOW_EN)
+*/
+#include "host_cmd.h"
+#include "host_serial.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ping 的统计
+typedef struct
+{
+    uint32_t num_ok;
+    uint32_t num_error;
+    uint64_t rtt_sum_us;
+    uint64_t rtt_max_us;
+} Cmd_Tool_Stat_Type;
+
+static void Cmd_Tool_Ping_Callback(const Host_Cmd_Event_Type *const event, void *const arg)
+{
+    Cmd_Tool_Stat_Type *stat = (Cmd_Tool_Stat_Type *)arg;
+
+    if (event->result != HOST_CMD_RES_OK)
+    {
+        ++stat->num_error;
+        return;
+    }
+    ++stat->num_ok;
+    stat->rtt_sum_us += event->rtt_us;
+    if (event->rtt_us > stat->rtt_max_us)
+    {
+        stat->rtt_max_us = event->rtt_us;
+    }
+}
+
+// 流水线 ping: 保持 window 帧未应答, 统计吞吐量和往返延迟
+static int Cmd_Tool_Ping(Host_Cmd_Type *const host, const uint32_t count, const uint32_t window, const uint8_t size)
+{
+    Cmd_Tool_Stat_Type stat = {0};
+    uint8_t payload[LIB_FRAME_PAYLOAD_MAXSIZE];
+    uint32_t sent = 0;
+    uint64_t start = 0, elapsed = 0, last_event = 0;
+    int res = 0;
+
+    for (uint8_t i = 0; i < size; ++i)
+    {
+        payload[i] = i;
+    }
+    start = Host_Serial_Time_us();
+    last_event = start;
+    while (stat.num_ok + stat.num_error < count)
+    {
+        while (sent < count && host->num_outstanding < window)
+        {
+            if (Host_Cmd_Send(host, HOST_CMD_PING, payload, size) < 0)
+            {
+                break;
+            }
+            ++sent;
+        }
+        res = Host_Cmd_Poll(host, 100, Cmd_Tool_Ping_Callback, &stat);
+        if (res < 0)
+        {
+            return -1;
+        }
+        if (res > 0)
+        {
+            last_event = Host_Serial_Time_us();
+        }
+        else if (Host_Serial_Time_us() - last_event > 1000000)
+        {
+            fprintf(stderr, "timeout: %u frames unacknowledged\n", host->num_outstanding);
+            break;
+        }
+    }
+    elapsed = Host_Serial_Time_us() - start;
+    printf("%u ok, %u error in %.3f s\n", stat.num_ok, stat.num_error, elapsed / 1e6);
+    if (stat.num_ok > 0)
+    {
+        printf("throughput: %.1f frames/s, %.1f payload B/s (each direction)\n",
+               stat.num_ok * 1e6 / elapsed, (double)stat.num_ok * size * 1e6 / elapsed);
+        printf("rtt: avg %.1f us, max %llu us\n",
+               (double)stat.rtt_sum_us / stat.num_ok, (unsigned long long)stat.rtt_max_us);
+    }
+    return stat.num_ok == count ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    Host_Cmd_Type *host = malloc(sizeof(Host_Cmd_Type));
+    uint32_t baud = 115200, new_baud = 0;
+    uint8_t res = 0;
+    int argi = 2, flow = 0;
+
+    if (argc < 3 || host == NULL)
+    {
+        fprintf(stderr, "usage: %s <device> [-b baud] [-n baud] [-r] rtc [unix] | ping <count> [window] [size] | stat\n", argv[0]);
+        return 1;
+    }
+    while (argi + 1 < argc && argv[argi][0] == '-')
+    {
+        if (strcmp(argv[argi], "-r") == 0)
+        {
+            flow = 1;
+            ++argi;
+            continue;
+        }
+        if (strcmp(argv[argi], "-b") == 0)
+        {
+            baud = (uint32_t)strtoul(argv[argi + 1], NULL, 0);
+        }
+        else if (strcmp(argv[argi], "-n") == 0)
+        {
+            new_baud = (uint32_t)strtoul(argv[argi + 1], NULL, 0);
+        }
+        argi += 2;
+    }
+    if (argi >= argc)
+    {
+        fprintf(stderr, "missing command\n");
+        return 1;
+    }
+    if (Host_Cmd_Open(host, argv[1], baud) != 0 || (flow && Host_Serial_Set_Flow(host->fd, 1) != 0))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    res = Host_Cmd_Call(host, HOST_CMD_START, NULL, 0, NULL, 1000);
+    if (res != HOST_CMD_RES_OK)
+    {
+        fprintf(stderr, "START failed: %u\n", res);
+        return 1;
+    }
+    if (new_baud != 0)
+    {
+        res = Host_Cmd_Set_Baud(host, new_baud);
+        fprintf(stderr, "baud %u: %s\n", res == HOST_CMD_RES_OK ? new_baud : baud,
+                res == HOST_CMD_RES_OK ? "ok" : "negotiation failed, keep the old rate");
+    }
+
+    if (strcmp(argv[argi], "rtc") == 0)
+    {
+        int32_t ts = argi + 1 < argc ? (int32_t)strtol(argv[argi + 1], NULL, 0) : (int32_t)time(NULL);
+        res = Host_Cmd_Set_RTC(host, ts);
+        printf("RTC_UNIX %d: %u\n", ts, res);
+        return res == HOST_CMD_RES_OK ? 0 : 1;
+    }
+    if (strcmp(argv[argi], "ping") == 0 && argi + 1 < argc)
+    {
+        uint32_t count = (uint32_t)strtoul(argv[argi + 1], NULL, 0);
+        uint32_t window = argi + 2 < argc ? (uint32_t)strtoul(argv[argi + 2], NULL, 0) : 4;
+        uint32_t size = argi + 3 < argc ? (uint32_t)strtoul(argv[argi + 3], NULL, 0) : 16;
+        if (window == 0 || window > 255 || size > LIB_FRAME_PAYLOAD_MAXSIZE)
+        {
+            fprintf(stderr, "window must be 1..255, size 0..%d\n", LIB_FRAME_PAYLOAD_MAXSIZE);
+            return 1;
+        }
+        return Cmd_Tool_Ping(host, count, window, (uint8_t)size) == 0 ? 0 : 1;
+    }
+    if (strcmp(argv[argi], "stat") == 0)
+    {
+        Host_Cmd_Stat_Type stat;
+        res = Host_Cmd_Get_Stat(host, &stat);
+        if (res != HOST_CMD_RES_OK)
+        {
+            fprintf(stderr, "STAT failed: %u\n", res);
+            return 1;
+        }
+        printf("overrun %u, framing %u, noise %u\n", stat.overrun, stat.framing, stat.noise);
+        printf("tx dropped %u B, tx stall %u us, rx paused %u times, rx dropped %u frames\n",
+               stat.tx_dropped, stat.tx_stall_us, stat.rx_paused, stat.rx_dropped);
+        return 0;
+    }
+    fprintf(stderr, "unknown command: %s\n", argv[argi]);
+    Host_Cmd_Close(host);
+    return 1;
+}
@@ -0,0 +1,1167 @@
+/*
+ * @brief   mod_flash.c, mod_ftl.c, diskio.c 和 FatFs 在 W25Q64 模型 (flash_sim.c) 上的测试和性能测试
+ * @note    编译: gcc -O2 -Wall -I. -I../libs/include -I../libs/fatfs -DMOD_FLASH_PORT='"flash_port.h"' [-DMOD_FTL_EN=1]
+ *                    [-DDISK_CACHE_SLOTS=n]
+ *                    -o flash_bench flash_bench.c flash_sim.c ../libs/source/mod_flash.c ../libs/source/mod_ftl.c
+ *                    ../libs/source/lib_format.c ../libs/fatfs/diskio.c ../libs/fatfs/ff.c ../libs/fatfs/ffunicode.c
+ *                    ../libs/source/mod_record.c ../libs/source/mod_config.c ../libs/source/lib_frame.c
+ *          用法: flash_bench [-m], -m 使用数据手册的最大时间 (默认为典型值); 全部通过时返回 0
+ *          FatFs 默认不经过 FTL (逻辑扇区直接对应物理扇区, 多扇区写入由 Mod_Flash_Write_Sectors() 合并擦除, 检查擦除指令数
+ *          少于擦除的扇区数); 加 -DMOD_FTL_EN=1 测试经过 FTL 的卷,
+ *          FTL 本身的测试两种情况都运行; 加 -DMOD_FTL_FLASH_MAXSIZE=16777216 时 W25Q128 全部经过 FTL
+ *          1) 测试: 指令和模型的行为, 范围擦除的合并, 不同容量和有无 SFDP 时的检测, 读取时暂停擦除, 多扇区写入, 固定的位 (读出校验),
+ *             FTL 在任意一次编程或擦除时掉电后的恢复, 记录存储的追加, 读取, 覆盖, 按时间查找和掉电恢复,
+ *             配置存储的读写, 删除, 整理 (包括写坏目标扇区), 磨损均衡和原子提交, FatFs 文件读写; 每项都检查模型记录的违规次数为 0
+ *          2) 性能: 按模拟的时钟计算, 包括 SPI 传输, 片选, 状态轮询和 FLASH 忙碌的时间; FTL 的突发写入比较有无空闲时
+ *             预先擦除的差别; 小文件和日志的 FatFs 负载输出写回缓存的命中率
+*/
+#include "flash_sim.h"
+#include "mod_flash.h"
+#include "mod_ftl.h"
+#include "mod_record.h"
+#include "mod_config.h"
+#include "diskio.h"
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_FTL_LBAS          64          // 掉电测试使用的逻辑扇区数
+#define BENCH_FTL_ROUNDS        400         // 掉电测试的次数
+#define BENCH_FILE_SIZE         (512 * 1024)
+#define BENCH_RECORD_SAME       500         // 记录存储测试中时间戳相同的记录数, 跨越多个扇区
+#define BENCH_SMALL_FILES       64          // 小文件测试的文件数
+#define BENCH_SMALL_SIZE        200
+#define BENCH_LOG_RECORDS       200         // 日志测试的记录数, 每条后 f_sync()
+#define BENCH_RECORD_LEN        24          // 性能测试的记录数据长度
+#define BENCH_RECORD_ROUNDS     300         // 记录存储掉电测试的次数
+#define BENCH_CONFIG_ROUNDS     300         // 配置存储掉电测试的次数
+
+static const Sim_Flash_Timing_Type *Bench_Timing = &Sim_Flash_Timing_Typical;
+static uint32_t Bench_Failed;
+static uint32_t Bench_Violations;           // 测试开始时模型的违规次数
+static jmp_buf Bench_Power_Loss;
+static uint8_t Bench_Buffer[2][64 * 1024];
+
+#define Bench_Check(cond, ...)  do { if (!(cond)) { printf("  FAIL %s:%d: ", __func__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++Bench_Failed; } } while (0)
+
+// FatFs 的时间戳, 模拟中固定
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2025 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
+
+static uint32_t Bench_Random(void)
+{
+    static uint32_t seed = 12345;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void Bench_Fill(uint8_t *const buffer, const uint32_t num, uint32_t seed)
+{
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        buffer[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+static uint32_t Bench_Get_Violations(void)
+{
+    Sim_Flash_Stat_Type stat;
+
+    Sim_Flash_Get_Stat(&stat);
+    return stat.violations;
+}
+
+static void Bench_Begin(const char *const name)
+{
+    printf("%s\n", name);
+    Bench_Violations = Bench_Get_Violations();
+}
+
+static void Bench_End(void)
+{
+    Bench_Check(Bench_Get_Violations() == Bench_Violations, "%u protocol violations", Bench_Get_Violations() - Bench_Violations);
+}
+
+// 输出一项性能: 模拟的时间和速度
+static void Bench_Report(const char *const name, const uint64_t ns, const uint32_t bytes)
+{
+    printf("  %-32s %10.3f ms %10.1f kB/s\n", name, ns / 1e6, ns > 0 ? bytes / 1.024 / (ns / 1e6) : 0.0);
+}
+
+// 不经过 mod_flash.c 的单条指令, 用于检查模型本身
+static void Bench_Raw(const uint8_t *const tx, uint8_t *const rx, const uint32_t num)
+{
+    Sim_Flash_Select();
+    Sim_Flash_Transfer(tx, rx, num);
+    Sim_Flash_Deselect();
+}
+
+static void Bench_Raw_Wait(void)
+{
+    uint8_t cmd[2] = {0x05, 0x00}, status[2] = {0};
+
+    do
+    {
+        Bench_Raw(cmd, status, sizeof(cmd));
+    } while (status[1] & MOD_FLASH_BUSY_Msk);
+}
+
+// 指令和模型的基本行为
+static void Test_Protocol(void)
+{
+    uint8_t cmd[4 + 32], rx[8];
+
+    Bench_Begin("protocol");
+    Sim_Flash_Init(Bench_Timing);
+    Bench_Check(Mod_Flash_Read_JEDCE_ID() == MOD_FLASH_JEDEC_ID, "JEDEC ID %06X", Mod_Flash_Read_JEDCE_ID());
+
+    // 编程是与运算
+    Bench_Buffer[0][0] = 0xF0;
+    Mod_Flash_Write(Bench_Buffer[0], 0x1000, 1);
+    Bench_Buffer[0][0] = 0x3C;
+    Mod_Flash_Write(Bench_Buffer[0], 0x1000, 1);
+    Mod_Flash_Read(rx, 0x1000, 2);
+    Bench_Check(rx[0] == 0x30 && rx[1] == 0xFF, "AND programming gave %02X %02X", rx[0], rx[1]);
+
+    // 超过页尾时回到页首
+    cmd[0] = MOD_FLASH_W25Q64_WRITE_ENABLE;
+    Bench_Raw(cmd, NULL, 1);
+    cmd[0] = MOD_FLASH_W25Q64_PAGE_PROGRAM;
+    cmd[1] = 0x00;
+    cmd[2] = 0x20;
+    cmd[3] = 0xF0;
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        cmd[4 + i] = i;
+    }
+    Bench_Raw(cmd, NULL, sizeof(cmd));
+    Bench_Raw_Wait();
+    Mod_Flash_Read(Bench_Buffer[0], 0x2000, 256);
+    Bench_Check(Bench_Buffer[0][0xF0] == 0 && Bench_Buffer[0][0xFF] == 15 && Bench_Buffer[0][0x00] == 16 && Bench_Buffer[0][0x0F] == 31
+                && Bench_Buffer[0][0x10] == 0xFF, "page wrap");
+
+    Mod_Flash_Erase_Sector(0x2000);
+    Mod_Flash_Read(Bench_Buffer[0], 0x2000, 256);
+    Bench_Check(Bench_Buffer[0][0x00] == 0xFF && Bench_Buffer[0][0xF0] == 0xFF, "sector erase");
+
+    // 掉电模式: 只响应 RELEASE_POWER_DOWN, 之后返回器件 ID
+    cmd[0] = MOD_FLASH_W25Q64_POWER_DOWN;
+    Bench_Raw(cmd, NULL, 1);
+    memset(cmd, 0, 5);
+    cmd[0] = MOD_FLASH_W25Q64_RELEASE_POWER_DOWN_HPM_DEVICE_ID;
+    Bench_Raw(cmd, rx, 5);
+    Bench_Check(rx[4] == 0x16, "release power-down ID %02X", rx[4]);
+    Bench_Raw_Wait();
+    Bench_Check(Mod_Flash_Read_JEDCE_ID() == MOD_FLASH_JEDEC_ID, "JEDEC ID after power-down");
+    Bench_End();
+}
+
+// 范围擦除合并为块擦除
+static void Test_Erase_Range(void)
+{
+    Sim_Flash_Stat_Type stat;
+    const uint8_t *const array = Sim_Flash_Array();
+    uint8_t ok = 1;
+
+    Bench_Begin("erase range");
+    Sim_Flash_Init(Bench_Timing);
+    memset(Bench_Buffer[0], 0, MOD_FLASH_PAGE_SIZE);
+    for (uint32_t addr = 0xE000; addr < 0x32000; addr += MOD_FLASH_SECTOR_SIZE)
+    {
+        Mod_Flash_Write(Bench_Buffer[0], addr, MOD_FLASH_PAGE_SIZE);
+    }
+    Mod_Flash_Erase_Range(0xF000, 0x22000);
+    Sim_Flash_Get_Stat(&stat);
+    // 0xF000 (4 KB) + 0x10000, 0x20000 (64 KB) + 0x30000 (4 KB)
+    Bench_Check(stat.erases[0] == 2 && stat.erases[1] == 0 && stat.erases[2] == 2, "erases 4K %u 32K %u 64K %u",
+                stat.erases[0], stat.erases[1], stat.erases[2]);
+    for (uint32_t addr = 0xF000; addr < 0x31000; addr += MOD_FLASH_SECTOR_SIZE)
+    {
+        ok &= array[addr] == 0xFF;
+    }
+    Bench_Check(ok && array[0xE000] == 0x00 && array[0x31000] == 0x00, "erased range");
+    Bench_End();
+}
+
+// SFDP 中的时间向上取整到单位, 检查在 [value, value + unit) 内
+#define Bench_Check_Time(value, ns, scale, unit)                                                            \
+    Bench_Check((value) >= (ns) / (scale) && (value) < (ns) / (scale) + (unit), #value " %u for %u",         \
+                (uint32_t)(value), (uint32_t)((ns) / (scale)))
+
+/*
+ * @brief   检测 W25Q32/W25Q64/W25Q128, 有和没有 SFDP: 容量, 擦除类型和时间, 分区地址, FatFs 的扇区数, 范围擦除的合并
+ * @note    最后恢复为 W25Q64, 之后的测试使用默认的几何参数
+*/
+static void Test_Detect(void)
+{
+    static const uint32_t chips[3] = {SIM_FLASH_JEDEC_W25Q32, SIM_FLASH_JEDEC_W25Q64, SIM_FLASH_JEDEC_W25Q128};
+    const Mod_Flash_Geometry_Type *const g = &Mod_Flash_Geometry;
+    Sim_Flash_Stat_Type before, stat;
+    LBA_t count = 0;
+
+    Bench_Begin("detect");
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        const uint32_t id = chips[i / 2];
+        const uint8_t sfdp = i % 2 == 0;
+        const uint32_t capacity = 1u << (id & 0xFF);
+        const uint32_t sectors = (capacity - MOD_FLASH_RECORD_SIZE - MOD_FLASH_CONFIG_SIZE) / MOD_FLASH_SECTOR_SIZE;
+
+        Sim_Flash_Init(Bench_Timing);
+        Sim_Flash_Set_Chip(id, sfdp);
+        Bench_Check(!(disk_initialize(0) & STA_NOINIT), "%06X sfdp %u: disk_initialize", id, sfdp);
+        Bench_Check(g->jedec_id == id && g->sfdp == sfdp && g->capacity == capacity && g->page_size == MOD_FLASH_PAGE_SIZE,
+                    "%06X sfdp %u: id %06X sfdp %u capacity %u page %u", id, sfdp, g->jedec_id, g->sfdp, g->capacity, g->page_size);
+        Bench_Check(g->erase[0].size == MOD_FLASH_SECTOR_SIZE && g->erase[0].cmd == MOD_FLASH_W25Q64_SECTOR_ERASE_4KB
+                    && g->erase[1].size == MOD_FLASH_BLOCK_32K_SIZE && g->erase[1].cmd == MOD_FLASH_W25Q64_BLOCK_ERASE_32KB
+                    && g->erase[2].size == MOD_FLASH_BLOCK_64K_SIZE && g->erase[2].cmd == MOD_FLASH_W25Q64_BLOCK_ERASE_64KB
+                    && g->erase[3].size == 0, "%06X sfdp %u: erase types", id, sfdp);
+        if (sfdp)
+        {
+            // SFDP 的时间来自模型的时间参数, 向上取整到单位
+            Bench_Check_Time(g->erase[0].time_ms, Bench_Timing->t_se, 1000000, 16);
+            Bench_Check_Time(g->erase[1].time_ms, Bench_Timing->t_be1, 1000000, 128);
+            Bench_Check_Time(g->erase[2].time_ms, Bench_Timing->t_be2, 1000000, 128);
+            // 页编程最多 32 * 64 us, 最大值的 3 ms 无法表示
+            Bench_Check_Time(g->program_us, Bench_Timing->t_pp < 2048000 ? Bench_Timing->t_pp : 2048000, 1000, 64);
+            Bench_Check_Time(g->chip_erase_ms, Bench_Timing->t_ce, 1000000, 4000);
+        }
+        // 记录和配置存储在芯片末尾, FatFs 占用其余部分
+        Bench_Check(MOD_FLASH_FATFS_SIZE == capacity - MOD_FLASH_RECORD_SIZE - MOD_FLASH_CONFIG_SIZE
+                    && MOD_RECORD_START == MOD_FLASH_FATFS_SIZE && MOD_CONFIG_START + MOD_FLASH_CONFIG_SIZE == capacity,
+                    "%06X sfdp %u: partitions", id, sfdp);
+        disk_ioctl(0, GET_SECTOR_COUNT, &count);
+#if MOD_FTL_EN
+        Bench_Check(count == (sectors < MOD_FTL_SECTORS_MAXNUM ? sectors : MOD_FTL_SECTORS_MAXNUM) - MOD_FTL_POOL_START - MOD_FTL_SPARE,
+                    "%06X sfdp %u: sector count %u", id, sfdp, (uint32_t)count);
+#else
+        Bench_Check(count == sectors, "%06X sfdp %u: sector count %u", id, sfdp, (uint32_t)count);
+#endif
+
+        // 记录存储的分区 (960 KB) 对齐 64 KB, 全部用 64 KB 块擦除
+        Sim_Flash_Get_Stat(&before);
+        Mod_Flash_Erase_Range(MOD_RECORD_START, MOD_FLASH_RECORD_SIZE);
+        Sim_Flash_Get_Stat(&stat);
+        Bench_Check(stat.erases[2] - before.erases[2] == MOD_FLASH_RECORD_SIZE / MOD_FLASH_BLOCK_64K_SIZE
+                    && stat.erases[0] == before.erases[0] && stat.erases[1] == before.erases[1],
+                    "%06X sfdp %u: erases 4K %u 32K %u 64K %u", id, sfdp, stat.erases[0] - before.erases[0],
+                    stat.erases[1] - before.erases[1], stat.erases[2] - before.erases[2]);
+        // 范围检查按检测到的容量
+        Bench_Check(Mod_Flash_Erase_Range(capacity - MOD_FLASH_SECTOR_SIZE, MOD_FLASH_SECTOR_SIZE) == SUCCESS
+                    && Mod_Flash_Erase_Range(capacity, MOD_FLASH_SECTOR_SIZE) == ERROR, "%06X sfdp %u: erase bounds", id, sfdp);
+    }
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Flash_Detect();
+    Bench_Check(g->capacity == 8388608 && MOD_FLASH_FATFS_SIZE == 7 * 1024 * 1024, "restore W25Q64");
+    Bench_End();
+}
+
+// 后台擦除时读取其他扇区, 暂停擦除
+static void Test_Suspend(void)
+{
+    Sim_Flash_Stat_Type before, stat;
+
+    Bench_Begin("erase suspend");
+    Sim_Flash_Init(Bench_Timing);
+    Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, 1);
+    Mod_Flash_Write(Bench_Buffer[0], 0x40000, MOD_FLASH_SECTOR_SIZE);
+    Mod_Flash_Write(Bench_Buffer[0], 0x50000, MOD_FLASH_SECTOR_SIZE);
+    Mod_Flash_Sync();
+
+    Mod_Flash_Erase_Start(0x50000);
+    // FatFs 每次访问都调用 disk_status(), 不能等待擦除, 也不访问总线
+    Sim_Flash_Get_Stat(&before);
+    Bench_Check(!(disk_status(0) & STA_NOINIT) && Mod_Flash_Read_JEDCE_ID() == MOD_FLASH_JEDEC_ID, "status during erase");
+    Sim_Flash_Get_Stat(&stat);
+    Bench_Check(Mod_Flash_Is_Busy() && stat.cs_cycles == before.cs_cycles, "status waited for the erase");
+    Mod_Flash_Read(Bench_Buffer[1], 0x40000, MOD_FLASH_SECTOR_SIZE);
+    Bench_Check(memcmp(Bench_Buffer[0], Bench_Buffer[1], MOD_FLASH_SECTOR_SIZE) == 0, "read during erase");
+    Sim_Flash_Get_Stat(&stat);
+    Bench_Check(stat.suspends == 1, "%u suspends", stat.suspends);
+    Mod_Flash_Read(Bench_Buffer[1], 0x40000, MOD_FLASH_SECTOR_SIZE);
+
+    // 读取正在擦除的扇区时等待擦除完成
+    Mod_Flash_Read(Bench_Buffer[1], 0x50000, 16);
+    Bench_Check(Bench_Buffer[1][0] == 0xFF && Bench_Buffer[1][15] == 0xFF, "read of erasing sector");
+    Bench_Check(!Mod_Flash_Is_Busy(), "erase still pending");
+    Bench_End();
+}
+
+// 随机的多扇区写入, 与模型的存储阵列比较
+static void Test_Write_Sectors(void)
+{
+    static uint8_t expect[1024 * 1024];
+    const uint8_t *const array = Sim_Flash_Array();
+    Mod_Flash_Stat_Type stat;
+    uint32_t sector = 0, count = 0, bad = 0;
+
+    Bench_Begin("write sectors");
+    Sim_Flash_Init(Bench_Timing);
+    memset(expect, 0xFF, sizeof(expect));
+    for (uint32_t round = 0; round < 300; ++round)
+    {
+        sector = Bench_Random() % (sizeof(expect) / MOD_FLASH_SECTOR_SIZE);
+        count = 1 + Bench_Random() % 16;
+        count = count < sizeof(expect) / MOD_FLASH_SECTOR_SIZE - sector ? count : sizeof(expect) / MOD_FLASH_SECTOR_SIZE - sector;
+        memcpy(Bench_Buffer[0], expect + sector * MOD_FLASH_SECTOR_SIZE, count * MOD_FLASH_SECTOR_SIZE);
+        // 一半完全重写, 一半只改几个字节 (部分只把 1 变为 0)
+        if (round % 2)
+        {
+            Bench_Fill(Bench_Buffer[0], count * MOD_FLASH_SECTOR_SIZE, round);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                Bench_Buffer[0][Bench_Random() % (count * MOD_FLASH_SECTOR_SIZE)] &= (uint8_t)Bench_Random();
+            }
+        }
+        Bench_Check(Mod_Flash_Write_Sectors(Bench_Buffer[0], sector * MOD_FLASH_SECTOR_SIZE, count) == SUCCESS, "write %u+%u", sector, count);
+        memcpy(expect + sector * MOD_FLASH_SECTOR_SIZE, Bench_Buffer[0], count * MOD_FLASH_SECTOR_SIZE);
+    }
+    Mod_Flash_Sync();
+    for (uint32_t i = 0; i < sizeof(expect); ++i)
+    {
+        bad += array[i] != expect[i];
+    }
+    Bench_Check(bad == 0, "%u bytes differ", bad);
+    Mod_Flash_Get_Stat(&stat);
+    printf("  erases %u (commands %u), avoided %u, pages programmed %u skipped %u\n",
+           stat.erases, stat.erase_cmds, stat.erases_avoided, stat.pages_programmed, stat.pages_skipped);
+    Bench_End();
+}
+
+// 固定的位: 读出校验发现写入失败
+static void Test_Stuck_Bit(void)
+{
+    Mod_Flash_Stat_Type before, after;
+
+    Bench_Begin("stuck bits");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Flash_Get_Stat(&before);
+    memset(Bench_Buffer[0], 0x00, MOD_FLASH_SECTOR_SIZE);
+    Sim_Flash_Set_Stuck_Bit(0x60123, 3, 1);
+    Bench_Check(Mod_Flash_Write_Sectors(Bench_Buffer[0], 0x60000, 1) == ERROR, "stuck-at-1 not detected");
+    memset(Bench_Buffer[0], 0xFF, MOD_FLASH_SECTOR_SIZE);
+    Sim_Flash_Set_Stuck_Bit(0x61456, 0, 0);
+    Bench_Check(Mod_Flash_Write_Sectors(Bench_Buffer[0], 0x61000, 1) == ERROR, "stuck-at-0 not detected");
+    Mod_Flash_Get_Stat(&after);
+#if MOD_FLASH_VERIFY_EN
+    Bench_Check(after.verify_errors - before.verify_errors == 2, "%u verify errors", after.verify_errors - before.verify_errors);
+#endif
+    Sim_Flash_Clear_Faults();
+    Bench_End();
+}
+
+static void Bench_Power_Loss_Handler(void)
+{
+    longjmp(Bench_Power_Loss, 1);
+}
+
+// 检查逻辑扇区的内容为第 version 个版本, 版本 0 为没有写入 (全为 0xFF)
+static uint8_t Bench_FTL_Is_Version(const uint32_t lba, const uint32_t version)
+{
+    Mod_FTL_Read(Bench_Buffer[1], lba, 1);
+    if (version == 0)
+    {
+        memset(Bench_Buffer[0], 0xFF, MOD_FLASH_SECTOR_SIZE);
+    }
+    else
+    {
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, lba * 65536 + version);
+    }
+    return memcmp(Bench_Buffer[0], Bench_Buffer[1], MOD_FLASH_SECTOR_SIZE) == 0;
+}
+
+/*
+ * @brief   FTL 写入时在随机的一次编程或擦除中掉电, 重新上电后每个逻辑扇区是旧内容或新内容
+ * @note    掉电处理函数 longjmp 回来, mod_flash.c 和 mod_ftl.c 的状态由 Mod_FTL_Init() 重建
+*/
+static void Test_FTL_Power_Loss(void)
+{
+    static uint32_t version[BENCH_FTL_LBAS];
+    volatile uint32_t losses = 0;
+    volatile uint32_t lba = 0;
+    volatile uint32_t bad = 0;
+
+    Bench_Begin("ftl power loss");
+    Sim_Flash_Init(Bench_Timing);
+    memset(version, 0, sizeof(version));
+    Mod_FTL_Init();
+    for (uint32_t round = 0; round < BENCH_FTL_ROUNDS; ++round)
+    {
+        lba = Bench_Random() % BENCH_FTL_LBAS;
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, lba * 65536 + version[lba] + 1);
+        if (round % 4 == 0)
+        {
+            Sim_Flash_Set_Power_Loss(1 + Bench_Random() % 24, Bench_Power_Loss_Handler);
+        }
+        if (setjmp(Bench_Power_Loss) == 0)
+        {
+            Bench_Check(Mod_FTL_Write(Bench_Buffer[0], lba) == SUCCESS, "write lba %u", lba);
+            ++version[lba];
+            continue;
+        }
+        // 掉电后重新上电
+        ++losses;
+        Sim_Flash_Set_Power_Loss(0, NULL);
+        Mod_FTL_Init();
+        if (Bench_FTL_Is_Version(lba, version[lba] + 1))
+        {
+            ++version[lba];
+        }
+        for (uint32_t i = 0; i < BENCH_FTL_LBAS; ++i)
+        {
+            if (!Bench_FTL_Is_Version(i, version[i]))
+            {
+                Bench_Check(0, "lba %u lost after power loss %u", i, losses);
+                ++bad;
+                version[i] = 0;     // 避免同一个错误重复报告
+            }
+        }
+        if (bad > 0)
+        {
+            break;
+        }
+    }
+    Sim_Flash_Set_Power_Loss(0, NULL);
+    printf("  %u power losses recovered\n", losses);
+    Bench_End();
+}
+
+// 记录 i 的数据长度和内容由 i 决定, 时间戳为 i
+static uint16_t Bench_Record_Len(const uint32_t i)
+{
+    return (uint16_t)(i * 7 % (MOD_RECORD_DATA_MAXSIZE + 1));
+}
+
+// 检查读出的记录是第 time 条
+static uint8_t Bench_Record_Is(const Mod_Record_Type *const record, const uint32_t time)
+{
+    Bench_Fill(Bench_Buffer[0], Bench_Record_Len(time), time);
+    return record->len == Bench_Record_Len(time) && memcmp(record->data, Bench_Buffer[0], record->len) == 0;
+}
+
+// 从迭代器开始读取, 检查时间戳为 first, first + 1, ... 且内容正确, 返回读出的条数
+static uint32_t Bench_Record_Verify(Mod_Record_Iter_Type *const iter, const uint32_t first)
+{
+    static Mod_Record_Type record;
+    uint32_t num = 0;
+
+    while (Mod_Record_Next(iter, &record) == SUCCESS)
+    {
+        if (record.time != first + num || !Bench_Record_Is(&record, record.time))
+        {
+            Bench_Check(0, "record %u: time %u len %u", first + num, record.time, record.len);
+            break;
+        }
+        ++num;
+    }
+    return num;
+}
+
+static void Bench_Record_Append(const uint32_t time)
+{
+    Bench_Fill(Bench_Buffer[0], Bench_Record_Len(time), time);
+    Bench_Check(Mod_Record_Append(time, Bench_Buffer[0], Bench_Record_Len(time)) == SUCCESS, "append %u", time);
+}
+
+/*
+ * @brief   记录存储: 追加后读取 (包括缓存中的记录), 上电恢复后继续追加, 写满后覆盖最旧的扇区, 按时间查找
+*/
+static void Test_Record(void)
+{
+    Mod_Record_Iter_Type iter;
+    Mod_Record_Stat_Type stat;
+    uint32_t num = 0, first = 0;
+    const uint32_t total = 40000;           // 约 5 MB, 覆盖分区约 4 遍
+
+    Bench_Begin("record store");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Record_Clear();
+    Mod_Record_Begin(&iter);
+    Bench_Check(Bench_Record_Verify(&iter, 1) == 0, "records in empty store");
+    Bench_Check(Mod_Record_Last_Time(&num) == ERROR, "last time in empty store");
+
+    // 没有编程的记录也能读到, 同一个迭代器继续读取之后追加的记录
+    for (uint32_t i = 1; i <= 1000; ++i)
+    {
+        Bench_Record_Append(i);
+    }
+    num = Bench_Record_Verify(&iter, 1);
+    Bench_Check(num == 1000, "%u of 1000 records", num);
+    Bench_Check(Mod_Record_Append(1001, Bench_Buffer[0], MOD_RECORD_DATA_MAXSIZE + 1) == ERROR, "oversized record accepted");
+    Bench_Record_Append(1001);
+    Bench_Check(Bench_Record_Verify(&iter, 1001) == 1, "record appended after iteration");
+
+    // 上电恢复, 追加到同一个扇区
+    Mod_Record_Flush();
+    Sim_Flash_Power_Cycle();
+    Mod_Record_Init();
+    Bench_Check(Mod_Record_Last_Time(&num) == SUCCESS && num == 1001, "last time %u after init", num);
+    for (uint32_t i = 1002; i <= 2000; ++i)
+    {
+        Bench_Record_Append(i);
+    }
+    Mod_Record_Begin(&iter);
+    num = Bench_Record_Verify(&iter, 1);
+    Bench_Check(num == 2000, "%u of 2000 records after init", num);
+
+    // 写满后覆盖, 最旧的记录在扇区边界上
+    for (uint32_t i = 2001; i <= total; ++i)
+    {
+        Bench_Record_Append(i);
+        if (i % 5000 == 0)
+        {
+            Mod_Record_Flush();
+            Sim_Flash_Power_Cycle();
+            Mod_Record_Init();
+        }
+    }
+    Bench_Check(Mod_Record_Last_Time(&num) == SUCCESS && num == total, "last time %u after wrap", num);
+    Mod_Record_Begin(&iter);
+    Mod_Record_Next(&iter, (Mod_Record_Type *)Bench_Buffer[1]);
+    first = ((Mod_Record_Type *)Bench_Buffer[1])->time;
+    Mod_Record_Begin(&iter);
+    num = Bench_Record_Verify(&iter, first);
+    Bench_Check(first > 1 && first + num - 1 == total, "records %u..%u after wrap", first, first + num - 1);
+    // 一个扇区在预擦除, 每个扇区末尾平均浪费半条记录
+    Bench_Check(num * (MOD_RECORD_HEADER_SIZE + MOD_RECORD_DATA_MAXSIZE / 2) > MOD_FLASH_RECORD_SIZE / 16 * 15,
+                "only %u records kept", num);
+
+    // 按时间查找
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        const uint32_t time = first + Bench_Random() % num;
+
+        Mod_Record_Seek(&iter, time);
+        Bench_Check(Bench_Record_Verify(&iter, time) == total - time + 1, "seek %u", time);
+    }
+    Mod_Record_Seek(&iter, 0);
+    Bench_Check(Bench_Record_Verify(&iter, first) == num, "seek before first");
+    Mod_Record_Seek(&iter, total + 1);
+    Bench_Check(Bench_Record_Verify(&iter, total + 1) == 0, "seek after last");
+
+    Mod_Record_Get_Stat(&stat);
+    printf("  %u records kept, %u pages, %u erases, %u stalls, %u dropped, %u corrupt\n",
+           num, stat.pages, stat.erases, stat.stalls, stat.dropped, stat.corrupt);
+    Bench_Check(stat.corrupt == 0, "%u corrupt records", stat.corrupt);
+
+    // 相同的时间戳跨越多个扇区 (RTC 的秒数), 查找从第一条开始
+    Mod_Record_Clear();
+    for (uint32_t i = 0; i < 2 * BENCH_RECORD_SAME; ++i)
+    {
+        Bench_Record_Append(i < BENCH_RECORD_SAME ? 1 : 5);
+    }
+    for (uint32_t time = 0; time <= 6; ++time)
+    {
+        const uint32_t expect = time <= 1 ? 2 * BENCH_RECORD_SAME : time <= 5 ? BENCH_RECORD_SAME : 0;
+
+        Mod_Record_Seek(&iter, time);
+        for (num = 0; Mod_Record_Next(&iter, (Mod_Record_Type *)Bench_Buffer[1]) == SUCCESS; ++num);
+        Bench_Check(num == expect, "seek %u with repeated timestamps: %u of %u records", time, num, expect);
+    }
+    Bench_End();
+}
+
+/*
+ * @brief   记录存储追加时在随机的一次编程或擦除中掉电, 重新上电后 Mod_Record_Flush() 之前的记录都在, 时间戳连续
+ * @note    重新上电后从最新的记录继续追加, 所以全部记录的时间戳始终连续; 写了一半的记录读取时跳过
+*/
+static void Test_Record_Power_Loss(void)
+{
+    Mod_Record_Iter_Type iter;
+    Mod_Record_Stat_Type stat;
+    volatile uint32_t losses = 0;
+    volatile uint32_t time = 0;             // 最后追加的时间戳
+    volatile uint32_t flushed = 0;          // 最后一次 Mod_Record_Flush() 时的时间戳
+    uint32_t first = 0, num = 0, last = 0;
+    const uint32_t failed = Bench_Failed;
+
+    Bench_Begin("record power loss");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Record_Clear();
+    for (uint32_t round = 0; round < BENCH_RECORD_ROUNDS; ++round)
+    {
+        Sim_Flash_Set_Power_Loss(1 + Bench_Random() % 64, Bench_Power_Loss_Handler);
+        if (setjmp(Bench_Power_Loss) == 0)
+        {
+            while (1)
+            {
+                Bench_Record_Append(time + 1);
+                ++time;
+                if (Bench_Random() % 16 == 0)
+                {
+                    Mod_Record_Flush();
+                    flushed = time;
+                }
+            }
+        }
+        // 掉电后重新上电
+        ++losses;
+        Sim_Flash_Set_Power_Loss(0, NULL);
+        Mod_Record_Init();
+        first = flushed > 1000 ? flushed - 1000 : 1;
+        Mod_Record_Seek(&iter, first);
+        num = Bench_Record_Verify(&iter, first);
+        Bench_Check(first + num > flushed && first + num <= time + 1, "records %u..%u, flushed %u, appended %u",
+                    first, first + num - 1, flushed, time);
+        Bench_Check(Mod_Record_Last_Time(&last) == SUCCESS && last == first + num - 1, "last time %u, records up to %u",
+                    last, first + num - 1);
+        if (Bench_Failed > failed)
+        {
+            break;
+        }
+        time = first + num - 1;
+        flushed = time;
+    }
+    Sim_Flash_Set_Power_Loss(0, NULL);
+    Mod_Record_Get_Stat(&stat);
+    printf("  %u power losses recovered, %u records, %u corrupt skipped\n", losses, time, stat.corrupt);
+    Bench_End();
+}
+
+// 配置存储的第 i 个键, 值的长度为 1..MOD_CONFIG_DATA_MAXSIZE, 内容由键和版本决定
+#define Bench_Config_Key(i)     ((uint16_t)(0x100 + (i)))
+#define Bench_Config_Len(i)     ((uint8_t)((i) * 5 % MOD_CONFIG_DATA_MAXSIZE + 1))
+
+static void Bench_Config_Set(const uint32_t i, const uint32_t version)
+{
+    Bench_Fill(Bench_Buffer[0], Bench_Config_Len(i), i * 65536 + version);
+    Bench_Check(Mod_Config_Set(Bench_Config_Key(i), Bench_Buffer[0], Bench_Config_Len(i)) == SUCCESS, "set key %u", i);
+}
+
+// 检查第 i 个键为第 version 个版本, 版本 0 为没有该键
+static uint8_t Bench_Config_Is(const uint32_t i, const uint32_t version)
+{
+    if (version == 0)
+    {
+        return Mod_Config_Get(Bench_Config_Key(i), Bench_Buffer[1], Bench_Config_Len(i)) == ERROR;
+    }
+    Bench_Fill(Bench_Buffer[0], Bench_Config_Len(i), i * 65536 + version);
+    return Mod_Config_Get(Bench_Config_Key(i), Bench_Buffer[1], Bench_Config_Len(i)) == SUCCESS
+           && memcmp(Bench_Buffer[0], Bench_Buffer[1], Bench_Config_Len(i)) == 0;
+}
+
+/*
+ * @brief   配置存储: 读写, 删除, 键数上限, 上电重建索引, 反复修改时的整理和磨损均衡
+*/
+static void Test_Config(void)
+{
+    static uint32_t version[MOD_CONFIG_KEYS_MAXNUM];
+    Mod_Config_Stat_Type stat;
+    uint32_t bad = 0, wear_min = UINT32_MAX, wear_max = 0;
+    uint64_t start = 0, init_ns = 0;
+
+    Bench_Begin("config store");
+    Sim_Flash_Init(Bench_Timing);
+    memset(version, 0, sizeof(version));
+    Mod_Config_Init();
+    Bench_Check(Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 2000, "default value");
+    Bench_Check(Mod_Config_Set_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 500) == SUCCESS, "set u32");
+    Bench_Check(Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 500, "get u32");
+    Bench_Check(Mod_Config_Get(MOD_CONFIG_KEY_SAMPLE_INTERVAL, Bench_Buffer[1], 2) == ERROR, "get with wrong size");
+    Bench_Check(Mod_Config_Delete(MOD_CONFIG_KEY_SAMPLE_INTERVAL) == SUCCESS
+                && Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 2000, "delete");
+
+    // 键数上限
+    for (uint32_t i = 0; i < MOD_CONFIG_KEYS_MAXNUM; ++i)
+    {
+        Bench_Config_Set(i, ++version[i]);
+    }
+    Bench_Check(Mod_Config_Set_U32(0x1000, 1) == ERROR, "key beyond MOD_CONFIG_KEYS_MAXNUM accepted");
+    Bench_Check(Mod_Config_Delete(Bench_Config_Key(0)) == SUCCESS && Mod_Config_Set_U32(0x1000, 1) == SUCCESS, "key after delete");
+    Bench_Check(Mod_Config_Delete(0x1000) == SUCCESS, "delete");
+    version[0] = 0;
+
+    // 反复修改, 随机删除, 每 500 次重新上电
+    for (uint32_t round = 0; round < 20000; ++round)
+    {
+        const uint32_t i = Bench_Random() % MOD_CONFIG_KEYS_MAXNUM;
+
+        if (Bench_Random() % 8 == 0)
+        {
+            Bench_Check(Mod_Config_Delete(Bench_Config_Key(i)) == SUCCESS, "delete key %u", i);
+            version[i] = 0;
+        }
+        else
+        {
+            Bench_Config_Set(i, ++version[i]);
+        }
+        if (round % 500 == 499)
+        {
+            Sim_Flash_Power_Cycle();
+            start = Sim_Clock_ns();
+            Mod_Config_Init();
+            init_ns = Sim_Clock_ns() - start;
+        }
+        for (uint32_t j = 0; j < MOD_CONFIG_KEYS_MAXNUM && round % 100 == 0; ++j)
+        {
+            if (!Bench_Config_Is(j, version[j]))
+            {
+                Bench_Check(bad++ < 5, "key %u version %u at round %u", j, version[j], round);
+            }
+        }
+    }
+    Mod_Config_Get_Stat(&stat);
+    for (uint32_t i = 0; i < MOD_CONFIG_SECTORS; ++i)
+    {
+        const uint32_t count = Sim_Flash_Erase_Count((MOD_CONFIG_START / MOD_FLASH_SECTOR_SIZE) + i);
+
+        wear_min = count < wear_min ? count : wear_min;
+        wear_max = count > wear_max ? count : wear_max;
+    }
+    printf("  %u keys, %u commits, %u compactions, wear %u..%u; init replayed %u entries in %.3f ms\n",
+           stat.keys, stat.commits, stat.compactions, wear_min, wear_max, stat.replayed, init_ns / 1e6);
+    // 上电后第一次整理不知道目标扇区是否已擦除, 多擦除一次
+    Bench_Check(wear_max - wear_min <= 2, "uneven wear %u..%u", wear_min, wear_max);
+    Bench_Check(stat.replayed <= MOD_CONFIG_KEYS_MAXNUM + MOD_CONFIG_LOG_MAXNUM, "init replayed %u entries", stat.replayed);
+    Bench_End();
+}
+
+/*
+ * @brief   配置存储整理失败: 提交中不能整理; 目标扇区写坏时整理和提交都返回 ERROR, 仍使用原来的扇区
+*/
+static void Test_Config_Fault(void)
+{
+    Bench_Begin("config faults");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Config_Init();
+    Mod_Config_Begin();
+    Bench_Check(Mod_Config_Compact() == ERROR, "compact inside a commit");
+    Bench_Check(Mod_Config_Commit() == SUCCESS, "empty commit");
+    Bench_Check(Mod_Config_Set_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 500) == SUCCESS, "set u32");
+    Bench_Check(Mod_Config_Compact() == SUCCESS, "compact");
+#if MOD_FLASH_VERIFY_EN
+    // 空分区的第一次整理写入第一个扇区, 上面的整理写入第二个扇区, 下一次写入第三个; 其头部固定的位使整理失败
+    Sim_Flash_Set_Stuck_Bit(MOD_CONFIG_START + 2 * MOD_FLASH_SECTOR_SIZE, 0, 0);
+    Bench_Check(Mod_Config_Compact() == ERROR, "stuck bit in compaction not detected");
+    Bench_Check(Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 500, "value after failed compaction");
+    Mod_Config_Init();
+    Bench_Check(Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 500, "value after failed compaction and power up");
+    Sim_Flash_Clear_Faults();
+    Bench_Check(Mod_Config_Compact() == SUCCESS, "compact after fault");
+    Mod_Config_Init();
+    Bench_Check(Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000) == 500, "value after compaction");
+#endif
+    Bench_End();
+}
+
+/*
+ * @brief   配置存储提交时在随机的一次编程或擦除中掉电, 重新上电后每次提交的几个键要么都是新值, 要么都是旧值
+*/
+static void Test_Config_Power_Loss(void)
+{
+    volatile uint32_t losses = 0;
+    volatile uint32_t committed = 0;        // 已经提交的版本
+    uint32_t now = 0;
+
+    Bench_Begin("config power loss");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Config_Init();
+    for (uint32_t round = 0; round < BENCH_CONFIG_ROUNDS; ++round)
+    {
+        Sim_Flash_Set_Power_Loss(1 + Bench_Random() % 32, Bench_Power_Loss_Handler);
+        if (setjmp(Bench_Power_Loss) == 0)
+        {
+            // 每次提交修改 4 个键, 都设为同一个版本
+            while (1)
+            {
+                Mod_Config_Begin();
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    Bench_Config_Set(i * 7 % MOD_CONFIG_KEYS_MAXNUM, committed + 1);
+                }
+                Bench_Check(Mod_Config_Commit() == SUCCESS, "commit %u", committed + 1);
+                ++committed;
+            }
+        }
+        ++losses;
+        Sim_Flash_Set_Power_Loss(0, NULL);
+        Mod_Config_Init();
+        now = Bench_Config_Is(0, committed + 1) ? committed + 1 : committed;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (!Bench_Config_Is(i * 7 % MOD_CONFIG_KEYS_MAXNUM, now))
+            {
+                Bench_Check(0, "key %u not at version %u after power loss %u", i * 7 % MOD_CONFIG_KEYS_MAXNUM, now, losses);
+                round = BENCH_CONFIG_ROUNDS;
+                break;
+            }
+        }
+        committed = now;
+    }
+    Sim_Flash_Set_Power_Loss(0, NULL);
+    printf("  %u power losses recovered, %u commits\n", losses, committed);
+    Bench_End();
+}
+
+// 不同写入方式和读取的性能
+static void Bench_Raw_Path(void)
+{
+    uint64_t start = 0;
+
+    Bench_Begin("raw flash");
+    Sim_Flash_Init(Bench_Timing);
+    Bench_Fill(Bench_Buffer[0], sizeof(Bench_Buffer[0]), 1);
+    Bench_Fill(Bench_Buffer[1], sizeof(Bench_Buffer[1]), 2);
+
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < MOD_FLASH_BLOCK_64K_SIZE; i += MOD_FLASH_SECTOR_SIZE)
+    {
+        Mod_Flash_Erase_Sector(i);
+        Mod_Flash_Write(Bench_Buffer[0] + i, i, MOD_FLASH_SECTOR_SIZE);
+    }
+    Mod_Flash_Sync();
+    Bench_Report("Erase_Sector + Write 64 KB", Sim_Clock_ns() - start, MOD_FLASH_BLOCK_64K_SIZE);
+
+    start = Sim_Clock_ns();
+    Mod_Flash_Write_Sectors(Bench_Buffer[1], 0, MOD_FLASH_BLOCK_64K_SIZE / MOD_FLASH_SECTOR_SIZE);
+    Mod_Flash_Sync();
+    Bench_Report("Write_Sectors 64 KB", Sim_Clock_ns() - start, MOD_FLASH_BLOCK_64K_SIZE);
+
+    start = Sim_Clock_ns();
+    Mod_Flash_Write_Sectors(Bench_Buffer[1], 0, MOD_FLASH_BLOCK_64K_SIZE / MOD_FLASH_SECTOR_SIZE);
+    Bench_Report("Write_Sectors 64 KB, same data", Sim_Clock_ns() - start, MOD_FLASH_BLOCK_64K_SIZE);
+
+    start = Sim_Clock_ns();
+    Mod_Flash_Read(Bench_Buffer[0], 0, MOD_FLASH_BLOCK_64K_SIZE);
+    Bench_Report("Read 64 KB", Sim_Clock_ns() - start, MOD_FLASH_BLOCK_64K_SIZE);
+    Bench_Check(memcmp(Bench_Buffer[0], Bench_Buffer[1], MOD_FLASH_BLOCK_64K_SIZE) == 0, "read back");
+
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < MOD_FLASH_BLOCK_64K_SIZE; i += 512)
+    {
+        Mod_Flash_Read(Bench_Buffer[0] + i, i, 512);
+    }
+    Bench_Report("Read 64 KB in 512 B", Sim_Clock_ns() - start, MOD_FLASH_BLOCK_64K_SIZE);
+    Bench_End();
+}
+
+/*
+ * @brief   FTL 突发写入: 没有空闲时间的连续写入每次都要等待上一次写入后开始的擦除; 突发之间空闲时 Mod_FTL_Poll()
+ *          补满预先擦除的扇区, 一次突发的 MOD_FTL_ERASED_NUM 个写入不等待擦除 (静态磨损均衡搬动的扇区除外)
+*/
+static void Bench_FTL_Burst(void)
+{
+    Mod_FTL_Stat_Type before, mid, after;
+    uint64_t start = 0, burst_ns = 0;
+    const uint32_t rounds = 20, num = rounds * MOD_FTL_ERASED_NUM;
+    uint32_t n = 0;
+
+    Bench_Begin("ftl burst");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_FTL_Init();
+    Mod_FTL_Get_Stat(&before);
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < num; ++i, ++n)
+    {
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, n);
+        Mod_FTL_Write(Bench_Buffer[0], n % BENCH_FTL_LBAS);
+    }
+    Mod_Flash_Sync();
+    Bench_Report("Write 4 KB back to back", Sim_Clock_ns() - start, num * MOD_FLASH_SECTOR_SIZE);
+
+    // 突发之间空闲 1 s, 主循环每 10 ms 调用一次 Mod_FTL_Poll()
+    Mod_FTL_Get_Stat(&mid);
+    for (uint32_t round = 0; round < rounds; ++round)
+    {
+        for (uint32_t t = 0; t < 100; ++t)
+        {
+            Sim_Clock_Advance(10000000);
+            Mod_FTL_Poll();
+        }
+        start = Sim_Clock_ns();
+        for (uint32_t i = 0; i < MOD_FTL_ERASED_NUM; ++i, ++n)
+        {
+            Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, n);
+            Mod_FTL_Write(Bench_Buffer[0], n % BENCH_FTL_LBAS);
+        }
+        burst_ns += Sim_Clock_ns() - start;
+    }
+    Mod_FTL_Get_Stat(&after);
+    Bench_Report("Write 4 KB in bursts after idle", burst_ns, num * MOD_FLASH_SECTOR_SIZE);
+    printf("  bursts: %u of %u allocations found no erased sector (%u moves)\n", after.erase_waits - mid.erase_waits,
+           num + after.moves - mid.moves, after.moves - mid.moves);
+    Bench_Check(after.erase_waits - mid.erase_waits <= after.moves - mid.moves, "%u erase waits in bursts",
+                after.erase_waits - mid.erase_waits);
+
+    // 重新上电: 检查空闲扇区, 找回预先擦除的扇区
+    for (uint32_t t = 0; t < 100; ++t)
+    {
+        Sim_Clock_Advance(10000000);
+        Mod_FTL_Poll();
+    }
+    Mod_Flash_Sync();
+    Mod_FTL_Init();
+    Mod_FTL_Get_Stat(&before);
+    for (uint32_t i = 0; i < MOD_FTL_ERASED_NUM; ++i, ++n)
+    {
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, n);
+        Mod_FTL_Write(Bench_Buffer[0], n % BENCH_FTL_LBAS);
+    }
+    Mod_FTL_Get_Stat(&after);
+    Bench_Check(after.erase_waits - before.erase_waits <= after.moves - before.moves, "erased sectors lost at init: %u erase waits",
+                after.erase_waits - before.erase_waits);
+    for (uint32_t i = n - BENCH_FTL_LBAS; i < n; ++i)
+    {
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, i);
+        Mod_FTL_Read(Bench_Buffer[1], i % BENCH_FTL_LBAS, 1);
+        Bench_Check(memcmp(Bench_Buffer[0], Bench_Buffer[1], MOD_FLASH_SECTOR_SIZE) == 0, "lba %u", i % BENCH_FTL_LBAS);
+    }
+    Bench_End();
+}
+
+// FatFs 顺序写入和读取文件, 经过写回缓存和 FTL
+static void Bench_FatFs(void)
+{
+    static FATFS fs;
+    static FIL fil;
+    static BYTE work[FF_MAX_SS];
+    Sim_Flash_Stat_Type sim;
+    Mod_FTL_Stat_Type ftl, ftl_before;
+    Mod_Flash_Stat_Type flash, flash_before;
+    DCACHE_STAT cache;
+    uint64_t start = 0;
+    uint32_t wear_min = 0xFFFFFFFF, wear_max = 0;
+    UINT bw = 0;
+    FRESULT fres;
+
+    Bench_Begin("fatfs");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_FTL_Get_Stat(&ftl_before);      // FTL 的统计不随 Mod_FTL_Init() 清零, 只输出这一项的部分
+    start = Sim_Clock_ns();
+    fres = f_mkfs("0:", &Mod_Flash_FatFs_Format, work, sizeof(work));
+    Bench_Check(fres == FR_OK, "f_mkfs %d", fres);
+    Bench_Report("f_mkfs", Sim_Clock_ns() - start, 0);
+    fres = f_mount(&fs, "0:", 1);
+    Bench_Check(fres == FR_OK, "f_mount %d", fres);
+
+    // 前两次新建文件, 每次写入一个扇区, 释放的簇已由 CTRL_TRIM 擦除; 第三次不截断, 原地改写, 每次写入 64 KB,
+    // FatFs 按簇 (MOD_FLASH_FATFS_CLUSTER) 以多扇区调用 disk_write(), 不经过 FTL 时由 Mod_Flash_Write_Sectors() 合并擦除
+    for (uint32_t pass = 0; pass < 3 && fres == FR_OK; ++pass)
+    {
+        const uint32_t chunk = pass < 2 ? MOD_FLASH_SECTOR_SIZE : MOD_FLASH_BLOCK_64K_SIZE;
+
+        Mod_Flash_Get_Stat(&flash_before);
+        start = Sim_Clock_ns();
+        fres = f_open(&fil, "0:bench.bin", pass < 2 ? FA_WRITE | FA_CREATE_ALWAYS : FA_WRITE);
+        for (uint32_t i = 0; i < BENCH_FILE_SIZE && fres == FR_OK; i += chunk)
+        {
+            for (uint32_t j = 0; j < chunk; j += MOD_FLASH_SECTOR_SIZE)
+            {
+                Bench_Fill(Bench_Buffer[0] + j, MOD_FLASH_SECTOR_SIZE, i + j + pass);
+            }
+            fres = f_write(&fil, Bench_Buffer[0], chunk, &bw);
+        }
+        if (fres == FR_OK)
+        {
+            fres = f_close(&fil);
+        }
+        Bench_Check(fres == FR_OK, "write pass %u: %d", pass, fres);
+        Bench_Report(pass == 0 ? "f_write 512 KB (new file)" : pass == 1 ? "f_write 512 KB (overwrite)" : "f_write 512 KB in 64 KB (in place)",
+                     Sim_Clock_ns() - start, BENCH_FILE_SIZE);
+    }
+    Mod_Flash_Get_Stat(&flash);
+    printf("  write sectors (64 KB pass): %u sectors erased with %u erase commands, %u erases avoided\n",
+           flash.erases - flash_before.erases, flash.erase_cmds - flash_before.erase_cmds, flash.erases_avoided - flash_before.erases_avoided);
+#if !MOD_FTL_EN
+    Bench_Check(flash.erase_cmds - flash_before.erase_cmds < flash.erases - flash_before.erases, "64 KB writes not coalesced");
+#endif
+
+    start = Sim_Clock_ns();
+    fres = f_open(&fil, "0:bench.bin", FA_READ);
+    for (uint32_t i = 0; i < BENCH_FILE_SIZE && fres == FR_OK; i += MOD_FLASH_SECTOR_SIZE)
+    {
+        fres = f_read(&fil, Bench_Buffer[1], MOD_FLASH_SECTOR_SIZE, &bw);
+        Bench_Fill(Bench_Buffer[0], MOD_FLASH_SECTOR_SIZE, i + 2);
+        Bench_Check(bw == MOD_FLASH_SECTOR_SIZE && memcmp(Bench_Buffer[0], Bench_Buffer[1], MOD_FLASH_SECTOR_SIZE) == 0, "data at %u", i);
+    }
+    f_close(&fil);
+    Bench_Report("f_read 512 KB", Sim_Clock_ns() - start, BENCH_FILE_SIZE);
+
+    start = Sim_Clock_ns();
+    fres = f_unlink("0:bench.bin");
+    Bench_Check(fres == FR_OK, "f_unlink %d", fres);
+    f_unmount("0:");
+    disk_ioctl(0, CTRL_SYNC, (void *)0);
+    Bench_Report("f_unlink + sync", Sim_Clock_ns() - start, 0);
+
+    Sim_Flash_Get_Stat(&sim);
+    Mod_FTL_Get_Stat(&ftl);
+    disk_cache_stat(&cache);
+    for (uint32_t i = 0; i < MOD_FLASH_CHIP_SIZE / MOD_FLASH_SECTOR_SIZE; ++i)
+    {
+        wear_min = Sim_Flash_Erase_Count(i) < wear_min ? Sim_Flash_Erase_Count(i) : wear_min;
+        wear_max = Sim_Flash_Erase_Count(i) > wear_max ? Sim_Flash_Erase_Count(i) : wear_max;
+    }
+    printf("  flash: %u programs, erases 4K %u 32K %u 64K %u chip %u, %u suspends, wear %u..%u\n",
+           sim.programs, sim.erases[0], sim.erases[1], sim.erases[2], sim.erases[3], sim.suspends, wear_min, wear_max);
+    printf("  ftl: %u writes, %u skipped, %u moves, %u checkpoints, %u trims, %u erase waits\n",
+           ftl.writes - ftl_before.writes, ftl.skipped - ftl_before.skipped, ftl.moves - ftl_before.moves,
+           ftl.checkpoints - ftl_before.checkpoints, ftl.trims - ftl_before.trims, ftl.erase_waits - ftl_before.erase_waits);
+    printf("  cache: %u read hits, %u misses, %u writes, %u write misses, %u flushes, %u evictions\n",
+           cache.read_hits, cache.read_misses, cache.writes, cache.write_misses, cache.flushes, cache.evictions);
+    Bench_End();
+}
+
+/*
+ * @brief   FatFs 的小文件和日志: 每次 f_close() 或 f_sync() 都改写 FAT 和目录扇区, 用于比较 DISK_CACHE_SLOTS
+ * @note    命中率 = 命中缓存的单扇区读写 / 全部单扇区读写; 多扇区读写不经过缓存
+*/
+static void Bench_FatFs_Small(void)
+{
+    static FATFS fs;
+    static FIL fil;
+    static BYTE work[FF_MAX_SS];
+    DCACHE_STAT before, after;
+    char name[16];
+    uint64_t start = 0;
+    uint32_t hits = 0, total = 0;
+    UINT bw = 0;
+    FRESULT fres;
+
+    Bench_Begin("fatfs small files");
+    Sim_Flash_Init(Bench_Timing);
+    fres = f_mkfs("0:", &Mod_Flash_FatFs_Format, work, sizeof(work));
+    if (fres == FR_OK)
+    {
+        fres = f_mount(&fs, "0:", 1);
+    }
+    Bench_Check(fres == FR_OK, "f_mkfs/f_mount %d", fres);
+    disk_cache_stat(&before);
+
+    // 新建 BENCH_SMALL_FILES 个小文件, 每个 f_close() 一次
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < BENCH_SMALL_FILES && fres == FR_OK; ++i)
+    {
+        snprintf(name, sizeof(name), "0:f%u.txt", i);
+        Bench_Fill(Bench_Buffer[0], BENCH_SMALL_SIZE, i);
+        fres = f_open(&fil, name, FA_WRITE | FA_CREATE_ALWAYS);
+        if (fres == FR_OK)
+        {
+            fres = f_write(&fil, Bench_Buffer[0], BENCH_SMALL_SIZE, &bw);
+            f_close(&fil);
+        }
+    }
+    Bench_Check(fres == FR_OK, "small files %d", fres);
+    Bench_Report("create 64 x 200 B files", Sim_Clock_ns() - start, BENCH_SMALL_FILES * BENCH_SMALL_SIZE);
+
+    // 日志: 每条 32 B 后 f_sync()
+    start = Sim_Clock_ns();
+    fres = f_open(&fil, "0:log.txt", FA_WRITE | FA_CREATE_ALWAYS);
+    for (uint32_t i = 0; i < BENCH_LOG_RECORDS && fres == FR_OK; ++i)
+    {
+        Bench_Fill(Bench_Buffer[0], 32, i);
+        fres = f_write(&fil, Bench_Buffer[0], 32, &bw);
+        if (fres == FR_OK)
+        {
+            fres = f_sync(&fil);
+        }
+    }
+    f_close(&fil);
+    Bench_Check(fres == FR_OK, "log %d", fres);
+    Bench_Report("append 32 B + f_sync", Sim_Clock_ns() - start, BENCH_LOG_RECORDS * 32);
+
+    for (uint32_t i = 0; i < BENCH_SMALL_FILES && fres == FR_OK; ++i)
+    {
+        snprintf(name, sizeof(name), "0:f%u.txt", i);
+        Bench_Fill(Bench_Buffer[0], BENCH_SMALL_SIZE, i);
+        fres = f_open(&fil, name, FA_READ);
+        if (fres == FR_OK)
+        {
+            fres = f_read(&fil, Bench_Buffer[1], BENCH_SMALL_SIZE, &bw);
+            f_close(&fil);
+        }
+        Bench_Check(fres == FR_OK && bw == BENCH_SMALL_SIZE && memcmp(Bench_Buffer[0], Bench_Buffer[1], BENCH_SMALL_SIZE) == 0,
+                    "%s", name);
+    }
+    f_unmount("0:");
+    disk_ioctl(0, CTRL_SYNC, (void *)0);
+
+    disk_cache_stat(&after);
+    hits = (after.read_hits - before.read_hits) + (after.writes - before.writes);
+    total = hits + (after.read_misses - before.read_misses) + (after.write_misses - before.write_misses);
+    printf("  cache (%u slots): %u read hits, %u misses, %u writes, %u write misses, %u flushes, %u evictions, hit rate %.1f%%\n",
+           DISK_CACHE_SLOTS, after.read_hits - before.read_hits, after.read_misses - before.read_misses, after.writes - before.writes,
+           after.write_misses - before.write_misses, after.flushes - before.flushes, after.evictions - before.evictions,
+           total ? 100.0 * hits / total : 0.0);
+    Bench_Check(DISK_CACHE_SLOTS == 0 || hits > 0, "no cache hits");
+    Bench_End();
+}
+
+/*
+ * @brief   记录存储追加的性能: 连续追加 (受擦除时间限制), 以及按固定的速率追加时是否需要等待擦除
+*/
+static void Bench_Record(void)
+{
+    Mod_Record_Stat_Type before, after;
+    uint64_t start = 0;
+    const uint32_t num = 20000;
+
+    Bench_Begin("record append");
+    Sim_Flash_Init(Bench_Timing);
+    Mod_Record_Clear();
+    Bench_Fill(Bench_Buffer[0], BENCH_RECORD_LEN, 1);
+
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        Mod_Record_Append(i, Bench_Buffer[0], BENCH_RECORD_LEN);
+    }
+    Mod_Record_Flush();
+    Bench_Report("append 20000 x 24 B", Sim_Clock_ns() - start, num * (MOD_RECORD_HEADER_SIZE + BENCH_RECORD_LEN));
+    printf("  %-32s %10.0f records/s\n", "", num / ((Sim_Clock_ns() - start) / 1e9));
+
+    // 每 2 ms 一条, 主循环中调用 Mod_Record_Poll()
+    Mod_Record_Get_Stat(&before);
+    start = Sim_Clock_ns();
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        Mod_Record_Append(num + i, Bench_Buffer[0], BENCH_RECORD_LEN);
+        Sim_Clock_Advance(2000000 - (Sim_Clock_ns() - start) % 2000000);
+        Mod_Record_Poll();
+    }
+    Mod_Record_Get_Stat(&after);
+    printf("  500 records/s: %u erases, %u stalls\n", after.erases - before.erases, after.stalls - before.stalls);
+    // 最大擦除时间 (400 ms) 内 1 KB 的缓存放不下
+    Bench_Check(Bench_Timing == &Sim_Flash_Timing_Max || after.stalls == before.stalls, "%u stalls at 500 records/s",
+                after.stalls - before.stalls);
+    Bench_End();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "-m") == 0)
+    {
+        Bench_Timing = &Sim_Flash_Timing_Max;
+    }
+    printf("timing: %s\n", Bench_Timing == &Sim_Flash_Timing_Max ? "datasheet max" : "datasheet typical");
+
+    Test_Protocol();
+    Test_Erase_Range();
+    Test_Detect();
+    Test_Suspend();
+    Test_Write_Sectors();
+    Test_Stuck_Bit();
+    Test_FTL_Power_Loss();
+    Test_Record();
+    Test_Record_Power_Loss();
+    Test_Config();
+    Test_Config_Fault();
+    Test_Config_Power_Loss();
+    Bench_Raw_Path();
+    Bench_FTL_Burst();
+    Bench_FatFs();
+    Bench_FatFs_Small();
+    Bench_Record();
+
+    printf(Bench_Failed ? "%u FAILED\n" : "all passed\n", Bench_Failed);
+    return Bench_Failed ? 1 : 0;
+}
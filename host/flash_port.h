@@ -0,0 +1,43 @@
+#ifndef _FLASH_PORT_H
+#define _FLASH_PORT_H
+
+/*
+ * @brief   mod_flash.c 在上位机上的接口, 由 flash_sim.c 实现, 代替 lib_spi.h, lib_tool.h 和 lib_usart.h
+ * @note    SPI 传输, DWT 计时都按模拟的时钟计算, 见 flash_sim.h
+*/
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+    SUCCESS = 0U,
+    ERROR = !SUCCESS
+} ErrorStatus;
+
+#define LIB_SPI_DUMMY    0x00
+
+void Sim_Flash_Select(void);
+void Sim_Flash_Deselect(void);
+uint8_t Sim_Flash_Exchange(const uint8_t data);
+void Sim_Flash_Transfer(const uint8_t *const tx, uint8_t *const rx, const uint32_t num);
+uint32_t Sim_Clock_Cycles(void);
+uint32_t Sim_Clock_Elapsed(const uint32_t start, const uint8_t is_us);
+
+#define Mod_Flash_COM_Init()                                    Mod_Flash_Detect()
+#define Mod_Flash_COM_Start()                                   Sim_Flash_Select()
+#define Mod_Flash_COM_Try_Start()                               (Sim_Flash_Select(), 1)     // 模拟的总线只有 FLASH, 不会被占用
+#define Mod_Flash_COM_Stop()                                    Sim_Flash_Deselect()
+#define Mod_Flash_Send_Byte(data)                               Sim_Flash_Exchange(data)
+#define Mod_Flash_Receive_Byte()                                Sim_Flash_Exchange(LIB_SPI_DUMMY)
+#define Mod_Flash_Send_Data(pbuffer, num)                       Sim_Flash_Transfer(pbuffer, (void *)0, num)
+#define Mod_Flash_Receive_Data(pbuffer, num)                    Sim_Flash_Transfer((void *)0, pbuffer, num)
+#define Mod_Flash_Send_Burst(pbuffer, num)                      Sim_Flash_Transfer(pbuffer, (void *)0, num)
+
+#define LIB_TOOL_AHB_FREQUENCY                                  72000000
+#define Lib_Tool_DWT_Timer_Start()                              Sim_Clock_Cycles()
+#define Lib_Tool_DWT_Timer_End(start, is_us)                    Sim_Clock_Elapsed(start, is_us)
+
+#define Lib_USART_Send_String(str)                              fputs(str, stdout)
+#define Lib_USART_Send_fString(...)                             printf(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,807 @@
+/*
+ * @brief   W25Q64 的上位机模型, 说明见 flash_sim.h
+ * @note    内部时间以皮秒计, 避免 SPI 字节时间 (36 MHz 时 222.2 ns) 的舍入误差累积
+*/
+#include "flash_sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 模型实现的指令
+#define SIM_CMD_WRITE_ENABLE           0x06
+#define SIM_CMD_WRITE_DISABLE          0x04
+#define SIM_CMD_READ_STATUS_1          0x05
+#define SIM_CMD_READ_STATUS_2          0x35
+#define SIM_CMD_PAGE_PROGRAM           0x02
+#define SIM_CMD_SECTOR_ERASE           0x20
+#define SIM_CMD_BLOCK_ERASE_32K        0x52
+#define SIM_CMD_BLOCK_ERASE_64K        0xD8
+#define SIM_CMD_CHIP_ERASE             0xC7
+#define SIM_CMD_CHIP_ERASE_ALT         0x60
+#define SIM_CMD_ERASE_SUSPEND          0x75
+#define SIM_CMD_ERASE_RESUME           0x7A
+#define SIM_CMD_POWER_DOWN             0xB9
+#define SIM_CMD_RELEASE_POWER_DOWN     0xAB
+#define SIM_CMD_MANUFACTURER_ID        0x90
+#define SIM_CMD_UNIQUE_ID              0x4B
+#define SIM_CMD_JEDEC_ID               0x9F
+#define SIM_CMD_READ_DATA              0x03
+#define SIM_CMD_FAST_READ              0x0B
+#define SIM_CMD_READ_SFDP              0x5A
+
+#define SIM_MANUFACTURER               0xEF
+#define SIM_DEVICE_ID                  (Sim.jedec_id - 1)     // 0x90, 0xAB 读出的设备 ID, 比 JEDEC ID 的容量字节小 1
+#define SIM_SFDP_SIZE                  0x100                  // SFDP 的地址范围, 之外读出 0xFF
+#define SIM_SFDP_BFPT                  0x80                   // 基本参数表的位置
+
+// 正在进行的操作
+#define SIM_OP_NONE                    0
+#define SIM_OP_PROGRAM                 1
+#define SIM_OP_ERASE                   2
+
+#define SIM_PS(ns)                     ((uint64_t)(ns) * 1000)
+#define SIM_VIOLATION_PRINT_MAXNUM     10       // 只打印前几次违规
+
+// 数据手册的典型值
+const Sim_Flash_Timing_Type Sim_Flash_Timing_Typical =
+{
+    .sck_hz = 36000000,
+    .byte_ns = 300,
+    .transfer_ns = 2000,
+    .cs_ns = 1000,
+    .timer_ns = 30,
+    .t_bp1 = 30000,
+    .t_bp2 = 2500,
+    .t_pp = 400000,
+    .t_se = 45000000,
+    .t_be1 = 120000000,
+    .t_be2 = 150000000,
+    .t_ce = 20000000000ULL,
+    .t_sus = 20000,
+    .t_dp = 3000,
+    .t_res1 = 3000,
+};
+
+// 数据手册的最大值, 总线部分与典型值相同
+const Sim_Flash_Timing_Type Sim_Flash_Timing_Max =
+{
+    .sck_hz = 36000000,
+    .byte_ns = 300,
+    .transfer_ns = 2000,
+    .cs_ns = 1000,
+    .timer_ns = 30,
+    .t_bp1 = 50000,
+    .t_bp2 = 12000,
+    .t_pp = 3000000,
+    .t_se = 400000000,
+    .t_be1 = 1600000000,
+    .t_be2 = 2000000000,
+    .t_ce = 100000000000ULL,
+    .t_sus = 20000,
+    .t_dp = 3000,
+    .t_res1 = 3000,
+};
+
+typedef struct
+{
+    uint32_t addr;
+    uint8_t mask;
+    uint8_t value;
+} Sim_Flash_Stuck_Type;
+
+static const uint8_t Sim_Flash_Unique_ID[8] = {0xD1, 0x63, 0x38, 0x2C, 0x13, 0x4A, 0x27, 0x21};
+
+static struct
+{
+    const Sim_Flash_Timing_Type *timing;
+    uint8_t *array;
+    uint32_t size;                          // 容量, 地址按此回绕
+    uint32_t jedec_id;
+    uint8_t sfdp[SIM_SFDP_SIZE];            // 为空 (全为 0xFF) 时没有 SFDP
+    uint32_t wear[SIM_FLASH_SECTORS];       // 每个扇区的擦除次数
+    uint64_t now;                           // 皮秒
+    uint64_t ready;                         // 在此之前 BUSY 为 1
+    // 当前的片选周期
+    uint8_t selected;
+    uint8_t cmd;
+    uint8_t ignore;                         // 指令无效, 忽略之后的字节
+    uint8_t bad_read;                       // 已经计过读取暂停范围的违规
+    uint32_t index;                         // 已收到的字节数
+    uint32_t addr;
+    uint8_t data[256];                      // PAGE_PROGRAM 收到的数据, 按页内地址存放
+    // 状态
+    uint8_t wel;
+    uint8_t power_down;
+    struct
+    {
+        uint8_t type;                       // SIM_OP_*
+        uint8_t suspended;
+        uint32_t addr;
+        uint32_t size;
+        uint64_t end;                       // 完成的时刻
+        uint64_t left;                      // 暂停时剩余的时间
+        uint64_t resume;                    // 上一次 ERASE_RESUME 的时刻
+        uint8_t data[256];
+    } op;
+    // 故障
+    uint32_t loss_ops;                      // 第几次编程或擦除时掉电, 0 表示不掉电
+    void (*loss_handler)(void);
+    Sim_Flash_Stuck_Type stuck[SIM_FLASH_STUCK_MAXNUM];
+    uint32_t stuck_num;
+    uint32_t seed;
+    Sim_Flash_Stat_Type stat;
+} Sim;
+
+static uint32_t Sim_Random(void)
+{
+    Sim.seed ^= Sim.seed << 13;
+    Sim.seed ^= Sim.seed >> 17;
+    Sim.seed ^= Sim.seed << 5;
+    return Sim.seed;
+}
+
+// 每一位以 permille / 1000 的概率为 1
+static uint8_t Sim_Random_Bits(const uint32_t permille)
+{
+    uint8_t bits = 0;
+
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+        if (Sim_Random() % 1000 < permille)
+        {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
+}
+
+static void Sim_Flash_Violation(const char *const what)
+{
+    if (Sim.stat.violations++ < SIM_VIOLATION_PRINT_MAXNUM)
+    {
+        printf("  flash: %s (cmd %02X at %.3f ms)\n", what, Sim.cmd, Sim.now / 1e9);
+    }
+}
+
+static uint8_t Sim_Flash_Is_Busy(void)
+{
+    return Sim.now < Sim.ready;
+}
+
+// 操作完成, 修改存储阵列
+static void Sim_Flash_Update(void)
+{
+    if (Sim.op.type == SIM_OP_NONE || Sim.op.suspended || Sim.now < Sim.op.end)
+    {
+        return;
+    }
+    if (Sim.op.type == SIM_OP_PROGRAM)
+    {
+        for (uint32_t i = 0; i < Sim.op.size; ++i)
+        {
+            Sim.array[Sim.op.addr + i] &= Sim.op.data[i];
+        }
+    }
+    else
+    {
+        memset(Sim.array + Sim.op.addr, 0xFF, Sim.op.size);
+        for (uint32_t i = 0; i < Sim.op.size; i += 4096)
+        {
+            ++Sim.wear[(Sim.op.addr + i) / 4096];
+        }
+    }
+    Sim.op.type = SIM_OP_NONE;
+    Sim.wel = 0;
+}
+
+// 掉电: 操作只完成随机的一部分, 之后芯片复位
+static void Sim_Flash_Power_Loss(void)
+{
+    const uint32_t permille = Sim_Random() % 1000;
+
+    if (Sim.op.type == SIM_OP_PROGRAM)
+    {
+        for (uint32_t i = 0; i < Sim.op.size; ++i)
+        {
+            Sim.array[Sim.op.addr + i] &= ~(~Sim.op.data[i] & Sim_Random_Bits(permille));
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < Sim.op.size; ++i)
+        {
+            Sim.array[Sim.op.addr + i] |= Sim_Random() % 1000 < permille ? 0xFF : Sim_Random_Bits(permille);
+        }
+        for (uint32_t i = 0; i < Sim.op.size; i += 4096)
+        {
+            ++Sim.wear[(Sim.op.addr + i) / 4096];
+        }
+    }
+    Sim_Flash_Power_Cycle();
+}
+
+// 开始编程或擦除, 数据已经在 Sim.op.data 中
+static void Sim_Flash_Start(const uint8_t type, const uint32_t addr, const uint32_t size, const uint64_t ns)
+{
+    Sim.op.type = type;
+    Sim.op.suspended = 0;
+    Sim.op.addr = addr;
+    Sim.op.size = size;
+    Sim.op.end = Sim.now + SIM_PS(ns);
+    Sim.op.resume = 0;
+    Sim.ready = Sim.op.end;
+    Sim.stat.busy_ns += ns;
+
+    if (Sim.loss_ops > 0 && --Sim.loss_ops == 0)
+    {
+        Sim_Flash_Power_Loss();
+        if (Sim.loss_handler != NULL)
+        {
+            Sim.loss_handler();
+        }
+    }
+}
+
+static void Sim_Flash_Erase(const uint32_t size, const uint64_t ns, const uint8_t kind)
+{
+    ++Sim.stat.erases[kind];
+    Sim_Flash_Start(SIM_OP_ERASE, Sim.addr & ~(size - 1) & (Sim.size - 1), size, ns);
+}
+
+// 读取存储阵列的一个字节, 叠加固定的位
+static uint8_t Sim_Flash_Read_Byte(const uint32_t addr)
+{
+    uint8_t data = Sim.array[addr];
+
+    if (Sim.op.suspended && addr - Sim.op.addr < Sim.op.size && !Sim.bad_read)
+    {
+        Sim.bad_read = 1;
+        Sim_Flash_Violation("read inside suspended operation");
+    }
+    for (uint32_t i = 0; i < Sim.stuck_num; ++i)
+    {
+        if (Sim.stuck[i].addr == addr)
+        {
+            data = (data & ~Sim.stuck[i].mask) | Sim.stuck[i].value;
+        }
+    }
+    ++Sim.stat.read_bytes;
+    return data;
+}
+
+// 片选周期的第一个字节
+static void Sim_Flash_Command(const uint8_t cmd)
+{
+    Sim.cmd = cmd;
+    Sim.addr = 0;
+    Sim.ignore = 0;
+    Sim.bad_read = 0;
+
+    if (Sim.power_down && cmd != SIM_CMD_RELEASE_POWER_DOWN)
+    {
+        Sim_Flash_Violation("command in power-down mode");
+        Sim.ignore = 1;
+        return;
+    }
+    if (Sim_Flash_Is_Busy() && cmd != SIM_CMD_READ_STATUS_1 && cmd != SIM_CMD_READ_STATUS_2 && cmd != SIM_CMD_ERASE_SUSPEND)
+    {
+        Sim_Flash_Violation("command while busy");
+        Sim.ignore = 1;
+        return;
+    }
+    switch (cmd)
+    {
+    case SIM_CMD_READ_STATUS_1:
+    case SIM_CMD_READ_STATUS_2:
+        ++Sim.stat.status_reads;
+        break;
+    case SIM_CMD_PAGE_PROGRAM:
+    case SIM_CMD_SECTOR_ERASE:
+    case SIM_CMD_BLOCK_ERASE_32K:
+    case SIM_CMD_BLOCK_ERASE_64K:
+    case SIM_CMD_CHIP_ERASE:
+    case SIM_CMD_CHIP_ERASE_ALT:
+        // 芯片允许在暂停擦除时编程其他扇区, mod_flash.c 不使用, 模型也不支持
+        if (Sim.op.suspended)
+        {
+            Sim_Flash_Violation("program or erase while suspended");
+            Sim.ignore = 1;
+        }
+        memset(Sim.data, 0xFF, sizeof(Sim.data));
+        break;
+    case SIM_CMD_WRITE_ENABLE:
+    case SIM_CMD_WRITE_DISABLE:
+    case SIM_CMD_ERASE_SUSPEND:
+    case SIM_CMD_ERASE_RESUME:
+    case SIM_CMD_POWER_DOWN:
+    case SIM_CMD_RELEASE_POWER_DOWN:
+    case SIM_CMD_MANUFACTURER_ID:
+    case SIM_CMD_UNIQUE_ID:
+    case SIM_CMD_JEDEC_ID:
+    case SIM_CMD_READ_DATA:
+    case SIM_CMD_FAST_READ:
+    case SIM_CMD_READ_SFDP:
+        break;
+    default:
+        Sim_Flash_Violation("unsupported command");
+        Sim.ignore = 1;
+        break;
+    }
+}
+
+// 片选周期中的一个字节, 返回 FLASH 输出的数据
+static uint8_t Sim_Flash_Byte(const uint8_t tx)
+{
+    const uint32_t i = Sim.index;
+    uint8_t out = 0xFF;
+
+    if (!Sim.selected)
+    {
+        Sim_Flash_Violation("transfer without chip select");
+        return out;
+    }
+    ++Sim.stat.bytes;
+    Sim.index = i + 1 > i ? i + 1 : i;
+    Sim_Flash_Update();
+    if (i == 0)
+    {
+        Sim_Flash_Command(tx);
+        return out;
+    }
+    if (Sim.ignore)
+    {
+        return out;
+    }
+
+    switch (Sim.cmd)
+    {
+    case SIM_CMD_READ_STATUS_1:
+        out = (Sim_Flash_Is_Busy() ? 0x01 : 0x00) | (Sim.wel ? 0x02 : 0x00);
+        // 连续读取时直接跳到操作完成
+        if (i >= 2 && Sim_Flash_Is_Busy())
+        {
+            Sim.now = Sim.ready;
+        }
+        break;
+    case SIM_CMD_READ_STATUS_2:
+        out = Sim.op.suspended ? 0x80 : 0x00;
+        break;
+    case SIM_CMD_JEDEC_ID:
+        out = i <= 3 ? (Sim.jedec_id >> (8 * (3 - i))) & 0xFF : 0xFF;
+        break;
+    case SIM_CMD_MANUFACTURER_ID:
+        if (i <= 3)
+        {
+            Sim.addr = (Sim.addr << 8) | tx;
+        }
+        else
+        {
+            out = ((i - 4 + Sim.addr) & 1) ? SIM_DEVICE_ID & 0xFF : SIM_MANUFACTURER;
+        }
+        break;
+    case SIM_CMD_RELEASE_POWER_DOWN:
+        out = i >= 4 ? SIM_DEVICE_ID & 0xFF : 0xFF;
+        break;
+    case SIM_CMD_UNIQUE_ID:
+        out = i >= 5 ? Sim_Flash_Unique_ID[(i - 5) % 8] : 0xFF;
+        break;
+    case SIM_CMD_READ_DATA:
+    case SIM_CMD_FAST_READ:
+        if (i <= 3)
+        {
+            Sim.addr = ((Sim.addr << 8) | tx) & (Sim.size - 1);
+        }
+        else if (i >= 4u + (Sim.cmd == SIM_CMD_FAST_READ))
+        {
+            out = Sim_Flash_Read_Byte(Sim.addr);
+            Sim.addr = (Sim.addr + 1) & (Sim.size - 1);
+        }
+        break;
+    case SIM_CMD_READ_SFDP:
+        // 3 字节地址, 1 个空字节
+        if (i <= 3)
+        {
+            Sim.addr = ((Sim.addr << 8) | tx) & 0xFFFFFF;
+        }
+        else if (i >= 5)
+        {
+            out = Sim.addr < SIM_SFDP_SIZE ? Sim.sfdp[Sim.addr] : 0xFF;
+            ++Sim.addr;
+        }
+        break;
+    case SIM_CMD_PAGE_PROGRAM:
+        if (i <= 3)
+        {
+            Sim.addr = ((Sim.addr << 8) | tx) & (Sim.size - 1);
+        }
+        else
+        {
+            // 超过页尾时回到页首, 覆盖之前收到的数据
+            Sim.data[(Sim.addr + i - 4) & 0xFF] = tx;
+        }
+        break;
+    case SIM_CMD_SECTOR_ERASE:
+    case SIM_CMD_BLOCK_ERASE_32K:
+    case SIM_CMD_BLOCK_ERASE_64K:
+        if (i <= 3)
+        {
+            Sim.addr = ((Sim.addr << 8) | tx) & (Sim.size - 1);
+        }
+        break;
+    default:
+        break;
+    }
+    return out;
+}
+
+// 片选上升沿, 执行写入类的指令
+static void Sim_Flash_Execute(void)
+{
+    const Sim_Flash_Timing_Type *const t = Sim.timing;
+    uint32_t num = 0;
+
+    if (Sim.ignore || Sim.index == 0)
+    {
+        return;
+    }
+    switch (Sim.cmd)
+    {
+    case SIM_CMD_WRITE_ENABLE:
+        Sim.wel = 1;
+        break;
+    case SIM_CMD_WRITE_DISABLE:
+        Sim.wel = 0;
+        break;
+    case SIM_CMD_PAGE_PROGRAM:
+        if (Sim.index < 5 || !Sim.wel)
+        {
+            Sim_Flash_Violation(Sim.wel ? "page program without data" : "page program without write enable");
+            break;
+        }
+        num = Sim.index - 4 < 256 ? Sim.index - 4 : 256;
+        ++Sim.stat.programs;
+        Sim.stat.program_bytes += num;
+        memcpy(Sim.op.data, Sim.data, sizeof(Sim.data));
+        Sim_Flash_Start(SIM_OP_PROGRAM, Sim.addr & ~0xFFu, 256,
+                        t->t_bp1 + (uint64_t)t->t_bp2 * (num - 1) < t->t_pp ? t->t_bp1 + (uint64_t)t->t_bp2 * (num - 1) : t->t_pp);
+        break;
+    case SIM_CMD_SECTOR_ERASE:
+    case SIM_CMD_BLOCK_ERASE_32K:
+    case SIM_CMD_BLOCK_ERASE_64K:
+        if (Sim.index != 4 || !Sim.wel)
+        {
+            Sim_Flash_Violation(Sim.wel ? "erase with wrong address length" : "erase without write enable");
+            break;
+        }
+        if (Sim.cmd == SIM_CMD_SECTOR_ERASE)
+        {
+            Sim_Flash_Erase(4096, t->t_se, 0);
+        }
+        else if (Sim.cmd == SIM_CMD_BLOCK_ERASE_32K)
+        {
+            Sim_Flash_Erase(32768, t->t_be1, 1);
+        }
+        else
+        {
+            Sim_Flash_Erase(65536, t->t_be2, 2);
+        }
+        break;
+    case SIM_CMD_CHIP_ERASE:
+    case SIM_CMD_CHIP_ERASE_ALT:
+        if (Sim.index != 1 || !Sim.wel)
+        {
+            Sim_Flash_Violation("chip erase without write enable");
+            break;
+        }
+        Sim.addr = 0;
+        Sim_Flash_Erase(Sim.size, t->t_ce, 3);
+        break;
+    case SIM_CMD_ERASE_SUSPEND:
+        // 没有正在进行的操作时忽略
+        if (Sim.op.type == SIM_OP_NONE || Sim.op.suspended)
+        {
+            break;
+        }
+        if (Sim.op.resume != 0 && Sim.now - Sim.op.resume < SIM_PS(t->t_sus))
+        {
+            Sim_Flash_Violation("suspend within tSUS of resume");
+        }
+        Sim.op.left = Sim.op.end - Sim.now;
+        Sim.op.suspended = 1;
+        Sim.ready = Sim.now + SIM_PS(t->t_sus);
+        ++Sim.stat.suspends;
+        break;
+    case SIM_CMD_ERASE_RESUME:
+        if (!Sim.op.suspended)
+        {
+            break;
+        }
+        Sim.op.suspended = 0;
+        Sim.op.end = Sim.now + Sim.op.left;
+        Sim.op.resume = Sim.now;
+        Sim.ready = Sim.op.end;
+        break;
+    case SIM_CMD_POWER_DOWN:
+        Sim.power_down = 1;
+        Sim.ready = Sim.now + SIM_PS(t->t_dp);
+        break;
+    case SIM_CMD_RELEASE_POWER_DOWN:
+        if (Sim.power_down)
+        {
+            Sim.power_down = 0;
+            Sim.ready = Sim.now + SIM_PS(t->t_res1);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * @brief   拉低片选
+*/
+void Sim_Flash_Select(void)
+{
+    if (Sim.selected)
+    {
+        Sim_Flash_Violation("chip select while selected");
+    }
+    Sim.now += SIM_PS(Sim.timing->cs_ns);
+    Sim.selected = 1;
+    Sim.index = 0;
+    ++Sim.stat.cs_cycles;
+}
+
+/*
+ * @brief   拉高片选, 执行擦除, 编程等指令
+*/
+void Sim_Flash_Deselect(void)
+{
+    if (!Sim.selected)
+    {
+        Sim_Flash_Violation("chip deselect while not selected");
+        return;
+    }
+    Sim.selected = 0;
+    Sim_Flash_Update();
+    Sim_Flash_Execute();
+}
+
+/*
+ * @brief   逐字节收发一个字节 (Lib_SPI_Send_Byte())
+*/
+uint8_t Sim_Flash_Exchange(const uint8_t data)
+{
+    Sim.now += 8 * 1000000000000ULL / Sim.timing->sck_hz + SIM_PS(Sim.timing->byte_ns);
+    return Sim_Flash_Byte(data);
+}
+
+/*
+ * @brief   连续收发 (Lib_SPI_Transfer()), tx 为 0 时发送 LIB_SPI_DUMMY, rx 为 0 时丢弃
+*/
+void Sim_Flash_Transfer(const uint8_t *const tx, uint8_t *const rx, const uint32_t num)
+{
+    uint8_t data = 0;
+
+    Sim.now += SIM_PS(Sim.timing->transfer_ns);
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        Sim.now += 8 * 1000000000000ULL / Sim.timing->sck_hz;
+        data = Sim_Flash_Byte(tx != NULL ? tx[i] : LIB_SPI_DUMMY);
+        if (rx != NULL)
+        {
+            rx[i] = data;
+        }
+    }
+}
+
+/*
+ * @brief   DWT 计数 (Lib_Tool_DWT_Timer_Start()), 按 LIB_TOOL_AHB_FREQUENCY 由模拟的时钟换算
+*/
+uint32_t Sim_Clock_Cycles(void)
+{
+    Sim.now += SIM_PS(Sim.timing->timer_ns);
+    return (uint32_t)(Sim.now / 1000 * (LIB_TOOL_AHB_FREQUENCY / 1000000) / 1000);
+}
+
+/*
+ * @brief   Lib_Tool_DWT_Timer_End(): 从 start 到现在的时间, is_us 为 1 时单位为微秒, 否则为毫秒
+*/
+uint32_t Sim_Clock_Elapsed(const uint32_t start, const uint8_t is_us)
+{
+    const uint32_t ticks = Sim_Clock_Cycles() - start;
+
+    return (uint32_t)((uint64_t)ticks * (is_us ? 1000000 : 1000) / LIB_TOOL_AHB_FREQUENCY);
+}
+
+/*
+ * @brief   模拟的时钟, 纳秒
+*/
+uint64_t Sim_Clock_ns(void)
+{
+    return Sim.now / 1000;
+}
+
+/*
+ * @brief   推进模拟的时钟, 代表 CPU 做其他事情的时间
+*/
+void Sim_Clock_Advance(const uint64_t ns)
+{
+    Sim.now += SIM_PS(ns);
+}
+
+// 把时间编码为 SFDP 的 (count + 1) * unit, 取不小于 ns 的最小值; 返回 count | (unit 的序号 << 5)
+static uint32_t Sim_SFDP_Time(const uint64_t ns, const uint64_t *const unit, const uint8_t num)
+{
+    uint64_t count = 0;
+    uint8_t k = 0;
+
+    for (k = 0; k + 1 < num && (ns + unit[k] - 1) / unit[k] > 32; ++k)
+    {
+    }
+    count = (ns + unit[k] - 1) / unit[k];
+    count = count == 0 ? 1 : count > 32 ? 32 : count;
+    return (uint32_t)(count - 1) | ((uint32_t)k << 5);
+}
+
+/*
+ * @brief   按容量和时间参数生成 SFDP (JESD216B): 头部, 一个参数头部, 16 个 DWORD 的基本参数表
+ * @note    本模型不使用的字段 (快速读取的模式等) 全为 1, 表示不支持
+*/
+static void Sim_SFDP_Build(void)
+{
+    static const uint64_t erase_unit[4] = {1000000, 16000000, 128000000, 1000000000};
+    static const uint64_t program_unit[2] = {8000, 64000};
+    static const uint64_t chip_unit[4] = {16000000, 256000000, 4000000000ULL, 64000000000ULL};
+    const Sim_Flash_Timing_Type *const t = Sim.timing;
+    uint32_t dword[16];
+    uint32_t e1 = 0, e2 = 0, e3 = 0, pp = 0, ce = 0;
+
+    memset(Sim.sfdp, 0xFF, sizeof(Sim.sfdp));
+    memcpy(Sim.sfdp, "SFDP\x06\x01\x00\xFF", 8);
+    // 参数头部: ID 0xFF00 (基本参数表), 版本 1.6, 16 个 DWORD, 地址 SIM_SFDP_BFPT
+    memcpy(Sim.sfdp + 8, "\x00\x06\x01\x10\x80\x00\x00\xFF", 8);
+
+    e1 = Sim_SFDP_Time(t->t_se, erase_unit, 4);
+    e2 = Sim_SFDP_Time(t->t_be1, erase_unit, 4);
+    e3 = Sim_SFDP_Time(t->t_be2, erase_unit, 4);
+    pp = Sim_SFDP_Time(t->t_pp, program_unit, 2);
+    ce = Sim_SFDP_Time(t->t_ce, chip_unit, 4);
+    memset(dword, 0xFF, sizeof(dword));
+    dword[0] = 0xFFF920E5;                              // 4 KB 擦除指令 0x20, 3 字节地址
+    dword[1] = Sim.size * 8 - 1;                        // 容量, 位数减 1
+    dword[7] = 0x520F200C;                              // 擦除 1: 4 KB 0x20; 擦除 2: 32 KB 0x52
+    dword[8] = 0x0000D810;                              // 擦除 3: 64 KB 0xD8; 擦除 4: 没有
+    dword[9] = 0x1 | (e1 << 4) | (e2 << 11) | (e3 << 18);                             // 擦除 1~3, 最大值为典型值的 4 倍
+    dword[10] = 0x1 | (8 << 4) | (pp << 8) | (ce << 24);                              // 页大小 256, 页编程, 整片擦除
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            Sim.sfdp[SIM_SFDP_BFPT + i * 4 + j] = (dword[i] >> (8 * j)) & 0xFF;
+        }
+    }
+}
+
+/*
+ * @brief   换成同系列的其他容量, 存储阵列全部擦除
+ * @param   jedec_id 例如 SIM_FLASH_JEDEC_W25Q128, 最后一个字节为 log2(容量)
+ *          sfdp 是否支持 READ_SFDP, 为 0 时模拟旧芯片
+ * @return  SUCCESS; ERROR: 容量超过 SIM_FLASH_MAXSIZE 或小于 64 KB, 不做修改
+ * @note    在 Sim_Flash_Init() 之后调用, SFDP 中的时间按 Sim_Flash_Init() 的时间参数生成
+*/
+ErrorStatus Sim_Flash_Set_Chip(const uint32_t jedec_id, const uint8_t sfdp)
+{
+    if ((jedec_id & 0xFF) < 16 || (1ULL << (jedec_id & 0xFF)) > SIM_FLASH_MAXSIZE)
+    {
+        return ERROR;
+    }
+    Sim.jedec_id = jedec_id;
+    Sim.size = 1u << (jedec_id & 0xFF);
+    memset(Sim.array, 0xFF, SIM_FLASH_MAXSIZE);
+    Sim_SFDP_Build();
+    if (!sfdp)
+    {
+        memset(Sim.sfdp, 0xFF, sizeof(Sim.sfdp));
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   初始化: 存储阵列全部擦除, 时钟, 统计, 擦除次数和故障清零
+ * @param   timing 时间参数, 通常为 &Sim_Flash_Timing_Typical
+ * @note    芯片为支持 SFDP 的 W25Q64
+*/
+void Sim_Flash_Init(const Sim_Flash_Timing_Type *const timing)
+{
+    if (Sim.array == NULL)
+    {
+        Sim.array = malloc(SIM_FLASH_MAXSIZE);
+        if (Sim.array == NULL)
+        {
+            printf("flash: out of memory\n");
+            exit(1);
+        }
+    }
+    memset(Sim.wear, 0, sizeof(Sim.wear));
+    memset(&Sim.stat, 0, sizeof(Sim.stat));
+    Sim.timing = timing;
+    Sim_Flash_Set_Chip(SIM_FLASH_JEDEC_W25Q64, 1);
+    Sim.now = 0;
+    Sim.seed = 1;
+    Sim_Flash_Clear_Faults();
+    Sim_Flash_Power_Cycle();
+}
+
+/*
+ * @brief   重新上电: 存储阵列不变, 正在进行的操作丢失, 状态复位
+*/
+void Sim_Flash_Power_Cycle(void)
+{
+    Sim.selected = 0;
+    Sim.index = 0;
+    Sim.ignore = 0;
+    Sim.wel = 0;
+    Sim.power_down = 0;
+    Sim.op.type = SIM_OP_NONE;
+    Sim.op.suspended = 0;
+    Sim.ready = Sim.now;
+}
+
+/*
+ * @brief   在之后的第 ops 次编程或擦除时掉电
+ * @param   ops 从 1 开始, 0 表示取消
+ *          handler 掉电后调用, 芯片已经复位; 通常 longjmp 回到测试, 代表 MCU 也已掉电
+*/
+void Sim_Flash_Set_Power_Loss(const uint32_t ops, void (*const handler)(void))
+{
+    Sim.loss_ops = ops;
+    Sim.loss_handler = handler;
+}
+
+/*
+ * @brief   把 addr 的第 bit 位固定为 value, 读取时总是得到 value
+ * @return  SUCCESS; ERROR: 已经有 SIM_FLASH_STUCK_MAXNUM 个
+*/
+ErrorStatus Sim_Flash_Set_Stuck_Bit(const uint32_t addr, const uint8_t bit, const uint8_t value)
+{
+    if (Sim.stuck_num >= SIM_FLASH_STUCK_MAXNUM)
+    {
+        return ERROR;
+    }
+    Sim.stuck[Sim.stuck_num].addr = addr & (Sim.size - 1);
+    Sim.stuck[Sim.stuck_num].mask = 1 << (bit & 7);
+    Sim.stuck[Sim.stuck_num].value = value ? 1 << (bit & 7) : 0;
+    ++Sim.stuck_num;
+    return SUCCESS;
+}
+
+/*
+ * @brief   取消掉电和固定的位
+*/
+void Sim_Flash_Clear_Faults(void)
+{
+    Sim.loss_ops = 0;
+    Sim.loss_handler = NULL;
+    Sim.stuck_num = 0;
+}
+
+void Sim_Flash_Get_Stat(Sim_Flash_Stat_Type *const stat)
+{
+    *stat = Sim.stat;
+}
+
+/*
+ * @brief   扇区 (4 KB) 的擦除次数, 包括块擦除和整片擦除
+*/
+uint32_t Sim_Flash_Erase_Count(const uint32_t sector)
+{
+    return sector < SIM_FLASH_SECTORS ? Sim.wear[sector] : 0;
+}
+
+/*
+ * @brief   存储阵列, 不叠加固定的位, 用于检查
+*/
+const uint8_t *Sim_Flash_Array(void)
+{
+    return Sim.array;
+}
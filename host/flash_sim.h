@@ -0,0 +1,85 @@
+#ifndef _FLASH_SIM_H
+#define _FLASH_SIM_H
+
+/*
+ * @brief   W25Q64 的上位机模型, 代替 SPI 总线上的 FLASH, 供 mod_flash.c, mod_ftl.c, diskio.c 和 FatFs 在 Linux 上运行
+ * @note    1) 实现 mod_flash.h 中使用的指令: JEDEC_ID, MANUFACTURER_DEVICE_ID, READ_UNIQUE_ID, READ_SFDP, 状态寄存器 1/2,
+ *             WRITE_ENABLE/DISABLE, READ_DATA, FAST_READ, PAGE_PROGRAM, 4 KB/32 KB/64 KB/整片擦除, ERASE_SUSPEND/RESUME,
+ *             POWER_DOWN 和 RELEASE_POWER_DOWN; 其他指令计为违规并忽略
+ *          2) 编程是与运算 (只能把 1 变为 0), 超过页尾时回到页首; 擦除和编程在完成时才改变存储阵列
+ *          3) 时间: 模拟的时钟以纳秒计, 每个 SPI 字节, 每次片选和每次读取 DWT 都推进时钟, 擦除和编程的时间取数据手册的
+ *             典型值或最大值 (Sim_Flash_Timing_Typical, Sim_Flash_Timing_Max); 一个片选周期内连续读取状态寄存器时
+ *             直接跳到操作完成, 与逐字节轮询的结果只差一个字节的时间
+ *          4) 违规: FLASH 忙碌时发出读状态寄存器和 ERASE_SUSPEND 以外的指令, 没有 WRITE_ENABLE 就编程或擦除,
+ *             读取暂停中的擦除或编程的范围, ERASE_RESUME 后不到 tSUS 又暂停等; 计入 Sim_Flash_Stat_Type.violations
+ *          5) 故障注入: 第 n 次编程或擦除时掉电 (只完成随机的一部分, 然后调用掉电处理函数, 通常 longjmp 回到测试),
+ *             固定为 0 或 1 的位 (读取时覆盖)
+ *          6) 容量: Sim_Flash_Set_Chip() 换成同系列的 W25Q32/W25Q128 等, JEDEC ID, 设备 ID 和地址范围随之改变;
+ *             SFDP 的基本参数表按当前的时间参数生成, 也可以模拟没有 SFDP 的旧芯片 (READ_SFDP 读出全为 0xFF)
+*/
+#include "flash_port.h"
+
+#define SIM_FLASH_MAXSIZE              16777216                      // 最大 16 MB (W25Q128), 3 字节地址
+#define SIM_FLASH_SECTORS              (SIM_FLASH_MAXSIZE / 4096)
+#define SIM_FLASH_JEDEC_W25Q32         0xEF4016
+#define SIM_FLASH_JEDEC_W25Q64         0xEF4017                      // Sim_Flash_Init() 的默认值
+#define SIM_FLASH_JEDEC_W25Q128        0xEF4018
+#define SIM_FLASH_STUCK_MAXNUM         16                            // 最多几个固定的位
+
+/*
+ * @brief   时间参数, 单位纳秒
+*/
+typedef struct
+{
+    // 总线和 CPU
+    uint32_t sck_hz;            // SPI 时钟, 每字节 8 个时钟
+    uint32_t byte_ns;           // 逐字节收发 (轮询) 时每个字节额外的 CPU 时间
+    uint32_t transfer_ns;       // 连续收发 (DMA) 每次额外的启动时间
+    uint32_t cs_ns;             // 每次片选 (Lib_SPI_Begin() + Lib_SPI_End()) 的时间
+    uint32_t timer_ns;          // 每次读取 DWT 的时间
+    // FLASH, W25Q64JV 数据手册
+    uint32_t t_bp1;             // 页编程的第一个字节
+    uint32_t t_bp2;             // 页编程之后的每个字节
+    uint32_t t_pp;              // 页编程的上限
+    uint32_t t_se;              // 4 KB 擦除
+    uint32_t t_be1;             // 32 KB 擦除
+    uint32_t t_be2;             // 64 KB 擦除
+    uint64_t t_ce;              // 整片擦除
+    uint32_t t_sus;             // 发出 ERASE_SUSPEND 到可以读取
+    uint32_t t_dp;              // 进入掉电模式
+    uint32_t t_res1;            // 退出掉电模式
+} Sim_Flash_Timing_Type;
+
+/*
+ * @brief   统计, 由 Sim_Flash_Init() 清零
+*/
+typedef struct
+{
+    uint32_t cs_cycles;         // 片选周期数
+    uint64_t bytes;             // SPI 传输的字节数
+    uint64_t read_bytes;        // 从存储阵列读出的字节数
+    uint32_t programs;          // PAGE_PROGRAM 次数
+    uint64_t program_bytes;     // 编程的字节数
+    uint32_t erases[4];         // 4 KB, 32 KB, 64 KB, 整片擦除的次数
+    uint32_t suspends;
+    uint32_t status_reads;      // 读取状态寄存器的片选周期数
+    uint64_t busy_ns;           // 擦除和编程的总时间
+    uint32_t violations;        // 违规次数, 见文件开头
+} Sim_Flash_Stat_Type;
+
+extern const Sim_Flash_Timing_Type Sim_Flash_Timing_Typical;
+extern const Sim_Flash_Timing_Type Sim_Flash_Timing_Max;
+
+void Sim_Flash_Init(const Sim_Flash_Timing_Type *const timing);
+ErrorStatus Sim_Flash_Set_Chip(const uint32_t jedec_id, const uint8_t sfdp);
+void Sim_Flash_Power_Cycle(void);
+void Sim_Flash_Set_Power_Loss(const uint32_t ops, void (*const handler)(void));
+ErrorStatus Sim_Flash_Set_Stuck_Bit(const uint32_t addr, const uint8_t bit, const uint8_t value);
+void Sim_Flash_Clear_Faults(void);
+void Sim_Flash_Get_Stat(Sim_Flash_Stat_Type *const stat);
+uint32_t Sim_Flash_Erase_Count(const uint32_t sector);
+const uint8_t *Sim_Flash_Array(void);
+uint64_t Sim_Clock_ns(void);
+void Sim_Clock_Advance(const uint64_t ns);
+
+#endif
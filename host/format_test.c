@@ -0,0 +1,298 @@
+/*
+ * @brief   lib_format.c 的上位机测试: 与 C 库的 snprintf 逐个比较输出
+ * @note    编译: gcc -O2 -Wall -I../libs/include -o format_test format_test.c ../libs/source/lib_format.c
+ *          用法: format_test [-f], 全部通过时返回 0
+ *                默认: 每个 10 的幂和 16 的幂附近, [-10^6, 10^6] 全部, 以及 10^7 个随机的 int32;
+ *                -f 遍历全部 2^32 个整数 (数分钟)
+ *          浮点数与 "%.*f" 比较, 包括恰好为 .5 的二进制小数; 不指定精度的 %f 位数与 C 库不同, 不比较
+*/
+#include "lib_format.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_RANDOM_NUM     10000000
+#define TEST_DENSE_RANGE    1000000
+#define TEST_EDGE_RANGE     1000
+#define TEST_FLOAT_NUM      1000000
+
+static uint32_t failed;
+static uint32_t Test_Seed = 12345;
+
+static uint32_t Test_Rand(void)
+{
+    Test_Seed ^= Test_Seed << 13;
+    Test_Seed ^= Test_Seed >> 17;
+    Test_Seed ^= Test_Seed << 5;
+    return Test_Seed;
+}
+
+static void Test_Check(const char *const name, const uint32_t errors, const uint64_t num)
+{
+    printf("%s %s (%llu values)\n", errors == 0 ? "PASS" : "FAIL", name, (unsigned long long)num);
+    if (errors != 0)
+    {
+        ++failed;
+    }
+}
+
+// 只打印前几个不一致的值
+static uint32_t Test_Compare(const char *const name, const char *const got, const uint32_t got_len,
+                             const char *const want, uint32_t *const errors)
+{
+    if (got_len != strlen(want) || memcmp(got, want, got_len) != 0)
+    {
+        if (++*errors <= 5)
+        {
+            printf("  %s: got \"%.*s\", want \"%s\"\n", name, (int)got_len, got, want);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// 一个 int32 的全部整数转换: Int2Char_DEC, UInt2Char_DEC, Int2Char_HEX, UInt2Char_HEX
+static void Test_Int(const int32_t num, uint32_t *const errors)
+{
+    uint8_t got[LIB_FORMAT_NUM_BUFFER_SIZE];
+    char want[LIB_FORMAT_NUM_BUFFER_SIZE];
+    uint8_t len = 0;
+
+    len = Lib_Format_Int2Char_DEC(num, got);
+    snprintf(want, sizeof(want), "%d", num);
+    if (Test_Compare("Int2Char_DEC", (const char *)got, len, want, errors) == 0 && got[len] != '\0')
+    {
+        Test_Compare("Int2Char_DEC terminator", "", 1, "", errors);
+    }
+    len = Lib_Format_UInt2Char_DEC((uint32_t)num, got);
+    snprintf(want, sizeof(want), "%u", (uint32_t)num);
+    Test_Compare("UInt2Char_DEC", (const char *)got, len, want, errors);
+    len = Lib_Format_Int2Char_HEX(num, got);
+    snprintf(want, sizeof(want), "0x%X", (uint32_t)num);
+    Test_Compare("Int2Char_HEX", (const char *)got, len, want, errors);
+    len = Lib_Format_UInt2Char_HEX((uint32_t)num, got, 0);
+    snprintf(want, sizeof(want), "%x", (uint32_t)num);
+    Test_Compare("UInt2Char_HEX", (const char *)got, len, want, errors);
+}
+
+static void Test_Int_Range(const int full)
+{
+    uint32_t errors = 0;
+    uint64_t num = 0;
+    int64_t base = 0;
+
+    if (full)
+    {
+        for (uint64_t i = 0; i <= UINT32_MAX; ++i)
+        {
+            Test_Int((int32_t)(uint32_t)i, &errors);
+        }
+        Test_Check("int32: full range", errors, 1ULL << 32);
+        return;
+    }
+    // 位数和十六进制位数变化的地方, 以及两端
+    for (int sign = -1; sign <= 1; sign += 2)
+    {
+        for (base = 1; base <= INT32_MAX; base *= 10)
+        {
+            for (int64_t d = -TEST_EDGE_RANGE; d <= TEST_EDGE_RANGE; ++d)
+            {
+                if (sign * base + d >= INT32_MIN && sign * base + d <= INT32_MAX)
+                {
+                    Test_Int((int32_t)(sign * base + d), &errors);
+                    ++num;
+                }
+            }
+        }
+        for (base = 16; base <= INT32_MAX; base *= 16)
+        {
+            for (int64_t d = -TEST_EDGE_RANGE; d <= TEST_EDGE_RANGE; ++d)
+            {
+                Test_Int((int32_t)(sign * base + d), &errors);
+                ++num;
+            }
+        }
+    }
+    for (int64_t d = 0; d <= TEST_EDGE_RANGE; ++d)
+    {
+        Test_Int((int32_t)(INT32_MIN + d), &errors);
+        Test_Int((int32_t)(INT32_MAX - d), &errors);
+        num += 2;
+    }
+    Test_Check("int32: digit boundaries and limits", errors, num);
+
+    errors = 0;
+    for (int32_t i = -TEST_DENSE_RANGE; i <= TEST_DENSE_RANGE; ++i)
+    {
+        Test_Int(i, &errors);
+    }
+    Test_Check("int32: dense range", errors, 2 * TEST_DENSE_RANGE + 1);
+
+    errors = 0;
+    for (uint32_t i = 0; i < TEST_RANDOM_NUM; ++i)
+    {
+        Test_Int((int32_t)Test_Rand(), &errors);
+    }
+    Test_Check("int32: random", errors, TEST_RANDOM_NUM);
+}
+
+// Scaled2Char 与按整数拆分后的 printf 比较
+static void Test_Scaled(void)
+{
+    uint8_t got[LIB_FORMAT_NUM_BUFFER_SIZE];
+    char want[LIB_FORMAT_NUM_BUFFER_SIZE + 8];
+    static const uint32_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    uint32_t errors = 0, abs_num = 0;
+    int32_t num = 0;
+    uint8_t len = 0;
+
+    for (uint32_t i = 0; i < TEST_FLOAT_NUM; ++i)
+    {
+        num = i < 4 ? (int32_t[]){0, -5, INT32_MIN, INT32_MAX}[i] : (int32_t)Test_Rand() >> (Test_Rand() % 32);
+        for (uint8_t bits = 0; bits <= LIB_FORMAT_FRAC_MAXDIGITS; ++bits)
+        {
+            abs_num = num < 0 ? 0U - (uint32_t)num : (uint32_t)num;
+            len = Lib_Format_Scaled2Char(num, got, bits);
+            if (bits == 0)
+            {
+                snprintf(want, sizeof(want), "%s%u", num < 0 ? "-" : "", abs_num);
+            }
+            else
+            {
+                snprintf(want, sizeof(want), "%s%u.%0*u", num < 0 ? "-" : "", abs_num / pow10[bits],
+                         bits, abs_num % pow10[bits]);
+            }
+            Test_Compare("Scaled2Char", (const char *)got, len, want, &errors);
+        }
+    }
+    Test_Check("Scaled2Char", errors, TEST_FLOAT_NUM * (LIB_FORMAT_FRAC_MAXDIGITS + 1));
+}
+
+// Q16.16 的值在 double 中精确, 与 "%.*f" 比较
+static void Test_Q16(void)
+{
+    uint8_t got[LIB_FORMAT_NUM_BUFFER_SIZE];
+    char want[64];
+    uint32_t errors = 0;
+    int32_t num = 0;
+    uint8_t len = 0;
+
+    for (uint32_t i = 0; i < TEST_FLOAT_NUM; ++i)
+    {
+        num = i < 3 ? (int32_t[]){0, INT32_MIN, INT32_MAX}[i] : (int32_t)Test_Rand() >> (Test_Rand() % 32);
+        for (uint8_t bits = 0; bits <= LIB_FORMAT_FRAC_MAXDIGITS; ++bits)
+        {
+            len = Lib_Format_Q16_2Char(num, got, bits);
+            snprintf(want, sizeof(want), "%.*f", bits, num / 65536.0);
+            Test_Compare("Q16_2Char", (const char *)got, len, want, &errors);
+        }
+    }
+    Test_Check("Q16_2Char", errors, TEST_FLOAT_NUM * (LIB_FORMAT_FRAC_MAXDIGITS + 1));
+}
+
+// double: 整数部分不超过 uint32 的随机值, 包括恰好为 0.5 的舍入 (按偶数舍入)
+static void Test_Double(void)
+{
+    uint8_t got[LIB_FORMAT_NUM_BUFFER_SIZE];
+    char want[64];
+    uint32_t errors = 0;
+    double num = 0;
+    uint8_t len = 0;
+
+    for (uint32_t i = 0; i < TEST_FLOAT_NUM; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0:  num = (double)(int32_t)Test_Rand() / (1 << (Test_Rand() % 24)); break;    // 二进制小数, 含 x.5
+            case 1:  num = ((double)Test_Rand() + Test_Rand() / 4294967296.0) * (Test_Rand() & 1 ? 1 : -1); break;
+            default: num = (double)Test_Rand() / 1e9 - 2.0; break;
+        }
+        for (uint8_t bits = 0; bits <= LIB_FORMAT_FRAC_MAXDIGITS; ++bits)
+        {
+            len = Lib_Format_Double2Char(num, got, bits);
+            snprintf(want, sizeof(want), "%.*f", bits, num);
+            Test_Compare("Double2Char", (const char *)got, len, want, &errors);
+        }
+    }
+    Test_Check("Double2Char", errors, TEST_FLOAT_NUM * (LIB_FORMAT_FRAC_MAXDIGITS + 1));
+}
+
+// double: 整数部分超过 uint32 时饱和为 4294967295, 包括 2^52 以上 (尾数左移) 和 [2^64, 2^84) (左移会溢出 uint64)
+static void Test_Double_Saturate(void)
+{
+    static const double nums[] = {4294967296.0, 0x1p52, 0x1p63, 0x1p64, 0x1.8p64, 0x1p70, 0x1.fffffp80, 0x1p83,
+                                  0x1.fffffffffffffp83, 0x1p84, 0x1p100, 1e300, -0x1p64, -0x1.8p80};
+    uint8_t got[LIB_FORMAT_NUM_BUFFER_SIZE];
+    char want[64];
+    uint32_t errors = 0;
+    uint8_t len = 0;
+
+    for (uint32_t i = 0; i < sizeof(nums) / sizeof(nums[0]); ++i)
+    {
+        for (uint8_t bits = 0; bits <= LIB_FORMAT_FRAC_MAXDIGITS; ++bits)
+        {
+            len = Lib_Format_Double2Char(nums[i], got, bits);
+            snprintf(want, sizeof(want), "%s4294967295%s%.*s", nums[i] < 0 ? "-" : "", bits ? "." : "", bits, "000000000");
+            Test_Compare("Double2Char saturate", (const char *)got, len, want, &errors);
+        }
+    }
+    Test_Check("Double2Char saturate", errors, sizeof(nums) / sizeof(nums[0]) * (LIB_FORMAT_FRAC_MAXDIGITS + 1));
+}
+
+// 格式字符串, 与 snprintf 比较; 也检查截断和返回值
+// 截断时的缓冲区大小, volatile 避免编译器对有意的截断给出警告
+static volatile uint32_t Test_Truncate_Size = 5;
+
+#define TEST_PRINT(fmt, ...)                                                                        \
+    do                                                                                              \
+    {                                                                                               \
+        char got_[128], want_[128];                                                                 \
+        uint32_t n_ = Lib_Format_snPrint(got_, sizeof(got_), fmt, __VA_ARGS__);                     \
+        int w_ = snprintf(want_, sizeof(want_), fmt, __VA_ARGS__);                                  \
+        if (n_ != (uint32_t)w_ || strcmp(got_, want_) != 0)                                         \
+        {                                                                                           \
+            ++errors;                                                                               \
+            printf("  \"%s\": got \"%s\" (%u), want \"%s\" (%d)\n", fmt, got_, n_, want_, w_);      \
+        }                                                                                           \
+        n_ = Lib_Format_snPrint(got_, Test_Truncate_Size, fmt, __VA_ARGS__);                        \
+        snprintf(want_, Test_Truncate_Size, fmt, __VA_ARGS__);                                      \
+        if (n_ != (uint32_t)w_ || strcmp(got_, want_) != 0)                                         \
+        {                                                                                           \
+            ++errors;                                                                               \
+            printf("  \"%s\" truncated: got \"%s\" (%u), want \"%s\"\n", fmt, got_, n_, want_);     \
+        }                                                                                           \
+        ++num;                                                                                      \
+    } while (0)
+
+static void Test_Print(void)
+{
+    uint32_t errors = 0, num = 0;
+
+    TEST_PRINT("%d; %d; %d; 0x%X; 0x%X; 0x%X", 123, -123, 0, 1234, -1234, 0);
+    TEST_PRINT("%i %u %x %X", INT_MIN, UINT_MAX, 0xDEADBEEFU, 0xDEADBEEFU);
+    TEST_PRINT("[%-6s] [%6u] [%08.2f] [%+d] [%c] [%.3s] [%ld%%]", "left", 42U, -3.14159, 7, 'A', "truncated", 100L);
+    TEST_PRINT("[%5d] [%-5d] [%05d] [% d] [%+d] [%+05d]", -42, -42, -42, 42, 0, 42);
+    TEST_PRINT("[%.5d] [%8.5d] [%-8.3d] [%.0d] [%#x] [%#X] [%#08x]", 42, -42, 7, 0, 255U, 255U, 255U);
+    TEST_PRINT("[%*d] [%-*d] [%.*f] [%*.*f]", 6, 12, 6, 12, 2, 2.675, 9, 4, -0.0625);
+    TEST_PRINT("[%hhd] [%hd] [%hhu] [%hu]", 300, 70000, 300, 70000);
+    // %f 不指定精度时为 LIB_FORMAT_FLOAT_PRECISION 位, 与 C 库的 6 位不同, 这里总是指定精度
+    TEST_PRINT("[%.3f] [%.0f] [%.1f] [%.6f] [%.2F]", 25.3, 2.5, -0.05, 1234.5678, 1.0);
+    TEST_PRINT("[%10.3f] [%-10.3f] [%+.2f] [% .2f] [%010.3f]", 3.14159, 3.14159, 2.5, 2.5, -3.14159);
+    TEST_PRINT("[%s] [%10s] [%-10s|] [%.0s]", "", "abc", "abc", "abc");
+    TEST_PRINT("[%c%c%c] [%5c] [%-5c|]", 'x', 'y', 'z', 'q', 'q');
+    TEST_PRINT("%s", "no conversions at all, only a rather long string that exceeds the truncated size");
+    Test_Check("snPrint formats", errors, num);
+}
+
+int main(int argc, char *argv[])
+{
+    Test_Int_Range(argc > 1 && strcmp(argv[1], "-f") == 0);
+    Test_Scaled();
+    Test_Q16();
+    Test_Double();
+    Test_Double_Saturate();
+    Test_Print();
+    printf("%s\n", failed ? "FAILED" : "all passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+#include "host_cmd.h"
+#include "host_serial.h"
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * @brief   打开串口并建立连接
+ * @return  0: 成功; -1: 失败
+*/
+int Host_Cmd_Open(Host_Cmd_Type *const host, const char *const path, const uint32_t baud)
+{
+    memset(host, 0, sizeof(*host));
+    Lib_Frame_Decoder_Init(&host->decoder);
+    host->fd = Host_Serial_Open(path, baud);
+    host->baud = baud;
+    return host->fd < 0 ? -1 : 0;
+}
+
+void Host_Cmd_Close(Host_Cmd_Type *const host)
+{
+    Host_Serial_Close(host->fd);
+}
+
+/*
+ * @brief   发送一条指令, 不等待应答; 可以连续发送多条 (流水线)
+ * @return  该指令的 seq; 256 条都未应答或发送失败时返回 -1
+*/
+int Host_Cmd_Send(Host_Cmd_Type *const host, const uint8_t cmd, const uint8_t *const payload, const uint8_t len)
+{
+    Lib_Frame_Type frame;
+    uint8_t buffer[LIB_FRAME_ENCODED_MAXSIZE];
+    uint32_t num = 0;
+
+    if (host->outstanding[host->seq] || len > LIB_FRAME_PAYLOAD_MAXSIZE)
+    {
+        return -1;
+    }
+    frame.seq = host->seq;
+    frame.cmd = cmd;
+    frame.len = len;
+    if (len > 0)
+    {
+        memcpy(frame.payload, payload, len);
+    }
+    num = Lib_Frame_Encode(&frame, buffer);
+    host->outstanding[frame.seq] = 1;
+    host->has_reply[frame.seq] = 0;
+    host->cmd[frame.seq] = cmd;
+    host->send_time_us[frame.seq] = Host_Serial_Time_us();
+    if (Host_Serial_Write(host->fd, buffer, num) != 0)
+    {
+        host->outstanding[frame.seq] = 0;
+        return -1;
+    }
+    ++host->num_outstanding;
+    ++host->seq;
+    return frame.seq;
+}
+
+// 处理收到的一帧: 返回数据先暂存, ACK 中的每个 (seq, 结果) 产生一个事件
+static void Host_Cmd_Handle_Frame(Host_Cmd_Type *const host, const Lib_Frame_Type *const frame,
+                                  const Host_Cmd_Callback_Type callback, void *const arg)
+{
+    Host_Cmd_Event_Type event;
+    uint64_t now = Host_Serial_Time_us();
+    uint8_t seq = 0;
+
+    if (frame->cmd != HOST_CMD_ACK)
+    {
+        if (host->outstanding[frame->seq])
+        {
+            host->reply[frame->seq] = *frame;
+            host->has_reply[frame->seq] = 1;
+        }
+        return;
+    }
+    for (uint8_t i = 0; i + 1 < frame->len; i += 2)
+    {
+        seq = frame->payload[i];
+        if (host->outstanding[seq] == 0)
+        {
+            continue; // 重复的应答
+        }
+        host->outstanding[seq] = 0;
+        --host->num_outstanding;
+        event.seq = seq;
+        event.cmd = host->cmd[seq];
+        event.result = frame->payload[i + 1];
+        event.rtt_us = now - host->send_time_us[seq];
+        event.reply = host->has_reply[seq] ? &host->reply[seq] : (void *)0;
+        if (callback != (void *)0)
+        {
+            callback(&event, arg);
+        }
+    }
+}
+
+/*
+ * @brief   接收并处理应答, 最多等待 timeout_ms 毫秒
+ * @return  本次处理的事件数; 出错返回 -1
+*/
+int Host_Cmd_Poll(Host_Cmd_Type *const host, const int timeout_ms, const Host_Cmd_Callback_Type callback, void *const arg)
+{
+    uint8_t buffer[256];
+    Lib_Frame_Type frame;
+    uint32_t before = host->num_outstanding;
+    int num = Host_Serial_Read(host->fd, buffer, sizeof(buffer), timeout_ms);
+
+    if (num < 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < num; ++i)
+    {
+        if (Lib_Frame_Decode_Byte(&host->decoder, buffer[i], &frame) == LIB_FRAME_READY)
+        {
+            Host_Cmd_Handle_Frame(host, &frame, callback, arg);
+        }
+    }
+    return (int)(before - host->num_outstanding);
+}
+
+// Host_Cmd_Call() 的等待状态
+typedef struct
+{
+    int seq;
+    uint8_t done;
+    uint8_t result;
+    Lib_Frame_Type *reply;
+} Host_Cmd_Wait_Type;
+
+static void Host_Cmd_Wait_Callback(const Host_Cmd_Event_Type *const event, void *const arg)
+{
+    Host_Cmd_Wait_Type *wait = (Host_Cmd_Wait_Type *)arg;
+
+    if (event->seq != wait->seq)
+    {
+        return;
+    }
+    wait->done = 1;
+    wait->result = event->result;
+    if (wait->reply != (void *)0)
+    {
+        if (event->reply != (void *)0)
+        {
+            *wait->reply = *event->reply;
+        }
+        else
+        {
+            wait->reply->len = 0;
+        }
+    }
+}
+
+/*
+ * @brief   发送一条指令并等待应答
+ * @param   reply 不为 0 时, 存放返回数据
+ * @return  HOST_CMD_RES_*; 超时返回 HOST_CMD_RES_TIMEOUT
+*/
+uint8_t Host_Cmd_Call(Host_Cmd_Type *const host, const uint8_t cmd, const uint8_t *const payload, const uint8_t len,
+                      Lib_Frame_Type *const reply, const int timeout_ms)
+{
+    Host_Cmd_Wait_Type wait = {0};
+    uint64_t deadline = Host_Serial_Time_us() + (uint64_t)timeout_ms * 1000;
+
+    wait.reply = reply;
+    wait.seq = Host_Cmd_Send(host, cmd, payload, len);
+    if (wait.seq < 0)
+    {
+        return HOST_CMD_RES_TIMEOUT;
+    }
+    while (wait.done == 0 && Host_Serial_Time_us() < deadline)
+    {
+        if (Host_Cmd_Poll(host, 10, Host_Cmd_Wait_Callback, &wait) < 0)
+        {
+            break;
+        }
+    }
+    if (wait.done == 0)
+    {
+        // 放弃该指令, 之后到达的应答会被当作重复应答忽略
+        host->outstanding[wait.seq] = 0;
+        --host->num_outstanding;
+        return HOST_CMD_RES_TIMEOUT;
+    }
+    return wait.result;
+}
+
+/*
+ * @brief   设置单片机的 RTC 时间
+*/
+uint8_t Host_Cmd_Set_RTC(Host_Cmd_Type *const host, const int32_t ts)
+{
+    uint8_t payload[4];
+    uint32_t v = (uint32_t)ts;
+
+    payload[0] = v & 0xFF;
+    payload[1] = (v >> 8) & 0xFF;
+    payload[2] = (v >> 16) & 0xFF;
+    payload[3] = (v >> 24) & 0xFF;
+    return Host_Cmd_Call(host, HOST_CMD_RTC_UNIX, payload, sizeof(payload), (void *)0, 1000);
+}
+
+// 退回原波特率, 等单片机超时后也退回
+static void Host_Cmd_Baud_Fallback(Host_Cmd_Type *const host, const uint32_t old)
+{
+    Host_Serial_Set_Baud(host->fd, old);
+    host->baud = old;
+    usleep((HOST_CMD_BAUD_TIMEOUT_MS + 100) * 1000);
+    Lib_Frame_Decoder_Init(&host->decoder);
+}
+
+/*
+ * @brief   与单片机协商新波特率, 过程见 lib_usart.c 中的 Lib_USART_CMD_Baud()
+ * @return  HOST_CMD_RES_OK: 双方已切换到新波特率; 其它: 失败, 双方仍为原波特率
+ * @note    最后一步确认的 ACK 丢失时, 单片机可能已经切换而上位机退回, 此时需要手动以新波特率重连
+*/
+uint8_t Host_Cmd_Set_Baud(Host_Cmd_Type *const host, const uint32_t baud)
+{
+    uint8_t payload[4], pattern[LIB_FRAME_PAYLOAD_MAXSIZE];
+    uint32_t old = host->baud;
+    Lib_Frame_Type reply;
+    uint8_t res = 0;
+
+    payload[0] = baud & 0xFF;
+    payload[1] = (baud >> 8) & 0xFF;
+    payload[2] = (baud >> 16) & 0xFF;
+    payload[3] = (baud >> 24) & 0xFF;
+    res = Host_Cmd_Call(host, HOST_CMD_BAUD, payload, sizeof(payload), (void *)0, 1000);
+    if (res != HOST_CMD_RES_OK)
+    {
+        return res;
+    }
+    // 单片机发出 ACK 后已切换
+    if (Host_Serial_Set_Baud(host->fd, baud) != 0)
+    {
+        Host_Cmd_Baud_Fallback(host, old);
+        return HOST_CMD_RES_FAIL;
+    }
+    host->baud = baud;
+    Lib_Frame_Decoder_Init(&host->decoder);
+
+    // 测试图样: 0x55/0xAA 交替 (最多的电平跳变), 0x00/0xFF 交替 (最长的连续电平), 其余为伪随机
+    for (uint32_t i = 0; i < sizeof(pattern); ++i)
+    {
+        pattern[i] = i < 16 ? ((i & 1) ? 0xAA : 0x55) : i < 32 ? ((i & 1) ? 0xFF : 0x00) : (uint8_t)(i * 167 + 13);
+    }
+    res = HOST_CMD_RES_TIMEOUT;
+    for (uint8_t retry = 0; retry < 3 && res != HOST_CMD_RES_OK; ++retry)
+    {
+        res = Host_Cmd_Call(host, HOST_CMD_BAUD_CHECK, pattern, sizeof(pattern), &reply, 100);
+        if (res == HOST_CMD_RES_OK && (reply.len != sizeof(pattern) || memcmp(reply.payload, pattern, sizeof(pattern)) != 0))
+        {
+            res = HOST_CMD_RES_FAIL;
+        }
+    }
+    if (res != HOST_CMD_RES_OK)
+    {
+        Host_Cmd_Baud_Fallback(host, old);
+        return res;
+    }
+
+    // 确认; 单片机对重复的确认也回复 OK
+    res = HOST_CMD_RES_TIMEOUT;
+    for (uint8_t retry = 0; retry < 3 && res != HOST_CMD_RES_OK; ++retry)
+    {
+        res = Host_Cmd_Call(host, HOST_CMD_BAUD_CHECK, (void *)0, 0, (void *)0, 100);
+    }
+    if (res != HOST_CMD_RES_OK)
+    {
+        Host_Cmd_Baud_Fallback(host, old);
+    }
+    return res;
+}
+
+/*
+ * @brief   读取单片机的链路统计
+*/
+uint8_t Host_Cmd_Get_Stat(Host_Cmd_Type *const host, Host_Cmd_Stat_Type *const stat)
+{
+    Lib_Frame_Type reply;
+    uint32_t *const p = (uint32_t *)stat;
+    uint8_t res = Host_Cmd_Call(host, HOST_CMD_STAT, (void *)0, 0, &reply, 1000);
+
+    if (res != HOST_CMD_RES_OK)
+    {
+        return res;
+    }
+    if (reply.len != sizeof(*stat))
+    {
+        return HOST_CMD_RES_FAIL;
+    }
+    for (uint32_t i = 0; i < sizeof(*stat) / sizeof(uint32_t); ++i)
+    {
+        p[i] = (uint32_t)reply.payload[i * 4] | ((uint32_t)reply.payload[i * 4 + 1] << 8)
+             | ((uint32_t)reply.payload[i * 4 + 2] << 16) | ((uint32_t)reply.payload[i * 4 + 3] << 24);
+    }
+    return HOST_CMD_RES_OK;
+}
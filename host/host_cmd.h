@@ -0,0 +1,83 @@
+#ifndef _HOST_CMD_H
+#define _HOST_CMD_H
+
+#include <stdint.h>
+#include "lib_frame.h"
+
+/*
+ * @brief   指令协议的上位机实现, 与 lib_usart.c 中 LIB_USART_CMD_EN 部分对应
+ * @note    指令和结果码必须与 lib_usart.h 中的 LIB_USART_CMD_* 保持一致
+*/
+#define HOST_CMD_ACK                0xFF
+#define HOST_CMD_START              0x01
+#define HOST_CMD_STOP               0x02
+#define HOST_CMD_RTC_UNIX           0x03
+#define HOST_CMD_PING               0x04
+#define HOST_CMD_BAUD               0x05
+#define HOST_CMD_BAUD_CHECK         0x06
+#define HOST_CMD_STAT               0x07
+#define HOST_CMD_BAUD_TIMEOUT_MS    500       // 与 LIB_USART_CMD_BAUD_TIMEOUT_MS 一致
+
+#define HOST_CMD_RES_OK             0x00
+#define HOST_CMD_RES_UNKNOWN        0x01
+#define HOST_CMD_RES_BAD_LEN        0x02
+#define HOST_CMD_RES_NOT_STARTED    0x03
+#define HOST_CMD_RES_FAIL           0x04
+#define HOST_CMD_RES_TIMEOUT        0xFF      // 上位机超时, 不是单片机返回的
+
+/*
+ * @brief   链路统计, 与 lib_usart.h 中的 Lib_USART_Stat_Type 一致
+*/
+typedef struct
+{
+    uint32_t overrun;
+    uint32_t framing;
+    uint32_t noise;
+    uint32_t tx_dropped;
+    uint32_t tx_stall_us;
+    uint32_t rx_paused;
+    uint32_t rx_dropped;
+} Host_Cmd_Stat_Type;
+
+/*
+ * @brief   一条指令的完成事件
+*/
+typedef struct
+{
+    uint8_t seq;                      // 指令的序号
+    uint8_t cmd;                      // 指令
+    uint8_t result;                   // HOST_CMD_RES_*
+    uint64_t rtt_us;                  // 从发送到收到 ACK 的时间
+    const Lib_Frame_Type *reply;      // 返回数据的帧, 没有则为 0; 先于 ACK 到达, 在此一并交出
+} Host_Cmd_Event_Type;
+
+typedef void (*Host_Cmd_Callback_Type)(const Host_Cmd_Event_Type *const event, void *const arg);
+
+/*
+ * @brief   一个连接
+*/
+typedef struct
+{
+    int fd;
+    uint32_t baud;                        // 当前波特率
+    uint8_t seq;                          // 下一帧的序号
+    uint32_t num_outstanding;             // 已发送未应答的帧数
+    uint8_t outstanding[256];             // 按 seq 记录是否已发送未应答
+    uint8_t cmd[256];                     // 按 seq 记录指令
+    uint64_t send_time_us[256];           // 按 seq 记录发送时刻
+    uint8_t has_reply[256];               // 按 seq 记录是否已收到返回数据
+    Lib_Frame_Type reply[256];            // 按 seq 暂存返回数据
+    Lib_Frame_Decoder_Type decoder;
+} Host_Cmd_Type;
+
+int Host_Cmd_Open(Host_Cmd_Type *const host, const char *const path, const uint32_t baud);
+void Host_Cmd_Close(Host_Cmd_Type *const host);
+int Host_Cmd_Send(Host_Cmd_Type *const host, const uint8_t cmd, const uint8_t *const payload, const uint8_t len);
+int Host_Cmd_Poll(Host_Cmd_Type *const host, const int timeout_ms, const Host_Cmd_Callback_Type callback, void *const arg);
+uint8_t Host_Cmd_Call(Host_Cmd_Type *const host, const uint8_t cmd, const uint8_t *const payload, const uint8_t len,
+                      Lib_Frame_Type *const reply, const int timeout_ms);
+uint8_t Host_Cmd_Set_RTC(Host_Cmd_Type *const host, const int32_t ts);
+uint8_t Host_Cmd_Set_Baud(Host_Cmd_Type *const host, const uint32_t baud);
+uint8_t Host_Cmd_Get_Stat(Host_Cmd_Type *const host, Host_Cmd_Stat_Type *const stat);
+
+#endif
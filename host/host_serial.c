@@ -0,0 +1,159 @@
+#include "host_serial.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// 波特率到 termios 常量的映射
+static speed_t Host_Serial_Speed(const uint32_t baud)
+{
+    switch (baud)
+    {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1152000: return B1152000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 2500000: return B2500000;
+        case 3000000: return B3000000;
+        case 3500000: return B3500000;
+        case 4000000: return B4000000;
+        default:      return B0;
+    }
+}
+
+/*
+ * @brief   打开串口, 配置为原始模式 8N1
+ * @param   path 设备路径, 如 /dev/ttyUSB0 或 /dev/pts/3
+ *          baud 波特率
+ * @return  文件描述符; 失败返回 -1
+*/
+int Host_Serial_Open(const char *const path, const uint32_t baud)
+{
+    struct termios tio;
+    int fd = open(path, O_RDWR | O_NOCTTY);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0 || Host_Serial_Set_Baud(fd, baud) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+/*
+ * @brief   修改波特率, 等待已写入的数据发送完成后生效
+ * @return  0: 成功; -1: 不支持的波特率或设置失败
+*/
+int Host_Serial_Set_Baud(const int fd, const uint32_t baud)
+{
+    struct termios tio;
+    speed_t speed = Host_Serial_Speed(baud);
+
+    if (speed == B0 || tcgetattr(fd, &tio) != 0)
+    {
+        return -1;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSADRAIN, &tio) == 0 ? 0 : -1;
+}
+
+/*
+ * @brief   开启或关闭 RTS/CTS 硬件流控, 对应单片机的 LIB_USART_FLOW_EN
+ * @return  0: 成功; -1: 失败 (pty 不支持时也可能返回成功但不生效)
+*/
+int Host_Serial_Set_Flow(const int fd, const int enable)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        return -1;
+    }
+    if (enable)
+    {
+        tio.c_cflag |= CRTSCTS;
+    }
+    else
+    {
+        tio.c_cflag &= ~CRTSCTS;
+    }
+    return tcsetattr(fd, TCSADRAIN, &tio) == 0 ? 0 : -1;
+}
+
+/*
+ * @brief   写入全部数据
+ * @return  0: 成功; -1: 失败
+*/
+int Host_Serial_Write(const int fd, const uint8_t *const data, const uint32_t num)
+{
+    uint32_t p = 0;
+    ssize_t n = 0;
+
+    while (p < num)
+    {
+        n = write(fd, data + p, num - p);
+        if (n < 0)
+        {
+            return -1;
+        }
+        p += (uint32_t)n;
+    }
+    return 0;
+}
+
+/*
+ * @brief   读取数据, 最多等待 timeout_ms 毫秒
+ * @return  读到的字节数, 超时返回 0, 出错返回 -1
+*/
+int Host_Serial_Read(const int fd, uint8_t *const buffer, const uint32_t num, const int timeout_ms)
+{
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int res = poll(&pfd, 1, timeout_ms);
+
+    if (res <= 0)
+    {
+        return res;
+    }
+    return (int)read(fd, buffer, num);
+}
+
+void Host_Serial_Close(const int fd)
+{
+    close(fd);
+}
+
+/*
+ * @brief   单调时钟, 微秒
+*/
+uint64_t Host_Serial_Time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
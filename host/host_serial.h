@@ -0,0 +1,17 @@
+#ifndef _HOST_SERIAL_H
+#define _HOST_SERIAL_H
+
+#include <stdint.h>
+
+/*
+ * @brief   Linux 串口 (或 pty) 的打开与原始模式读写, 供上位机工具使用
+*/
+int Host_Serial_Open(const char *const path, const uint32_t baud);
+int Host_Serial_Set_Baud(const int fd, const uint32_t baud);
+int Host_Serial_Set_Flow(const int fd, const int enable);
+int Host_Serial_Write(const int fd, const uint8_t *const data, const uint32_t num);
+int Host_Serial_Read(const int fd, uint8_t *const buffer, const uint32_t num, const int timeout_ms);
+void Host_Serial_Close(const int fd);
+uint64_t Host_Serial_Time_us(void);
+
+#endif
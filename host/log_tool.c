@@ -0,0 +1,345 @@
+/*
+ * @brief   延迟日志 (lib_log.h, LIB_LOG_DEFERRED_EN) 的解码工具: 从 ELF 读取格式字符串, 把记录还原为文本
+ * @note    编译: gcc -O2 -I../libs/include -o log_tool log_tool.c host_serial.c ../libs/source/lib_frame.c
+ *          用法: log_tool <ELF 文件> <设备 | -> [-b 波特率] [-f 时间增量的频率, 默认 72 MHz >> 10]
+ *                设备为 - 时从标准输入读取 (例如保存下来的串口数据), 结束时打印统计
+ *          记录之外的字节 (例如 Lib_USART_Send_String() 的文本) 原样输出
+*/
+#include "host_serial.h"
+#include "lib_frame.h"
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LOG_TOOL_CHUNK_MAXSIZE    1024      // 两个 0x00 之间最多保留的字节数, 超出部分按文本直接输出
+
+// 解码的状态和统计
+typedef struct
+{
+    const char *strings;          // .lib_log 段的内容
+    uint32_t strings_size;
+    double freq;                  // 时间戳频率 (Hz)
+    uint64_t time;                // 累计的时间戳
+    uint8_t chunk[LOG_TOOL_CHUNK_MAXSIZE];
+    uint32_t chunk_num;
+    uint64_t num_in;              // 收到的字节数
+    uint64_t num_out;             // 还原出的文本字节数 (只算记录)
+    uint32_t num_records;
+    uint32_t num_errors;
+} Log_Tool_Type;
+
+/*
+ * @brief   读取 ELF 文件中 .lib_log 段的内容, 支持 32 位和 64 位 (上位机测试)
+ * @return  段内容, 用 free() 释放; 失败返回 NULL
+*/
+static char *Log_Tool_Load_Strings(const char *const path, uint32_t *const size)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char ident[EI_NIDENT];
+    uint64_t shoff = 0, sh_offset = 0, sh_size = 0, str_offset = 0;
+    uint32_t shentsize = 0, shnum = 0, shstrndx = 0, sh_name = 0;
+    char *res = NULL, name[16];
+
+    if (fp == NULL || fread(ident, 1, EI_NIDENT, fp) != EI_NIDENT || memcmp(ident, ELFMAG, SELFMAG) != 0)
+    {
+        goto out;
+    }
+    rewind(fp);
+    if (ident[EI_CLASS] == ELFCLASS32)
+    {
+        Elf32_Ehdr eh;
+        if (fread(&eh, sizeof(eh), 1, fp) != 1)
+        {
+            goto out;
+        }
+        shoff = eh.e_shoff;
+        shentsize = eh.e_shentsize;
+        shnum = eh.e_shnum;
+        shstrndx = eh.e_shstrndx;
+    }
+    else
+    {
+        Elf64_Ehdr eh;
+        if (fread(&eh, sizeof(eh), 1, fp) != 1)
+        {
+            goto out;
+        }
+        shoff = eh.e_shoff;
+        shentsize = eh.e_shentsize;
+        shnum = eh.e_shnum;
+        shstrndx = eh.e_shstrndx;
+    }
+
+    // 先找段名字符串表, 再逐个比较段名
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (uint32_t i = (pass == 0) ? shstrndx : 0; i < shnum; ++i)
+        {
+            if (fseek(fp, (long)(shoff + (uint64_t)i * shentsize), SEEK_SET) != 0)
+            {
+                goto out;
+            }
+            if (ident[EI_CLASS] == ELFCLASS32)
+            {
+                Elf32_Shdr sh;
+                if (fread(&sh, sizeof(sh), 1, fp) != 1)
+                {
+                    goto out;
+                }
+                sh_name = sh.sh_name;
+                sh_offset = sh.sh_offset;
+                sh_size = sh.sh_size;
+            }
+            else
+            {
+                Elf64_Shdr sh;
+                if (fread(&sh, sizeof(sh), 1, fp) != 1)
+                {
+                    goto out;
+                }
+                sh_name = sh.sh_name;
+                sh_offset = sh.sh_offset;
+                sh_size = sh.sh_size;
+            }
+            if (pass == 0)
+            {
+                str_offset = sh_offset;
+                break;
+            }
+            memset(name, 0, sizeof(name));
+            if (fseek(fp, (long)(str_offset + sh_name), SEEK_SET) != 0 || fread(name, 1, sizeof(name) - 1, fp) == 0)
+            {
+                goto out;
+            }
+            if (strcmp(name, ".lib_log") == 0)
+            {
+                res = malloc(sh_size + 1);
+                if (res == NULL || fseek(fp, (long)sh_offset, SEEK_SET) != 0 || fread(res, 1, sh_size, fp) != sh_size)
+                {
+                    free(res);
+                    res = NULL;
+                    goto out;
+                }
+                res[sh_size] = '\0';
+                *size = (uint32_t)sh_size;
+                goto out;
+            }
+        }
+    }
+out:
+    if (fp != NULL)
+    {
+        fclose(fp);
+    }
+    return res;
+}
+
+// 读取一个 varint; 失败返回 -1
+static int Log_Tool_Get_Varint(const uint8_t *const data, const uint32_t num, uint32_t *const p, uint32_t *const value)
+{
+    uint32_t res = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (*p >= num)
+        {
+            return -1;
+        }
+        res |= (uint32_t)(data[*p] & 0x7F) << shift;
+        if ((data[(*p)++] & 0x80) == 0)
+        {
+            *value = res;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * @brief   按格式字符串还原一条记录
+ * @param   args/num 记录中参数部分
+ *          out      输出缓冲区
+ * @return  文本长度; 参数个数不符或格式不支持时返回 -1
+*/
+static int Log_Tool_Format(const char *fmt, const uint8_t *const args, const uint32_t num, char *const out, const size_t size)
+{
+    uint32_t p = 0, value = 0;
+    size_t len = 0;
+    char spec[32], conv = 0;
+    size_t spec_len = 0;
+    int32_t signed_value = 0;
+
+    while (*fmt != '\0' && len + 1 < size)
+    {
+        if (*fmt != '%')
+        {
+            out[len++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%')
+        {
+            out[len++] = '%';
+            fmt += 2;
+            continue;
+        }
+        // 复制 "%[标志][宽度][.精度]", 去掉长度修饰, 参数统一按 32 位处理
+        spec_len = 0;
+        spec[spec_len++] = *fmt++;
+        while (*fmt != '\0' && strchr("-0+ #.123456789", *fmt) != NULL && spec_len < sizeof(spec) - 3)
+        {
+            spec[spec_len++] = *fmt++;
+        }
+        while (*fmt == 'h' || *fmt == 'l')
+        {
+            ++fmt;
+        }
+        conv = *fmt++;
+        if (strchr("diuxXc", conv) == NULL || conv == '\0')
+        {
+            return -1;
+        }
+        if (Log_Tool_Get_Varint(args, num, &p, &value) != 0)
+        {
+            return -1;
+        }
+        signed_value = (int32_t)((value >> 1) ^ (0U - (value & 1)));   // zigzag 解码
+        spec[spec_len++] = conv;
+        spec[spec_len] = '\0';
+        if (conv == 'd' || conv == 'i' || conv == 'c')
+        {
+            len += (size_t)snprintf(&out[len], size - len, spec, (int)signed_value);
+        }
+        else
+        {
+            len += (size_t)snprintf(&out[len], size - len, spec, (unsigned)signed_value);
+        }
+        if (len >= size)
+        {
+            len = size - 1;
+        }
+    }
+    out[len] = '\0';
+    return p == num ? (int)len : -1;
+}
+
+// 处理两个 0x00 之间的一段数据
+static void Log_Tool_Chunk(Log_Tool_Type *const log)
+{
+    uint8_t raw[LOG_TOOL_CHUNK_MAXSIZE];
+    char text[4096];
+    int32_t num = 0;
+    int len = 0;
+    uint32_t p = 0, id = 0, dt = 0;
+
+    if (log->chunk_num == 0)
+    {
+        return;
+    }
+    num = Lib_Frame_COBS_Decode(log->chunk, log->chunk_num, raw);
+    if (num < 3 || (uint8_t)Lib_Frame_CRC16(raw, (uint32_t)num - 1, 0xFFFF) != raw[num - 1]
+        || Log_Tool_Get_Varint(raw, (uint32_t)num - 1, &p, &id) != 0
+        || Log_Tool_Get_Varint(raw, (uint32_t)num - 1, &p, &dt) != 0 || id >= log->strings_size)
+    {
+        fwrite(log->chunk, 1, log->chunk_num, stdout);   // 不是记录, 原样输出
+        log->chunk_num = 0;
+        return;
+    }
+    len = Log_Tool_Format(&log->strings[id], &raw[p], (uint32_t)num - 1 - p, text, sizeof(text));
+    if (len < 0)
+    {
+        ++log->num_errors;
+        fprintf(stderr, "bad record: id %u \"%s\"\n", id, &log->strings[id]);
+    }
+    else
+    {
+        log->time += dt;
+        printf("[%12.6f] %s", log->time / log->freq, text);
+        fflush(stdout);
+        ++log->num_records;
+        log->num_out += (uint64_t)len;
+    }
+    log->chunk_num = 0;
+}
+
+static void Log_Tool_Input(Log_Tool_Type *const log, const uint8_t *const data, const uint32_t num)
+{
+    log->num_in += num;
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        if (data[i] == LIB_FRAME_DELIMITER)
+        {
+            Log_Tool_Chunk(log);
+            continue;
+        }
+        if (log->chunk_num == LOG_TOOL_CHUNK_MAXSIZE)
+        {
+            fwrite(log->chunk, 1, log->chunk_num, stdout);   // 不是记录, 原样输出
+            log->chunk_num = 0;
+        }
+        log->chunk[log->chunk_num++] = data[i];
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    Log_Tool_Type *log = calloc(1, sizeof(Log_Tool_Type));
+    uint8_t buffer[256];
+    uint32_t baud = 115200;
+    int fd = 0, num = 0, from_stdin = 0;
+
+    if (argc < 3 || log == NULL)
+    {
+        fprintf(stderr, "usage: %s <elf> <device | -> [-b baud] [-f timestamp_hz]\n", argv[0]);
+        return 1;
+    }
+    log->freq = 72000000.0 / 1024;  // LIB_LOG_TIME_SHIFT 为 10
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-b") == 0)
+        {
+            baud = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-f") == 0)
+        {
+            log->freq = strtod(argv[i + 1], NULL);
+        }
+    }
+    log->strings = Log_Tool_Load_Strings(argv[1], &log->strings_size);
+    if (log->strings == NULL)
+    {
+        fprintf(stderr, "%s: no .lib_log section\n", argv[1]);
+        return 1;
+    }
+
+    from_stdin = strcmp(argv[2], "-") == 0;
+    fd = from_stdin ? STDIN_FILENO : Host_Serial_Open(argv[2], baud);
+    if (fd < 0)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    while (1)
+    {
+        num = from_stdin ? (int)read(fd, buffer, sizeof(buffer)) : Host_Serial_Read(fd, buffer, sizeof(buffer), 1000);
+        if (num < 0 || (from_stdin && num == 0))
+        {
+            break;
+        }
+        Log_Tool_Input(log, buffer, (uint32_t)num);
+    }
+    Log_Tool_Chunk(log);
+    if (from_stdin)
+    {
+        fprintf(stderr, "%u records, %u errors, %llu bytes in, %llu bytes of text (%.1fx)\n",
+                log->num_records, log->num_errors, (unsigned long long)log->num_in,
+                (unsigned long long)log->num_out, log->num_in ? (double)log->num_out / log->num_in : 0.0);
+    }
+    else
+    {
+        Host_Serial_Close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef _SPI_QUEUE_PORT_H
+#define _SPI_QUEUE_PORT_H
+
+/*
+ * @brief   lib_spi_queue.c 在上位机上的接口, 由 spi_queue_sim.c 实现, 代替 lib_spi.h
+*/
+#include <stdint.h>
+
+typedef enum
+{
+    SUCCESS = 0U,
+    ERROR = !SUCCESS
+} ErrorStatus;
+
+#define LIB_SPI_DUMMY    0x00
+
+typedef void (*Lib_SPI_Callback_Type)(void *const arg, const ErrorStatus status);
+
+// 模拟的设备, 只用于区分片选
+typedef struct
+{
+    char name;
+    uintptr_t cs_port;
+    uint32_t cs_pin;
+} Lib_SPI_Device_Type;
+
+ErrorStatus Sim_SPI_Begin(const Lib_SPI_Device_Type *const dev);
+void Sim_SPI_End(const Lib_SPI_Device_Type *const dev);
+void Sim_SPI_Transfer(const Lib_SPI_Device_Type *const dev, const uint8_t *const tx, uint8_t *const rx,
+                      const uint32_t num, const Lib_SPI_Callback_Type callback, void *const arg);
+
+#define Lib_SPI_Queue_Begin(dev)                                Sim_SPI_Begin(dev)
+#define Lib_SPI_Queue_End(dev)                                  Sim_SPI_End(dev)
+#define Lib_SPI_Queue_Transfer(dev, tx, rx, num, callback, arg) Sim_SPI_Transfer(dev, tx, rx, num, callback, arg)
+#define Lib_SPI_Queue_Lock(primask)                             ((void)(primask))
+#define Lib_SPI_Queue_Unlock(primask)                           ((void)(primask))
+
+#endif
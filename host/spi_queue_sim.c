@@ -0,0 +1,390 @@
+/*
+ * @brief   lib_spi_queue.c 的上位机模拟: 用模拟的 SPI 总线检查描述符的顺序, 片选, 取消, 总线占用和传输失败
+ * @note    编译: gcc -O2 -Wall -I. -I../libs/include -DLIB_SPI_QUEUE_PORT='"spi_queue_port.h"'
+ *                    -o spi_queue_sim spi_queue_sim.c ../libs/source/lib_spi_queue.c
+ *          用法: spi_queue_sim, 全部通过时返回 0
+ *          总线上的通信记录为文本: "A[" 表示设备 A 拉低片选, "]" 表示拉高, 中间是发送的字节
+ *          传输有两种完成方式: 同步 (不使用 DMA, 回调在传输函数中调用) 和异步 (模拟 DMA 中断, 由 Sim_Run() 逐个完成)
+*/
+#include "lib_spi_queue.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_LOG_SIZE    1024
+#define SIM_ORDER_SIZE  16
+
+static const Lib_SPI_Device_Type Sim_Dev_A = {'A', 1, 4};
+static const Lib_SPI_Device_Type Sim_Dev_B = {'B', 2, 12};
+
+static struct
+{
+    uint8_t async;                  // 1: 传输由 Sim_Run() 完成
+    uint8_t locked;                 // 总线是否被占用
+    uint8_t external;               // 总线被队列之外的调用者占用
+    char cs;                        // 拉低片选的设备, 0 表示没有
+    uint8_t next_rx;                // 设备返回的数据, 每个字节加 1
+    Lib_SPI_Callback_Type callback; // 未完成的异步传输
+    void *arg;
+    ErrorStatus status;             // 未完成的异步传输的结果
+    uint32_t transfers;             // 已开始的传输次数
+    uint32_t fail_mask;             // 第 n 次传输 (从 0 开始) 失败时 bit n 为 1, 相当于 DMA 传输错误
+    uint32_t nested;                // 回调嵌套深度
+    uint32_t max_nested;
+    char log[SIM_LOG_SIZE];
+    char order[SIM_ORDER_SIZE];     // 完成回调的顺序, 取消的记为小写, 失败的后跟 '!'
+    uint32_t failed;
+} Sim;
+
+static void Sim_Log(const char *const str)
+{
+    strncat(Sim.log, str, SIM_LOG_SIZE - strlen(Sim.log) - 1);
+}
+
+ErrorStatus Sim_SPI_Begin(const Lib_SPI_Device_Type *const dev)
+{
+    char str[3] = {dev->name, '[', '\0'};
+
+    if (Sim.locked)
+    {
+        return ERROR;
+    }
+    Sim.locked = 1;
+    Sim.cs = dev->name;
+    Sim_Log(str);
+    return SUCCESS;
+}
+
+void Sim_SPI_End(const Lib_SPI_Device_Type *const dev)
+{
+    if (Sim.cs != dev->name)
+    {
+        printf("  End(%c) while %c selected\n", dev->name, Sim.cs ? Sim.cs : '-');
+        ++Sim.failed;
+    }
+    Sim.locked = 0;
+    Sim.cs = 0;
+    Sim_Log("]");
+}
+
+void Sim_SPI_Transfer(const Lib_SPI_Device_Type *const dev, const uint8_t *const tx, uint8_t *const rx,
+                      const uint32_t num, const Lib_SPI_Callback_Type callback, void *const arg)
+{
+    char str[4];
+    ErrorStatus status = (Sim.fail_mask >> (Sim.transfers++ & 31)) & 1 ? ERROR : SUCCESS;
+
+    if (Sim.cs != dev->name || Sim.callback != NULL)
+    {
+        printf("  Transfer(%c) while %c selected or busy\n", dev->name, Sim.cs ? Sim.cs : '-');
+        ++Sim.failed;
+    }
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        snprintf(str, sizeof(str), "%02X ", tx != NULL ? tx[i] : LIB_SPI_DUMMY);
+        Sim_Log(str);
+        if (rx != NULL)
+        {
+            rx[i] = Sim.next_rx++;
+        }
+    }
+    if (Sim.async)
+    {
+        Sim.callback = callback;
+        Sim.arg = arg;
+        Sim.status = status;
+        return;
+    }
+    ++Sim.nested;
+    Sim.max_nested = Sim.nested > Sim.max_nested ? Sim.nested : Sim.max_nested;
+    callback(arg, status);
+    --Sim.nested;
+}
+
+// 完成所有异步传输, 相当于依次进入 DMA 中断
+static void Sim_Run(void)
+{
+    while (Sim.callback != NULL)
+    {
+        Lib_SPI_Callback_Type callback = Sim.callback;
+        Sim.callback = NULL;
+        callback(Sim.arg, Sim.status);
+    }
+}
+
+static void Sim_Reset(const uint8_t async)
+{
+    memset(&Sim, 0, sizeof(Sim));
+    Sim.async = async;
+}
+
+// 完成回调: 按 arg 记录顺序
+static void Sim_Callback(Lib_SPI_Queue_Trans_Type *const trans)
+{
+    char str[3] = {*(const char *)trans->arg, '\0', '\0'};
+
+    if (trans->result == LIB_SPI_QUEUE_RES_CANCELLED)
+    {
+        str[0] += 'a' - 'A';
+    }
+    else if (trans->result == LIB_SPI_QUEUE_RES_ERROR)
+    {
+        str[1] = '!';
+    }
+    strncat(Sim.order, str, SIM_ORDER_SIZE - strlen(Sim.order) - 1);
+}
+
+static void Sim_Check(const char *const name, const char *const log, const char *const order)
+{
+    uint8_t ok = Sim.failed == 0 && strcmp(Sim.log, log) == 0 && strcmp(Sim.order, order) == 0;
+
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    if (!ok)
+    {
+        printf("  log   %s\n  want  %s\n  order %s, want %s\n", Sim.log, log, Sim.order, order);
+        ++Sim.failed;
+    }
+}
+
+static uint32_t failed;
+
+static void Sim_Done(void)
+{
+    failed += Sim.failed;
+}
+
+// 与 W25Q64 的 READ_DATA 相同: 指令 + 3 字节地址 + 数据
+static void Sim_Read(Lib_SPI_Queue_Trans_Type *const t, const Lib_SPI_Device_Type *const dev, uint8_t *const rx,
+                     const uint32_t num, const char *const tag)
+{
+    memset(t, 0, sizeof(*t));
+    t->dev = dev;
+    t->flags = LIB_SPI_QUEUE_CMD;
+    t->cmd = 0x03;
+    t->addr = 0x012345;
+    t->addr_len = 3;
+    t->rx = rx;
+    t->num = num;
+    t->callback = Sim_Callback;
+    t->arg = (void *)tag;
+}
+
+static void Sim_Write(Lib_SPI_Queue_Trans_Type *const t, const Lib_SPI_Device_Type *const dev, const uint8_t *const tx,
+                      const uint32_t num, const char *const tag)
+{
+    memset(t, 0, sizeof(*t));
+    t->dev = dev;
+    t->tx = tx;
+    t->num = num;
+    t->callback = Sim_Callback;
+    t->arg = (void *)tag;
+}
+
+// 两个设备交替, 按提交顺序完成, 每个描述符一个片选周期
+static void Test_Order(const uint8_t async)
+{
+    static const uint8_t data[2] = {0xAA, 0x55};
+    Lib_SPI_Queue_Type queue;
+    Lib_SPI_Queue_Trans_Type t[3];
+    uint8_t rx[2][2];
+
+    Sim_Reset(async);
+    Lib_SPI_Queue_Init(&queue);
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 2, "1");
+    Sim_Write(&t[1], &Sim_Dev_B, data, 2, "2");
+    Sim_Read(&t[2], &Sim_Dev_A, rx[1], 2, "3");
+    for (int i = 0; i < 3; ++i)
+    {
+        Lib_SPI_Queue_Submit(&queue, &t[i]);
+    }
+    Sim_Run();
+    if (!Lib_SPI_Queue_Is_Idle(&queue) || rx[0][0] != 0 || rx[0][1] != 1 || rx[1][0] != 2 || rx[1][1] != 3)
+    {
+        ++Sim.failed;
+    }
+    Sim_Check(async ? "order (async)" : "order (sync)",
+              "A[03 01 23 45 00 00 ]B[AA 55 ]A[03 01 23 45 00 00 ]", "123");
+    Sim_Done();
+}
+
+// CS_HOLD: 指令 + 空周期 + 读到两个缓冲区, 只有一个片选周期; 之后的其他设备先结束它
+static void Test_Hold(const uint8_t async)
+{
+    Lib_SPI_Queue_Type queue;
+    Lib_SPI_Queue_Trans_Type t[3];
+    uint8_t rx[2][2];
+    static const uint8_t data[1] = {0x5A};
+
+    Sim_Reset(async);
+    Lib_SPI_Queue_Init(&queue);
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 2, "1");
+    t[0].cmd = 0x0B;
+    t[0].dummy_len = 1;
+    t[0].flags |= LIB_SPI_QUEUE_CS_HOLD;
+    Sim_Read(&t[1], &Sim_Dev_A, rx[1], 2, "2");
+    t[1].flags = 0;
+    t[1].addr_len = 0;
+    t[1].flags |= LIB_SPI_QUEUE_CS_HOLD;
+    Sim_Write(&t[2], &Sim_Dev_B, data, 1, "3");
+    for (int i = 0; i < 3; ++i)
+    {
+        Lib_SPI_Queue_Submit(&queue, &t[i]);
+    }
+    Sim_Run();
+    Sim_Check(async ? "cs hold (async)" : "cs hold (sync)", "A[0B 01 23 45 00 00 00 00 00 ]B[5A ]", "123");
+    Sim_Done();
+}
+
+// 正在传输的不能取消; 等待中的取消后立即回调, 不出现在总线上
+static void Test_Cancel(void)
+{
+    Lib_SPI_Queue_Type queue;
+    Lib_SPI_Queue_Trans_Type t[3];
+    uint8_t rx[3][1];
+
+    Sim_Reset(1);
+    Lib_SPI_Queue_Init(&queue);
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 1, "A");
+    Sim_Read(&t[1], &Sim_Dev_B, rx[1], 1, "B");
+    Sim_Read(&t[2], &Sim_Dev_A, rx[2], 1, "C");
+    for (int i = 0; i < 3; ++i)
+    {
+        Lib_SPI_Queue_Submit(&queue, &t[i]);
+    }
+    if (Lib_SPI_Queue_Cancel(&queue, &t[0]) != ERROR || Lib_SPI_Queue_Cancel(&queue, &t[1]) != SUCCESS
+        || t[1].result != LIB_SPI_QUEUE_RES_CANCELLED)
+    {
+        ++Sim.failed;
+    }
+    Sim_Run();
+    // 已完成的不能再取消; 取消最后一个后, 新提交的仍然能接到队尾
+    if (Lib_SPI_Queue_Cancel(&queue, &t[0]) != ERROR)
+    {
+        ++Sim.failed;
+    }
+    Sim_Check("cancel", "A[03 01 23 45 00 ]A[03 01 23 45 00 ]", "bAC");
+    Sim_Done();
+
+    Sim_Reset(1);
+    Lib_SPI_Queue_Init(&queue);
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 1, "A");
+    Sim_Read(&t[1], &Sim_Dev_B, rx[1], 1, "B");
+    Sim_Read(&t[2], &Sim_Dev_A, rx[2], 1, "C");
+    Lib_SPI_Queue_Submit(&queue, &t[0]);
+    Lib_SPI_Queue_Submit(&queue, &t[1]);
+    Lib_SPI_Queue_Cancel(&queue, &t[1]);
+    Lib_SPI_Queue_Submit(&queue, &t[2]);
+    Sim_Run();
+    Sim_Check("cancel tail", "A[03 01 23 45 00 ]A[03 01 23 45 00 ]", "bAC");
+    Sim_Done();
+}
+
+// 总线被其他调用者占用时暂停, Lib_SPI_Queue_Poll() 后继续; 等待总线的队首可以取消
+static void Test_Busy(void)
+{
+    Lib_SPI_Queue_Type queue;
+    Lib_SPI_Queue_Trans_Type t[2];
+    uint8_t rx[2][1];
+
+    Sim_Reset(1);
+    Lib_SPI_Queue_Init(&queue);
+    Sim.locked = 1;
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 1, "A");
+    Sim_Read(&t[1], &Sim_Dev_B, rx[1], 1, "B");
+    Lib_SPI_Queue_Submit(&queue, &t[0]);
+    Lib_SPI_Queue_Submit(&queue, &t[1]);
+    Sim_Run();
+    if (Sim.log[0] != '\0' || Lib_SPI_Queue_Is_Idle(&queue) || Lib_SPI_Queue_Cancel(&queue, &t[0]) != SUCCESS)
+    {
+        ++Sim.failed;
+    }
+    Lib_SPI_Queue_Poll(&queue);
+    Sim_Run();
+    Sim.locked = 0;
+    Lib_SPI_Queue_Poll(&queue);
+    Sim_Run();
+    Sim_Check("bus busy", "B[03 01 23 45 00 ]", "aB");
+    Sim_Done();
+}
+
+// 传输失败: 跳过剩余阶段, 即使有 CS_HOLD 也拉高片选, 以 LIB_SPI_QUEUE_RES_ERROR 回调; 之后的描述符不受影响
+static void Test_Error(const uint8_t async)
+{
+    Lib_SPI_Queue_Type queue;
+    Lib_SPI_Queue_Trans_Type t[3];
+    uint8_t rx[3][2];
+
+    Sim_Reset(async);
+    Lib_SPI_Queue_Init(&queue);
+    Sim.fail_mask = (1U << 0) | (1U << 2);  // 第一个的指令阶段, 第二个的数据阶段
+    Sim_Read(&t[0], &Sim_Dev_A, rx[0], 2, "1");
+    Sim_Read(&t[1], &Sim_Dev_A, rx[1], 1, "2");
+    t[1].flags |= LIB_SPI_QUEUE_CS_HOLD;
+    Sim_Read(&t[2], &Sim_Dev_A, rx[2], 1, "3");
+    for (int i = 0; i < 3; ++i)
+    {
+        Lib_SPI_Queue_Submit(&queue, &t[i]);
+    }
+    Sim_Run();
+    if (!Lib_SPI_Queue_Is_Idle(&queue) || Sim.locked || t[2].result != LIB_SPI_QUEUE_RES_OK)
+    {
+        ++Sim.failed;
+    }
+    Sim_Check(async ? "error (async)" : "error (sync)",
+              "A[03 01 23 45 ]A[03 01 23 45 00 ]A[03 01 23 45 00 ]", "1!2!3");
+    Sim_Done();
+}
+
+// 在回调中提交下一个描述符; 同步完成时回调嵌套深度不随描述符个数增长
+static Lib_SPI_Queue_Type Chain_Queue;
+static Lib_SPI_Queue_Trans_Type Chain_Trans[8];
+static uint8_t Chain_RX[8];
+static int Chain_Count;
+
+static void Chain_Callback(Lib_SPI_Queue_Trans_Type *const trans)
+{
+    Sim_Callback(trans);
+    if (++Chain_Count < 8)
+    {
+        Lib_SPI_Queue_Submit(&Chain_Queue, &Chain_Trans[Chain_Count]);
+    }
+}
+
+static void Test_Chain(const uint8_t async)
+{
+    static const char tags[] = "12345678";
+
+    Sim_Reset(async);
+    Lib_SPI_Queue_Init(&Chain_Queue);
+    Chain_Count = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        Sim_Write(&Chain_Trans[i], i % 2 ? &Sim_Dev_B : &Sim_Dev_A, NULL, 0, &tags[i]);
+        Chain_Trans[i].rx = &Chain_RX[i];
+        Chain_Trans[i].num = 1;
+        Chain_Trans[i].callback = Chain_Callback;
+    }
+    Lib_SPI_Queue_Submit(&Chain_Queue, &Chain_Trans[0]);
+    Sim_Run();
+    if (Sim.max_nested > 1)
+    {
+        printf("  nested callbacks: %u\n", Sim.max_nested);
+        ++Sim.failed;
+    }
+    Sim_Check(async ? "chain (async)" : "chain (sync)",
+              "A[00 ]B[00 ]A[00 ]B[00 ]A[00 ]B[00 ]A[00 ]B[00 ]", "12345678");
+    Sim_Done();
+}
+
+int main(void)
+{
+    for (uint8_t async = 0; async < 2; ++async)
+    {
+        Test_Order(async);
+        Test_Hold(async);
+        Test_Chain(async);
+        Test_Error(async);
+    }
+    Test_Cancel();
+    Test_Busy();
+    printf("%s\n", failed ? "FAILED" : "all passed");
+    return failed ? 1 : 0;
+}
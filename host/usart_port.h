@@ -0,0 +1,226 @@
+#ifndef _USART_PORT_H
+#define _USART_PORT_H
+
+/*
+ * @brief   lib_usart.c 在上位机上的接口, 由 usart_sim.c 实现, 代替 LL 库, CMSIS, lib_tool.h 和 lib_rtc.h
+ * @note    1) 寄存器只模拟用到的 SR, DR 和 GPIO 的输出; 配置函数不做任何事
+ *          2) DMA 通道 4 (发送) 由单独的线程按模拟的波特率搬运, 通道 5 (接收) 由 Sim_RX_Byte() 写入
+ *          3) 屏蔽中断用一个互斥锁模拟, 中断服务函数在持有该锁时调用, 见 Sim_Interrupt()
+*/
+#include <stdint.h>
+
+// 打开流控, 发送 DMA, 接收 DMA, 中断和指令
+#define LIB_USART_FLOW_EN        1
+#define LIB_USART_IT_EN          1
+#define LIB_USART_IT_RX_EN       0
+#define LIB_USART_DMA_EN         1
+#define LIB_USART_DMA_RX_EN      1
+#define LIB_USART_CMD_EN         1
+
+typedef enum
+{
+    SUCCESS = 0U,
+    ERROR = !SUCCESS
+} ErrorStatus;
+
+#define RESET    0U
+#define SET      1U
+
+// 寄存器
+typedef struct
+{
+    volatile uint32_t SR;
+    volatile uint32_t DR;
+} USART_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    uint32_t unused;
+} DMA_TypeDef;
+
+extern USART_TypeDef Sim_USART1, Sim_USART2, Sim_USART3;
+extern GPIO_TypeDef Sim_GPIOA, Sim_GPIOB;
+extern DMA_TypeDef Sim_DMA1;
+#define USART1    (&Sim_USART1)
+#define USART2    (&Sim_USART2)
+#define USART3    (&Sim_USART3)
+#define GPIOA     (&Sim_GPIOA)
+#define GPIOB     (&Sim_GPIOB)
+#define DMA1      (&Sim_DMA1)
+
+#define USART_SR_PE      0x001U
+#define USART_SR_FE      0x002U
+#define USART_SR_NE      0x004U
+#define USART_SR_ORE     0x008U
+#define USART_SR_IDLE    0x010U
+#define USART_SR_RXNE    0x020U
+#define USART_SR_TC      0x040U
+#define USART_SR_TXE     0x080U
+
+typedef enum
+{
+    USART1_IRQn = 37,
+    USART2_IRQn = 38,
+    USART3_IRQn = 39,
+    DMA1_Channel4_IRQn = 14,
+    DMA1_Channel5_IRQn = 15,
+} IRQn_Type;
+
+// 时钟和引脚, 只用于填写实例表
+#define LL_APB1_GRP1_PERIPH_USART2    0x00020000U
+#define LL_APB1_GRP1_PERIPH_USART3    0x00040000U
+#define LL_APB2_GRP1_PERIPH_GPIOA     0x00000004U
+#define LL_APB2_GRP1_PERIPH_GPIOB     0x00000008U
+#define LL_APB2_GRP1_PERIPH_USART1    0x00004000U
+#define LL_AHB1_GRP1_PERIPH_DMA1      0x00000001U
+#define LL_GPIO_PIN_2                 (1U << 2)
+#define LL_GPIO_PIN_3                 (1U << 3)
+#define LL_GPIO_PIN_9                 (1U << 9)
+#define LL_GPIO_PIN_10                (1U << 10)
+#define LL_GPIO_PIN_11                (1U << 11)
+#define LL_GPIO_PIN_12                (1U << 12)
+
+// 配置: 结构体只保留 lib_usart.c 填写的成员, 常量的值无关紧要
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+} LL_GPIO_InitTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t DataWidth;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t TransferDirection;
+    uint32_t HardwareFlowControl;
+} LL_USART_InitTypeDef;
+
+typedef struct
+{
+    uintptr_t PeriphOrM2MSrcAddress;
+    uintptr_t MemoryOrM2MDstAddress;
+    uint32_t Direction;
+    uint32_t Mode;
+    uint32_t PeriphOrM2MSrcIncMode;
+    uint32_t MemoryOrM2MDstIncMode;
+    uint32_t PeriphOrM2MSrcDataSize;
+    uint32_t MemoryOrM2MDstDataSize;
+    uint32_t NbData;
+    uint32_t Priority;
+} LL_DMA_InitTypeDef;
+
+#define LL_GPIO_MODE_FLOATING                 0
+#define LL_GPIO_MODE_OUTPUT                   1
+#define LL_GPIO_MODE_ALTERNATE                2
+#define LL_GPIO_OUTPUT_PUSHPULL               0
+#define LL_GPIO_SPEED_FREQ_HIGH               0
+#define LL_USART_DATAWIDTH_8B                 0
+#define LL_USART_PARITY_NONE                  0
+#define LL_USART_STOPBITS_1                   0
+#define LL_USART_DIRECTION_TX_RX              0
+#define LL_USART_HWCONTROL_NONE               0
+#define LL_USART_HWCONTROL_CTS                1
+#define LL_DMA_CHANNEL_4                      4
+#define LL_DMA_CHANNEL_5                      5
+#define LL_DMA_PRIORITY_VERYHIGH              0
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY     0
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH     1
+#define LL_DMA_MODE_NORMAL                    0
+#define LL_DMA_MODE_CIRCULAR                  1
+#define LL_DMA_PERIPH_NOINCREMENT             0
+#define LL_DMA_MEMORY_INCREMENT               1
+#define LL_DMA_PDATAALIGN_BYTE                0
+#define LL_DMA_MDATAALIGN_BYTE                0
+
+#define LL_APB1_GRP1_EnableClock(periph)              ((void)(periph))
+#define LL_APB2_GRP1_EnableClock(periph)              ((void)(periph))
+#define LL_AHB1_GRP1_EnableClock(periph)              ((void)(periph))
+#define LL_GPIO_Init(port, config)                    ((void)(port), (void)(config))
+#define LL_GPIO_SetOutputPin(port, pin)               ((port)->ODR |= (pin))
+#define LL_GPIO_ResetOutputPin(port, pin)             ((port)->ODR &= ~(uint32_t)(pin))
+#define NVIC_GetPriorityGrouping()                    0U
+#define NVIC_EncodePriority(group, preempt, sub)      ((void)(group), (uint32_t)((preempt) << 2 | (sub)))
+#define NVIC_SetPriority(irq, priority)               ((void)(irq), (void)(priority))
+#define NVIC_EnableIRQ(irq)                           ((void)(irq))
+
+#define LL_USART_Init(usart, config)                  ((void)(usart), (void)(config))
+#define LL_USART_Enable(usart)                        ((void)(usart))
+#define LL_USART_Disable(usart)                       ((void)(usart))
+#define LL_USART_EnableIT_RXNE(usart)                 ((void)(usart))
+#define LL_USART_EnableIT_IDLE(usart)                 ((void)(usart))
+#define LL_USART_EnableIT_ERROR(usart)                ((void)(usart))
+#define LL_USART_EnableDMAReq_TX(usart)               ((void)(usart))
+#define LL_USART_EnableDMAReq_RX(usart)               ((void)(usart))
+#define LL_USART_ReadReg(usart, reg)                  ((usart)->reg)
+#define LL_USART_IsActiveFlag_TXE(usart)              SET
+#define LL_USART_IsActiveFlag_TC(usart)               SET
+#define LL_USART_TransmitData8(usart, data)           Sim_USART_Transmit(usart, data)
+#define LL_USART_ReceiveData8(usart)                  Sim_USART_Receive(usart)
+#define LL_USART_SetBaudRate(usart, pclk, baud)       Sim_USART_Set_Baud(usart, pclk, baud)
+
+#define LL_DMA_Init(dma, ch, config)                  Sim_DMA_Init(ch, config)
+#define LL_DMA_EnableIT_TC(dma, ch)                   ((void)(ch))
+#define LL_DMA_EnableIT_HT(dma, ch)                   ((void)(ch))
+#define LL_DMA_EnableChannel(dma, ch)                 Sim_DMA_Enable(ch, 1)
+#define LL_DMA_DisableChannel(dma, ch)                Sim_DMA_Enable(ch, 0)
+#define LL_DMA_SetMemoryAddress(dma, ch, addr)        Sim_DMA_Set_Address(ch, addr)
+#define LL_DMA_SetDataLength(dma, ch, num)            Sim_DMA_Set_Length(ch, num)
+#define LL_DMA_GetDataLength(dma, ch)                 Sim_DMA_Get_Length(ch)
+#define LL_DMA_IsActiveFlag_TC4(dma)                  Sim_DMA_Flag(4, SIM_DMA_FLAG_TC, 0)
+#define LL_DMA_ClearFlag_TC4(dma)                     Sim_DMA_Flag(4, SIM_DMA_FLAG_TC, 1)
+#define LL_DMA_IsActiveFlag_HT5(dma)                  Sim_DMA_Flag(5, SIM_DMA_FLAG_HT, 0)
+#define LL_DMA_ClearFlag_HT5(dma)                     Sim_DMA_Flag(5, SIM_DMA_FLAG_HT, 1)
+#define LL_DMA_IsActiveFlag_TC5(dma)                  Sim_DMA_Flag(5, SIM_DMA_FLAG_TC, 0)
+#define LL_DMA_ClearFlag_TC5(dma)                     Sim_DMA_Flag(5, SIM_DMA_FLAG_TC, 1)
+#define Lib_USART_DMA_Addr(p)                         ((uintptr_t)(p))
+
+// 时钟: APB2 为 72 MHz, APB1 为 36 MHz
+typedef struct
+{
+    uint32_t SYSCLK_Frequency;
+    uint32_t HCLK_Frequency;
+    uint32_t PCLK1_Frequency;
+    uint32_t PCLK2_Frequency;
+} LL_RCC_ClocksTypeDef;
+
+#define LL_RCC_GetSystemClocksFreq(clocks)            Sim_RCC_Get_Clocks(clocks)
+
+#define __get_PRIMASK()                               Sim_Get_PRIMASK()
+#define __disable_irq()                               Sim_Disable_IRQ()
+#define __set_PRIMASK(primask)                        Sim_Set_PRIMASK(primask)
+
+#define Lib_Tool_DWT_Timer_Start()                    Sim_Clock_Cycles()
+#define Lib_Tool_DWT_Timer_End(start, is_us)          Sim_Clock_Elapsed(start, is_us)
+
+#define Lib_RTC_UnixType                              int32_t
+
+#define SIM_DMA_FLAG_HT    0x1U
+#define SIM_DMA_FLAG_TC    0x2U
+
+void Sim_USART_Transmit(USART_TypeDef *const usart, const uint8_t data);
+uint8_t Sim_USART_Receive(USART_TypeDef *const usart);
+void Sim_USART_Set_Baud(USART_TypeDef *const usart, const uint32_t pclk, const uint32_t baud);
+void Sim_RCC_Get_Clocks(LL_RCC_ClocksTypeDef *const clocks);
+void Sim_DMA_Init(const uint32_t ch, const LL_DMA_InitTypeDef *const config);
+void Sim_DMA_Enable(const uint32_t ch, const uint8_t enable);
+void Sim_DMA_Set_Address(const uint32_t ch, const uintptr_t addr);
+void Sim_DMA_Set_Length(const uint32_t ch, const uint32_t num);
+uint32_t Sim_DMA_Get_Length(const uint32_t ch);
+uint32_t Sim_DMA_Flag(const uint32_t ch, const uint32_t flag, const uint8_t clear);
+uint32_t Sim_Get_PRIMASK(void);
+void Sim_Disable_IRQ(void);
+void Sim_Set_PRIMASK(const uint32_t primask);
+uint32_t Sim_Clock_Cycles(void);
+uint32_t Sim_Clock_Elapsed(const uint32_t start, const uint8_t is_us);
+void Lib_RTC_Set_Time(const Lib_RTC_UnixType ts);
+
+#endif
@@ -0,0 +1,758 @@
+/*
+ * @brief   lib_usart.c 的上位机模拟: 用模拟的 DMA 检查发送环形缓冲区和循环 DMA 接收
+ * @note    编译: gcc -O2 -Wall -pthread -I. -I../libs/include -DLIB_USART_PORT='"usart_port.h"'
+ *                    -o usart_sim usart_sim.c host_cmd.c host_serial.c
+ *                    ../libs/source/lib_usart.c ../libs/source/lib_format.c ../libs/source/lib_frame.c
+ *          加 -DLIB_USART_TX_POLICY=1 (DROP) 或 2 (OVERWRITE) 测试其他的缓冲区满策略, 默认为 BLOCK
+ *          用法: usart_sim, 全部通过时返回 0
+ *          发送: DMA 线程每个字节用时 SIM_BYTE_NS, 写入速度约为发送的 2 倍, 发送函数会频繁遇到缓冲区满和回绕
+ *          接收: 测试逐字节调用 Sim_RX_Byte(), 在半传输, 传输完成和 IDLE 时调用中断服务函数;
+ *                Sim.dma_defer 为 1 时 DMA 中断挂起, 模拟中断响应晚于 DMA 回绕;
+ *                没有回调时检查 Lib_USART_Receive() 和 RTS 的高低水位
+ *          回环: 打开一对 pty, 发送 DMA 写入主端, 主端读到的数据经接收 DMA 和 IDLE 交给 Lib_USART_CMD_Receive(),
+ *                主循环调用 Lib_USART_CMD_Process(); 上位机一侧是 host_cmd.c, 与 cmd_tool 相同,
+ *                检查 START, RTC_UNIX, 错误结果, 流水线 PING, 波特率协商和 STAT.
+ *                pty 没有波特率, 吞吐量和往返延迟只反映协议和调度的开销.
+ *                只在 BLOCK 策略下运行: 其他策略在缓冲区满时截断应答帧, 需要上位机重发
+*/
+#define _GNU_SOURCE                 // posix_openpt()
+#include "lib_usart.h"
+#include "host_cmd.h"
+#include "host_serial.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_BYTE_NS         1000                // 发送一个字节的时间, 相当于 10 Mbps
+#define SIM_TX_MSG_NUM      400                 // 发送测试的消息数
+#define SIM_TX_MSG_MAXSIZE  300                 // 单条消息的最大长度, 大于发送缓冲区
+#define SIM_LOG_SIZE        (SIM_TX_MSG_NUM * SIM_TX_MSG_MAXSIZE)
+#define SIM_PING_NUM        2000                // 回环测试的 PING 数
+#define SIM_PING_WINDOW     3                   // 同时未应答的帧数, 小于指令队列长度
+#define SIM_PING_SIZE       32
+#define SIM_RTC_UNIX        1735689600
+#define SIM_BAUD_NEW        921600
+
+USART_TypeDef Sim_USART1, Sim_USART2, Sim_USART3;
+GPIO_TypeDef Sim_GPIOA, Sim_GPIOB;
+DMA_TypeDef Sim_DMA1;
+
+// DMA 通道
+typedef struct
+{
+    uintptr_t addr;                 // 内存地址
+    uint32_t size;                  // 初始化时的传输数, 循环模式下重新装载
+    volatile uint32_t length;       // 剩余传输数
+    volatile uint8_t enabled;
+    volatile uint32_t flags;        // SIM_DMA_FLAG_*
+} Sim_DMA_Channel_Type;
+
+static pthread_mutex_t Sim_IRQ_Lock = PTHREAD_MUTEX_INITIALIZER;   // 持有时相当于屏蔽中断
+static __thread uint32_t Sim_Masked;                                // 本线程是否持有 Sim_IRQ_Lock
+
+static struct
+{
+    Sim_DMA_Channel_Type dma[8];
+    pthread_t tx_thread;
+    volatile uint8_t running;
+    uint8_t tx_log[SIM_LOG_SIZE];   // DMA 发出的数据
+    volatile uint32_t tx_len;
+    uint32_t tx_transfers;          // DMA 传输次数
+    uint32_t tx_max_transfer;       // 单次传输的最大字节数
+    uint8_t dma_defer;              // 1: DMA 接收中断挂起, 不调用中断服务函数
+    uint8_t rx_log[SIM_LOG_SIZE];   // 回调收到的数据
+    uint32_t rx_len;
+    uint32_t rx_calls;
+    uint32_t rx_bad;                // 回调的数据超出 Lib_USART_Buffer 或长度为 0 的次数
+    int master_fd;                  // 回环测试时 pty 的主端, 发送的数据写入这里; 否则为 -1
+    volatile uint8_t host_done;     // 上位机一侧已结束
+    pthread_t line_thread;
+    pthread_t host_thread;
+    int32_t rtc;                    // Lib_RTC_Set_Time() 收到的时间
+    uint32_t baud;                  // Sim_USART_Set_Baud() 设置的波特率
+    uint32_t pclk;                  // 设置控制台波特率时使用的总线频率
+    uint32_t rx_dropped;            // 回环开始前的 rx_dropped, 之前的测试故意覆盖过数据
+} Sim = {.master_fd = -1};
+
+static uint32_t failed;
+static uint32_t Sim_Seed = 12345;
+
+static uint32_t Sim_Rand(void)
+{
+    Sim_Seed = Sim_Seed * 1103515245U + 12345U;
+    return Sim_Seed >> 8;
+}
+
+static void Sim_Check(const char *const name, const int ok)
+{
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    if (!ok)
+    {
+        ++failed;
+    }
+}
+
+// 中断服务函数在持有 Sim_IRQ_Lock 时调用, 与屏蔽中断的代码互斥
+static void Sim_Interrupt(void (*const handler)(void))
+{
+    pthread_mutex_lock(&Sim_IRQ_Lock);
+    Sim_Masked = 1;
+    handler();
+    Sim_Masked = 0;
+    pthread_mutex_unlock(&Sim_IRQ_Lock);
+}
+
+uint32_t Sim_Get_PRIMASK(void)
+{
+    return Sim_Masked;
+}
+
+void Sim_Disable_IRQ(void)
+{
+    if (!Sim_Masked)
+    {
+        pthread_mutex_lock(&Sim_IRQ_Lock);
+        Sim_Masked = 1;
+    }
+}
+
+void Sim_Set_PRIMASK(const uint32_t primask)
+{
+    if (primask == 0 && Sim_Masked)
+    {
+        Sim_Masked = 0;
+        pthread_mutex_unlock(&Sim_IRQ_Lock);
+    }
+}
+
+static uint64_t Sim_Time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// DWT 按 72 MHz 计数
+uint32_t Sim_Clock_Cycles(void)
+{
+    return (uint32_t)(Sim_Time_ns() * 72 / 1000);
+}
+
+uint32_t Sim_Clock_Elapsed(const uint32_t start, const uint8_t is_us)
+{
+    uint32_t cycles = Sim_Clock_Cycles() - start;
+
+    return is_us ? cycles / 72 : cycles / 72000;
+}
+
+// 轮询发送只用于其他实例, 这里不检查
+void Sim_USART_Transmit(USART_TypeDef *const usart, const uint8_t data)
+{
+    (void)usart;
+    (void)data;
+}
+
+// 读 DR 清除 RXNE, IDLE 和错误标志
+uint8_t Sim_USART_Receive(USART_TypeDef *const usart)
+{
+    uint8_t data = (uint8_t)usart->DR;
+
+    usart->SR &= ~(USART_SR_RXNE | USART_SR_IDLE | USART_SR_ORE | USART_SR_FE | USART_SR_NE);
+    return data;
+}
+
+void Sim_USART_Set_Baud(USART_TypeDef *const usart, const uint32_t pclk, const uint32_t baud)
+{
+    Sim.pclk = usart == USART1 ? pclk : 0;
+    Sim.baud = baud;
+}
+
+void Sim_RCC_Get_Clocks(LL_RCC_ClocksTypeDef *const clocks)
+{
+    clocks->SYSCLK_Frequency = 72000000;
+    clocks->HCLK_Frequency = 72000000;
+    clocks->PCLK1_Frequency = 36000000;
+    clocks->PCLK2_Frequency = 72000000;
+}
+
+void Lib_RTC_Set_Time(const Lib_RTC_UnixType ts)
+{
+    Sim.rtc = ts;
+}
+
+void Sim_DMA_Init(const uint32_t ch, const LL_DMA_InitTypeDef *const config)
+{
+    Sim.dma[ch].addr = config->MemoryOrM2MDstAddress;
+    Sim.dma[ch].size = config->NbData;
+    Sim.dma[ch].length = config->NbData;
+}
+
+void Sim_DMA_Enable(const uint32_t ch, const uint8_t enable)
+{
+    Sim.dma[ch].enabled = enable;
+}
+
+void Sim_DMA_Set_Address(const uint32_t ch, const uintptr_t addr)
+{
+    Sim.dma[ch].addr = addr;
+}
+
+void Sim_DMA_Set_Length(const uint32_t ch, const uint32_t num)
+{
+    Sim.dma[ch].size = num;
+    Sim.dma[ch].length = num;
+}
+
+uint32_t Sim_DMA_Get_Length(const uint32_t ch)
+{
+    return Sim.dma[ch].length;
+}
+
+uint32_t Sim_DMA_Flag(const uint32_t ch, const uint32_t flag, const uint8_t clear)
+{
+    if (clear)
+    {
+        Sim.dma[ch].flags &= ~flag;
+        return RESET;
+    }
+    return (Sim.dma[ch].flags & flag) ? SET : RESET;
+}
+
+/*
+ * @brief   DMA 通道 4: 取出一次传输的数据, 按 SIM_BYTE_NS 等待发送完, 然后置 TC 并调用中断服务函数
+*/
+static void *Sim_TX_Thread(void *arg)
+{
+    Sim_DMA_Channel_Type *const ch = &Sim.dma[4];
+    uintptr_t addr = 0;
+    uint32_t len = 0;
+    uint64_t end = 0;
+
+    (void)arg;
+    while (Sim.running)
+    {
+        pthread_mutex_lock(&Sim_IRQ_Lock);
+        len = ch->enabled ? ch->length : 0;
+        addr = ch->addr;
+        pthread_mutex_unlock(&Sim_IRQ_Lock);
+        if (len == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        if (Sim.master_fd >= 0)
+        {
+            for (uint32_t n = 0; n < len; )
+            {
+                ssize_t res = write(Sim.master_fd, (const uint8_t *)addr + n, len - n);
+                n += res > 0 ? (uint32_t)res : 0;
+            }
+        }
+        else if (Sim.tx_len + len <= SIM_LOG_SIZE)
+        {
+            memcpy(&Sim.tx_log[Sim.tx_len], (const uint8_t *)addr, len);
+        }
+        ++Sim.tx_transfers;
+        if (len > Sim.tx_max_transfer)
+        {
+            Sim.tx_max_transfer = len;
+        }
+        end = Sim_Time_ns() + (uint64_t)len * SIM_BYTE_NS;
+        while (Sim_Time_ns() < end)
+        {
+            sched_yield();
+        }
+        Sim.tx_len += len;
+        pthread_mutex_lock(&Sim_IRQ_Lock);
+        ch->length = 0;
+        ch->flags |= SIM_DMA_FLAG_TC;
+        pthread_mutex_unlock(&Sim_IRQ_Lock);
+        Sim_Interrupt(Lib_USART_DMA_TX_Handler);
+    }
+    return NULL;
+}
+
+/*
+ * @brief   DMA 通道 5 收到一个字节: 写入缓冲区, 到一半置 HT, 写满置 TC 并从头开始
+*/
+static void Sim_RX_Byte(const uint8_t data)
+{
+    Sim_DMA_Channel_Type *const ch = &Sim.dma[5];
+
+    if (!ch->enabled)
+    {
+        return;
+    }
+    ((uint8_t *)ch->addr)[ch->size - ch->length] = data;
+    --ch->length;
+    if (ch->length == ch->size / 2)
+    {
+        ch->flags |= SIM_DMA_FLAG_HT;
+    }
+    if (ch->length == 0)
+    {
+        ch->flags |= SIM_DMA_FLAG_TC;
+        ch->length = ch->size;
+    }
+    if (ch->flags != 0 && !Sim.dma_defer)
+    {
+        Sim_Interrupt(Lib_USART_DMA_RX_Handler);
+    }
+}
+
+// 线路空闲一个字节时间
+static void Sim_RX_Idle(void)
+{
+    USART1->SR |= USART_SR_IDLE;
+    Sim_Interrupt(Lib_USART_IT_Handler);
+}
+
+static void Sim_RX_Callback(const uint8_t *const data, const uint32_t num)
+{
+    if (num == 0 || data < Lib_USART_Buffer || data + num > Lib_USART_Buffer + LIB_USART_BUFFER_MAXSIZE
+        || Sim.rx_len + num > SIM_LOG_SIZE)
+    {
+        ++Sim.rx_bad;
+        return;
+    }
+    memcpy(&Sim.rx_log[Sim.rx_len], data, num);
+    Sim.rx_len += num;
+    ++Sim.rx_calls;
+}
+
+static void Sim_RX_Reset(void)
+{
+    Sim.rx_len = 0;
+    Sim.rx_calls = 0;
+    Sim.rx_bad = 0;
+}
+
+// DMA 当前的写入位置
+static uint32_t Sim_RX_Pos(void)
+{
+    return Sim.dma[5].size - Sim.dma[5].length;
+}
+
+// 一帧数据后空闲: 一次回调交出整帧
+static void Test_RX_Idle(void)
+{
+    uint8_t frame[10];
+
+    Sim_RX_Reset();
+    for (uint32_t i = 0; i < sizeof(frame); ++i)
+    {
+        frame[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(frame[i]);
+    }
+    Sim_Check("rx: nothing before idle", Sim.rx_calls == 0);
+    Sim_RX_Idle();
+    Sim_Check("rx: idle delivers the frame",
+              Sim.rx_calls == 1 && Sim.rx_len == sizeof(frame) && memcmp(Sim.rx_log, frame, sizeof(frame)) == 0);
+    Sim_RX_Idle();
+    Sim_Check("rx: idle without new data", Sim.rx_calls == 1 && Sim.rx_bad == 0);
+}
+
+// 连续输入, 没有空闲: 每半个缓冲区交出一次, 最后由 IDLE 交出剩余部分
+static void Test_RX_Stream(void)
+{
+    static uint8_t stream[3 * LIB_USART_BUFFER_MAXSIZE + 37];
+    uint32_t behind_max = 0;
+
+    Sim_RX_Reset();
+    for (uint32_t i = 0; i < sizeof(stream); ++i)
+    {
+        stream[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(stream[i]);
+        if (i + 1 - Sim.rx_len > behind_max)
+        {
+            behind_max = i + 1 - Sim.rx_len;
+        }
+    }
+    Sim_Check("rx: half/full transfer deliver in order",
+              Sim.rx_len <= sizeof(stream) && memcmp(Sim.rx_log, stream, Sim.rx_len) == 0);
+    Sim_Check("rx: never more than half a buffer behind", behind_max <= LIB_USART_BUFFER_MAXSIZE / 2);
+    Sim_RX_Idle();
+    Sim_Check("rx: idle delivers the rest",
+              Sim.rx_len == sizeof(stream) && memcmp(Sim.rx_log, stream, sizeof(stream)) == 0 && Sim.rx_bad == 0);
+}
+
+// DMA 中断挂起时 DMA 回绕, IDLE 中断把跨越末尾的数据分两次交出, 之后的 DMA 中断没有新数据
+static void Test_RX_Wrap(void)
+{
+    uint8_t frame[20];
+    uint32_t calls = 0;
+
+    // 先移到缓冲区末尾前 5 个字节
+    while (Sim_RX_Pos() != LIB_USART_BUFFER_MAXSIZE - 5)
+    {
+        Sim_RX_Byte(0x55);
+    }
+    Sim_RX_Idle();
+    Sim_RX_Reset();
+    Sim.dma_defer = 1;
+    for (uint32_t i = 0; i < sizeof(frame); ++i)
+    {
+        frame[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(frame[i]);
+    }
+    Sim.dma_defer = 0;
+    Sim_RX_Idle();
+    Sim_Check("rx: wrapped frame is split at the end of the buffer",
+              Sim.rx_calls == 2 && Sim.rx_len == sizeof(frame) && memcmp(Sim.rx_log, frame, sizeof(frame)) == 0);
+    calls = Sim.rx_calls;
+    Sim_Interrupt(Lib_USART_DMA_RX_Handler);
+    Sim_Check("rx: late DMA interrupt finds nothing new", Sim.rx_calls == calls && Sim.dma[5].flags == 0);
+}
+
+// 错误中断只统计, 不产生数据
+static void Test_RX_Errors(void)
+{
+    Lib_USART_Stat_Type before, after;
+
+    Lib_USART_Get_Stat(&before);
+    Sim_RX_Reset();
+    USART1->SR |= USART_SR_ORE | USART_SR_FE;
+    Sim_Interrupt(Lib_USART_IT_Handler);
+    Lib_USART_Get_Stat(&after);
+    Sim_Check("rx: errors counted and cleared",
+              after.overrun == before.overrun + 1 && after.framing == before.framing + 1
+              && after.noise == before.noise && (USART1->SR & (USART_SR_ORE | USART_SR_FE)) == 0
+              && Sim.rx_calls == 0);
+}
+
+// RTS 是否已拉高
+static int Sim_RTS(void)
+{
+    return (LIB_USART_RTS_PORT->ODR & LIB_USART_RTS_PIN) != 0;
+}
+
+// 没有回调时数据留在缓冲区, 由 Lib_USART_Receive() 读取; RTS 跟随未读取数据的高低水位
+static void Test_RX_Ring(void)
+{
+    static uint8_t stream[LIB_USART_BUFFER_MAXSIZE + 44], out[LIB_USART_BUFFER_MAXSIZE + 44];
+    Lib_USART_Stat_Type before, after;
+    uint32_t n = 0, i = 0;
+
+    Lib_USART_RX_Set_Callback(NULL);
+    Lib_USART_Get_Stat(&before);
+    for (i = 0; i < LIB_USART_RX_HIGH_WATERMARK - 1; ++i)
+    {
+        stream[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(stream[i]);
+    }
+    Sim_RX_Idle();
+    Sim_Check("ring: below the high watermark RTS stays low", !Sim_RTS());
+    stream[i] = (uint8_t)Sim_Rand();
+    Sim_RX_Byte(stream[i++]);
+    Sim_RX_Idle();
+    Lib_USART_Get_Stat(&after);
+    Sim_Check("ring: high watermark raises RTS", Sim_RTS() && after.rx_paused == before.rx_paused + 1);
+
+    // 分两次读: 第一次读完后仍高于低水位
+    n = Lib_USART_Receive(out, i - LIB_USART_RX_LOW_WATERMARK - 1);
+    Sim_Check("ring: RTS held above the low watermark", n == i - LIB_USART_RX_LOW_WATERMARK - 1 && Sim_RTS());
+    n += Lib_USART_Receive(&out[n], sizeof(out));
+    Sim_Check("ring: reading drains the buffer and lowers RTS",
+              n == i && memcmp(out, stream, n) == 0 && !Sim_RTS());
+
+    // 没有 IDLE 也能读到 DMA 已写入的数据
+    for (i = 0; i < 7; ++i)
+    {
+        stream[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(stream[i]);
+    }
+    n = Lib_USART_Receive(out, sizeof(out));
+    Sim_Check("ring: receive polls the DMA position", n == 7 && memcmp(out, stream, n) == 0);
+
+    // 上位机不理会 RTS: 超出缓冲区的旧数据被覆盖并计入 rx_dropped
+    Lib_USART_Get_Stat(&before);
+    for (i = 0; i < sizeof(stream); ++i)
+    {
+        stream[i] = (uint8_t)Sim_Rand();
+        Sim_RX_Byte(stream[i]);
+    }
+    n = Lib_USART_Receive(out, sizeof(out));
+    Lib_USART_Get_Stat(&after);
+    Sim_Check("ring: overrun keeps the newest buffer",
+              n == LIB_USART_BUFFER_MAXSIZE && memcmp(out, &stream[sizeof(stream) - n], n) == 0
+              && after.rx_dropped == before.rx_dropped + sizeof(stream) - n && !Sim_RTS());
+    Lib_USART_RX_Set_Callback(Sim_RX_Callback);
+}
+
+#if LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_OVERWRITE
+// 贪心匹配: sub 的字节是否按顺序出现在 seq 中
+static int Sim_Is_Subsequence(const uint8_t *const sub, const uint32_t sub_len,
+                              const uint8_t *const seq, const uint32_t seq_len)
+{
+    uint32_t j = 0;
+
+    for (uint32_t i = 0; i < sub_len; ++i)
+    {
+        while (j < seq_len && seq[j] != sub[i])
+        {
+            ++j;
+        }
+        if (j == seq_len)
+        {
+            return 0;
+        }
+        ++j;
+    }
+    return 1;
+}
+#endif
+
+/*
+ * @brief   发送随机长度的消息, 检查 DMA 发出的数据
+ * @note    BLOCK: 与写入的数据完全相同; DROP: 每条消息按丢弃的字节数截短;
+ *          OVERWRITE: 发出的数据是写入数据的子序列, 且以最后一条消息结尾
+*/
+static void Test_TX(void)
+{
+    static uint8_t sent[SIM_LOG_SIZE];
+    static uint8_t expect[SIM_LOG_SIZE];
+    uint8_t msg[SIM_TX_MSG_MAXSIZE];
+    uint32_t sent_len = 0, expect_len = 0, len = 0, dropped = 0;
+    Lib_USART_Stat_Type stat;
+    struct timespec pause = {0};
+
+    Sim.tx_len = 0;
+    for (uint32_t i = 0; i < SIM_TX_MSG_NUM; ++i)
+    {
+        len = 1 + Sim_Rand() % SIM_TX_MSG_MAXSIZE;
+        for (uint32_t k = 0; k < len; ++k)
+        {
+            msg[k] = (uint8_t)Sim_Rand();
+        }
+        dropped = Lib_USART_TX_Get_Dropped();
+        Lib_USART_Send_Data(msg, len);
+        dropped = Lib_USART_TX_Get_Dropped() - dropped;
+        memcpy(&sent[sent_len], msg, len);
+        sent_len += len;
+        // DROP 时每条消息只截掉自己放不下的部分; OVERWRITE 时丢弃的是旧数据
+        if (dropped <= len)
+        {
+            memcpy(&expect[expect_len], msg, len - dropped);
+            expect_len += len - dropped;
+        }
+        // 写入速度约为发送速度的 2 倍, 缓冲区时满时空
+        pause.tv_nsec = len * SIM_BYTE_NS / 2;
+        nanosleep(&pause, NULL);
+    }
+    Lib_USART_Flush();
+    Lib_USART_Get_Stat(&stat);
+
+    Sim_Check("tx: no transfer longer than the buffer", Sim.tx_max_transfer <= LIB_USART_TX_BUFFER_SIZE);
+    Sim_Check("tx: sent + dropped = written", Sim.tx_len + Lib_USART_TX_Get_Dropped() == sent_len);
+#if LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_BLOCK
+    Sim_Check("tx: block keeps every byte in order",
+              Sim.tx_len == sent_len && memcmp(Sim.tx_log, sent, sent_len) == 0);
+    Sim_Check("tx: block stall time counted", stat.tx_stall_us > 0);
+#elif LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_DROP
+    Sim_Check("tx: drop truncates the new messages",
+              Sim.tx_len == expect_len && memcmp(Sim.tx_log, expect, expect_len) == 0);
+    Sim_Check("tx: dropped bytes counted", stat.tx_dropped > 0 && stat.tx_dropped == Lib_USART_TX_Get_Dropped());
+#else
+    Sim_Check("tx: overwrite sends a subsequence in order", Sim_Is_Subsequence(Sim.tx_log, Sim.tx_len, sent, sent_len));
+    Sim_Check("tx: overwrite keeps the newest message",
+              Sim.tx_len >= len && memcmp(&Sim.tx_log[Sim.tx_len - len], msg, len) == 0);
+    Sim_Check("tx: dropped bytes counted", stat.tx_dropped > 0 && stat.tx_dropped == Lib_USART_TX_Get_Dropped());
+#endif
+    printf("  %u B written, %u B sent in %u transfers, %u B dropped, stall %u us\n",
+           sent_len, Sim.tx_len, Sim.tx_transfers, Lib_USART_TX_Get_Dropped(), stat.tx_stall_us);
+}
+
+/*
+ * @brief   线路: 把 pty 主端收到的数据逐字节交给接收 DMA, 每次读完视为线路空闲
+*/
+static void *Sim_Line_Thread(void *arg)
+{
+    struct pollfd pfd = {.fd = Sim.master_fd, .events = POLLIN};
+    uint8_t buffer[256];
+    ssize_t num = 0;
+
+    (void)arg;
+    while (!Sim.host_done)
+    {
+        if (poll(&pfd, 1, 10) <= 0)
+        {
+            continue;
+        }
+        num = read(Sim.master_fd, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < num; ++i)
+        {
+            Sim_RX_Byte(buffer[i]);
+        }
+        if (num > 0)
+        {
+            Sim_RX_Idle();
+        }
+    }
+    return NULL;
+}
+
+typedef struct
+{
+    uint32_t num_ok;
+    uint32_t num_bad;
+    uint64_t rtt_sum_us;
+    uint64_t rtt_max_us;
+} Sim_Ping_Stat_Type;
+
+static void Sim_Ping_Callback(const Host_Cmd_Event_Type *const event, void *const arg)
+{
+    Sim_Ping_Stat_Type *const stat = (Sim_Ping_Stat_Type *)arg;
+
+    if (event->result != HOST_CMD_RES_OK || event->reply == NULL || event->reply->len != SIM_PING_SIZE)
+    {
+        ++stat->num_bad;
+        return;
+    }
+    ++stat->num_ok;
+    stat->rtt_sum_us += event->rtt_us;
+    if (event->rtt_us > stat->rtt_max_us)
+    {
+        stat->rtt_max_us = event->rtt_us;
+    }
+}
+
+/*
+ * @brief   上位机一侧, 与 cmd_tool 的用法相同
+*/
+static void *Sim_Host_Thread(void *arg)
+{
+    Host_Cmd_Type *const host = malloc(sizeof(Host_Cmd_Type));
+    Host_Cmd_Stat_Type stat;
+    Sim_Ping_Stat_Type ping = {0};
+    uint8_t payload[SIM_PING_SIZE] = {0};
+    uint32_t sent = 0;
+    uint64_t start = 0, elapsed = 0, last_event = 0;
+    int res = 0;
+
+    if (host == NULL || Host_Cmd_Open(host, (const char *)arg, 115200) != 0)
+    {
+        Sim_Check("loop: open the pty", 0);
+        free(host);
+        Sim.host_done = 1;
+        return NULL;
+    }
+    Sim_Check("loop: commands rejected before START",
+              Host_Cmd_Call(host, HOST_CMD_PING, NULL, 0, NULL, 1000) == HOST_CMD_RES_NOT_STARTED);
+    Sim_Check("loop: START", Host_Cmd_Call(host, HOST_CMD_START, NULL, 0, NULL, 1000) == HOST_CMD_RES_OK);
+    Sim_Check("loop: RTC_UNIX", Host_Cmd_Set_RTC(host, SIM_RTC_UNIX) == HOST_CMD_RES_OK && Sim.rtc == SIM_RTC_UNIX);
+    Sim_Check("loop: bad length", Host_Cmd_Call(host, HOST_CMD_RTC_UNIX, payload, 2, NULL, 1000) == HOST_CMD_RES_BAD_LEN);
+    Sim_Check("loop: unknown command", Host_Cmd_Call(host, 0x42, NULL, 0, NULL, 1000) == HOST_CMD_RES_UNKNOWN);
+
+    // 流水线 PING
+    start = Host_Serial_Time_us();
+    last_event = start;
+    while (ping.num_ok + ping.num_bad < SIM_PING_NUM)
+    {
+        while (sent < SIM_PING_NUM && host->num_outstanding < SIM_PING_WINDOW)
+        {
+            payload[0] = (uint8_t)sent;
+            if (Host_Cmd_Send(host, HOST_CMD_PING, payload, SIM_PING_SIZE) < 0)
+            {
+                break;
+            }
+            ++sent;
+        }
+        res = Host_Cmd_Poll(host, 100, Sim_Ping_Callback, &ping);
+        if (res < 0)
+        {
+            break;
+        }
+        if (res > 0)
+        {
+            last_event = Host_Serial_Time_us();
+        }
+        else if (Host_Serial_Time_us() - last_event > 1000000)
+        {
+            printf("  timeout: %u frames unacknowledged\n", host->num_outstanding);
+            break;
+        }
+    }
+    elapsed = Host_Serial_Time_us() - start;
+    Sim_Check("loop: pipelined PING", ping.num_ok == SIM_PING_NUM);
+    if (ping.num_ok > 0)
+    {
+        printf("  %u PING x %u B, window %u: %.0f frames/s, rtt avg %.0f us, max %llu us\n",
+               ping.num_ok, SIM_PING_SIZE, SIM_PING_WINDOW, ping.num_ok * 1e6 / elapsed,
+               (double)ping.rtt_sum_us / ping.num_ok, (unsigned long long)ping.rtt_max_us);
+    }
+
+    Sim_Check("loop: baud negotiation",
+              Host_Cmd_Set_Baud(host, SIM_BAUD_NEW) == HOST_CMD_RES_OK && Sim.baud == SIM_BAUD_NEW
+              && Sim.pclk == 72000000 && Lib_USART_Get_Baud() == SIM_BAUD_NEW);
+    Sim_Check("loop: STAT", Host_Cmd_Get_Stat(host, &stat) == HOST_CMD_RES_OK && stat.rx_dropped == Sim.rx_dropped);
+    Sim_Check("loop: STOP", Host_Cmd_Call(host, HOST_CMD_STOP, NULL, 0, NULL, 1000) == HOST_CMD_RES_OK);
+    Host_Cmd_Close(host);
+    free(host);
+    Sim.host_done = 1;
+    return NULL;
+}
+
+/*
+ * @brief   pty 回环: 上位机的 host_cmd.c 与 lib_usart.c 的指令模式通信
+*/
+static void Test_Loopback(void)
+{
+    const char *slave = NULL;
+    Lib_USART_Stat_Type stat;
+
+    Sim.master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (Sim.master_fd < 0 || grantpt(Sim.master_fd) != 0 || unlockpt(Sim.master_fd) != 0
+        || (slave = ptsname(Sim.master_fd)) == NULL)
+    {
+        Sim_Check("loop: open the pty", 0);
+        return;
+    }
+    Lib_USART_Get_Stat(&stat);
+    Sim.rx_dropped = stat.rx_dropped;
+    Lib_USART_RX_Set_Callback(Lib_USART_CMD_Receive);
+    Sim.host_done = 0;
+    pthread_create(&Sim.line_thread, NULL, Sim_Line_Thread, NULL);
+    pthread_create(&Sim.host_thread, NULL, Sim_Host_Thread, (void *)slave);
+    // 单片机的主循环
+    while (!Sim.host_done)
+    {
+        Lib_USART_CMD_Process();
+        sched_yield();
+    }
+    pthread_join(Sim.host_thread, NULL);
+    pthread_join(Sim.line_thread, NULL);
+    close(Sim.master_fd);
+    Sim.master_fd = -1;
+}
+
+int main(void)
+{
+    Lib_USART_Init();
+    Lib_USART_RX_Set_Callback(Sim_RX_Callback);
+
+    Test_RX_Idle();
+    Test_RX_Stream();
+    Test_RX_Wrap();
+    Test_RX_Errors();
+    Test_RX_Ring();
+
+    Sim.running = 1;
+    pthread_create(&Sim.tx_thread, NULL, Sim_TX_Thread, NULL);
+    Test_TX();
+    if (LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_BLOCK)
+    {
+        Test_Loopback();
+    }
+    Sim.running = 0;
+    pthread_join(Sim.tx_thread, NULL);
+
+    printf("%s\n", failed ? "FAILED" : "all passed");
+    return failed ? 1 : 0;
+}
@@ -100,7 +100,7 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   /* USER CODE BEGIN 2 */
-  Lib_I2C_Init();
+  Mod_Oled_COM_Init();
   Mod_Oled_Power_Up();
   Mod_Oled_Full_Screen();
   LL_mDelay(1000);
@@ -118,13 +118,13 @@ int main(void)
   pos = Mod_Oled_Show_fString(pos, "Voltage: %.1f V", 3.3f);
   LL_mDelay(100);
   // 显示十六进制
-  pos = Mod_Oled_Show_fString(pos, "Error: %x", 0x1A);
+  pos = Mod_Oled_Show_fString(pos, "Error: 0x%X", 0x1A);
   LL_mDelay(100);
   // 显示字符串
   pos = Mod_Oled_Show_fString(pos, "Status: %s", "OK");
   LL_mDelay(100);
   // 混合类型
-  pos = Mod_Oled_Show_fString(pos, "%s: %d, Hex: %x, Float: %.2f", "Sensor", 123, 123, 4.56);
+  pos = Mod_Oled_Show_fString(pos, "%s: %d, Hex: 0x%X, Float: %.2f", "Sensor", 123, 123, 4.56);
   LL_mDelay(100);
   /* USER CODE END 2 */
 
@@ -11,14 +11,157 @@
 #include "diskio.h"		/* Declarations FatFs MAI */
 
 /* Example: Declarations of the platform and disk functions in the project */
-#include "lib_spi.h"
 #include "mod_flash.h"
+#include "mod_ftl.h"
 
 /* Example: Mapping of physical drive number for each drive */
 #define DEV_FLASH	0	/* Map FTL to physical drive 0 */
 // #define DEV_MMC		1	/* Map MMC/SD card to physical drive 1 */
 // #define DEV_USB		2	/* Map USB MSD to physical drive 2 */
 
+#include <string.h>
+
+
+/*-----------------------------------------------------------------------*/
+/* FLASH 读写, 经过或不经过 FTL                                          */
+/*-----------------------------------------------------------------------*/
+
+// sector 为扇区的编号, 不是真实地址, 需要乘以 4096, 即左移 12 位
+// count 为扇区的数量, 也要左移 12 位表示字节数
+static DRESULT flash_read (BYTE *buff, LBA_t sector, UINT count)
+{
+	// 多个扇区在一个片选周期内用 FAST_READ 连续读取, 数据由 DMA 直接写入 buff
+#if MOD_FTL_EN
+	// 经过 FTL 时, 物理扇区也连续的部分合并为一次读取
+	if (Mod_FTL_Read((uint8_t*)buff, sector, count) != SUCCESS)
+		return RES_PARERR;
+#else
+	Mod_Flash_Read((uint8_t*)buff, sector << 12, count << 12);
+#endif
+	return RES_OK;
+}
+
+static DRESULT flash_write (const BYTE *buff, LBA_t sector, UINT count)
+{
+#if MOD_FTL_EN
+	// 经过 FTL 时写到已擦除的空闲扇区, 不在写入时擦除
+	for (UINT i = 0; i < count; ++i)
+		if (Mod_FTL_Write((const uint8_t*)buff + (i << 12), sector + i) != SUCCESS)
+			return RES_ERROR;
+#else
+	// 比较后更新, 内容相同或只有 1 变为 0 时不擦除, 需要擦除的连续扇区用块擦除; 读出校验失败时返回错误
+	if (Mod_Flash_Write_Sectors((const uint8_t*)buff, sector << 12, count) != SUCCESS)
+		return RES_ERROR;
+#endif
+	return RES_OK;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* 写回缓存                                                              */
+/*-----------------------------------------------------------------------*/
+// 单扇区的读取 (FAT, 目录和文件缓冲区) 放入缓存; 单扇区的写入只在扇区已经在缓存中时修改缓存, 在 CTRL_SYNC
+// (f_sync(), f_close()) 或被替换时写回. FatFs 修改 FAT 和目录前总会先读取, 所以它们的改写命中缓存; 没有读过的
+// 扇区 (新文件的数据) 直接写入 FLASH, 不挤掉缓存中的扇区. 多扇区的读写 (大块文件数据) 直接访问 FLASH
+// 缓存满时替换最久没有使用的扇区 (LRU); CTRL_SYNC 之前掉电会丢失缓存中的写入, 与 FatFs 的要求相同
+
+#if DISK_CACHE_SLOTS
+
+typedef struct {
+	BYTE	data[4096];
+	LBA_t	sector;
+	DWORD	used;			/* 最近一次使用的时刻, 越小越久 */
+	BYTE	valid;
+	BYTE	dirty;			/* 与 FLASH 不同, 替换或同步时需要写回 */
+} DCACHE_SLOT;
+
+static DCACHE_SLOT Disk_Cache[DISK_CACHE_SLOTS];
+static DWORD Disk_Cache_Clock;
+static DCACHE_STAT Disk_Cache_Stat;
+
+// 查找缓存的扇区, 没有时返回 0
+static DCACHE_SLOT* cache_find (LBA_t sector)
+{
+	for (UINT i = 0; i < DISK_CACHE_SLOTS; ++i)
+		if (Disk_Cache[i].valid && Disk_Cache[i].sector == sector)
+			return &Disk_Cache[i];
+	return 0;
+}
+
+// 写回一个槽
+static DRESULT cache_flush_slot (DCACHE_SLOT *slot)
+{
+	if (!slot->valid || !slot->dirty)
+		return RES_OK;
+	if (flash_write(slot->data, slot->sector, 1) != RES_OK)
+		return RES_ERROR;
+	slot->dirty = 0;
+	Disk_Cache_Stat.flushes++;
+	return RES_OK;
+}
+
+// 取得一个槽用于 sector: 优先空槽, 否则写回并替换最久没有使用的
+static DCACHE_SLOT* cache_alloc (LBA_t sector)
+{
+	DCACHE_SLOT *slot = &Disk_Cache[0];
+
+	for (UINT i = 0; i < DISK_CACHE_SLOTS; ++i) {
+		if (!Disk_Cache[i].valid) {
+			slot = &Disk_Cache[i];
+			break;
+		}
+		if (Disk_Cache[i].used < slot->used)
+			slot = &Disk_Cache[i];
+	}
+	if (slot->valid && slot->dirty) {
+		if (cache_flush_slot(slot) != RES_OK)
+			return 0;
+		Disk_Cache_Stat.evictions++;
+	}
+	slot->sector = sector;
+	slot->valid = 1;
+	slot->dirty = 0;
+	return slot;
+}
+
+// 写回所有修改过的扇区, 按扇区顺序
+static DRESULT cache_flush (void)
+{
+	DCACHE_SLOT *slot;
+
+	do {
+		slot = 0;
+		for (UINT i = 0; i < DISK_CACHE_SLOTS; ++i)
+			if (Disk_Cache[i].valid && Disk_Cache[i].dirty && (!slot || Disk_Cache[i].sector < slot->sector))
+				slot = &Disk_Cache[i];
+		if (slot && cache_flush_slot(slot) != RES_OK)
+			return RES_ERROR;
+	} while (slot);
+	return RES_OK;
+}
+
+// 丢弃 [sector, sector + count) 范围内的缓存, 修改过的也不写回 (将被覆盖或不再使用)
+static void cache_drop (LBA_t sector, LBA_t count)
+{
+	for (UINT i = 0; i < DISK_CACHE_SLOTS; ++i)
+		if (Disk_Cache[i].valid && Disk_Cache[i].sector >= sector && Disk_Cache[i].sector - sector < count)
+			Disk_Cache[i].valid = Disk_Cache[i].dirty = 0;
+}
+
+#endif
+
+/*
+ * @brief   读取写回缓存的统计
+ */
+void disk_cache_stat (DCACHE_STAT* stat)
+{
+#if DISK_CACHE_SLOTS
+	*stat = Disk_Cache_Stat;
+#else
+	memset(stat, 0, sizeof(*stat));
+#endif
+}
+
 
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
@@ -29,12 +172,11 @@ DSTATUS disk_status (
 )
 {
 	DSTATUS stat = STA_NOINIT | STA_PROTECT; // FatFs 没有 STA_NODISK
-	int result;
 
 	switch (pdrv) {
 	case DEV_FLASH:
-		result = Mod_Flash_Read_JEDCE_ID();
-		if (result == MOD_FLASH_JEDEC_ID)
+		// FatFs 每次访问都会调用, 只看 Mod_Flash_Detect() 的结果 (检测失败时为 0), 不访问总线, 不等待后台擦除
+		if (Mod_Flash_Geometry.jedec_id != 0)
 		{
 			(void)stat;
 			return ~stat; // 必须清除两个位, 因为 f_mkfs() 会检测这两个位
@@ -57,9 +199,14 @@ DSTATUS disk_initialize (
 
 	switch (pdrv) {
 	case DEV_FLASH:
-		Lib_SPI_Init();
+		Mod_Flash_COM_Init();
 		(void)stat;
 		(void)result;
+#if MOD_FTL_EN
+		// 读取日志区, 重建逻辑扇区到物理扇区的映射
+		if (!(disk_status(pdrv) & STA_NOINIT))
+			Mod_FTL_Init();
+#endif
 		return disk_status(pdrv);
 	}
 	return STA_NOINIT;
@@ -81,12 +228,41 @@ DRESULT disk_read (
 
 	switch (pdrv) {
 	case DEV_FLASH:
-		// sector 是扇区的标号, 不是实际地址; 因此需要乘以 4096, 即左移 12 位
-		// 同理, count 是读取的扇区数, 不是字节数, 也要左移 12 位
-		Mod_Flash_Read((uint8_t*)buff, sector << 12, count << 12);
-		(void)res;
 		(void)result;
+#if DISK_CACHE_SLOTS
+		DCACHE_SLOT *slot = cache_find(sector);
+		if (count == 1) {
+			if (slot) {
+				Disk_Cache_Stat.read_hits++;
+			} else {
+				// 放入缓存, 下次读写同一个扇区时不再访问 FLASH
+				Disk_Cache_Stat.read_misses++;
+				slot = cache_alloc(sector);
+				if (!slot)
+					return RES_ERROR;
+				res = flash_read(slot->data, sector, 1);
+				if (res != RES_OK) {
+					slot->valid = 0;
+					return res;
+				}
+			}
+			slot->used = ++Disk_Cache_Clock;
+			memcpy(buff, slot->data, 4096);
+			return RES_OK;
+		}
+		// 多扇区直接读取, 再用缓存中修改过的扇区覆盖
+		res = flash_read(buff, sector, count);
+		if (res != RES_OK)
+			return res;
+		Disk_Cache_Stat.read_misses += count;
+		for (UINT i = 0; i < DISK_CACHE_SLOTS; ++i)
+			if (Disk_Cache[i].valid && Disk_Cache[i].dirty && Disk_Cache[i].sector >= sector && Disk_Cache[i].sector - sector < count)
+				memcpy(buff + ((Disk_Cache[i].sector - sector) << 12), Disk_Cache[i].data, 4096);
 		return RES_OK;
+#else
+		(void)res;
+		return flash_read(buff, sector, count);
+#endif
 	}
 
 	return RES_PARERR;
@@ -110,14 +286,26 @@ DRESULT disk_write (
 
 	switch (pdrv) {
 	case DEV_FLASH:
-		// sector 为扇区的编号, 不是真实地址, 需要乘以 4096, 即左移 12 位
-		// count 为写入扇区的数量, 也要左移 12 位表示字节数
-		for (uint8_t i = 0; i < count; ++i)
-			Mod_Flash_Erase_Sector((sector + i) << 12);
-		Mod_Flash_Write((uint8_t*)buff, sector << 12, count << 12);
-		(void)res;
 		(void)result;
-		return RES_OK;
+#if DISK_CACHE_SLOTS
+		if (count == 1) {
+			// 已在缓存中时只写入缓存, 合并之后对同一个扇区的写入; 否则直接写入, 不分配槽
+			DCACHE_SLOT *slot = cache_find(sector);
+			if (!slot) {
+				Disk_Cache_Stat.write_misses++;
+				return flash_write(buff, sector, 1);
+			}
+			memcpy(slot->data, buff, 4096);
+			slot->dirty = 1;
+			slot->used = ++Disk_Cache_Clock;
+			Disk_Cache_Stat.writes++;
+			return RES_OK;
+		}
+		// 多扇区直接写入, 缓存中的旧数据作废
+		cache_drop(sector, count);
+#endif
+		(void)res;
+		return flash_write(buff, sector, count);
 	}
 
 	return RES_PARERR;
@@ -146,23 +334,50 @@ DRESULT disk_ioctl (
 			(void)result;
 			// 将存储器缓存的数据立刻写入物理介质
 			case CTRL_SYNC:
-				// Mod_Flash_Write() 保证数据一定写入物理介质
+#if DISK_CACHE_SLOTS
+				// 写回缓存
+				if (cache_flush() != RES_OK)
+					return RES_ERROR;
+#endif
+				// 最后一页的编程在后台进行, 等待完成
+				Mod_Flash_Sync();
 				break;
-			// 获取扇区数量, 该指令需要 UINT 参数
+			// 扇区不再使用, 可以擦除; 该指令的参数为起止扇区 (LBA_t[2], 包含结束扇区)
+			// f_mkfs() 和删除文件时调用, 按块擦除比逐扇区快; 经过 FTL 时只取消映射, 空闲扇区在写入前擦除
+			case CTRL_TRIM:
+			{
+				LBA_t *lba = (LBA_t*)buff;
+#if DISK_CACHE_SLOTS
+				cache_drop(lba[0], lba[1] - lba[0] + 1);
+#endif
+#if MOD_FTL_EN
+				if (Mod_FTL_Trim(lba[0], lba[1] - lba[0] + 1) != SUCCESS)
+					return RES_ERROR;
+#else
+				if (Mod_Flash_Erase_Range(lba[0] << 12, (lba[1] - lba[0] + 1) << 12) != SUCCESS)
+					return RES_ERROR;
+#endif
+				break;
+			}
+			// 获取扇区数量, 该指令需要 LBA_t 参数
 			case GET_SECTOR_COUNT:
-				// 使用的 Flash 一共有 2048 个扇区
-				*(UINT*)buff = 2048;
+				// FatFs 分区的扇区数 (不包括记录存储), 随检测到的容量变化; 经过 FTL 时除去日志区和备用扇区
+#if MOD_FTL_EN
+				*(LBA_t*)buff = Mod_FTL_Get_Logical();
+#else
+				*(LBA_t*)buff = MOD_FLASH_FATFS_SIZE / MOD_FLASH_SECTOR_SIZE;
+#endif
 				break;
-			// 获取扇区大小, 该指令需要 UINT 参数
+			// 获取扇区大小, 该指令需要 WORD 参数, 写入 UINT 会覆盖 f_mkfs() 栈上相邻的变量
 			case GET_SECTOR_SIZE:
 				// 使用的 Flash 的大小为 4096 B
-				*(UINT*)buff = 4096;
+				*(WORD*)buff = 4096;
 				break;
-			// 获取擦除块大小, 该指令需要 UINT 参数
+			// 获取擦除块大小, 该指令需要 DWORD 参数
 			case GET_BLOCK_SIZE:
 				// 擦除块大小的意思是存储设备最小的擦除单位是几个扇区
 				// 使用的 Flash 能够逐扇区擦除, 即 1
-				*(UINT*)buff = 1;
+				*(DWORD*)buff = 1;
 				break;
 			default:
 				return RES_PARERR;
@@ -33,6 +33,25 @@ DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 
 
+/* 写回缓存 (diskio.c) */
+
+#ifndef DISK_CACHE_SLOTS
+#define DISK_CACHE_SLOTS	0	/* 缓存的扇区数, 每个占用 4 KB RAM; 0 表示不使用缓存 */
+#endif
+
+/* 缓存统计, 用于根据 RAM 选择 DISK_CACHE_SLOTS */
+typedef struct {
+	DWORD	read_hits;		/* 从缓存读取的扇区数 */
+	DWORD	read_misses;	/* 从 FLASH 读取的扇区数 */
+	DWORD	writes;			/* 写入缓存的扇区数 (扇区已在缓存中) */
+	DWORD	write_misses;	/* 扇区不在缓存中, 直接写入 FLASH 的单扇区写入数 */
+	DWORD	flushes;		/* 写回 FLASH 的扇区数, writes - flushes 为合并掉的写入 */
+	DWORD	evictions;		/* 其中因为缓存已满而写回的扇区数 */
+} DCACHE_STAT;
+
+void disk_cache_stat (DCACHE_STAT* stat);
+
+
 /* Disk Status Bits (DSTATUS) */
 
 #define STA_NOINIT		0x01	/* Drive not initialized */
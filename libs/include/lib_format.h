@@ -0,0 +1,42 @@
+#ifndef _LIB_FORMAT_H
+#define _LIB_FORMAT_H
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * @brief   printf 风格的格式化输出, 与硬件无关
+ * @note    1) 格式: %[标志][宽度][.精度][长度]转换
+ *              标志: '-' 左对齐, '0' 补零, '+' 正数显示 +, ' ' 正数显示空格, '#' 十六进制加 0x
+ *              宽度/精度: 数字或 '*' (从参数读取)
+ *              长度: hh, h, l (int 和 long 都是 32 位)
+ *              转换: d i u x X c s f F p %
+ *          2) 字符直接交给输出函数 (sink), 不经过中间缓冲区; 可重入, 不使用静态变量
+ *          3) %f 不调用软件浮点库, 精度不超过 LIB_FORMAT_FRAC_MAXDIGITS, 整数部分超过 uint32 时饱和
+ *          4) %x 不带 0x 前缀, 需要时用 "%#x" 或 "0x%X"
+*/
+#define LIB_FORMAT_FRAC_MAXDIGITS        6         // 小数最多显示的位数
+#define LIB_FORMAT_FLOAT_PRECISION       3         // %f 不指定精度时的小数位数
+#define LIB_FORMAT_NUM_BUFFER_SIZE       20        // 数字转字符串需要的缓冲区大小: 符号 + 10 位整数 + 小数点 + 小数 + 结束符
+
+/*
+ * @brief   输出函数, 每次输出一段连续的字符
+ * @param   arg  Lib_Format_Print() 传入的参数, 例如 OLED 坐标, 文件指针, 内存缓冲区
+ *          data 字符, 不以 '\0' 结尾
+ *          num  字符数
+*/
+typedef void (*Lib_Format_Sink_Type)(void *const arg, const char *const data, const uint32_t num);
+
+uint8_t Lib_Format_UInt2Char_DEC(uint32_t num, uint8_t *const buffer);
+uint8_t Lib_Format_UInt2Char_HEX(const uint32_t num, uint8_t *const buffer, const uint8_t upper);
+uint8_t Lib_Format_Int2Char_DEC(const int num, uint8_t *const buffer);
+uint8_t Lib_Format_Int2Char_HEX(const int num, uint8_t *const buffer);
+uint8_t Lib_Format_Double2Char(const double num, uint8_t *const buffer, const uint8_t num_frac_bits);
+uint8_t Lib_Format_Q16_2Char(const int32_t num, uint8_t *const buffer, const uint8_t num_frac_bits);
+uint8_t Lib_Format_Scaled2Char(const int32_t num, uint8_t *const buffer, uint8_t num_frac_bits);
+uint32_t Lib_Format_vPrint(const Lib_Format_Sink_Type sink, void *const arg, const char *const str, va_list ap);
+uint32_t Lib_Format_Print(const Lib_Format_Sink_Type sink, void *const arg, const char *const str, ...);
+uint32_t Lib_Format_vsnPrint(char *const buffer, const uint32_t size, const char *const str, va_list ap);
+uint32_t Lib_Format_snPrint(char *const buffer, const uint32_t size, const char *const str, ...);
+
+#endif
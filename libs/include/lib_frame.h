@@ -0,0 +1,61 @@
+#ifndef _LIB_FRAME_H
+#define _LIB_FRAME_H
+
+#include <stdint.h>
+
+/*
+ * @brief   二进制帧编解码, 与硬件无关, 上位机 (host/) 和单片机共用
+ * @note    帧格式 (COBS 编码前):
+ *              seq(1) + cmd(1) + len(1) + payload(len) + crc16(2, 小端)
+ *          crc16 为 CRC-16/CCITT-FALSE, 覆盖 seq 到 payload.
+ *          COBS 编码后帧内不含 0x00, 以 0x00 作为帧结束符.
+*/
+#define LIB_FRAME_PAYLOAD_MAXSIZE      64                                     // 负载最大字节数
+#define LIB_FRAME_HEADER_SIZE          3                                      // seq + cmd + len
+#define LIB_FRAME_CRC_SIZE             2
+#define LIB_FRAME_RAW_MAXSIZE          (LIB_FRAME_HEADER_SIZE + LIB_FRAME_PAYLOAD_MAXSIZE + LIB_FRAME_CRC_SIZE)
+// COBS 每 254 字节最多多 1 字节, 再加开头的 1 字节和结束符
+#define LIB_FRAME_ENCODED_MAXSIZE      (LIB_FRAME_RAW_MAXSIZE + LIB_FRAME_RAW_MAXSIZE / 254 + 2)
+#define LIB_FRAME_DELIMITER            0x00
+
+/*
+ * @brief   一帧数据
+*/
+typedef struct
+{
+    uint8_t seq;                                  // 序号, 由发送方递增, 应答时原样返回
+    uint8_t cmd;                                  // 指令
+    uint8_t len;                                  // 负载字节数
+    uint8_t payload[LIB_FRAME_PAYLOAD_MAXSIZE];   // 负载
+} Lib_Frame_Type;
+
+/*
+ * @brief   逐字节解码的结果
+*/
+typedef enum
+{
+    LIB_FRAME_PENDING,        // 帧未结束, 继续输入
+    LIB_FRAME_READY,          // 收到完整且校验正确的一帧
+    LIB_FRAME_ERROR,          // 帧结束, 但 COBS/长度/CRC 错误, 该帧被丢弃
+} Lib_Frame_Status_Type;
+
+/*
+ * @brief   流式解码器, 每个数据源一个
+*/
+typedef struct
+{
+    uint8_t buffer[LIB_FRAME_RAW_MAXSIZE];    // COBS 解码后的数据
+    uint16_t num;                             // buffer 中的字节数
+    uint8_t code;                             // 当前 COBS 块的编码字节
+    uint8_t remain;                           // 当前 COBS 块剩余的字节数
+    uint8_t overflow;                         // 当前帧超长, 丢弃到下一个结束符
+} Lib_Frame_Decoder_Type;
+
+uint16_t Lib_Frame_CRC16(const uint8_t *const data, const uint32_t num, const uint16_t crc);
+uint32_t Lib_Frame_COBS_Encode(const uint8_t *const raw, const uint32_t num, uint8_t *const out);
+int32_t Lib_Frame_COBS_Decode(const uint8_t *const in, const uint32_t num, uint8_t *const out);
+uint32_t Lib_Frame_Encode(const Lib_Frame_Type *const frame, uint8_t *const out);
+void Lib_Frame_Decoder_Init(Lib_Frame_Decoder_Type *const dec);
+Lib_Frame_Status_Type Lib_Frame_Decode_Byte(Lib_Frame_Decoder_Type *const dec, const uint8_t byte, Lib_Frame_Type *const frame);
+
+#endif
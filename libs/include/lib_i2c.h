@@ -5,21 +5,80 @@
 #include "stm32f1xx_ll_i2c.h"
 #include "stm32f1xx_ll_gpio.h"
 
+/*
+ * @brief   I2C 实例的统计, 由 Lib_I2C_Get_Stat() 读取
+*/
+typedef struct
+{
+    uint32_t transfers;         // 完成的传输次数
+    uint32_t bytes;             // 完成的传输的字节数
+    uint32_t nack;              // 从机不应答 (地址或数据), 传输中止的次数
+} Lib_I2C_Stat_Type;
+
+/*
+ * @brief   I2C 实例的运行状态, 每个实例一份, 定义在 lib_i2c.c
+*/
+typedef struct
+{
+    Lib_I2C_Stat_Type stat;
+} Lib_I2C_State_Type;
+
+/*
+ * @brief   I2C 实例: 外设, 时钟, 引脚, 速度和状态
+ * @note    实例是下面的 static const 表, 用 &Lib_I2C1 这样的常量调用时, 编译器直接代入表中的值
+*/
+typedef struct
+{
+    I2C_TypeDef *i2c;
+    uint32_t apb1_periph;       // I2C 的时钟 (LL_APB1_GRP1_PERIPH_*)
+    uint32_t apb2_periph;       // GPIO 的时钟 (LL_APB2_GRP1_PERIPH_*)
+    GPIO_TypeDef *port;         // SCL, SDA 所在端口
+    uint32_t scl_pin;
+    uint32_t sda_pin;
+    uint32_t speed;             // SCL时钟频率，必须不高于400kHz
+    uint32_t addr;              // I2C的地址，必须是唯一的，且在[0x00, 0x3FF]
+    Lib_I2C_State_Type *state;
+} Lib_I2C_Type;
+
 // I2C配置
-#define    LIB_I2C                       I2C1   // 使用I2C1
-#define    LIB_I2C_ENCLK()               LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_I2C1)
-#define    LIB_I2C_SPEED                 400000 // SCL时钟频率，必须不高于400kHz
-#define    LIB_I2C_ADDR                  0x01   // I2C的地址，必须是唯一的，且在[0x00, 0x3FF]
-
-// GPIO配置
-#define    LIB_I2C_SCL_PORT      GPIOB             // I2C1_SCL为PB6
-#define    LIB_I2C_SCL_PIN       LL_GPIO_PIN_6
-#define    LIB_I2C_SDA_PORT      GPIOB             // I2C1_SDA为PB7
-#define    LIB_I2C_SDA_PIN       LL_GPIO_PIN_7
-#define    LIB_I2C_PORT_ENCLK()  LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_GPIOB)
-
-void Lib_I2C_Init(void);
-void Lib_I2C_Send_Data(const uint8_t slave_addr, const uint8_t *const buffer, const uint32_t num);
-void Lib_I2C_Receive_Data(const uint8_t slave_addr, uint8_t *const buffer, const uint32_t num);
-
-#endif
\ No newline at end of file
+#define    LIB_I2C1_EN                   1      // 是否使用I2C1
+#define    LIB_I2C2_EN                   0      // 是否使用I2C2, 引脚与USART3相同
+
+#if LIB_I2C1_EN
+extern Lib_I2C_State_Type Lib_I2C1_State;
+static const Lib_I2C_Type Lib_I2C1 =
+{
+    .i2c = I2C1,
+    .apb1_periph = LL_APB1_GRP1_PERIPH_I2C1,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOB,
+    .port = GPIOB,
+    .scl_pin = LL_GPIO_PIN_6,                   // I2C1_SCL为PB6
+    .sda_pin = LL_GPIO_PIN_7,                   // I2C1_SDA为PB7
+    .speed = 400000,
+    .addr = 0x01,
+    .state = &Lib_I2C1_State,
+};
+#endif
+
+#if LIB_I2C2_EN
+extern Lib_I2C_State_Type Lib_I2C2_State;
+static const Lib_I2C_Type Lib_I2C2 =
+{
+    .i2c = I2C2,
+    .apb1_periph = LL_APB1_GRP1_PERIPH_I2C2,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOB,
+    .port = GPIOB,
+    .scl_pin = LL_GPIO_PIN_10,                  // I2C2_SCL为PB10
+    .sda_pin = LL_GPIO_PIN_11,                  // I2C2_SDA为PB11
+    .speed = 400000,
+    .addr = 0x02,
+    .state = &Lib_I2C2_State,
+};
+#endif
+
+void Lib_I2C_Init(const Lib_I2C_Type *const i2c);
+ErrorStatus Lib_I2C_Send_Data(const Lib_I2C_Type *const i2c, const uint8_t slave_addr, const uint8_t *const buffer, const uint32_t num);
+ErrorStatus Lib_I2C_Receive_Data(const Lib_I2C_Type *const i2c, const uint8_t slave_addr, uint8_t *const buffer, const uint32_t num);
+void Lib_I2C_Get_Stat(const Lib_I2C_Type *const i2c, Lib_I2C_Stat_Type *const stat);
+
+#endif
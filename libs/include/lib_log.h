@@ -0,0 +1,51 @@
+#ifndef _LIB_LOG_H
+#define _LIB_LOG_H
+
+#include <stdint.h>
+#include "lib_usart.h"
+
+/*
+ * @brief   日志, 用法与 printf 相同: LIB_LOG("Temperature: %d\n", temp);
+ * @note    1) 延迟模式 (LIB_LOG_DEFERRED_EN 为 1) 下格式字符串不下载到单片机, 只保留在 ELF 的 .lib_log 段中,
+ *             单片机只发送一条记录, 由上位机 host/log_tool 读取 ELF 还原文本.
+ *             记录 (COBS 编码前): id + 时间增量 + 参数 + 校验(1)
+ *                 id       格式字符串在 .lib_log 段中的偏移, varint
+ *                 时间增量 与上一条记录的 Lib_Log_Get_Time() 之差, 右移 LIB_LOG_TIME_SHIFT 位, varint
+ *                 参数     每个参数按 zigzag 编码为 varint, 个数由格式字符串决定
+ *                 校验     CRC-16/CCITT-FALSE 的低 8 位
+ *             COBS 编码后前后各有一个 0x00, 与普通文本混在一起时上位机也能分开.
+ *          2) 延迟模式下参数只能是 32 位以内的整数 (%d %i %u %x %X %c), 最多 LIB_LOG_ARGS_MAXNUM 个,
+ *             不支持 %s 和 %f (字符串和浮点数不在记录中)
+ *          3) 链接脚本需要 .lib_log 段, 见 STM32F103XX_FLASH.ld
+ *          4) 文本模式 (LIB_LOG_DEFERRED_EN 为 0) 下直接调用 Lib_USART_Send_fString()
+*/
+#define LIB_LOG_DEFERRED_EN              0         // 是否使用延迟日志
+#if LIB_LOG_DEFERRED_EN
+    #include "lib_tool.h"
+    #define LIB_LOG_ARGS_MAXNUM              8         // 参数最多个数
+    // 时间戳, 单位为 1/LIB_TOOL_AHB_FREQUENCY, 需要先 Lib_Tool_DWT_Init(); 两条日志的间隔不能超过 59 s
+    #define Lib_Log_Get_Time()               (DWT->CYCCNT)
+    // 时间增量右移的位数, 10 时单位为 14.2 us, 间隔 2 s 的时间增量占 3 字节; 上位机 log_tool -f 为 72 MHz >> 10
+    #define LIB_LOG_TIME_SHIFT               10
+    // 记录的发送
+    #define Lib_Log_Send_Data(data, num)     Lib_USART_Send_Data(data, num)
+    // 记录的最大字节数: id + 时间增量 + 参数 (varint 每个最多 5 字节) + 校验
+    #define LIB_LOG_RECORD_MAXSIZE           (5 + 5 + 5 * LIB_LOG_ARGS_MAXNUM + 1)
+
+    // 参数个数, 0 ~ 8
+    #define LIB_LOG_NARGS(...)               LIB_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+    #define LIB_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)   n
+
+    #define LIB_LOG(fmt, ...)                                                                        \
+        do                                                                                           \
+        {                                                                                            \
+            static const char Lib_Log_Fmt[] __attribute__((section(".lib_log"), used)) = fmt;        \
+            Lib_Log_Write((uint32_t)Lib_Log_Fmt, LIB_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);         \
+        } while (0)
+
+    void Lib_Log_Write(const uint32_t id, const uint8_t num_args, ...);
+#else
+    #define LIB_LOG(fmt, ...)                Lib_USART_Send_fString(fmt, ##__VA_ARGS__)
+#endif
+
+#endif
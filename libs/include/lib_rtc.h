@@ -51,7 +51,7 @@ typedef struct {
 } Lib_RTC_DateType;
 
 /*
- * @brief   所在的 UTC 时区
+ * @brief   所在的 UTC 时区和上电时的 RTC 时间, 都是默认值: 运行时可由 Lib_RTC_Set_Timezone() 和 Lib_RTC_Set_Time() 修改
 */
 #define LIB_RTC_TIMEZONE        (+8)
 #define LIB_RTC_UNIX        1735689600 
@@ -63,6 +63,7 @@ typedef struct {
 
 void Lib_RTC_Init(void);
 void Lib_RTC_Set_Time(const Lib_RTC_UnixType ts);
+ErrorStatus Lib_RTC_Set_Timezone(const int32_t timezone);
 Lib_RTC_UnixType Lib_RTC_Read_Time(void);
 Lib_RTC_UnixType Lib_RTC_Date2Unix(const Lib_RTC_DateType *dt);
 void Lib_RTC_Unix2Date(const Lib_RTC_UnixType timestamp, Lib_RTC_DateType* dt);
@@ -4,33 +4,233 @@
 #include "stm32f1xx_ll_bus.h"
 #include "stm32f1xx_ll_gpio.h"
 #include "stm32f1xx_ll_spi.h"
+#include "stm32f1xx_ll_dma.h"
+
+/*
+ * @brief   传输完成回调函数类型
+ * @param   arg    Lib_SPI_Transfer_Start() 传入的参数
+ *          status SUCCESS; ERROR: DMA 传输错误或接收溢出, 传输被中止, 接收的数据不完整
+ * @note    使用 DMA 时在 DMA 中断中调用
+*/
+typedef void (*Lib_SPI_Callback_Type)(void *const arg, const ErrorStatus status);
+
+/*
+ * @brief   SPI 实例的统计, 由 Lib_SPI_Get_Stat() 读取
+ * @note    Lib_SPI_Send_Byte() 等内联的逐字节函数不计入
+*/
+typedef struct
+{
+    uint32_t transfers;                 // 完成的块传输次数 (DMA 或轮询)
+    uint32_t bytes;                     // 块传输的字节数
+    uint32_t overrun;                   // 轮询块传输的接收溢出 (OVR) 次数
+    uint32_t dma_error;                 // DMA 传输错误 (TE) 而中止的块传输次数
+    uint32_t busy;                      // 上一次传输未完成, Lib_SPI_Transfer_Start() 被拒绝的次数
+    uint32_t locked;                    // 总线被占用, Lib_SPI_Begin() 失败的次数
+} Lib_SPI_Stat_Type;
+
+/*
+ * @brief   SPI 实例的运行状态, 每个实例一份, 定义在 lib_spi.c
+*/
+typedef struct
+{
+    volatile uint8_t busy;              // 是否有传输未完成
+    const uint8_t *tx;                  // 下一段要发送的数据, 0 表示发送 LIB_SPI_DUMMY
+    uint8_t *rx;                        // 下一段接收数据的位置, 0 表示丢弃
+    uint32_t num;                       // 还没有交给 DMA 的字节数
+    Lib_SPI_Callback_Type callback;
+    void *arg;
+    uint32_t mode;                      // CR1 中 CPOL, CPHA, BR, LSBFIRST 的当前值, 用于判断是否需要重新配置
+    volatile uint8_t locked;            // 总线是否被占用, 见 Lib_SPI_Begin()
+    GPIO_TypeDef *cs_port;              // 批处理中保持为低的片选, 0 表示没有
+    uint32_t cs_pin;
+    volatile Lib_SPI_Stat_Type stat;    // 统计, DMA 中断和其他上下文都会修改
+} Lib_SPI_State_Type;
+
+/*
+ * @brief   SPI 实例: 外设, 时钟, 引脚和通信参数
+ * @note    1) 实例是下面的 static const 表, 用 &Lib_SPI1 这样的常量调用时, 编译器直接代入表中的值,
+ *             与原来的 LIB_SPI 等宏相同, 没有额外的运行开销
+ *          2) SCK, MISO, MOSI 在同一个端口上; NSS 由软件控制, 可以是任意引脚
+ *          3) dma 为 0 时, Lib_SPI_Transfer() 等块传输函数以轮询方式完成
+*/
+typedef struct
+{
+    SPI_TypeDef *spi;
+    uint32_t apb1_periph;       // APB1 上需要开启的时钟 (LL_APB1_GRP1_PERIPH_*), 0 表示没有
+    uint32_t apb2_periph;       // APB2 上需要开启的时钟 (LL_APB2_GRP1_PERIPH_*), 包括 GPIO
+    GPIO_TypeDef *port;         // SCK, MISO, MOSI 所在端口
+    uint32_t sck_pin;
+    uint32_t miso_pin;
+    uint32_t mosi_pin;
+    GPIO_TypeDef *nss_port;
+    uint32_t nss_pin;
+    uint32_t cpol;
+    uint32_t cpha;
+    uint32_t bit_order;
+    uint32_t baud_rate;         // 分频系数, f_SCK = f_pclk / 分频
+    DMA_TypeDef *dma;           // 块传输使用的 DMA, 0 表示不使用
+    uint32_t dma_rx_ch;         // 接收通道 (LL_DMA_CHANNEL_*), 其传输完成中断表示整个传输完成
+    uint32_t dma_tx_ch;         // 发送通道
+    IRQn_Type dma_irq;          // 接收通道的中断
+    IRQn_Type dma_tx_irq;       // 发送通道的中断, 只用于传输错误
+    uint8_t dma_preempt_priority;
+    uint8_t dma_sub_priority;
+    Lib_SPI_State_Type *state;
+} Lib_SPI_Type;
 
 // SPI 配置
-#define LIB_SPI_ENCLK()                 LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SPI1)
-#define LIB_SPI                         SPI1                                                    // 使用SPI1
-#define LIB_SPI_CPOL                    LL_SPI_POLARITY_LOW                                     // 模式 0 的 CPOL 和 CPHA 都是 0
-#define LIB_SPI_CPHA                    LL_SPI_PHASE_1EDGE
-#define LIB_SPI_BIT_ORDER               LL_SPI_MSB_FIRST                                        // MSB 先发送
-#define LIB_SPI_BAUD_RATE               LL_SPI_BAUDRATEPRESCALER_DIV2                           // f_SCK = f_pclk / 2
-
-// GPIO配置             
-#define LIB_SPI_PORT_ENCLK()            LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_GPIOA) 
-#define LIB_SPI_NSS_PORT                GPIOA                                                   // SPI1_NSS 为 PA4
-#define LIB_SPI_NSS_PIN                 LL_GPIO_PIN_4                                         
-#define LIB_SPI_SCK_PORT                GPIOA                                                   // SPI1_SCK 为 PA5
-#define LIB_SPI_SCK_PIN                 LL_GPIO_PIN_5                                         
-#define LIB_SPI_MISO_PORT               GPIOA                                                   // SPI1_MISO 为 PA6
-#define LIB_SPI_MISO_PIN                LL_GPIO_PIN_6                                         
-#define LIB_SPI_MOSI_PORT               GPIOA                                                   // SPI1_MOSI 为 PA7
-#define LIB_SPI_MOSI_PIN                LL_GPIO_PIN_7
+#define LIB_SPI1_EN                     1                                                       // 是否使用 SPI1
+#define LIB_SPI2_EN                     0                                                       // 是否使用 SPI2
+#define LIB_SPI1_DMA_EN                 0                                                       // SPI1 块传输是否使用 DMA1 通道 2 (RX) 和 3 (TX)
+#define LIB_SPI2_DMA_EN                 0                                                       // SPI2 块传输是否使用 DMA1 通道 4 (RX) 和 5 (TX), 与 USART1 的 DMA 冲突
+
+#if LIB_SPI1_EN
+#if LIB_SPI1_DMA_EN
+    #define Lib_SPI1_DMA_RX_Handler     DMA1_Channel2_IRQHandler                                // DMA1通道2的中断服务函数
+    #define Lib_SPI1_DMA_TX_Handler     DMA1_Channel3_IRQHandler                                // DMA1通道3的中断服务函数
+#endif
+// SPI1 挂在 APB2 (72 MHz) 上
+extern Lib_SPI_State_Type Lib_SPI1_State;
+static const Lib_SPI_Type Lib_SPI1 =
+{
+    .spi = SPI1,
+    .apb1_periph = 0,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_SPI1 | LL_APB2_GRP1_PERIPH_GPIOA,
+    .port = GPIOA,                                                                              // SPI1_SCK 为 PA5
+    .sck_pin = LL_GPIO_PIN_5,
+    .miso_pin = LL_GPIO_PIN_6,                                                                  // SPI1_MISO 为 PA6
+    .mosi_pin = LL_GPIO_PIN_7,                                                                  // SPI1_MOSI 为 PA7
+    .nss_port = GPIOA,                                                                          // SPI1_NSS 为 PA4
+    .nss_pin = LL_GPIO_PIN_4,
+    .cpol = LL_SPI_POLARITY_LOW,                                                                // 模式 0 的 CPOL 和 CPHA 都是 0
+    .cpha = LL_SPI_PHASE_1EDGE,
+    .bit_order = LL_SPI_MSB_FIRST,                                                              // MSB 先发送
+    .baud_rate = LL_SPI_BAUDRATEPRESCALER_DIV2,                                                 // f_SCK = 72 MHz / 2
+#if LIB_SPI1_DMA_EN
+    .dma = DMA1,
+#else
+    .dma = 0,
+#endif
+    .dma_rx_ch = LL_DMA_CHANNEL_2,                                                              // SPI1_RX 对应通道 2
+    .dma_tx_ch = LL_DMA_CHANNEL_3,                                                              // SPI1_TX 对应通道 3
+    .dma_irq = DMA1_Channel2_IRQn,
+    .dma_tx_irq = DMA1_Channel3_IRQn,
+    .dma_preempt_priority = 0,
+    .dma_sub_priority = 0,
+    .state = &Lib_SPI1_State,
+};
+#endif
+
+#if LIB_SPI2_EN
+#if LIB_SPI2_DMA_EN
+    #define Lib_SPI2_DMA_RX_Handler     DMA1_Channel4_IRQHandler                                // DMA1通道4的中断服务函数
+    #define Lib_SPI2_DMA_TX_Handler     DMA1_Channel5_IRQHandler                                // DMA1通道5的中断服务函数
+#endif
+// SPI2 挂在 APB1 (36 MHz) 上
+extern Lib_SPI_State_Type Lib_SPI2_State;
+static const Lib_SPI_Type Lib_SPI2 =
+{
+    .spi = SPI2,
+    .apb1_periph = LL_APB1_GRP1_PERIPH_SPI2,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOB,
+    .port = GPIOB,                                                                              // SPI2_SCK 为 PB13
+    .sck_pin = LL_GPIO_PIN_13,
+    .miso_pin = LL_GPIO_PIN_14,                                                                 // SPI2_MISO 为 PB14
+    .mosi_pin = LL_GPIO_PIN_15,                                                                 // SPI2_MOSI 为 PB15
+    .nss_port = GPIOB,                                                                          // SPI2_NSS 为 PB12
+    .nss_pin = LL_GPIO_PIN_12,
+    .cpol = LL_SPI_POLARITY_LOW,
+    .cpha = LL_SPI_PHASE_1EDGE,
+    .bit_order = LL_SPI_MSB_FIRST,
+    .baud_rate = LL_SPI_BAUDRATEPRESCALER_DIV2,                                                 // f_SCK = 36 MHz / 2
+#if LIB_SPI2_DMA_EN
+    .dma = DMA1,
+#else
+    .dma = 0,
+#endif
+    .dma_rx_ch = LL_DMA_CHANNEL_4,                                                              // SPI2_RX 对应通道 4
+    .dma_tx_ch = LL_DMA_CHANNEL_5,                                                              // SPI2_TX 对应通道 5
+    .dma_irq = DMA1_Channel4_IRQn,
+    .dma_tx_irq = DMA1_Channel5_IRQn,
+    .dma_preempt_priority = 0,
+    .dma_sub_priority = 0,
+    .state = &Lib_SPI2_State,
+};
+#endif
+
+/*
+ * @brief   SPI 总线上的设备: 片选和通信参数
+ * @note    1) 同一总线上的设备通信参数可以不同, Lib_SPI_Begin() 只在参数与总线当前参数不同时才修改 CR1
+ *          2) batch 为 1 时, Lib_SPI_End() 不拉高片选, 同一设备紧接着的下一次 Lib_SPI_Begin() 省去片选的切换,
+ *             适合显示屏等连续写入的设备; FLASH 等以片选上升沿结束指令的设备必须为 0
+ *          3) 与实例一样, 设备是模块头文件中的 static const 表
+*/
+typedef struct
+{
+    const Lib_SPI_Type *spi;    // 所在总线
+    uint32_t apb2_periph;       // 片选 GPIO 的时钟
+    GPIO_TypeDef *cs_port;
+    uint32_t cs_pin;
+    uint32_t cpol;
+    uint32_t cpha;
+    uint32_t bit_order;
+    uint32_t baud_rate;
+    uint8_t batch;
+} Lib_SPI_Device_Type;
 
 // SPI 控制
-#define LIB_SPI_START()                 LL_GPIO_ResetOutputPin(LIB_SPI_NSS_PORT, LIB_SPI_NSS_PIN)   // NSS 低电平表示通信开始
-#define LIB_SPI_STOP()                  LL_GPIO_SetOutputPin(LIB_SPI_NSS_PORT, LIB_SPI_NSS_PIN)     // NSS 高电平表示通信结束
+#define Lib_SPI_Start(spi)              LL_GPIO_ResetOutputPin((spi)->nss_port, (spi)->nss_pin)   // NSS 低电平表示通信开始
+#define Lib_SPI_Stop(spi)               LL_GPIO_SetOutputPin((spi)->nss_port, (spi)->nss_pin)     // NSS 高电平表示通信结束
 #define LIB_SPI_DUMMY                   0x00                                                        // 无效数据, 用于等待或接收
+#define LIB_SPI_DMA_MAXSIZE             65535                                                       // DMA 一次最多传输的字节数, 更长的传输分段进行
+
+// 块传输, 见 Lib_SPI_Transfer()
+#define Lib_SPI_Send_Data(spi, tx, num)         Lib_SPI_Transfer(spi, tx, (void *)0, num)           // 只发送, 丢弃收到的数据
+#define Lib_SPI_Receive_Data(spi, rx, num)      Lib_SPI_Transfer(spi, (void *)0, rx, num)           // 只接收, 发送 LIB_SPI_DUMMY
+
+void Lib_SPI_Init(const Lib_SPI_Type *const spi);
+ErrorStatus Lib_SPI_Transfer_Start(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx,
+                                   const uint32_t num, const Lib_SPI_Callback_Type callback, void *const arg);
+void Lib_SPI_Transfer(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num);
+void Lib_SPI_Wait(const Lib_SPI_Type *const spi);
+ErrorStatus Lib_SPI_Burst(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num);
+ErrorStatus Lib_SPI_Burst16(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num);
+void Lib_SPI_DMA_IT_Handler(const Lib_SPI_Type *const spi);
+void Lib_SPI_Device_Init(const Lib_SPI_Device_Type *const dev);
+ErrorStatus Lib_SPI_Begin(const Lib_SPI_Device_Type *const dev);
+void Lib_SPI_End(const Lib_SPI_Device_Type *const dev);
+void Lib_SPI_Flush(const Lib_SPI_Type *const spi);
+void Lib_SPI_Get_Stat(const Lib_SPI_Type *const spi, Lib_SPI_Stat_Type *const stat);
+#if LIB_SPI1_EN && LIB_SPI1_DMA_EN
+void Lib_SPI1_DMA_RX_Handler(void);
+void Lib_SPI1_DMA_TX_Handler(void);
+#endif
+#if LIB_SPI2_EN && LIB_SPI2_DMA_EN
+void Lib_SPI2_DMA_RX_Handler(void);
+void Lib_SPI2_DMA_TX_Handler(void);
+#endif
+
+// 是否有传输未完成
+#define Lib_SPI_Is_Busy(spi)            ((spi)->state->busy)
+
+// 使用前需要 Lib_SPI_Start(); 内联, 逐字节调用时不多一次函数调用和查表
+static inline uint8_t Lib_SPI_Send_Byte(const Lib_SPI_Type *const spi, const uint8_t data)
+{
+    while (LL_SPI_IsActiveFlag_TXE(spi->spi) != SET);
+    LL_SPI_TransmitData8(spi->spi, data);
+    // SPI 全双工工作, 发送的同时也在接收
+    // 发送了一个数据, 也意味着接收了一个数据
+    // 接收的数据是否有效取决于实际情况
+    while (LL_SPI_IsActiveFlag_RXNE(spi->spi) != SET);
+    return LL_SPI_ReceiveData8(spi->spi);
+}
 
-void Lib_SPI_Init(void);
-uint8_t Lib_SPI_Send_Byte(uint8_t data);
-uint8_t Lib_SPI_Receive_Byte(void);
+// 使用前需要 Lib_SPI_Start()
+static inline uint8_t Lib_SPI_Receive_Byte(const Lib_SPI_Type *const spi)
+{
+    // SPI 全双工工作, 发送的同时也在接收
+    // 接收数据, 可以发送一个任意数据
+    return Lib_SPI_Send_Byte(spi, LIB_SPI_DUMMY);
+}
 
-#endif
\ No newline at end of file
+#endif
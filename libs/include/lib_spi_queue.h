@@ -0,0 +1,90 @@
+#ifndef _LIB_SPI_QUEUE_H
+#define _LIB_SPI_QUEUE_H
+
+#include <stdint.h>
+
+/*
+ * @brief   SPI 异步传输队列: 调用者提交描述符后立即返回, 由 DMA 中断依次完成, 完成后调用描述符的回调
+ * @note    1) 每个描述符是一次完整的片选周期: 指令阶段 (1 字节, 可选) + 地址阶段 (0 ~ 4 字节, MSB 在前)
+ *             + 空周期 (0 ~ LIB_SPI_QUEUE_DUMMY_MAXSIZE 字节) + 数据阶段 (发送, 接收或同时)
+ *          2) 描述符带 LIB_SPI_QUEUE_CS_HOLD 时, 完成后不拉高片选也不释放总线, 下一个同一设备的描述符
+ *             接着在同一个片选周期内传输, 例如分散到多个缓冲区的读取; 最后一个描述符不带该标志
+ *          3) 描述符和缓冲区由调用者提供, 在回调之前必须保持有效; 队列不分配内存
+ *          4) 总线被占用 (Lib_SPI_Begin() 失败) 时暂停, 需要在主循环或定时中断中调用 Lib_SPI_Queue_Poll() 重试
+ *          5) 上位机模拟 (host/spi_queue_sim.c) 定义 LIB_SPI_QUEUE_PORT, 替换下面的接口
+*/
+#ifdef LIB_SPI_QUEUE_PORT
+    #include LIB_SPI_QUEUE_PORT
+#else
+    #include "lib_spi.h"
+    // 接口
+    #define Lib_SPI_Queue_Begin(dev)                                Lib_SPI_Begin(dev)
+    #define Lib_SPI_Queue_End(dev)                                  Lib_SPI_End(dev)
+    #define Lib_SPI_Queue_Transfer(dev, tx, rx, num, callback, arg) Lib_SPI_Transfer_Start((dev)->spi, tx, rx, num, callback, arg)
+    #define Lib_SPI_Queue_Lock(primask)                             do { primask = __get_PRIMASK(); __disable_irq(); } while (0)
+    #define Lib_SPI_Queue_Unlock(primask)                           __set_PRIMASK(primask)
+#endif
+
+#define LIB_SPI_QUEUE_DUMMY_MAXSIZE      4         // 空周期最多的字节数
+
+// 描述符的标志
+#define LIB_SPI_QUEUE_CMD                0x01      // 有指令阶段
+#define LIB_SPI_QUEUE_CS_HOLD            0x02      // 完成后保持片选, 与下一个描述符属于同一个片选周期
+
+// 描述符的结果
+#define LIB_SPI_QUEUE_RES_PENDING        0x00      // 在队列中
+#define LIB_SPI_QUEUE_RES_OK             0x01      // 已完成
+#define LIB_SPI_QUEUE_RES_CANCELLED      0x02      // 被 Lib_SPI_Queue_Cancel() 取消
+#define LIB_SPI_QUEUE_RES_ERROR          0x03      // 传输失败 (DMA 传输错误或接收溢出), 跳过剩余阶段并拉高片选
+
+struct Lib_SPI_Queue_Trans;
+
+/*
+ * @brief   完成回调函数类型
+ * @note    在 DMA 中断中调用 (不使用 DMA 时在提交或 Lib_SPI_Queue_Poll() 中调用); 可以在回调中提交新的描述符
+*/
+typedef void (*Lib_SPI_Queue_Callback_Type)(struct Lib_SPI_Queue_Trans *const trans);
+
+/*
+ * @brief   传输描述符
+*/
+typedef struct Lib_SPI_Queue_Trans
+{
+    const Lib_SPI_Device_Type *dev;         // 设备
+    uint8_t flags;                          // LIB_SPI_QUEUE_CMD, LIB_SPI_QUEUE_CS_HOLD
+    uint8_t cmd;                            // 指令
+    uint8_t addr_len;                       // 地址的字节数, 0 ~ 4
+    uint8_t dummy_len;                      // 空周期的字节数, 0 ~ LIB_SPI_QUEUE_DUMMY_MAXSIZE
+    uint32_t addr;
+    const uint8_t *tx;                      // 数据阶段发送的数据, 为 0 时发送 LIB_SPI_DUMMY
+    uint8_t *rx;                            // 数据阶段接收的位置, 为 0 时丢弃
+    uint32_t num;                           // 数据阶段的字节数, 可以为 0
+    Lib_SPI_Queue_Callback_Type callback;   // 完成或取消时调用, 可以为 0
+    void *arg;                              // 调用者使用
+    volatile uint8_t result;                // LIB_SPI_QUEUE_RES_*
+    struct Lib_SPI_Queue_Trans *next;       // 队列内部使用
+} Lib_SPI_Queue_Trans_Type;
+
+/*
+ * @brief   队列, 一条总线一个; 由 Lib_SPI_Queue_Init() 初始化
+*/
+typedef struct
+{
+    Lib_SPI_Queue_Trans_Type *head;         // 正在传输或等待总线的描述符
+    Lib_SPI_Queue_Trans_Type *tail;
+    const Lib_SPI_Device_Type *held;        // 因 LIB_SPI_QUEUE_CS_HOLD 而保持片选的设备, 0 表示没有
+    uint8_t phase;                          // 队首描述符的阶段
+    volatile uint8_t busy;                  // 是否在等待传输完成
+    volatile uint8_t error;                 // 队首描述符的某次传输失败
+    volatile uint8_t running;               // Lib_SPI_Queue_Step() 是否正在执行
+    volatile uint8_t again;                 // 执行期间传输已完成, 需要继续
+    uint8_t header[1 + 4 + LIB_SPI_QUEUE_DUMMY_MAXSIZE];   // 指令, 地址和空周期
+} Lib_SPI_Queue_Type;
+
+void Lib_SPI_Queue_Init(Lib_SPI_Queue_Type *const queue);
+void Lib_SPI_Queue_Submit(Lib_SPI_Queue_Type *const queue, Lib_SPI_Queue_Trans_Type *const trans);
+ErrorStatus Lib_SPI_Queue_Cancel(Lib_SPI_Queue_Type *const queue, Lib_SPI_Queue_Trans_Type *const trans);
+void Lib_SPI_Queue_Poll(Lib_SPI_Queue_Type *const queue);
+uint8_t Lib_SPI_Queue_Is_Idle(const Lib_SPI_Queue_Type *const queue);
+
+#endif
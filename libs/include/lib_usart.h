@@ -1,74 +1,348 @@
 #ifndef _LIB_USART_H
 #define _LIB_USART_H
 
+/*
+ * @note    上位机模拟 (host/usart_sim.c) 定义 LIB_USART_PORT, 替换寄存器, DMA, 中断屏蔽和 DWT 计时,
+ *          并打开要测试的功能; 下面的功能开关都可以这样在编译时覆盖
+*/
+#ifdef LIB_USART_PORT
+    #include LIB_USART_PORT
+#else
 #include "stm32f1xx_ll_bus.h"
 #include "stm32f1xx_ll_gpio.h"
 #include "stm32f1xx_ll_usart.h"
 #include "stm32f1xx_ll_dma.h"
+#include "stm32f1xx_ll_rcc.h"
+
+// DMA 的地址寄存器为 32 位
+#define Lib_USART_DMA_Addr(p)    ((uint32_t)(p))
+#endif
+#include "lib_format.h"
+
+/*
+ * @brief   链路统计, 用于诊断链路是否饱和
+ * @note    错误计数需要开启接收中断; 阻塞时间需要 LIB_USART_DMA_EN 为 1 并开启 DWT
+*/
+typedef struct
+{
+    uint32_t overrun;       // 溢出错误 (ORE): 上一个字节未被读走时又收到新字节, 新字节丢失
+    uint32_t framing;       // 帧错误 (FE): 没有检测到停止位, 多为波特率不一致或线路干扰
+    uint32_t noise;         // 噪声错误 (NE)
+    uint32_t tx_dropped;    // 发送缓冲区满时丢弃的字节数 (LIB_USART_TX_POLICY 为 DROP 或 OVERWRITE)
+    uint32_t tx_stall_us;   // 发送缓冲区满时发送函数阻塞的总时间 (LIB_USART_TX_POLICY 为 BLOCK)
+    uint32_t rx_paused;     // 拉高 RTS 暂停接收的次数
+    uint32_t rx_dropped;    // 控制台: 指令队列满时丢弃的帧数; 其他实例: 接收缓冲区满时丢弃的字节数
+} Lib_USART_Stat_Type;
+
+/*
+ * @brief   USART 实例的运行状态, 每个实例一份, 定义在 lib_usart.c
+*/
+typedef struct
+{
+    uint32_t baud;                  // 当前波特率
+    volatile Lib_USART_Stat_Type stat;  // 链路统计, 由中断累加
+    volatile uint32_t rx_head;      // 接收缓冲区的写入计数, 只由接收中断修改
+    volatile uint32_t rx_tail;      // 接收缓冲区的读取计数, 只由 Lib_USART_Port_Receive() 修改
+} Lib_USART_State_Type;
+
+/*
+ * @brief   USART 实例: 外设, 时钟, 引脚, 波特率, 接收缓冲区和状态
+ * @note    1) 实例是下面的 static const 表, 用 &Lib_USART2 这样的常量调用时, 编译器直接代入表中的值,
+ *             与原来的 LIB_USART 等宏相同, 没有额外的运行开销
+ *          2) USART1 是控制台: Lib_USART_Init(), Lib_USART_Send_*() 等不带实例的函数只操作 USART1,
+ *             中断, DMA, 流控和指令都在控制台上; 其他实例用 Lib_USART_Port_*(), 轮询发送, 中断接收
+*/
+typedef struct
+{
+    USART_TypeDef *usart;
+    uint32_t apb1_periph;           // APB1 上需要开启的时钟 (LL_APB1_GRP1_PERIPH_*), 0 表示没有
+    uint32_t apb2_periph;           // APB2 上需要开启的时钟 (LL_APB2_GRP1_PERIPH_*), 包括 GPIO
+    GPIO_TypeDef *port;             // TX, RX 所在端口
+    uint32_t tx_pin;
+    uint32_t rx_pin;
+    uint32_t baud;                  // 上电后的波特率; 运行时可由 Lib_USART_Port_Set_Baud() 修改
+    IRQn_Type irq;
+    uint8_t preempt_priority;
+    uint8_t sub_priority;
+    uint8_t *rx_buffer;             // 接收缓冲区, 为 0 时不开启接收中断
+    uint32_t rx_size;               // 接收缓冲区大小, 必须是 2 的幂
+    Lib_USART_State_Type *state;
+} Lib_USART_Type;
 
 // USART配置
-#define LIB_USART                USART1   // 使用USART1
-#define LIB_USART_ENCLK()        LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_USART1) // 使能USART1的时钟
-#define LIB_USART_BAUD_RATE      115200   // 波特率为115.2Kbps
+#define LIB_USART_BAUD_TOLERANCE 50       // 实际波特率的误差不超过 1/50 (2%)
+#define LIB_USART2_EN            0        // 是否使用USART2
+#define LIB_USART3_EN            0        // 是否使用USART3, 引脚与I2C2相同
+
+// USART1 (控制台) 挂在 APB2 上, 16 倍过采样, 最高 PCLK2 / 16 (72 MHz 时为 4.5Mbps)
+extern Lib_USART_State_Type Lib_USART1_State;
+static const Lib_USART_Type Lib_USART1 =
+{
+    .usart = USART1,
+    .apb1_periph = 0,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_USART1 | LL_APB2_GRP1_PERIPH_GPIOA,
+    .port = GPIOA,
+    .tx_pin = LL_GPIO_PIN_9,                // USART1的TX为PA9
+    .rx_pin = LL_GPIO_PIN_10,               // USART1的RX为PA10
+    .baud = 115200,                         // 波特率为115.2Kbps
+    .irq = USART1_IRQn,                     // 中断由 LIB_USART_IT_EN 配置
+    .preempt_priority = 0,
+    .sub_priority = 0,
+    .rx_buffer = 0,                         // 控制台的接收见 LIB_USART_IT_EN
+    .rx_size = 0,
+    .state = &Lib_USART1_State,
+};
+#define LIB_USART_CONSOLE        (&Lib_USART1)
+#define LIB_USART                USART1   // 控制台使用USART1
+
+#if LIB_USART2_EN
+    // USART2 挂在 APB1 上, 最高 PCLK1 / 16 (36 MHz 时为 2.25Mbps)
+    #define LIB_USART2_RX_BUFFER_SIZE    64                   // 必须是 2 的幂
+    #define Lib_USART2_IT_Handler        USART2_IRQHandler    // USART2的中断服务函数
+    extern Lib_USART_State_Type Lib_USART2_State;
+    extern uint8_t Lib_USART2_RX_Buffer[LIB_USART2_RX_BUFFER_SIZE];
+    static const Lib_USART_Type Lib_USART2 =
+    {
+        .usart = USART2,
+        .apb1_periph = LL_APB1_GRP1_PERIPH_USART2,
+        .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOA,
+        .port = GPIOA,
+        .tx_pin = LL_GPIO_PIN_2,            // USART2的TX为PA2
+        .rx_pin = LL_GPIO_PIN_3,            // USART2的RX为PA3
+        .baud = 115200,
+        .irq = USART2_IRQn,
+        .preempt_priority = 1,
+        .sub_priority = 0,
+        .rx_buffer = Lib_USART2_RX_Buffer,
+        .rx_size = LIB_USART2_RX_BUFFER_SIZE,
+        .state = &Lib_USART2_State,
+    };
+#endif
 
-// GPIO配置
-#define LIB_USART_TX_PORT        GPIOA    // USART1的TX为PA9
-#define LIB_USART_TX_PIN         LL_GPIO_PIN_9
-#define LIB_USART_RX_PORT        GPIOA    // USART1的RX为PA10
-#define LIB_USART_RX_PIN         LL_GPIO_PIN_10
-#define LIB_USART_PORT_ENCLK()   LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_GPIOA) // 使能GPIOA的时钟
+#if LIB_USART3_EN
+    // USART3 挂在 APB1 上, 最高 PCLK1 / 16 (36 MHz 时为 2.25Mbps)
+    #define LIB_USART3_RX_BUFFER_SIZE    64                   // 必须是 2 的幂
+    #define Lib_USART3_IT_Handler        USART3_IRQHandler    // USART3的中断服务函数
+    extern Lib_USART_State_Type Lib_USART3_State;
+    extern uint8_t Lib_USART3_RX_Buffer[LIB_USART3_RX_BUFFER_SIZE];
+    static const Lib_USART_Type Lib_USART3 =
+    {
+        .usart = USART3,
+        .apb1_periph = LL_APB1_GRP1_PERIPH_USART3,
+        .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOB,
+        .port = GPIOB,
+        .tx_pin = LL_GPIO_PIN_10,           // USART3的TX为PB10
+        .rx_pin = LL_GPIO_PIN_11,           // USART3的RX为PB11
+        .baud = 115200,
+        .irq = USART3_IRQn,
+        .preempt_priority = 1,
+        .sub_priority = 0,
+        .rx_buffer = Lib_USART3_RX_Buffer,
+        .rx_size = LIB_USART3_RX_BUFFER_SIZE,
+        .state = &Lib_USART3_State,
+    };
+#endif
+
+// 硬件流控 (RTS/CTS)
+// CTS 由硬件处理: 上位机拉高 CTS 时, USART 发完当前字节后暂停, DMA 和发送缓冲区随之等待, 数据不丢失
+// RTS 是软件控制的 GPIO: DMA 接收缓冲区超过高水位, 指令队列将满或调用 Lib_USART_RX_Pause() 时拉高,
+// 通知上位机暂停发送; 缓冲区读到低水位以下, 指令队列清空后拉低.
+// F1 的硬件 RTS 只反映 1 字节的 DR, 不知道上层缓冲区, 所以不用
+#ifndef LIB_USART_FLOW_EN
+    #define LIB_USART_FLOW_EN    0        // 是否启用 RTS/CTS
+#endif
+#if LIB_USART_FLOW_EN
+    #define LIB_USART_CTS_PORT       GPIOA    // USART1的CTS为PA11, 低电平允许发送
+    #define LIB_USART_CTS_PIN        LL_GPIO_PIN_11
+    #define LIB_USART_RTS_PORT       GPIOA    // USART1的RTS为PA12, 低电平允许上位机发送
+    #define LIB_USART_RTS_PIN        LL_GPIO_PIN_12
+#endif
 
 // USART的中断配置
-#define LIB_USART_IT_EN              0    // 是否启用中断
+#ifndef LIB_USART_IT_EN
+    #define LIB_USART_IT_EN          0    // 是否启用中断
+#endif
 #if LIB_USART_IT_EN
     #define LIB_USART_IRQ                USART1_IRQn  // USART1的中断编号
     #define LIB_USART_PREEMPT_PRIORITY   0    // 抢占优先级
     #define LIB_USART_SUB_PRIORITY       0    // 子优先级
-    #define LIB_USART_IT_RX_EN           1    // 是否启用接收中断
+    #ifndef LIB_USART_IT_RX_EN
+        #define LIB_USART_IT_RX_EN       1    // 是否启用接收中断 (逐字节, 与 LIB_USART_DMA_RX_EN 互斥)
+    #endif
     #define Lib_USART_IT_Handler         USART1_IRQHandler  // USART1的中断服务函数
-    #define LIB_USART_BUFFER_MAXSIZE        100
+    #define LIB_USART_BUFFER_MAXSIZE        256  // 使用 DMA 接收时, 为循环缓冲区大小, 必须是 2 的幂
     extern uint8_t Lib_USART_Buffer[LIB_USART_BUFFER_MAXSIZE];  // USART的缓冲区, 需在main.c中定义为全局便量
 #endif
 
 // DMA配置
-#define LIB_USART_DMA_EN             0        // 是否使用DMA
+// 使能后, Lib_USART_Send_* 只把数据写入发送环形缓冲区, 由 DMA1 通道 4 在后台发送, 调用立即返回
+#ifndef LIB_USART_DMA_EN
+    #define LIB_USART_DMA_EN         0        // 是否使用DMA
+#endif
 #if LIB_USART_DMA_EN
     #define LIB_USART_DMA                DMA1
     #define LIB_USART_DMA_CH             LL_DMA_CHANNEL_4     // USART1_TX对应通道
     #define LIB_USART_DMA_CH_EN()        LL_DMA_EnableChannel(LIB_USART_DMA, LIB_USART_DMA_CH)
+    #define LIB_USART_DMA_CH_DIS()       LL_DMA_DisableChannel(LIB_USART_DMA, LIB_USART_DMA_CH)
     #define LIB_USART_DMA_ENCLK()        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1)
     #define LIB_USART_DMA_PRIORITY       LL_DMA_PRIORITY_VERYHIGH
     #define LIB_USART_DMA_DIRECTION      LL_DMA_DIRECTION_MEMORY_TO_PERIPH
     #define LIB_USART_DMA_MODE           LL_DMA_MODE_NORMAL
-    #define LIB_USART_DMA_PADDR          (uint32_t)(&LIB_USART->DR) // 外设地址; 内存源地址
-    #define LIB_USART_DMA_MADDR          (uint32_t)Lib_USART_Buffer // 内存地址; 内存目标地址
+    #define LIB_USART_DMA_PADDR          Lib_USART_DMA_Addr(&LIB_USART->DR) // 外设地址; 内存源地址
     #define LIB_USART_DMA_PINC           LL_DMA_PERIPH_NOINCREMENT  // 外设指针自增; 内存源指针自增
     #define LIB_USART_DMA_MINC           LL_DMA_MEMORY_INCREMENT    // 内存指针自增; 内存目标指针自增
     #define LIB_USART_DMA_PDSIZE         LL_DMA_PDATAALIGN_BYTE     // 外设数据大小; 内存源数据大小
     #define LIB_USART_DMA_MDSIZE         LL_DMA_PDATAALIGN_BYTE     // 内存数据大小; 内存目标数据大小
-    #define LIB_USART_DMA_NDATA          LIB_USART_BUFFER_MAXSIZE   // 输出数据的数量
+    // DMA 发送完成中断
+    #define LIB_USART_DMA_IRQ            DMA1_Channel4_IRQn
+    #define LIB_USART_DMA_PREEMPT_PRIORITY   0
+    #define LIB_USART_DMA_SUB_PRIORITY       0
+    #define Lib_USART_DMA_TX_Handler     DMA1_Channel4_IRQHandler   // DMA1通道4的中断服务函数
+    #define LIB_USART_DMA_IsActiveFlag_TC()  LL_DMA_IsActiveFlag_TC4(LIB_USART_DMA)
+    #define LIB_USART_DMA_ClearFlag_TC()     LL_DMA_ClearFlag_TC4(LIB_USART_DMA)
+
+    // 发送环形缓冲区
+    #define LIB_USART_TX_BUFFER_SIZE     256      // 必须是 2 的幂
+    #define LIB_USART_TX_BUFFER_MASK     (LIB_USART_TX_BUFFER_SIZE - 1)
+    // 缓冲区满时的处理策略
+    #define LIB_USART_TX_POLICY_BLOCK        0    // 阻塞, 等待 DMA 腾出空间 (不能在屏蔽中断时调用)
+    #define LIB_USART_TX_POLICY_DROP         1    // 丢弃放不下的新数据
+    #define LIB_USART_TX_POLICY_OVERWRITE    2    // 丢弃尚未开始发送的旧数据, 保留新数据
+    #ifndef LIB_USART_TX_POLICY
+        #define LIB_USART_TX_POLICY      LIB_USART_TX_POLICY_BLOCK
+    #endif
+#endif
+
+// DMA接收配置
+// 使能后, DMA1 通道 5 以循环模式把数据写入 Lib_USART_Buffer, 在 USART 空闲 (IDLE) 中断
+// 和 DMA 半传输/传输完成中断中, 把新收到的数据以 (指针, 长度) 的形式交给回调函数, 不拷贝;
+// 没有设置回调时, 数据留在缓冲区中, 由主循环调用 Lib_USART_Receive() 读取
+// 需要 LIB_USART_IT_EN 为 1, LIB_USART_IT_RX_EN 为 0
+#ifndef LIB_USART_DMA_RX_EN
+    #define LIB_USART_DMA_RX_EN      0
+#endif
+#if LIB_USART_DMA_RX_EN
+    #if !LIB_USART_IT_EN || LIB_USART_IT_RX_EN
+        #error "LIB_USART_DMA_RX_EN requires LIB_USART_IT_EN = 1 and LIB_USART_IT_RX_EN = 0"
+    #endif
+    #define LIB_USART_DMA_RX                 DMA1
+    #define LIB_USART_DMA_RX_CH              LL_DMA_CHANNEL_5     // USART1_RX对应通道
+    #define LIB_USART_DMA_RX_ENCLK()         LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1)
+    #define LIB_USART_DMA_RX_PRIORITY        LL_DMA_PRIORITY_VERYHIGH
+    #define LIB_USART_DMA_RX_IRQ             DMA1_Channel5_IRQn
+    #define LIB_USART_DMA_RX_PREEMPT_PRIORITY    0
+    #define LIB_USART_DMA_RX_SUB_PRIORITY        0
+    #define Lib_USART_DMA_RX_Handler         DMA1_Channel5_IRQHandler   // DMA1通道5的中断服务函数
+    // 缓冲区中未读取的字节数的水位 (LIB_USART_FLOW_EN). 中断每半个缓冲区才检查一次,
+    // 高水位加上半个缓冲区, 再加上上位机响应 RTS 前多发的字节, 不能超过缓冲区大小
+    #define LIB_USART_RX_HIGH_WATERMARK      (LIB_USART_BUFFER_MAXSIZE / 4)
+    #define LIB_USART_RX_LOW_WATERMARK       (LIB_USART_BUFFER_MAXSIZE / 8)
+
+    /*
+     * @brief   接收回调函数类型
+     * @param   data 新收到的数据, 直接指向 Lib_USART_Buffer, 仅在回调期间有效
+     *          num  数据的字节数
+     * @note    1) 在中断中调用, 必须在半个缓冲区被填满之前返回
+     *          2) 数据跨越缓冲区末尾时, 分两次调用
+     *          3) IDLE 中断表示一帧结束, 半传输/传输完成中断只交出已收到的部分
+    */
+    typedef void (*Lib_USART_RX_Callback_Type)(const uint8_t *const data, const uint32_t num);
 #endif
 
 // 指令
-#define LIB_USART_CMD_EN                 0         // 是否启用指令模式
+// 上位机发送 COBS 编码的帧 (格式见 lib_frame.h), 接收中断只负责解码和入队, 由主循环调用
+// Lib_USART_CMD_Process() 查表执行. 上位机可以连续发送多帧而不等待应答, 每次处理完队列中
+// 的帧后, 只回复一个 ACK 帧, 负载为若干个 (seq, 结果) 对; 需要返回数据的指令另外回复同 seq 的帧
+// 需要 LIB_USART_IT_EN 为 1
+#ifndef LIB_USART_CMD_EN
+    #define LIB_USART_CMD_EN             0         // 是否启用指令模式
+#endif
 #if LIB_USART_CMD_EN
-    #include "lib_rtc.h"
-    extern uint8_t Lib_USART_CMD_Status1;
-    extern uint8_t Lib_USART_CMD_Status2;
-    extern uint32_t Lib_USART_CMD_Data;
-    #define LIB_USART_CMD_ACK                0xFF      // mcu 回复 pc
+    #if !LIB_USART_IT_EN
+        #error "LIB_USART_CMD_EN requires LIB_USART_IT_EN = 1"
+    #endif
+    #include "lib_frame.h"
+    #ifndef LIB_USART_PORT
+        #include "lib_rtc.h"
+    #endif
+    #define LIB_USART_CMD_QUEUE_SIZE         4         // 待处理帧队列长度, 必须是 2 的幂
+    #define LIB_USART_CMD_ACK                0xFF      // mcu 回复 pc, 负载为 (seq, 结果) 对
     #define LIB_USART_CMD_START              0x01      // 开启指令模式
     #define LIB_USART_CMD_STOP               0x02      // 关闭指令模式
-    #define LIB_USART_CMD_RTC_UNIX           0x03      // 配置 RTC 时间戳
+    #define LIB_USART_CMD_RTC_UNIX           0x03      // 配置 RTC 时间戳, 负载为 int32 小端
+    #define LIB_USART_CMD_PING               0x04      // 原样返回负载, 用于测量往返延迟
+    #define LIB_USART_CMD_BAUD               0x05      // 协商波特率, 负载为 uint32 小端; ACK 发出后切换到新波特率
+    #define LIB_USART_CMD_BAUD_CHECK         0x06      // 新波特率下校验: 负载非空时原样返回, 为空时确认切换
+    #define LIB_USART_CMD_STAT               0x07      // 返回链路统计 Lib_USART_Stat_Type, 每个成员 uint32 小端
+    // 切换后 LIB_USART_CMD_BAUD_TIMEOUT_MS 内没有收到确认则退回原波特率, 计时需要先 Lib_Tool_DWT_Init()
+    #define LIB_USART_CMD_BAUD_TIMEOUT_MS    500
+
+    // ACK 中每一帧的结果
+    #define LIB_USART_CMD_RES_OK             0x00      // 执行成功
+    #define LIB_USART_CMD_RES_UNKNOWN        0x01      // 未知指令
+    #define LIB_USART_CMD_RES_BAD_LEN        0x02      // 负载长度错误
+    #define LIB_USART_CMD_RES_NOT_STARTED    0x03      // 未开启指令模式
+    #define LIB_USART_CMD_RES_FAIL           0x04      // 执行失败
+
+    /*
+     * @brief   指令处理函数类型
+     * @param   req   收到的帧
+     *          reply 需要返回数据时, 填写 reply->len 和 reply->payload; seq 和 cmd 已填好
+     * @return  LIB_USART_CMD_RES_*
+    */
+    typedef uint8_t (*Lib_USART_CMD_Handler_Type)(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
 #endif
 
+// 数字转字符串, 实现在 lib_format.c, 保留原名称
+#define LIB_USART_FRAC_MAXDIGITS         LIB_FORMAT_FRAC_MAXDIGITS
+#define LIB_USART_NUM_BUFFER_SIZE        LIB_FORMAT_NUM_BUFFER_SIZE
+#define Lib_USART_Int2Char_DEC(num, buffer)                   Lib_Format_Int2Char_DEC(num, buffer)
+#define Lib_USART_Int2Char_HEX(num, buffer)                   Lib_Format_Int2Char_HEX(num, buffer)
+#define Lib_USART_Double2Char(num, buffer, num_frac_bits)     Lib_Format_Double2Char(num, buffer, num_frac_bits)
+#define Lib_USART_Q16_2Char(num, buffer, num_frac_bits)       Lib_Format_Q16_2Char(num, buffer, num_frac_bits)
+#define Lib_USART_Scaled2Char(num, buffer, num_frac_bits)     Lib_Format_Scaled2Char(num, buffer, num_frac_bits)
+
 void Lib_USART_Init(void);
 void Lib_USART_Send_Byte(const int8_t data);
+void Lib_USART_Send_Data(const uint8_t *const data, const uint32_t num);
 void Lib_USART_Send_String(const char *str);
-void Lib_USART_Int2Char_DEC(const int num, uint8_t *const buffer);
-void Lib_USART_Int2Char_HEX(const int num, uint8_t *const buffer);
-void Lib_USART_Double2Char(const double num, uint8_t *const buffer, const uint8_t num_frac_bits);
-void Lib_USART_Send_fString(const char *str, ...);
+uint32_t Lib_USART_Send_fString(const char *str, ...);
 void Lib_USART_IT_Handler(void);
+void Lib_USART_Flush(void);
+ErrorStatus Lib_USART_Set_Baud(const uint32_t baud);
+uint32_t Lib_USART_Get_Baud(void);
+void Lib_USART_Get_Stat(Lib_USART_Stat_Type *const stat);
+void Lib_USART_Port_Init(const Lib_USART_Type *const usart);
+void Lib_USART_Port_Send_Data(const Lib_USART_Type *const usart, const uint8_t *const data, const uint32_t num);
+void Lib_USART_Port_Send_String(const Lib_USART_Type *const usart, const char *str);
+uint32_t Lib_USART_Port_Send_fString(const Lib_USART_Type *const usart, const char *str, ...);
+uint32_t Lib_USART_Port_Receive(const Lib_USART_Type *const usart, uint8_t *const buffer, const uint32_t num);
+void Lib_USART_Port_IT_Handler(const Lib_USART_Type *const usart);
+ErrorStatus Lib_USART_Port_Set_Baud(const Lib_USART_Type *const usart, const uint32_t baud);
+uint32_t Lib_USART_Port_Get_Baud(const Lib_USART_Type *const usart);
+void Lib_USART_Port_Get_Stat(const Lib_USART_Type *const usart, Lib_USART_Stat_Type *const stat);
+#if LIB_USART2_EN
+void Lib_USART2_IT_Handler(void);
+#endif
+#if LIB_USART3_EN
+void Lib_USART3_IT_Handler(void);
+#endif
+#if LIB_USART_FLOW_EN
+void Lib_USART_RX_Pause(void);
+void Lib_USART_RX_Resume(void);
+#endif
+#if LIB_USART_DMA_EN
+uint32_t Lib_USART_TX_Get_Dropped(void);
+void Lib_USART_DMA_TX_Handler(void);
+#endif
+#if LIB_USART_DMA_RX_EN
+void Lib_USART_RX_Set_Callback(const Lib_USART_RX_Callback_Type callback);
+uint32_t Lib_USART_Receive(uint8_t *const buffer, const uint32_t num);
+void Lib_USART_DMA_RX_Handler(void);
+#endif
+#if LIB_USART_CMD_EN
+void Lib_USART_CMD_Receive(const uint8_t *const data, const uint32_t num);
+void Lib_USART_CMD_Process(void);
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef _MOD_CONFIG_H
+#define _MOD_CONFIG_H
+
+#include "mod_flash.h"
+
+/*
+ * @brief   配置存储: FLASH 末尾的分区 (MOD_FLASH_CONFIG_SIZE) 中的键值对, 用于运行时可修改的设置
+ * @note    1) 键为 16 位的编号 (MOD_CONFIG_KEY_*), 值最多 MOD_CONFIG_DATA_MAXSIZE 字节; 条目为
+ *             键 (2) + 长度 (1) + 标志 (1) + CRC16 (2) + 值, 只追加到当前扇区
+ *          2) 整理: 当前扇区写满或追加的条目超过 MOD_CONFIG_LOG_MAXNUM 时, 把全部有效的键值写入环形的下一个扇区,
+ *             最后编程扇区头部, 头部有效即整理完成; 分区的扇区轮流使用, 磨损均衡; 之后在后台擦除再下一个扇区
+ *          3) 原子提交: Mod_Config_Begin() 之后的 Mod_Config_Set(), Mod_Config_Delete() 暂存在 RAM 中,
+ *             Mod_Config_Commit() 一次编程, 最后一个条目带提交标志; 上电时没有提交标志的条目全部忽略
+ *          4) 索引: RAM 中的哈希表 (开放寻址) 记录每个键在扇区中的位置, 不超过 4 字节的值直接缓存, 读取不访问 FLASH
+ *          5) 上电 (Mod_Config_Init()): 读取各扇区头部找到最新的扇区, 只重放该扇区: 整理时写入的有效键值,
+ *             加上最多 MOD_CONFIG_LOG_MAXNUM 个之后追加的条目; 读取量与有效的键数成正比, 与扇区大小无关
+ *          6) 需要先 Mod_Flash_COM_Init()
+*/
+
+// 配置存储
+#define MOD_CONFIG_START               (MOD_FLASH_FATFS_SIZE + MOD_FLASH_RECORD_SIZE)  // 分区的开始地址, 记录存储之后
+#define MOD_CONFIG_SECTORS             (MOD_FLASH_CONFIG_SIZE / MOD_FLASH_SECTOR_SIZE)  // 分区的扇区数, 至少 2 个
+#define MOD_CONFIG_KEYS_MAXNUM         32                            // 最多几个键
+#define MOD_CONFIG_INDEX_SIZE          64                            // 哈希表的大小, 2 的幂, 不小于 2 倍的键数
+#define MOD_CONFIG_DATA_MAXSIZE        32                            // 一个值最多的字节数
+#define MOD_CONFIG_LOG_MAXNUM          64                            // 整理后最多追加几个条目, 决定上电时的读取量
+#define MOD_CONFIG_TXN_SIZE            256                           // 一次提交最多的字节数, 包括条目头部
+
+#define MOD_CONFIG_ENTRY_HEADER_SIZE   6                             // 条目头部: 键, 长度, 标志, CRC16
+
+/*
+ * @brief   键的编号, 0xFFFF 保留; 括号中为没有设置时使用的默认值
+ * @note    上电时由 Mod_DHT11_Task() 读取, 修改后重新上电生效
+*/
+#define MOD_CONFIG_KEY_TIMEZONE        0x0001                        // 时区, int32_t (LIB_RTC_TIMEZONE)
+#define MOD_CONFIG_KEY_BAUDRATE        0x0002                        // 串口波特率, uint32_t (115200)
+#define MOD_CONFIG_KEY_SAMPLE_INTERVAL 0x0003                        // 采样间隔, 毫秒, uint32_t (2000)
+#define MOD_CONFIG_KEY_RTC_UNIX        0x0004                        // 上电时 RTC 的 Unix 时间, uint32_t (LIB_RTC_UNIX)
+
+/*
+ * @brief   配置存储的统计, 见 Mod_Config_Get_Stat()
+*/
+typedef struct
+{
+    uint16_t keys;              // 有效的键数
+    uint16_t used;              // 当前扇区已用的字节数
+    uint32_t commits;           // 提交次数
+    uint32_t compactions;       // 整理次数, 即擦除的扇区数
+    uint32_t replayed;          // 上电时重放的条目数
+} Mod_Config_Stat_Type;
+
+void Mod_Config_Init(void);
+ErrorStatus Mod_Config_Get(const uint16_t key, void *const pbuffer, const uint8_t size);
+uint32_t Mod_Config_Get_U32(const uint16_t key, const uint32_t value);
+void Mod_Config_Begin(void);
+ErrorStatus Mod_Config_Set(const uint16_t key, const void *const data, const uint8_t len);
+ErrorStatus Mod_Config_Set_U32(const uint16_t key, const uint32_t value);
+ErrorStatus Mod_Config_Delete(const uint16_t key);
+ErrorStatus Mod_Config_Commit(void);
+ErrorStatus Mod_Config_Compact(void);
+void Mod_Config_Get_Stat(Mod_Config_Stat_Type *const stat);
+
+#endif
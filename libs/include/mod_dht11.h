@@ -12,6 +12,9 @@
 #define    MOD_DHT11_DATA_PIN                LL_GPIO_PIN_1
 #define    MOD_DHT11_GPIO_EN_CLK()           LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_GPIOB)
 
+// 每追加多少条记录调用一次 Mod_Record_Flush(), 掉电最多丢失这么多条; 凑满一页的记录由 Mod_Record_Poll() 编程
+#define    MOD_DHT11_FLUSH_NUM               30
+
 /*
  * @brief   DHT11 错误类型
 */
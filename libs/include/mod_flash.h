@@ -1,28 +1,146 @@
 #ifndef _MOD_FLASH_H
 #define _MOD_FLASH_H
 
+#include "ff.h"
+
+/*
+ * @note    上位机模拟 (host/flash_sim.c) 定义 MOD_FLASH_PORT, 替换下面的设备描述和接口, 以及 mod_flash.c 使用的
+ *          DWT 计时和串口输出
+*/
+#ifdef MOD_FLASH_PORT
+    #include MOD_FLASH_PORT
+#else
 #include "lib_spi.h"
+#include "lib_tool.h"
+
+// FLASH 在 SPI 总线上的设备描述, 片选为 PA4, 模式 0, f_SCK = 36 MHz
+static const Lib_SPI_Device_Type Mod_Flash_Device =
+{
+    .spi = &Lib_SPI1,
+    .apb2_periph = LL_APB2_GRP1_PERIPH_GPIOA,
+    .cs_port = GPIOA,
+    .cs_pin = LL_GPIO_PIN_4,
+    .cpol = LL_SPI_POLARITY_LOW,
+    .cpha = LL_SPI_PHASE_1EDGE,
+    .bit_order = LL_SPI_MSB_FIRST,
+    .baud_rate = LL_SPI_BAUDRATEPRESCALER_DIV2,
+    .batch = 0,                                                 // 指令以片选上升沿结束
+};
 
 // 接口
-#define Mod_Flash_COM_Start()                                   LIB_SPI_START()           // 开始通信
-#define Mod_Flash_COM_Stop()                                    LIB_SPI_STOP()            // 结束通信
-#define Mod_Flash_Send_Byte(data)                               Lib_SPI_Send_Byte(data)   // 发送一个字节
-#define Mod_Flash_Receive_Byte()                                Lib_SPI_Receive_Byte()    // 接收一个字节
+#define MOD_FLASH_DEV                                           (&Mod_Flash_Device)
+#define MOD_FLASH_SPI                                           (MOD_FLASH_DEV->spi)                    // FLASH 所在的 SPI 实例
+#define Mod_Flash_COM_Init()                                    do { Lib_SPI_Init(MOD_FLASH_SPI); Lib_SPI_Device_Init(MOD_FLASH_DEV); Lib_Tool_DWT_Init(); Mod_Flash_Detect(); } while (0)
+#define Mod_Flash_COM_Start()                                   do { } while (Lib_SPI_Begin(MOD_FLASH_DEV) != SUCCESS)  // 开始通信, 等待总线空闲
+#define Mod_Flash_COM_Try_Start()                               (Lib_SPI_Begin(MOD_FLASH_DEV) == SUCCESS)               // 开始通信, 总线被占用时返回 0
+#define Mod_Flash_COM_Stop()                                    Lib_SPI_End(MOD_FLASH_DEV)              // 结束通信
+#define Mod_Flash_Send_Byte(data)                               Lib_SPI_Send_Byte(MOD_FLASH_SPI, data)  // 发送一个字节
+#define Mod_Flash_Receive_Byte()                                Lib_SPI_Receive_Byte(MOD_FLASH_SPI)     // 接收一个字节
+#define Mod_Flash_Send_Data(pbuffer, num)                       Lib_SPI_Send_Data(MOD_FLASH_SPI, pbuffer, num)      // 连续发送, 可用 DMA
+#define Mod_Flash_Receive_Data(pbuffer, num)                    Lib_SPI_Receive_Data(MOD_FLASH_SPI, pbuffer, num)   // 连续接收, 可用 DMA
+#define Mod_Flash_Send_Burst(pbuffer, num)                      Lib_SPI_Burst(MOD_FLASH_SPI, pbuffer, (void *)0, num)   // 连续发送几个字节, 轮询, 不用 DMA
+#endif
 
-// 使用的 FLASH 为 W25Q64
-#define MOD_FLASH_JEDEC_ID             0xEF4017
+// 使用的 FLASH: W25Q 系列 (W25Q32/64/128), 容量, 擦除指令和时间在 Mod_Flash_COM_Init() 时从 SFDP 读取, 见 Mod_Flash_Detect()
+// 页和扇区大小是驱动, FTL 和 FatFs 缓冲区的前提, 检测到的芯片不同时不使用
+#define MOD_FLASH_JEDEC_ID             0xEF4017                      // 没有检测时默认的 W25Q64
 #define MOD_FLASH_PAGE_SIZE            256                           // 页大小为 256 B
 #define MOD_FLASH_SECTOR_SIZE          4096                          // 扇区大小为 4 KB
+#define MOD_FLASH_BLOCK_32K_SIZE       32768                         // 32 KB 块
+#define MOD_FLASH_BLOCK_64K_SIZE       65536                         // 64 KB 块, Mod_Flash_Write_Sectors() 按此分组
+#define MOD_FLASH_CHIP_MAXSIZE         16777216                      // 3 字节地址最大 16 MB, 更大的芯片只使用前 16 MB
+#define MOD_FLASH_CHIP_SIZE            (Mod_Flash_Geometry.capacity)  // 检测到的容量
+// 分区: 开头给 FatFs (经过或不经过 FTL), 之后 MOD_FLASH_RECORD_SIZE 给记录存储 (mod_record.c),
+// 末尾 MOD_FLASH_CONFIG_SIZE 给配置存储 (mod_config.c); 都必须是 64 KB 的整数倍; 后两个位置随容量变化, FatFs 使用其余全部
+#define MOD_FLASH_RECORD_SIZE          983040                        // 960 KB, 240 个扇区
+#define MOD_FLASH_CONFIG_SIZE          65536                         // 64 KB, 16 个扇区
+#define MOD_FLASH_FATFS_SIZE           (MOD_FLASH_CHIP_SIZE - MOD_FLASH_RECORD_SIZE - MOD_FLASH_CONFIG_SIZE)
+// FatFs 的簇大小, 数据区也按此对齐: f_write() 在簇的边界拆分 disk_write(), 簇为 4 KB 时每次只写一个扇区; 不小于 32 KB 时
+// 不经过 FTL 的多扇区写入才能合并为块擦除. 代价是每个文件至少占一个簇; 只在 f_mkfs() 时使用, 见 Mod_Flash_FatFs_Format
+#define MOD_FLASH_FATFS_CLUSTER        32768
 #define MOD_FLASH_BUSY_Pos             (0U)                          // 状态位, 检测 FLASH 是否忙碌
 #define MOD_FLASH_BUSY_Msk             (0x1U << MOD_FLASH_BUSY_Pos)
 #define MOD_FLASH_BUSY                 (0x1U << MOD_FLASH_BUSY_Pos)            
 
+// 读取使用的指令: FAST_READ 在地址后多一个空字节, 最高 104 MHz; READ_DATA 没有空字节, 最高 50 MHz
+#define MOD_FLASH_READ_CMD             MOD_FLASH_W25Q64_FAST_READ
+#define MOD_FLASH_READ_DUMMY           1                             // 地址后的空字节数, READ_DATA 时为 0
+
+// 暂停擦除或编程: 发出 ERASE_SUSPEND 后最多 tSUS 完成; ERASE_RESUME 后至少经过 tSUS 才能再次暂停, 否则擦除没有进展
+#define MOD_FLASH_SUSPEND_US           20                            // tSUS, 微秒
+
+// 写入扇区后是否读出校验, 见 Mod_Flash_Write_Sectors()
+#define MOD_FLASH_VERIFY_EN            1
+
+/*
+ * @brief   Mod_Flash_Write_Sectors() 的统计, 见 Mod_Flash_Get_Stat()
+*/
+typedef struct
+{
+    uint32_t erases;            // 需要擦除的扇区数
+    uint32_t erase_cmds;        // 发出的擦除指令数 (包括块擦除), 小于 erases 时说明合并了
+    uint32_t erases_avoided;    // 不需要擦除的扇区数: 内容相同, 或只有 1 变为 0
+    uint32_t sectors_skipped;   // 其中内容完全相同, 没有任何编程的扇区数
+    uint32_t pages_programmed;  // 编程的页数
+    uint32_t pages_skipped;     // 内容相同而跳过的页数
+    uint32_t bytes_programmed;  // 编程的字节数, 每页只编程变化的部分
+    uint32_t verify_errors;     // 读出校验失败的次数
+} Mod_Flash_Stat_Type;
+
+/*
+ * @brief   一种擦除指令, 见 Mod_Flash_Geometry_Type
+*/
+typedef struct
+{
+    uint32_t size;              // 字节数, 0 表示没有
+    uint8_t cmd;
+    uint16_t time_ms;           // 典型时间, 0 表示未知
+} Mod_Flash_Erase_Type;
+
+/*
+ * @brief   FLASH 的参数, Mod_Flash_Detect() 从 JEDEC ID 和 SFDP 得到
+*/
+typedef struct
+{
+    uint32_t jedec_id;          // 0 表示没有检测到 FLASH
+    uint32_t capacity;          // 字节, 不超过 MOD_FLASH_CHIP_MAXSIZE
+    uint16_t page_size;
+    uint8_t sfdp;               // 1: 参数来自 SFDP; 0: 没有 SFDP, 容量按 JEDEC ID 推算, 其余为 W25Q 的默认值
+    Mod_Flash_Erase_Type erase[4];  // 按大小从小到大, 第一个为 MOD_FLASH_SECTOR_SIZE
+    uint16_t program_us;        // 页编程的典型时间, 0 表示未知
+    uint32_t chip_erase_ms;     // 整片擦除的典型时间, 0 表示未知
+} Mod_Flash_Geometry_Type;
+
+extern Mod_Flash_Geometry_Type Mod_Flash_Geometry;
+extern const MKFS_PARM Mod_Flash_FatFs_Format;
+
+/*
+ * @brief   分散读取的一段: 从 FLASH 的连续地址读取到多个缓冲区, 见 Mod_Flash_Read_Vector()
+*/
+typedef struct
+{
+    uint8_t *buffer;
+    uint32_t num;
+} Mod_Flash_Vector_Type;
+
 // 函数申明
 uint32_t Mod_Flash_Read_JEDCE_ID(void);
+ErrorStatus Mod_Flash_Detect(void);
 ErrorStatus Mod_Flash_Erase_Sector(const uint32_t addr);
 void Mod_Flash_Write(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t num_write);
 void Mod_Flash_Read(uint8_t * const pbuffer, const uint32_t addr, const uint32_t num_read);
+void Mod_Flash_Read_Vector(const Mod_Flash_Vector_Type *const vector, const uint32_t num_vector, const uint32_t addr);
+ErrorStatus Mod_Flash_Erase_Start(const uint32_t addr);
+ErrorStatus Mod_Flash_Erase_Range(const uint32_t addr, const uint32_t len);
+ErrorStatus Mod_Flash_Update_Sector(const uint8_t *const pbuffer, const uint32_t addr);
+ErrorStatus Mod_Flash_Write_Sectors(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t count);
+uint8_t Mod_Flash_Compare(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t num);
+void Mod_Flash_Get_Stat(Mod_Flash_Stat_Type *const stat);
+void Mod_Flash_Poll(void);
+void Mod_Flash_Sync(void);
+uint8_t Mod_Flash_Is_Busy(void);
 void Mod_Flash_FatFs_Check(FATFS *fs);
+UINT Mod_Flash_FatFs_Printf(FIL *const fp, const char *const str, ...);
 
 // W25Q64 指令
 #define MOD_FLASH_W25Q64_WRITE_ENABLE							0x06
@@ -45,6 +163,7 @@ void Mod_Flash_FatFs_Check(FATFS *fs);
 #define MOD_FLASH_W25Q64_MANUFACTURER_DEVICE_ID				    0x90
 #define MOD_FLASH_W25Q64_READ_UNIQUE_ID						    0x4B
 #define MOD_FLASH_W25Q64_JEDEC_ID								0x9F
+#define MOD_FLASH_W25Q64_READ_SFDP								0x5A
 #define MOD_FLASH_W25Q64_READ_DATA							    0x03
 #define MOD_FLASH_W25Q64_FAST_READ							    0x0B
 #define MOD_FLASH_W25Q64_FAST_READ_DUAL_OUTPUT				    0x3B
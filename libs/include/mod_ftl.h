@@ -0,0 +1,65 @@
+#ifndef _MOD_FTL_H
+#define _MOD_FTL_H
+
+#include "mod_flash.h"
+
+/*
+ * @brief   FLASH 转换层: FatFs 的逻辑扇区 (4 KB) 映射到 FLASH 的物理扇区, 每次写入都写到新的物理扇区
+ * @note    1) 物理扇区的划分: 开头两个日志区, 各 MOD_FTL_BANK_SECTORS 个扇区; 其余为数据区, 其中
+ *             MOD_FTL_SPARE 个扇区不对应逻辑扇区, 用于轮换
+ *          2) 映射表 (每个逻辑扇区 2 字节) 在 RAM 中; 日志区保存映射表的快照和之后的每次修改 (8 字节记录),
+ *             上电时读取最新的日志区重建; 日志区写满时把快照写到另一个日志区, 写完头部后才切换
+ *          3) 掉电安全: 先写数据再写记录, 记录完成前旧的物理扇区仍然有效且不会被擦除
+ *          4) 动态磨损均衡: 空闲扇区按顺序轮流使用; 静态磨损均衡: 每 MOD_FTL_STATIC_PERIOD 次写入,
+ *             把一个逻辑扇区 (按顺序轮流) 搬到新的物理扇区, 冷数据占用的扇区也参与轮换
+ *          5) 回收: 最多 MOD_FTL_ERASED_NUM 个空闲扇区预先擦除, 由主循环中的 Mod_FTL_Poll() 在 FLASH 空闲时逐个补充,
+ *             连续写入这么多个扇区都不需要等待擦除; 用完时每次写入后在后台开始擦除下一个 (Mod_Flash_Erase_Start()).
+ *             上电时按顺序检查游标之后的空闲扇区是否全为 0xFF, 重建预擦除的扇区
+ *          6) RAM: 映射表 MOD_FTL_LOGICAL_MAXNUM * 2 字节, 使用位图 MOD_FTL_SECTORS_MAXNUM / 8 字节, 由 MOD_FTL_FLASH_MAXSIZE
+ *             决定: 8 MB (W25Q64) 约 3.6 KB, 16 MB (W25Q128) 约 7.9 KB; 管理的扇区数在 Mod_FTL_Init() 时按检测到的
+ *             FLASH 容量确定, 不超过 MOD_FTL_SECTORS_MAXNUM, 比 MOD_FTL_FLASH_MAXSIZE 更大的芯片只有前面的部分经过 FTL
+ *          7) 与不经过 FTL 的 FatFs 卷不兼容, 第一次使用时格式化 (映射表为空), 之后需要 f_mkfs(); 所以 MOD_FTL_EN
+ *             默认为 0, 已有数据的设备打开前要先备份文件
+*/
+
+// FTL 配置
+#ifndef MOD_FTL_EN
+    #define MOD_FTL_EN                 0                             // diskio 是否经过 FTL; 为 0 时逻辑扇区直接对应物理扇区
+#endif
+#ifndef MOD_FTL_FLASH_MAXSIZE
+    #define MOD_FTL_FLASH_MAXSIZE      8388608                       // 全部经过 FTL 的最大芯片容量 (W25Q64), 决定 RAM, 见 6)
+#endif
+// 最多管理的物理扇区数: 该容量下 FatFs 分区的扇区数, 从地址 0 开始; W25Q64 为 1792
+#define MOD_FTL_SECTORS_MAXNUM         ((MOD_FTL_FLASH_MAXSIZE - MOD_FLASH_RECORD_SIZE - MOD_FLASH_CONFIG_SIZE) / MOD_FLASH_SECTOR_SIZE)
+#define MOD_FTL_BANK_SECTORS           4                             // 每个日志区的扇区数
+#define MOD_FTL_SPARE                  40                            // 备用扇区数, 至少为 2
+#define MOD_FTL_ERASED_NUM             4                             // 最多预先擦除的空闲扇区数, 不超过 MOD_FTL_SPARE - 2
+#define MOD_FTL_STATIC_PERIOD          64                            // 每写入多少次搬动一个扇区, 0 表示不做静态磨损均衡
+#define MOD_FTL_TRIM_RECORDS           16                            // 一次 Mod_FTL_Trim() 最多写入的记录数, 更多时直接写快照
+
+#define MOD_FTL_POOL_START             (2 * MOD_FTL_BANK_SECTORS)                    // 数据区的第一个物理扇区
+#define MOD_FTL_LOGICAL_MAXNUM         (MOD_FTL_SECTORS_MAXNUM - MOD_FTL_POOL_START - MOD_FTL_SPARE)   // 最多的逻辑扇区数
+#define MOD_FTL_NONE                   0xFFFF                        // 没有对应的物理扇区, 与擦除后的 FLASH 相同
+
+/*
+ * @brief   FTL 统计, 见 Mod_FTL_Get_Stat()
+*/
+typedef struct
+{
+    uint32_t writes;            // 写入新物理扇区的次数
+    uint32_t skipped;           // 内容相同而跳过的写入
+    uint32_t moves;             // 静态磨损均衡搬动的扇区数
+    uint32_t checkpoints;       // 写快照 (擦除日志区) 的次数
+    uint32_t trims;             // 取消映射的逻辑扇区数
+    uint32_t erase_waits;       // 分配时没有预先擦除的扇区, 写入要等待擦除的次数
+} Mod_FTL_Stat_Type;
+
+void Mod_FTL_Init(void);
+ErrorStatus Mod_FTL_Read(uint8_t *const pbuffer, const uint32_t lba, const uint32_t count);
+ErrorStatus Mod_FTL_Write(const uint8_t *const pbuffer, const uint32_t lba);
+ErrorStatus Mod_FTL_Trim(const uint32_t lba, const uint32_t count);
+void Mod_FTL_Get_Stat(Mod_FTL_Stat_Type *const stat);
+uint32_t Mod_FTL_Get_Logical(void);
+void Mod_FTL_Poll(void);
+
+#endif
@@ -10,6 +10,8 @@
 #define MOD_OLED_BUFFER_SIZE                 100
 
 // 接口
+#define MOD_OLED_I2C                         (&Lib_I2C1)   // OLED 所在的 I2C 实例
+#define Mod_Oled_COM_Init()                  Lib_I2C_Init(MOD_OLED_I2C)
 #define MOD_OLED_BUFFER                      Mod_Oled_Buffer
 #define MOD_OLED_PBUFFER                     Mod_Oled_PBuffer
 // 清空缓冲区
@@ -17,9 +19,9 @@
 // 向缓冲区添加数据
 #define Mod_Oled_Buffer_Append(data)         (MOD_OLED_BUFFER[MOD_OLED_PBUFFER++] = data)
 // 使用 I2C 发送缓冲区数据
-#define Mod_Oled_Buffer_Send()               Lib_I2C_Send_Data(MOD_OLED_ADDR, MOD_OLED_BUFFER, MOD_OLED_PBUFFER)
+#define Mod_Oled_Buffer_Send()               Lib_I2C_Send_Data(MOD_OLED_I2C, MOD_OLED_ADDR, MOD_OLED_BUFFER, MOD_OLED_PBUFFER)
 // 使用 I2C 发送自定义缓冲区数据
-#define Mod_Oled_Send_Data(pbuffer, num)     Lib_I2C_Send_Data(MOD_OLED_ADDR, (const uint8_t* const)pbuffer, num)
+#define Mod_Oled_Send_Data(pbuffer, num)     Lib_I2C_Send_Data(MOD_OLED_I2C, MOD_OLED_ADDR, (const uint8_t* const)pbuffer, num)
 
 /*
  * @brief   表示光标所在位置
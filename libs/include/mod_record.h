@@ -0,0 +1,75 @@
+#ifndef _MOD_RECORD_H
+#define _MOD_RECORD_H
+
+#include "mod_flash.h"
+
+/*
+ * @brief   记录存储: 在 FatFs 之后的分区 (MOD_FLASH_RECORD_SIZE) 中只追加的日志, 不经过 FatFs, 用于高频率的传感器记录
+ * @note    1) 分区的扇区组成环形日志, 每个扇区开头是头部 (序号, 第一条记录的时间戳); 记录为
+ *             长度 (2) + CRC16 (2) + 时间戳 (4) + 数据, 紧密排列, 不跨扇区; 写满后覆盖最旧的扇区
+ *          2) 追加只写入 RAM 中的缓存, 凑满一页后编程; 打开新扇区时在后台擦除下一个扇区 (Mod_Flash_Erase_Start()),
+ *             擦除期间记录留在缓存中, 缓存满时才等待擦除完成; 追加的路径上没有同步擦除
+ *          3) 掉电: 缓存中没有编程的记录丢失, 需要保存时调用 Mod_Record_Flush(); 写了一半的记录 CRC 错误,
+ *             上电后该扇区不再追加, 读取时跳过
+ *          4) 上电恢复 (Mod_Record_Init()): 各扇区的序号沿环形连续, 用二分查找找到最新和最旧的扇区,
+ *             只读取 O(log n) 个头部, 再扫描最新的扇区找到追加的位置和最新的时间戳 (Mod_Record_Last_Time())
+ *          5) 按时间查找 (Mod_Record_Seek()): 扇区头部的时间戳是稀疏索引, 二分查找扇区后在扇区内顺序查找;
+ *             要求时间戳不减 (例如 RTC 秒数或 SysTick 毫秒数)
+ *          6) 读取用迭代器 (Mod_Record_Begin(), Mod_Record_Seek(), Mod_Record_Next()), 也能读到缓存中的记录;
+ *             迭代器指向的扇区被覆盖时, 从最旧的记录继续
+ *          7) 需要先 Mod_Flash_COM_Init(); 主循环中调用 Mod_Record_Poll()
+*/
+
+// 记录存储配置
+#define MOD_RECORD_START               MOD_FLASH_FATFS_SIZE          // 分区的开始地址, FatFs 之后
+#define MOD_RECORD_SECTORS             (MOD_FLASH_RECORD_SIZE / MOD_FLASH_SECTOR_SIZE)  // 分区的扇区数
+#define MOD_RECORD_BUFFER_SIZE         1024                          // 追加缓存的大小, 至少 2 页; 决定擦除期间能缓存多少记录
+#define MOD_RECORD_DATA_MAXSIZE        240                           // 一条记录的数据最多的字节数
+
+#define MOD_RECORD_HEADER_SIZE         8                             // 记录头部: 长度, CRC16, 时间戳
+
+/*
+ * @brief   读出的一条记录
+*/
+typedef struct
+{
+    uint32_t time;                              // 时间戳
+    uint16_t len;                               // 数据的字节数
+    uint8_t data[MOD_RECORD_DATA_MAXSIZE];
+} Mod_Record_Type;
+
+/*
+ * @brief   迭代器, 指向下一条要读取的记录
+*/
+typedef struct
+{
+    uint32_t seq;                               // 扇区的序号
+    uint16_t offset;                            // 在扇区内的位置
+} Mod_Record_Iter_Type;
+
+/*
+ * @brief   记录存储的统计, 见 Mod_Record_Get_Stat()
+*/
+typedef struct
+{
+    uint32_t records;           // 追加的记录数
+    uint32_t bytes;             // 追加的字节数, 包括记录头部
+    uint32_t pages;             // 编程的次数 (凑满一页或 Mod_Record_Flush())
+    uint32_t erases;            // 擦除的扇区数
+    uint32_t stalls;            // 缓存满或打开新扇区时等待擦除完成的次数
+    uint32_t dropped;           // 写满后覆盖的最旧扇区数
+    uint32_t corrupt;           // 读取时跳过的损坏记录 (掉电时写了一半)
+} Mod_Record_Stat_Type;
+
+void Mod_Record_Init(void);
+ErrorStatus Mod_Record_Append(const uint32_t time, const void *const data, const uint16_t len);
+ErrorStatus Mod_Record_Last_Time(uint32_t *const time);
+void Mod_Record_Poll(void);
+void Mod_Record_Flush(void);
+void Mod_Record_Clear(void);
+void Mod_Record_Begin(Mod_Record_Iter_Type *const iter);
+void Mod_Record_Seek(Mod_Record_Iter_Type *const iter, const uint32_t time);
+ErrorStatus Mod_Record_Next(Mod_Record_Iter_Type *const iter, Mod_Record_Type *const record);
+void Mod_Record_Get_Stat(Mod_Record_Stat_Type *const stat);
+
+#endif
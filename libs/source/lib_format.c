@@ -0,0 +1,731 @@
+#include "lib_format.h"
+#include <string.h>
+
+// "00" ~ "99" 两位数字表, 每次查表写出两位, 除法次数减半
+static const char Lib_Format_Digit_Pairs[200] =
+{
+  '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+  '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+  '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+  '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+  '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+  '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+  '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+  '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+  '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+  '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+static const char Lib_Format_Hex_Digits[16] =
+{
+  '0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F',
+};
+// 10^1 ~ 10^9, 用于计算十进制位数
+static const uint32_t Lib_Format_Pow10[9] =
+{
+  10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U,
+};
+
+/*
+ * @brief   无符号 32 位整数转十进制字符串, 不含结束符
+ * @param   num    整数
+ *          buffer 缓冲区, 至少 10 字节
+ * @return  写入的字符数
+ * @note    先求位数, 再从末尾往前每次写两位, 不需要反转.
+ *          num / 100 用乘法和移位代替: 0x51EB851F = ceil(2^37 / 100), 对全部 uint32 精确.
+*/
+uint8_t Lib_Format_UInt2Char_DEC(uint32_t num, uint8_t * const buffer)
+{
+  uint8_t len = 1, p = 0;
+  uint32_t q = 0, r = 0;
+
+  while (len < 10 && num >= Lib_Format_Pow10[len - 1])
+  {
+    ++len;
+  }
+  p = len;
+  while (num >= 100)
+  {
+    q = (uint32_t)(((uint64_t)num * 0x51EB851FU) >> 37);
+    r = num - q * 100;
+    num = q;
+    p -= 2;
+    buffer[p] = Lib_Format_Digit_Pairs[r * 2];
+    buffer[p + 1] = Lib_Format_Digit_Pairs[r * 2 + 1];
+  }
+  if (num >= 10)
+  {
+    buffer[0] = Lib_Format_Digit_Pairs[num * 2];
+    buffer[1] = Lib_Format_Digit_Pairs[num * 2 + 1];
+  }
+  else
+  {
+    buffer[0] = num + '0';
+  }
+  return len;
+}
+
+/*
+ * @brief   无符号整数转固定 width 位的十进制字符串, 不足补前导 0, 不含结束符
+ * @note    num 必须小于 10^width; 用于小数部分
+*/
+static void Lib_Format_UInt2Char_DEC_Width(uint32_t num, uint8_t * const buffer, const uint8_t width)
+{
+  uint8_t p = width;
+  uint32_t q = 0, r = 0;
+
+  while (p >= 2)
+  {
+    q = (uint32_t)(((uint64_t)num * 0x51EB851FU) >> 37);
+    r = num - q * 100;
+    num = q;
+    p -= 2;
+    buffer[p] = Lib_Format_Digit_Pairs[r * 2];
+    buffer[p + 1] = Lib_Format_Digit_Pairs[r * 2 + 1];
+  }
+  if (p == 1)
+  {
+    buffer[0] = num + '0';
+  }
+}
+
+/*
+ * @brief   有符号整数转十进制字符串
+ * @param   num    整数, 支持 INT_MIN
+ *          buffer 缓冲区, 至少 12 字节
+ * @return  字符串长度, 不含结束符
+*/
+uint8_t Lib_Format_Int2Char_DEC(const int num, uint8_t * const buffer)
+{
+  uint8_t p = 0;
+  uint32_t tmp = (uint32_t)num;
+
+  if (num < 0)
+  {
+    buffer[p++] = '-';
+    tmp = 0U - tmp; // 对 INT_MIN 也正确
+  }
+  p += Lib_Format_UInt2Char_DEC(tmp, &buffer[p]);
+  buffer[p] = '\0';
+  return p;
+}
+
+/*
+ * @brief   无符号 32 位整数转十六进制字符串, 不含前缀和结束符
+ * @param   num    整数
+ *          buffer 缓冲区, 至少 8 字节
+ *          upper  是否使用大写字母
+ * @return  写入的字符数
+*/
+uint8_t Lib_Format_UInt2Char_HEX(const uint32_t num, uint8_t * const buffer, const uint8_t upper)
+{
+  uint8_t len = 1, p = 0;
+
+  // 有效的十六进制位数
+  while (len < 8 && (num >> (len * 4)) != 0)
+  {
+    ++len;
+  }
+  for (int8_t shift = (len - 1) * 4; shift >= 0; shift -= 4)
+  {
+    buffer[p] = Lib_Format_Hex_Digits[(num >> shift) & 0xF];
+    // 'A' ~ 'F' 与 'a' ~ 'f' 相差 0x20, 数字不受影响
+    if (!upper && buffer[p] > '9')
+    {
+      buffer[p] += 'a' - 'A';
+    }
+    ++p;
+  }
+  return len;
+}
+
+/*
+ * @brief   整数转十六进制字符串, 带 0x 前缀
+ * @param   num    整数, 按 32 位无符号数 (补码) 显示, 例如 -1 显示为 0xFFFFFFFF
+ *          buffer 缓冲区, 至少 11 字节
+ * @return  字符串长度, 不含结束符
+*/
+uint8_t Lib_Format_Int2Char_HEX(const int num, uint8_t * const buffer)
+{
+  uint8_t p = 2;
+
+  buffer[0] = '0';
+  buffer[1] = 'x';
+  p += Lib_Format_UInt2Char_HEX((uint32_t)num, &buffer[p], 1);
+  buffer[p] = '\0';
+  return p;
+}
+
+/*
+ * @brief   把 "整数部分 + Q0.64 小数部分" 格式化为保留 num_frac_bits 位小数的字符串, 不含符号
+ * @param   int_part      整数部分
+ *          frac          小数部分, 即 frac / 2^64
+ *          num_frac_bits 小数位数, 不超过 LIB_FORMAT_FRAC_MAXDIGITS; 为 0 时不显示小数点
+ *          buffer        缓冲区
+ * @return  字符串长度, 不含结束符
+ * @note    1) 只用 32x32 位整数乘法和移位, 不需要软件浮点库
+ *          2) 四舍五入, 恰好为 5 时向偶数舍入, 与 printf 一致
+*/
+static uint8_t Lib_Format_Fixed_Format(uint32_t int_part, const uint64_t frac, uint8_t num_frac_bits,
+                                       uint8_t * const buffer)
+{
+  uint8_t p = 0;
+  uint32_t scale = 1, digits = 0;
+  uint64_t lo = 0, hi = 0, rem = 0;
+
+  if (num_frac_bits > LIB_FORMAT_FRAC_MAXDIGITS)
+  {
+    num_frac_bits = LIB_FORMAT_FRAC_MAXDIGITS;
+  }
+  if (num_frac_bits > 0)
+  {
+    scale = Lib_Format_Pow10[num_frac_bits - 1];
+  }
+  // frac * 10^n 共 96 位: digits 为高 32 位, rem 为低 64 位 (被舍去的部分)
+  lo = (uint64_t)(uint32_t)frac * scale;
+  hi = (uint64_t)(uint32_t)(frac >> 32) * scale + (lo >> 32);
+  digits = (uint32_t)(hi >> 32);
+  rem = (hi << 32) | (uint32_t)lo;
+  if (rem > 0x8000000000000000ULL || (rem == 0x8000000000000000ULL && ((num_frac_bits > 0 ? digits : int_part) & 1)))
+  {
+    ++digits;
+  }
+  // 进位到整数部分
+  if (digits >= scale)
+  {
+    digits -= scale;
+    if (int_part != 0xFFFFFFFFU)
+    {
+      ++int_part;
+    }
+  }
+
+  p = Lib_Format_UInt2Char_DEC(int_part, buffer);
+  if (num_frac_bits > 0)
+  {
+    buffer[p++] = '.';
+    Lib_Format_UInt2Char_DEC_Width(digits, &buffer[p], num_frac_bits);
+    p += num_frac_bits;
+  }
+  buffer[p] = '\0';
+  return p;
+}
+
+/*
+ * @brief   double 转字符串, 不含符号, 见 Lib_Format_Double2Char()
+ * @param   neg 返回是否为负数
+*/
+static uint8_t Lib_Format_Double_Body(const double num, uint8_t * const neg, uint8_t * const buffer,
+                                      const uint8_t num_frac_bits)
+{
+  uint64_t bits = 0, mant = 0, frac = 0;
+  uint32_t int_part = 0;
+  int32_t exp = 0, shift = 0;
+
+  memcpy(&bits, &num, sizeof(bits));
+  *neg = (uint8_t)(bits >> 63);
+  exp = (int32_t)((bits >> 52) & 0x7FF);
+  mant = bits & 0xFFFFFFFFFFFFFULL;
+
+  if (exp == 0x7FF) // 无穷大或非数
+  {
+    if (mant != 0)
+    {
+      *neg = 0;
+    }
+    buffer[0] = (mant == 0) ? 'i' : 'n';
+    buffer[1] = (mant == 0) ? 'n' : 'a';
+    buffer[2] = (mant == 0) ? 'f' : 'n';
+    buffer[3] = '\0';
+    return 3;
+  }
+  if (exp != 0)
+  {
+    mant |= 1ULL << 52; // 规格化数的隐含位
+  }
+  else
+  {
+    exp = 1;            // 非规格化数
+  }
+  // |num| = mant * 2^shift
+  shift = exp - 1075;
+  if (shift >= 0)
+  {
+    int_part = 0xFFFFFFFFU; // |num| >= 2^52, 饱和; mant << shift 在 shift >= 12 时会溢出
+  }
+  else if (shift > -64)
+  {
+    int_part = ((mant >> -shift) > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)(mant >> -shift);
+    frac = mant << (64 + shift);
+  }
+  else if (shift > -128)
+  {
+    frac = mant >> (-shift - 64);
+  }
+
+  return Lib_Format_Fixed_Format(int_part, frac, num_frac_bits, buffer);
+}
+
+/*
+ * @brief   double 转字符串, 保留 num_frac_bits 位小数, 四舍五入
+ * @param   num           浮点数, 整数部分超过 uint32 时饱和
+ *          buffer        缓冲区, 至少 LIB_FORMAT_NUM_BUFFER_SIZE 字节
+ *          num_frac_bits 小数位数, 不超过 LIB_FORMAT_FRAC_MAXDIGITS
+ * @return  字符串长度, 不含结束符
+ * @note    直接拆分 IEEE-754 的符号, 指数和尾数, 用整数运算得到整数部分和小数部分,
+ *          不调用软件浮点库 (STM32F103 没有 FPU)
+*/
+uint8_t Lib_Format_Double2Char(const double num, uint8_t * const buffer, const uint8_t num_frac_bits)
+{
+  uint8_t neg = 0, len = 0;
+
+  len = Lib_Format_Double_Body(num, &neg, &buffer[1], num_frac_bits);
+  if (neg)
+  {
+    buffer[0] = '-';
+    return len + 1;
+  }
+  for (uint8_t i = 0; i <= len; ++i)
+  {
+    buffer[i] = buffer[i + 1];
+  }
+  return len;
+}
+
+/*
+ * @brief   Q16.16 定点数转字符串, 保留 num_frac_bits 位小数, 四舍五入
+ * @param   num           定点数, 实际值为 num / 65536
+ *          buffer        缓冲区, 至少 LIB_FORMAT_NUM_BUFFER_SIZE 字节
+ *          num_frac_bits 小数位数, 不超过 LIB_FORMAT_FRAC_MAXDIGITS
+ * @return  字符串长度, 不含结束符
+*/
+uint8_t Lib_Format_Q16_2Char(const int32_t num, uint8_t * const buffer, const uint8_t num_frac_bits)
+{
+  uint32_t tmp = (uint32_t)num;
+  uint8_t p = 0;
+
+  if (num < 0)
+  {
+    tmp = 0U - tmp;
+    buffer[p++] = '-';
+  }
+  return p + Lib_Format_Fixed_Format(tmp >> 16, (uint64_t)(tmp & 0xFFFF) << 48, num_frac_bits, &buffer[p]);
+}
+
+/*
+ * @brief   按 10 的幂缩放的整数转字符串, 例如 DHT11 的 temp (温度 * 10)
+ * @param   num           整数, 实际值为 num / 10^num_frac_bits
+ *          buffer        缓冲区, 至少 LIB_FORMAT_NUM_BUFFER_SIZE 字节
+ *          num_frac_bits 小数位数, 不超过 LIB_FORMAT_FRAC_MAXDIGITS
+ * @return  字符串长度, 不含结束符
+ * @note    例如 (-5, 1) 显示为 -0.5, (1234, 2) 显示为 12.34
+*/
+uint8_t Lib_Format_Scaled2Char(const int32_t num, uint8_t * const buffer, uint8_t num_frac_bits)
+{
+  uint32_t tmp = (uint32_t)num, scale = 1, int_part = 0, digits = 0;
+  uint8_t p = 0;
+
+  if (num < 0)
+  {
+    tmp = 0U - tmp;
+    buffer[p++] = '-';
+  }
+  if (num_frac_bits > LIB_FORMAT_FRAC_MAXDIGITS)
+  {
+    num_frac_bits = LIB_FORMAT_FRAC_MAXDIGITS;
+  }
+  if (num_frac_bits > 0)
+  {
+    scale = Lib_Format_Pow10[num_frac_bits - 1];
+  }
+  int_part = tmp / scale;
+  digits = tmp - int_part * scale;
+  p += Lib_Format_UInt2Char_DEC(int_part, &buffer[p]);
+  if (num_frac_bits > 0)
+  {
+    buffer[p++] = '.';
+    Lib_Format_UInt2Char_DEC_Width(digits, &buffer[p], num_frac_bits);
+    p += num_frac_bits;
+  }
+  buffer[p] = '\0';
+  return p;
+}
+
+
+// 格式说明的标志位
+#define LIB_FORMAT_FLAG_LEFT      0x01    // '-'
+#define LIB_FORMAT_FLAG_ZERO      0x02    // '0'
+#define LIB_FORMAT_FLAG_PLUS      0x04    // '+'
+#define LIB_FORMAT_FLAG_SPACE     0x08    // ' '
+#define LIB_FORMAT_FLAG_ALT       0x10    // '#'
+
+// 填充用的常量字符串, 每次最多输出 16 个
+static const char Lib_Format_Spaces[16] = {' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' '};
+static const char Lib_Format_Zeros[16] = {'0','0','0','0','0','0','0','0','0','0','0','0','0','0','0','0'};
+
+// 输出 num 个填充字符
+static void Lib_Format_Pad(const Lib_Format_Sink_Type sink, void *const arg, const char *const pad, uint32_t num)
+{
+  while (num > 0)
+  {
+    sink(arg, pad, (num > 16) ? 16 : num);
+    num -= (num > 16) ? 16 : num;
+  }
+}
+
+/*
+ * @brief   按宽度输出一个字段: [空格] 前缀 [0] 内容 [空格]
+ * @param   prefix/prefix_len 符号或 0x 前缀
+ *          zeros             前缀和内容之间的 0 (整数的精度)
+ *          body/body_len     内容
+ *          width/flags       宽度和标志, flags 含 ZERO 时用 0 代替左侧的空格
+ * @return  输出的字符数
+*/
+static uint32_t Lib_Format_Field(const Lib_Format_Sink_Type sink, void *const arg,
+                                 const char *const prefix, const uint32_t prefix_len, uint32_t zeros,
+                                 const char *const body, const uint32_t body_len,
+                                 const uint32_t width, const uint8_t flags)
+{
+  uint32_t len = prefix_len + zeros + body_len, fill = 0;
+
+  if (width > len)
+  {
+    fill = width - len;
+  }
+  if (!(flags & LIB_FORMAT_FLAG_LEFT))
+  {
+    if (flags & LIB_FORMAT_FLAG_ZERO)
+    {
+      zeros += fill;
+    }
+    else
+    {
+      Lib_Format_Pad(sink, arg, Lib_Format_Spaces, fill);
+    }
+  }
+  if (prefix_len > 0)
+  {
+    sink(arg, prefix, prefix_len);
+  }
+  Lib_Format_Pad(sink, arg, Lib_Format_Zeros, zeros);
+  if (body_len > 0)
+  {
+    sink(arg, body, body_len);
+  }
+  if (flags & LIB_FORMAT_FLAG_LEFT)
+  {
+    Lib_Format_Pad(sink, arg, Lib_Format_Spaces, fill);
+  }
+  return len + fill;
+}
+
+// 从格式字符串读取十进制数, 用于宽度和精度
+static uint32_t Lib_Format_Parse_Num(const char **const p)
+{
+  uint32_t num = 0;
+
+  while (**p >= '0' && **p <= '9')
+  {
+    num = num * 10 + (uint32_t)(**p - '0');
+    ++*p;
+  }
+  return num;
+}
+
+/*
+ * @brief   格式化输出, 见 lib_format.h
+ * @param   sink 输出函数
+ *          arg  传给 sink 的参数
+ *          str  格式字符串
+ *          ap   参数列表
+ * @return  输出的字符数
+ * @note    不支持的转换原样输出
+*/
+uint32_t Lib_Format_vPrint(const Lib_Format_Sink_Type sink, void *const arg, const char *const str, va_list ap)
+{
+  const char *p = str, *start = str, *body = 0;
+  char num_buffer[LIB_FORMAT_NUM_BUFFER_SIZE];
+  char prefix[2] = {0};
+  uint32_t count = 0, width = 0, precision = 0, body_len = 0, prefix_len = 0, zeros = 0, value = 0;
+  int32_t tmp = 0;
+  uint8_t flags = 0, has_precision = 0, length = 0, neg = 0;
+  char ch = 0;
+
+  while (*p != '\0')
+  {
+    if (*p != '%')
+    {
+      ++p;
+      continue;
+    }
+    // 普通字符整段输出
+    if (p > start)
+    {
+      sink(arg, start, (uint32_t)(p - start));
+      count += (uint32_t)(p - start);
+    }
+    start = p++;
+
+    // 标志
+    flags = 0;
+    for (;; ++p)
+    {
+      if (*p == '-')      flags |= LIB_FORMAT_FLAG_LEFT;
+      else if (*p == '0') flags |= LIB_FORMAT_FLAG_ZERO;
+      else if (*p == '+') flags |= LIB_FORMAT_FLAG_PLUS;
+      else if (*p == ' ') flags |= LIB_FORMAT_FLAG_SPACE;
+      else if (*p == '#') flags |= LIB_FORMAT_FLAG_ALT;
+      else break;
+    }
+    // 宽度
+    if (*p == '*')
+    {
+      tmp = va_arg(ap, int);
+      if (tmp < 0)
+      {
+        flags |= LIB_FORMAT_FLAG_LEFT;
+        tmp = -tmp;
+      }
+      width = (uint32_t)tmp;
+      ++p;
+    }
+    else
+    {
+      width = Lib_Format_Parse_Num(&p);
+    }
+    // 精度
+    has_precision = 0;
+    precision = 0;
+    if (*p == '.')
+    {
+      has_precision = 1;
+      ++p;
+      if (*p == '*')
+      {
+        tmp = va_arg(ap, int);
+        has_precision = (tmp >= 0);   // 负的精度视为未指定
+        precision = (tmp >= 0) ? (uint32_t)tmp : 0;
+        ++p;
+      }
+      else
+      {
+        precision = Lib_Format_Parse_Num(&p);
+      }
+    }
+    // 长度, 0: int, 1: h, 2: hh, 3: l
+    length = 0;
+    if (*p == 'h')
+    {
+      length = (p[1] == 'h') ? 2 : 1;
+      p += length;
+    }
+    else if (*p == 'l')
+    {
+      length = 3;
+      ++p;
+    }
+
+    ch = *p;
+    if (ch == '\0')
+    {
+      break;  // 格式字符串不完整, 原样输出
+    }
+    ++p;
+    prefix_len = 0;
+    zeros = 0;
+    neg = 0;
+    body = num_buffer;
+    switch (ch)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+        value = (length == 3) ? (uint32_t)va_arg(ap, long) : (uint32_t)va_arg(ap, int);
+        if (length == 1)
+        {
+          value = (ch == 'd' || ch == 'i') ? (uint32_t)(int16_t)value : (uint16_t)value;
+        }
+        else if (length == 2)
+        {
+          value = (ch == 'd' || ch == 'i') ? (uint32_t)(int8_t)value : (uint8_t)value;
+        }
+        if (ch == 'd' || ch == 'i')
+        {
+          if ((int32_t)value < 0)
+          {
+            value = 0U - value;
+            prefix[prefix_len++] = '-';
+          }
+          else if (flags & LIB_FORMAT_FLAG_PLUS)
+          {
+            prefix[prefix_len++] = '+';
+          }
+          else if (flags & LIB_FORMAT_FLAG_SPACE)
+          {
+            prefix[prefix_len++] = ' ';
+          }
+        }
+        else if ((ch == 'x' || ch == 'X') && (flags & LIB_FORMAT_FLAG_ALT) && value != 0)
+        {
+          prefix[prefix_len++] = '0';
+          prefix[prefix_len++] = ch;
+        }
+        if (has_precision && precision == 0 && value == 0)
+        {
+          body_len = 0;   // "%.0d" 输出 0 时不显示数字
+        }
+        else if (ch == 'x' || ch == 'X')
+        {
+          body_len = Lib_Format_UInt2Char_HEX(value, (uint8_t *)num_buffer, ch == 'X');
+        }
+        else
+        {
+          body_len = Lib_Format_UInt2Char_DEC(value, (uint8_t *)num_buffer);
+        }
+        if (has_precision)
+        {
+          zeros = (precision > body_len) ? precision - body_len : 0;
+          flags &= ~LIB_FORMAT_FLAG_ZERO;  // 指定精度时忽略 '0'
+        }
+        break;
+
+      case 'f':
+      case 'F':
+        if (!has_precision)
+        {
+          precision = LIB_FORMAT_FLOAT_PRECISION;
+        }
+        body_len = Lib_Format_Double_Body(va_arg(ap, double), &neg, (uint8_t *)num_buffer,
+                                          (precision > LIB_FORMAT_FRAC_MAXDIGITS) ? LIB_FORMAT_FRAC_MAXDIGITS : (uint8_t)precision);
+        if (neg)
+        {
+          prefix[prefix_len++] = '-';
+        }
+        else if (flags & LIB_FORMAT_FLAG_PLUS)
+        {
+          prefix[prefix_len++] = '+';
+        }
+        else if (flags & LIB_FORMAT_FLAG_SPACE)
+        {
+          prefix[prefix_len++] = ' ';
+        }
+        if (num_buffer[0] > '9')
+        {
+          flags &= ~LIB_FORMAT_FLAG_ZERO; // inf 和 nan 不补零
+        }
+        break;
+
+      case 'c':
+        num_buffer[0] = (char)va_arg(ap, int);
+        body_len = 1;
+        flags &= ~LIB_FORMAT_FLAG_ZERO;
+        break;
+
+      case 's':
+        body = va_arg(ap, const char *);
+        if (body == 0)
+        {
+          body = "(null)";
+        }
+        // 指定精度时最多输出 precision 个字符, 且不读取之后的内容
+        for (body_len = 0; (!has_precision || body_len < precision) && body[body_len] != '\0'; ++body_len)
+        {
+        }
+        flags &= ~LIB_FORMAT_FLAG_ZERO;
+        break;
+
+      case 'p':
+        prefix[prefix_len++] = '0';
+        prefix[prefix_len++] = 'x';
+        body_len = Lib_Format_UInt2Char_HEX((uint32_t)(uintptr_t)va_arg(ap, void *), (uint8_t *)num_buffer, 0);
+        break;
+
+      case '%':
+        num_buffer[0] = '%';
+        body_len = 1;
+        width = 0;
+        break;
+
+      default:
+        // 不支持的转换, 原样输出整个格式说明
+        continue;
+    }
+    count += Lib_Format_Field(sink, arg, prefix, prefix_len, zeros, body, body_len, width, flags);
+    start = p;
+  }
+  if (p > start)
+  {
+    sink(arg, start, (uint32_t)(p - start));
+    count += (uint32_t)(p - start);
+  }
+  return count;
+}
+
+/*
+ * @brief   格式化输出, 见 Lib_Format_vPrint()
+*/
+uint32_t Lib_Format_Print(const Lib_Format_Sink_Type sink, void *const arg, const char *const str, ...)
+{
+  uint32_t num = 0;
+  va_list ap;
+
+  va_start(ap, str);
+  num = Lib_Format_vPrint(sink, arg, str, ap);
+  va_end(ap);
+  return num;
+}
+
+// 内存缓冲区输出的状态
+typedef struct
+{
+  char *buffer;
+  uint32_t size;    // 缓冲区大小, 含结束符
+  uint32_t num;     // 已写入的字符数
+} Lib_Format_Memory_Type;
+
+// 内存缓冲区输出函数, 超出部分丢弃
+static void Lib_Format_Memory_Sink(void *const arg, const char *const data, const uint32_t num)
+{
+  Lib_Format_Memory_Type *const mem = (Lib_Format_Memory_Type *)arg;
+
+  for (uint32_t i = 0; i < num && mem->num + 1 < mem->size; ++i)
+  {
+    mem->buffer[mem->num++] = data[i];
+  }
+}
+
+/*
+ * @brief   格式化输出到内存缓冲区
+ * @param   buffer 缓冲区
+ *          size   缓冲区大小; 非 0 时结果总以 '\0' 结尾, 超出部分被截断
+ *          str    格式字符串
+ *          ap     参数列表
+ * @return  完整结果的字符数 (不含结束符), 大于等于 size 说明被截断
+*/
+uint32_t Lib_Format_vsnPrint(char *const buffer, const uint32_t size, const char *const str, va_list ap)
+{
+  Lib_Format_Memory_Type mem = {buffer, size, 0};
+  uint32_t num = 0;
+
+  num = Lib_Format_vPrint(Lib_Format_Memory_Sink, &mem, str, ap);
+  if (size > 0)
+  {
+    buffer[mem.num] = '\0';
+  }
+  return num;
+}
+
+/*
+ * @brief   格式化输出到内存缓冲区, 见 Lib_Format_vsnPrint()
+*/
+uint32_t Lib_Format_snPrint(char *const buffer, const uint32_t size, const char *const str, ...)
+{
+  uint32_t num = 0;
+  va_list ap;
+
+  va_start(ap, str);
+  num = Lib_Format_vsnPrint(buffer, size, str, ap);
+  va_end(ap);
+  return num;
+}
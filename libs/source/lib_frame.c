@@ -0,0 +1,219 @@
+#include "lib_frame.h"
+
+// CRC-16/CCITT-FALSE 半字节查找表 (多项式 0x1021), 比整字节表节省 480 B Flash
+static const uint16_t Lib_Frame_CRC16_Table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+/*
+ * @brief   计算 CRC-16/CCITT-FALSE
+ * @param   data 数据
+ *          num  数据的字节数
+ *          crc  初值, 首次计算为 0xFFFF; 分段计算时传入上一段的结果
+ * @return  CRC 值
+*/
+uint16_t Lib_Frame_CRC16(const uint8_t *const data, const uint32_t num, const uint16_t crc)
+{
+    uint16_t res = crc;
+
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        res = (res << 4) ^ Lib_Frame_CRC16_Table[(res >> 12) ^ (data[i] >> 4)];
+        res = (res << 4) ^ Lib_Frame_CRC16_Table[(res >> 12) ^ (data[i] & 0x0F)];
+    }
+    return res;
+}
+
+/*
+ * @brief   COBS 编码, 末尾带结束符 0x00
+ * @param   raw 原数据
+ *          num 原数据的字节数
+ *          out 输出缓冲区, 至少 num + num / 254 + 2 字节, 不能与 raw 重叠
+ * @return  out 中的字节数, 含结束符
+*/
+uint32_t Lib_Frame_COBS_Encode(const uint8_t *const raw, const uint32_t num, uint8_t *const out)
+{
+    uint32_t p = 1, code_idx = 0; // p 为 out 的写入位置; code_idx 为当前块编码字节的位置
+    uint8_t code = 1;
+
+    // 每个 0x00 替换为到下一个 0x00 的距离, 块最长 254 个非零字节
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        if (raw[i] == 0)
+        {
+            out[code_idx] = code;
+            code_idx = p++;
+            code = 1;
+        }
+        else
+        {
+            out[p++] = raw[i];
+            ++code;
+            if (code == 0xFF)
+            {
+                out[code_idx] = code;
+                code_idx = p++;
+                code = 1;
+            }
+        }
+    }
+    out[code_idx] = code;
+    out[p++] = LIB_FRAME_DELIMITER;
+    return p;
+}
+
+/*
+ * @brief   COBS 解码一段完整的数据, 用于按结束符分段后整段解码 (例如上位机)
+ * @param   in  编码后的数据, 不含结束符
+ *          num in 的字节数
+ *          out 输出缓冲区, 至少 num 字节, 可以与 in 相同
+ * @return  out 中的字节数; 编码错误 (含 0x00 或块不完整) 返回 -1
+*/
+int32_t Lib_Frame_COBS_Decode(const uint8_t *const in, const uint32_t num, uint8_t *const out)
+{
+    uint32_t i = 0, p = 0;
+    uint8_t code = 0;
+
+    while (i < num)
+    {
+        code = in[i++];
+        if (code == 0 || i + code - 1 > num)
+        {
+            return -1;
+        }
+        for (uint8_t j = 1; j < code; ++j)
+        {
+            if (in[i] == 0)
+            {
+                return -1;
+            }
+            out[p++] = in[i++];
+        }
+        // 不是 254 字节的满块且不是最后一块, 说明原数据在此处有一个 0x00
+        if (code != 0xFF && i < num)
+        {
+            out[p++] = 0;
+        }
+    }
+    return (int32_t)p;
+}
+
+/*
+ * @brief   把一帧编码为 COBS 字节流, 末尾带结束符 0x00
+ * @param   frame 待编码的帧, frame->len 不能超过 LIB_FRAME_PAYLOAD_MAXSIZE
+ *          out   输出缓冲区, 至少 LIB_FRAME_ENCODED_MAXSIZE 字节
+ * @return  out 中的字节数, 含结束符; frame->len 超长时返回 0
+*/
+uint32_t Lib_Frame_Encode(const Lib_Frame_Type *const frame, uint8_t *const out)
+{
+    uint8_t raw[LIB_FRAME_RAW_MAXSIZE];
+    uint32_t num = 0;
+    uint16_t crc = 0;
+
+    if (frame->len > LIB_FRAME_PAYLOAD_MAXSIZE)
+    {
+        return 0;
+    }
+
+    raw[num++] = frame->seq;
+    raw[num++] = frame->cmd;
+    raw[num++] = frame->len;
+    for (uint8_t i = 0; i < frame->len; ++i)
+    {
+        raw[num++] = frame->payload[i];
+    }
+    crc = Lib_Frame_CRC16(raw, num, 0xFFFF);
+    raw[num++] = crc & 0xFF;
+    raw[num++] = crc >> 8;
+
+    return Lib_Frame_COBS_Encode(raw, num, out);
+}
+
+/*
+ * @brief   初始化 (复位) 解码器
+*/
+void Lib_Frame_Decoder_Init(Lib_Frame_Decoder_Type *const dec)
+{
+    dec->num = 0;
+    dec->code = 0;
+    dec->remain = 0;
+    dec->overflow = 0;
+}
+
+// 向解码缓冲区追加一个字节, 超长时标记 overflow
+static void Lib_Frame_Decoder_Append(Lib_Frame_Decoder_Type *const dec, const uint8_t byte)
+{
+    if (dec->num >= LIB_FRAME_RAW_MAXSIZE)
+    {
+        dec->overflow = 1;
+        return;
+    }
+    dec->buffer[dec->num++] = byte;
+}
+
+/*
+ * @brief   输入一个字节, 遇到结束符时校验并输出一帧
+ * @param   dec   解码器
+ *          byte  收到的字节
+ *          frame 返回 LIB_FRAME_READY 时, 存放解出的帧
+ * @return  见 Lib_Frame_Status_Type; 连续的结束符 (空帧) 返回 LIB_FRAME_PENDING
+*/
+Lib_Frame_Status_Type Lib_Frame_Decode_Byte(Lib_Frame_Decoder_Type *const dec, const uint8_t byte, Lib_Frame_Type *const frame)
+{
+    Lib_Frame_Status_Type res = LIB_FRAME_ERROR;
+    uint16_t crc = 0;
+    uint8_t len = 0;
+
+    if (byte == LIB_FRAME_DELIMITER)
+    {
+        if (dec->num == 0 && dec->code == 0 && dec->overflow == 0)
+        {
+            return LIB_FRAME_PENDING;
+        }
+        len = dec->buffer[2];
+        // 块必须完整, 长度字段必须与实际字节数一致
+        if (dec->overflow == 0 && dec->remain == 0
+            && dec->num >= LIB_FRAME_HEADER_SIZE + LIB_FRAME_CRC_SIZE
+            && len <= LIB_FRAME_PAYLOAD_MAXSIZE
+            && dec->num == LIB_FRAME_HEADER_SIZE + len + LIB_FRAME_CRC_SIZE)
+        {
+            crc = Lib_Frame_CRC16(dec->buffer, LIB_FRAME_HEADER_SIZE + len, 0xFFFF);
+            if ((crc & 0xFF) == dec->buffer[dec->num - 2] && (crc >> 8) == dec->buffer[dec->num - 1])
+            {
+                frame->seq = dec->buffer[0];
+                frame->cmd = dec->buffer[1];
+                frame->len = len;
+                for (uint8_t i = 0; i < len; ++i)
+                {
+                    frame->payload[i] = dec->buffer[LIB_FRAME_HEADER_SIZE + i];
+                }
+                res = LIB_FRAME_READY;
+            }
+        }
+        Lib_Frame_Decoder_Init(dec);
+        return res;
+    }
+
+    if (dec->overflow)
+    {
+        return LIB_FRAME_PENDING;
+    }
+    if (dec->remain == 0) // 编码字节, 开始新的块
+    {
+        // 上一个块不是 254 字节的满块, 说明原数据在此处有一个 0x00
+        if (dec->code != 0 && dec->code != 0xFF)
+        {
+            Lib_Frame_Decoder_Append(dec, 0);
+        }
+        dec->code = byte;
+        dec->remain = byte - 1;
+    }
+    else
+    {
+        Lib_Frame_Decoder_Append(dec, byte);
+        --dec->remain;
+    }
+    return LIB_FRAME_PENDING;
+}
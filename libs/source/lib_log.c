@@ -0,0 +1,61 @@
+#include "lib_log.h"
+
+#if LIB_LOG_DEFERRED_EN
+#include <stdarg.h>
+#include "lib_frame.h"
+
+static uint32_t Lib_Log_Last_Time;    // 已发送的时间增量之和, 与 Lib_Log_Get_Time() 同单位
+
+// 把 num 按 varint 写入 buffer[p], 每字节 7 位, 低位在前, 最高位为 1 表示后面还有; 返回新的写入位置
+static uint32_t Lib_Log_Put_Varint(uint8_t *const buffer, uint32_t p, uint32_t num)
+{
+  while (num >= 0x80)
+  {
+    buffer[p++] = (uint8_t)(num | 0x80);
+    num >>= 7;
+  }
+  buffer[p++] = (uint8_t)num;
+  return p;
+}
+
+/*
+ * @brief   发送一条延迟日志记录, 由 LIB_LOG() 调用
+ * @param   id       格式字符串在 .lib_log 段中的偏移
+ *          num_args 参数个数, 不超过 LIB_LOG_ARGS_MAXNUM, 多余的参数被忽略
+ *          ...      参数, 都按 int 读取
+ * @note    只做 varint 编码, 不做格式化; 可在中断中调用, 但与主循环同时打印时, 时间增量按生成记录的顺序计算
+*/
+void Lib_Log_Write(const uint32_t id, const uint8_t num_args, ...)
+{
+  uint8_t raw[LIB_LOG_RECORD_MAXSIZE];
+  uint8_t out[LIB_LOG_RECORD_MAXSIZE + 3];  // 开头的结束符 + COBS 编码最多多 2 字节
+  uint32_t num = 0, now = 0, dt = 0, arg = 0, primask = 0;
+  va_list ap;
+
+  // 读取时间和更新上一条记录的时间不能被打断
+  primask = __get_PRIMASK();
+  __disable_irq();
+  now = Lib_Log_Get_Time();
+  dt = (now - Lib_Log_Last_Time) >> LIB_LOG_TIME_SHIFT;
+  Lib_Log_Last_Time += dt << LIB_LOG_TIME_SHIFT;    // 舍去的部分留给下一条记录, 误差不累积
+  __set_PRIMASK(primask);
+
+  num = Lib_Log_Put_Varint(raw, num, id);
+  num = Lib_Log_Put_Varint(raw, num, dt);
+  va_start(ap, num_args);
+  for (uint8_t i = 0; i < num_args && i < LIB_LOG_ARGS_MAXNUM; ++i)
+  {
+    arg = (uint32_t)va_arg(ap, int);
+    // zigzag: 0, -1, 1, -2 ... 编码为 0, 1, 2, 3 ..., 绝对值小的负数也只占 1 字节
+    num = Lib_Log_Put_Varint(raw, num, (arg << 1) ^ (uint32_t)((int32_t)arg >> 31));
+  }
+  va_end(ap);
+  raw[num] = (uint8_t)Lib_Frame_CRC16(raw, num, 0xFFFF);
+  ++num;
+
+  // 先发一个结束符, 使之前的文本 (例如 Lib_USART_Send_String()) 单独成段, 不会和本条记录连在一起
+  out[0] = LIB_FRAME_DELIMITER;
+  num = 1 + Lib_Frame_COBS_Encode(raw, num, &out[1]);
+  Lib_Log_Send_Data(out, num);
+}
+#endif
@@ -3,6 +3,9 @@
 // 任何修改 RTC 的操作必须等待上一个操作完成, 即 RTOF 被置位
 #define LIB_RTC_WAIT_TASK()     do {} while(LL_RTC_IsActiveFlag_RTOF(LIB_RTC) != SET)
 
+// 日期转换使用的时区, 见 Lib_RTC_Set_Timezone()
+static int32_t Lib_RTC_Timezone = LIB_RTC_TIMEZONE;
+
 /*
  * @brief   初始化 RTC
 */
@@ -55,13 +58,29 @@ void Lib_RTC_Set_Time(const Lib_RTC_UnixType ts)
     LL_RTC_DisableWriteProtection(LIB_RTC);
     LIB_RTC_WAIT_TASK();
     // RTC 时间
-    LL_RTC_TIME_Set(LIB_RTC, LIB_RTC_UNIX);
+    LL_RTC_TIME_Set(LIB_RTC, (uint32_t)ts);
     LIB_RTC_WAIT_TASK();
     // 若要使配置生效, 必须退出配置模式
     LL_RTC_EnableWriteProtection(LIB_RTC);
     LIB_RTC_WAIT_TASK();
 }
 
+/*
+ * @brief   修改日期转换使用的时区, 默认为 LIB_RTC_TIMEZONE
+ * @param   timezone UTC 时区, -12 ~ +14
+ * @return  SUCCESS; ERROR: 超出范围, 时区不变
+ * @note    RTC 计数器始终是 UTC 的 Unix 时间, 只影响 Lib_RTC_Date2Unix(), Lib_RTC_Unix2Date() 和 FatFs 的文件时间
+*/
+ErrorStatus Lib_RTC_Set_Timezone(const int32_t timezone)
+{
+    if (timezone < -12 || timezone > 14)
+    {
+        return ERROR;
+    }
+    Lib_RTC_Timezone = timezone;
+    return SUCCESS;
+}
+
 /*
  * @brief   读取现在的 RTC 时间
  * @return  返回数据为 Unix 时间戳
@@ -117,7 +136,7 @@ Lib_RTC_UnixType Lib_RTC_Date2Unix(const Lib_RTC_DateType *dt)
         + (int64_t)dt->hour * 3600
         + (int64_t)dt->minute * 60
         + (int64_t)dt->second
-        - (int64_t)LIB_RTC_TIMEZONE * 3600;
+        - (int64_t)Lib_RTC_Timezone * 3600;
 
     if (res < INT32_MIN)
         return INT32_MIN;
@@ -134,7 +153,7 @@ Lib_RTC_UnixType Lib_RTC_Date2Unix(const Lib_RTC_DateType *dt)
 */
 void Lib_RTC_Unix2Date(const Lib_RTC_UnixType ts, Lib_RTC_DateType* const dt)
 {
-    int64_t modified_ts = (int64_t)ts + LIB_RTC_TIMEZONE * 3600;
+    int64_t modified_ts = (int64_t)ts + (int64_t)Lib_RTC_Timezone * 3600;
     int64_t total_days = modified_ts / 86400, secs_of_day = modified_ts % 86400;
 
     if (secs_of_day < 0)
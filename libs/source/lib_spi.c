@@ -1,64 +1,508 @@
 #include "lib_spi.h"
 
-void Lib_SPI_Init(void)
+// 实例的状态
+#if LIB_SPI1_EN
+    Lib_SPI_State_Type Lib_SPI1_State;
+#endif
+#if LIB_SPI2_EN
+    Lib_SPI_State_Type Lib_SPI2_State;
+#endif
+
+// 只接收时 DMA 发送的数据, 只发送时 DMA 接收的目标; 地址不自增
+static const uint8_t Lib_SPI_Dummy_TX = LIB_SPI_DUMMY;
+static uint8_t Lib_SPI_Dummy_RX;
+
+/*
+ * @brief   初始化 SPI 实例, 例如 Lib_SPI_Init(&Lib_SPI1)
+*/
+void Lib_SPI_Init(const Lib_SPI_Type *const spi)
 {
     LL_GPIO_InitTypeDef gpio_config = {0};
     LL_SPI_InitTypeDef spi_config = {0};
+    LL_DMA_InitTypeDef dma_config = {0};
 
-    LIB_SPI_PORT_ENCLK();
-    LIB_SPI_ENCLK();
+    if (spi->apb1_periph != 0)
+    {
+        LL_APB1_GRP1_EnableClock(spi->apb1_periph);
+    }
+    LL_APB2_GRP1_EnableClock(spi->apb2_periph);
 
     // 配置 GPIO
     // SPI_NSS 采用推挽输出 (软件控制; 如果是硬件控制, 需要复用)
     // SPI_SCK, SPI_MOSI 采用复用推挽输出
     // SPI_MISO 采用浮空输入
-    gpio_config.Pin = LIB_SPI_NSS_PIN;
+    gpio_config.Pin = spi->nss_pin;
     gpio_config.Mode = LL_GPIO_MODE_OUTPUT;  // SPI_NSS 采用软件控制, 不需要复用
     gpio_config.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
     gpio_config.Speed = LL_GPIO_SPEED_FREQ_HIGH;
-    LL_GPIO_Init(LIB_SPI_NSS_PORT, &gpio_config);
-    gpio_config.Pin = LIB_SPI_MOSI_PIN;
+    LL_GPIO_Init(spi->nss_port, &gpio_config);
+    gpio_config.Pin = spi->mosi_pin;
     gpio_config.Mode = LL_GPIO_MODE_ALTERNATE;
-    LL_GPIO_Init(LIB_SPI_MOSI_PORT, &gpio_config);
-    gpio_config.Pin = LIB_SPI_SCK_PIN;
-    LL_GPIO_Init(LIB_SPI_SCK_PORT, &gpio_config);
-    gpio_config.Pin = LIB_SPI_MISO_PIN;
+    LL_GPIO_Init(spi->port, &gpio_config);
+    gpio_config.Pin = spi->sck_pin;
+    LL_GPIO_Init(spi->port, &gpio_config);
+    gpio_config.Pin = spi->miso_pin;
     gpio_config.Mode = LL_GPIO_MODE_FLOATING;
-    LL_GPIO_Init(LIB_SPI_MISO_PORT, &gpio_config);
+    LL_GPIO_Init(spi->port, &gpio_config);
 
     // 配置 SPI
     spi_config.TransferDirection = LL_SPI_FULL_DUPLEX;
     spi_config.Mode = LL_SPI_MODE_MASTER;
     spi_config.DataWidth = LL_SPI_DATAWIDTH_8BIT;
-    spi_config.ClockPolarity = LIB_SPI_CPOL;
-    spi_config.ClockPhase = LIB_SPI_CPHA;
+    spi_config.ClockPolarity = spi->cpol;
+    spi_config.ClockPhase = spi->cpha;
     spi_config.NSS = LL_SPI_NSS_SOFT;
-    spi_config.BaudRate = LIB_SPI_BAUD_RATE;
-    spi_config.BitOrder = LIB_SPI_BIT_ORDER;
+    spi_config.BaudRate = spi->baud_rate;
+    spi_config.BitOrder = spi->bit_order;
     spi_config.CRCCalculation = LL_SPI_CRCCALCULATION_DISABLE;
-    LL_SPI_Init(LIB_SPI, &spi_config);
+    LL_SPI_Init(spi->spi, &spi_config);
+
+    // 配置 DMA: 接收通道和发送通道同时启动, 接收通道的传输完成表示最后一个字节已经收到
+    if (spi->dma != (void *)0)
+    {
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+        dma_config.Direction = LL_DMA_DIRECTION_PERIPH_TO_MEMORY;
+        dma_config.Mode = LL_DMA_MODE_NORMAL;
+        dma_config.PeriphOrM2MSrcAddress = (uint32_t)&spi->spi->DR;
+        dma_config.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+        dma_config.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_BYTE;
+        dma_config.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_BYTE;
+        dma_config.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;     // 每次启动时重新设置
+        // 接收优先级高于发送, 否则发送领先太多时 DR 来不及读走, 产生溢出
+        dma_config.Priority = LL_DMA_PRIORITY_VERYHIGH;
+        LL_DMA_Init(spi->dma, spi->dma_rx_ch, &dma_config);
+        dma_config.Direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
+        dma_config.Priority = LL_DMA_PRIORITY_HIGH;
+        LL_DMA_Init(spi->dma, spi->dma_tx_ch, &dma_config);
+        LL_DMA_EnableIT_TC(spi->dma, spi->dma_rx_ch);
+        // 传输错误 (总线错误, 例如地址无效) 时通道被硬件关闭, 不会再有传输完成中断, 两个通道都要处理
+        LL_DMA_EnableIT_TE(spi->dma, spi->dma_rx_ch);
+        LL_DMA_EnableIT_TE(spi->dma, spi->dma_tx_ch);
+        NVIC_SetPriority(spi->dma_irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                         spi->dma_preempt_priority, spi->dma_sub_priority));
+        NVIC_EnableIRQ(spi->dma_irq);
+        NVIC_SetPriority(spi->dma_tx_irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                         spi->dma_preempt_priority, spi->dma_sub_priority));
+        NVIC_EnableIRQ(spi->dma_tx_irq);
+        // 通道未使能时 DMA 请求被忽略, Lib_SPI_Send_Byte() 等轮询函数不受影响
+        LL_SPI_EnableDMAReq_RX(spi->spi);
+        LL_SPI_EnableDMAReq_TX(spi->spi);
+    }
+    spi->state->busy = 0;
+    spi->state->mode = spi->cpol | spi->cpha | spi->bit_order | spi->baud_rate;
+    spi->state->locked = 0;
+    spi->state->cs_port = (void *)0;
 
     // NSS 置 1, 再使能 SPI
-    LIB_SPI_STOP();
-    LL_SPI_Enable(LIB_SPI);
+    Lib_SPI_Stop(spi);
+    LL_SPI_Enable(spi->spi);
 }
 
-// 使用前需要 LIB_SPI_START()
-uint8_t Lib_SPI_Send_Byte(uint8_t data)
+// 清除 DMA 通道的所有标志; 通道 n 的标志位于 IFCR 的 [4(n-1), 4n)
+#define Lib_SPI_DMA_ClearFlags(dma, ch)     WRITE_REG((dma)->IFCR, DMA_IFCR_CGIF1 << (((ch) - 1) * 4))
+
+/*
+ * @brief   用 DMA 传输下一段, 每段最多 LIB_SPI_DMA_MAXSIZE 字节
+*/
+static void Lib_SPI_DMA_Next(const Lib_SPI_Type *const spi)
 {
-    while (LL_SPI_IsActiveFlag_TXE(LIB_SPI) != SET);
-    LL_SPI_TransmitData8(LIB_SPI, data);
-    // SPI 全双工工作, 发送的同时也在接收
-    // 发送了一个数据, 也意味着接收了一个数据
-    // 接收的数据是否有效取决于实际情况
-    while (LL_SPI_IsActiveFlag_RXNE(LIB_SPI) != SET);
-    return LL_SPI_ReceiveData8(LIB_SPI);
+    Lib_SPI_State_Type *const state = spi->state;
+    uint32_t num = state->num > LIB_SPI_DMA_MAXSIZE ? LIB_SPI_DMA_MAXSIZE : state->num;
+
+    LL_DMA_DisableChannel(spi->dma, spi->dma_rx_ch);
+    LL_DMA_DisableChannel(spi->dma, spi->dma_tx_ch);
+    Lib_SPI_DMA_ClearFlags(spi->dma, spi->dma_rx_ch);
+    Lib_SPI_DMA_ClearFlags(spi->dma, spi->dma_tx_ch);
+
+    if (state->rx != (void *)0)
+    {
+        LL_DMA_SetMemoryAddress(spi->dma, spi->dma_rx_ch, (uint32_t)state->rx);
+        LL_DMA_SetMemoryIncMode(spi->dma, spi->dma_rx_ch, LL_DMA_MEMORY_INCREMENT);
+        state->rx += num;
+    }
+    else
+    {
+        LL_DMA_SetMemoryAddress(spi->dma, spi->dma_rx_ch, (uint32_t)&Lib_SPI_Dummy_RX);
+        LL_DMA_SetMemoryIncMode(spi->dma, spi->dma_rx_ch, LL_DMA_MEMORY_NOINCREMENT);
+    }
+    if (state->tx != (void *)0)
+    {
+        LL_DMA_SetMemoryAddress(spi->dma, spi->dma_tx_ch, (uint32_t)state->tx);
+        LL_DMA_SetMemoryIncMode(spi->dma, spi->dma_tx_ch, LL_DMA_MEMORY_INCREMENT);
+        state->tx += num;
+    }
+    else
+    {
+        LL_DMA_SetMemoryAddress(spi->dma, spi->dma_tx_ch, (uint32_t)&Lib_SPI_Dummy_TX);
+        LL_DMA_SetMemoryIncMode(spi->dma, spi->dma_tx_ch, LL_DMA_MEMORY_NOINCREMENT);
+    }
+    LL_DMA_SetDataLength(spi->dma, spi->dma_rx_ch, num);
+    LL_DMA_SetDataLength(spi->dma, spi->dma_tx_ch, num);
+    state->num -= num;
+    // 先使能接收, 再由发送启动时钟
+    LL_DMA_EnableChannel(spi->dma, spi->dma_rx_ch);
+    LL_DMA_EnableChannel(spi->dma, spi->dma_tx_ch);
+}
+
+// 通道 n 的标志位于 ISR 的 [4(n-1), 4n)
+#define Lib_SPI_DMA_IsActiveFlag(dma, ch, flag)     (READ_BIT((dma)->ISR, (flag) << (((ch) - 1) * 4)) != 0)
+
+/*
+ * @brief   DMA 中断: 一段传输完成, 继续下一段或结束传输; 任一通道传输错误时中止传输
+ * @note    1) 由 Lib_SPI1_DMA_RX_Handler(), Lib_SPI1_DMA_TX_Handler() 等中断服务函数调用
+ *          2) 中止时丢弃剩余的段, 以 ERROR 调用回调; 已经收到的数据不完整
+*/
+void Lib_SPI_DMA_IT_Handler(const Lib_SPI_Type *const spi)
+{
+    Lib_SPI_State_Type *const state = spi->state;
+
+    if (Lib_SPI_DMA_IsActiveFlag(spi->dma, spi->dma_rx_ch, DMA_ISR_TEIF1)
+        || Lib_SPI_DMA_IsActiveFlag(spi->dma, spi->dma_tx_ch, DMA_ISR_TEIF1))
+    {
+        LL_DMA_DisableChannel(spi->dma, spi->dma_rx_ch);
+        LL_DMA_DisableChannel(spi->dma, spi->dma_tx_ch);
+        Lib_SPI_DMA_ClearFlags(spi->dma, spi->dma_rx_ch);
+        Lib_SPI_DMA_ClearFlags(spi->dma, spi->dma_tx_ch);
+        // 等待移位寄存器中的字节发送完, 读走 DR 并清除 OVR, 以免影响之后的轮询传输
+        while (LL_SPI_IsActiveFlag_BSY(spi->spi) == SET);
+        (void)LL_SPI_ReceiveData8(spi->spi);
+        LL_SPI_ClearFlag_OVR(spi->spi);
+        state->num = 0;
+        ++state->stat.dma_error;
+        state->busy = 0;
+        if (state->callback != (void *)0)
+        {
+            state->callback(state->arg, ERROR);
+        }
+        return;
+    }
+    if (!Lib_SPI_DMA_IsActiveFlag(spi->dma, spi->dma_rx_ch, DMA_ISR_TCIF1))
+    {
+        return;
+    }
+    Lib_SPI_DMA_ClearFlags(spi->dma, spi->dma_rx_ch);
+    if (state->num > 0)
+    {
+        Lib_SPI_DMA_Next(spi);
+        return;
+    }
+    LL_DMA_DisableChannel(spi->dma, spi->dma_rx_ch);
+    LL_DMA_DisableChannel(spi->dma, spi->dma_tx_ch);
+    ++state->stat.transfers;
+    state->busy = 0;
+    if (state->callback != (void *)0)
+    {
+        state->callback(state->arg, SUCCESS);
+    }
+}
+
+#if LIB_SPI1_EN && LIB_SPI1_DMA_EN
+    void Lib_SPI1_DMA_RX_Handler(void)
+    {
+        Lib_SPI_DMA_IT_Handler(&Lib_SPI1);
+    }
+
+    void Lib_SPI1_DMA_TX_Handler(void)
+    {
+        Lib_SPI_DMA_IT_Handler(&Lib_SPI1);
+    }
+#endif
+
+#if LIB_SPI2_EN && LIB_SPI2_DMA_EN
+    void Lib_SPI2_DMA_RX_Handler(void)
+    {
+        Lib_SPI_DMA_IT_Handler(&Lib_SPI2);
+    }
+
+    void Lib_SPI2_DMA_TX_Handler(void)
+    {
+        Lib_SPI_DMA_IT_Handler(&Lib_SPI2);
+    }
+#endif
+
+/*
+ * @brief   启动块传输, 立即返回; 完成后调用 callback
+ * @param   spi      实例, 需要已经 Lib_SPI_Start()
+ *          tx       发送的数据, 为 0 时发送 LIB_SPI_DUMMY (只接收)
+ *          rx       接收的位置, 为 0 时丢弃收到的数据 (只发送); 可以与 tx 相同
+ *          num      字节数
+ *          callback 完成回调, 可以为 0; 回调中可以启动下一次传输
+ *          arg      回调的参数
+ * @return  SUCCESS: 已启动; ERROR: 上一次传输未完成
+ * @note    1) 使用 DMA 时, 字节之间没有间隔, 速度为 f_SCK; 传输期间 tx 和 rx 必须保持有效
+ *          2) 实例不使用 DMA 时, 用 Lib_SPI_Burst() 轮询完成后调用 callback 再返回
+ *          3) 传输失败 (DMA 传输错误, 轮询时接收溢出) 也调用 callback, 以 ERROR 区分
+*/
+ErrorStatus Lib_SPI_Transfer_Start(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx,
+                                   const uint32_t num, const Lib_SPI_Callback_Type callback, void *const arg)
+{
+    Lib_SPI_State_Type *const state = spi->state;
+
+    if (state->busy)
+    {
+        ++state->stat.busy;
+        return ERROR;
+    }
+    if (spi->dma == (void *)0 || num == 0)
+    {
+        ErrorStatus res = Lib_SPI_Burst(spi, tx, rx, num);
+        if (callback != (void *)0)
+        {
+            callback(arg, res);
+        }
+        return SUCCESS;
+    }
+    state->busy = 1;
+    state->stat.bytes += num;
+    state->tx = tx;
+    state->rx = rx;
+    state->num = num;
+    state->callback = callback;
+    state->arg = arg;
+    Lib_SPI_DMA_Next(spi);
+    return SUCCESS;
+}
+
+/*
+ * @brief   轮询块传输, 发送缓冲区始终比接收提前一个字节: 第 n 个字节在移位寄存器中时, 第 n+1 个字节已写入 DR,
+ *          第 n 个字节收完后立即开始发送第 n+1 个, 字节之间没有间隔
+ * @param   spi 实例, 需要已经 Lib_SPI_Start(), 且没有未完成的 DMA 传输
+ *          tx  发送的数据, 为 0 时发送 LIB_SPI_DUMMY
+ *          rx  接收的位置, 为 0 时丢弃收到的数据; 可以与 tx 相同
+ *          num 字节数
+ * @return  SUCCESS; ERROR: 接收溢出 (OVR), 收到的数据不完整
+ * @note    读出第 n 个字节必须在第 n+1 个字节发送完之前, f_SCK = 36 MHz 时只有 16 个 CPU 周期,
+ *          期间被中断打断会溢出; 这种情况下应降低 f_SCK, 屏蔽中断, 或者用 DMA
+*/
+ErrorStatus Lib_SPI_Burst(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num)
+{
+    SPI_TypeDef *const reg = spi->spi;
+    uint8_t data = 0;
+
+    if (num == 0)
+    {
+        return SUCCESS;
+    }
+    while (LL_SPI_IsActiveFlag_TXE(reg) != SET);
+    LL_SPI_TransmitData8(reg, tx != (void *)0 ? tx[0] : LIB_SPI_DUMMY);
+    for (uint32_t i = 1; i < num; ++i)
+    {
+        // 第 i-1 个字节进入移位寄存器后, 立即写入第 i 个
+        while (LL_SPI_IsActiveFlag_TXE(reg) != SET);
+        LL_SPI_TransmitData8(reg, tx != (void *)0 ? tx[i] : LIB_SPI_DUMMY);
+        while (LL_SPI_IsActiveFlag_RXNE(reg) != SET);
+        data = LL_SPI_ReceiveData8(reg);
+        if (rx != (void *)0)
+        {
+            rx[i - 1] = data;
+        }
+    }
+    while (LL_SPI_IsActiveFlag_RXNE(reg) != SET);
+    data = LL_SPI_ReceiveData8(reg);
+    if (rx != (void *)0)
+    {
+        rx[num - 1] = data;
+    }
+    ++spi->state->stat.transfers;
+    spi->state->stat.bytes += num;
+    if (LL_SPI_IsActiveFlag_OVR(reg) == SET)
+    {
+        // 读 DR 再读 SR 清除 OVR
+        LL_SPI_ClearFlag_OVR(reg);
+        ++spi->state->stat.overrun;
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   16 位帧的轮询块传输, 参数见 Lib_SPI_Burst(), num 必须是偶数
+ * @note    1) 每次读写 DR 传输 2 个字节, 循环次数减半, f_SCK 高时比 Lib_SPI_Burst() 更不容易跟不上,
+ *             读出期限也变为 32 个 CPU 周期; 适合 DMA 通道被占用时的大块传输
+ *          2) 总线上的字节顺序与 8 位帧相同: MSB 先发送时, tx[0] 放在帧的高字节
+ *          3) 切换帧宽度需要先关闭 SPI, 结束后恢复 8 位帧
+*/
+ErrorStatus Lib_SPI_Burst16(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num)
+{
+    SPI_TypeDef *const reg = spi->spi;
+    const uint16_t dummy = (LIB_SPI_DUMMY << 8) | LIB_SPI_DUMMY;
+    uint8_t hi = LL_SPI_GetTransferBitOrder(reg) == LL_SPI_MSB_FIRST ? 0 : 1;  // 帧的高字节在缓冲区中的位置
+    uint16_t data = 0;
+    ErrorStatus res = SUCCESS;
+
+    if (num == 0 || num % 2 != 0)
+    {
+        return num == 0 ? SUCCESS : ERROR;
+    }
+    // 等待上一个字节发送完成再关闭 SPI
+    while (LL_SPI_IsActiveFlag_BSY(reg) == SET);
+    LL_SPI_Disable(reg);
+    LL_SPI_SetDataWidth(reg, LL_SPI_DATAWIDTH_16BIT);
+    LL_SPI_Enable(reg);
+
+    #define Lib_SPI_Burst16_TX(i)   (tx != (void *)0 ? (uint16_t)((tx[(i) + hi] << 8) | tx[(i) + 1 - hi]) : dummy)
+    LL_SPI_TransmitData16(reg, Lib_SPI_Burst16_TX(0));
+    for (uint32_t i = 2; i < num; i += 2)
+    {
+        while (LL_SPI_IsActiveFlag_TXE(reg) != SET);
+        LL_SPI_TransmitData16(reg, Lib_SPI_Burst16_TX(i));
+        while (LL_SPI_IsActiveFlag_RXNE(reg) != SET);
+        data = LL_SPI_ReceiveData16(reg);
+        if (rx != (void *)0)
+        {
+            rx[i - 2 + hi] = data >> 8;
+            rx[i - 1 - hi] = data & 0xFF;
+        }
+    }
+    #undef Lib_SPI_Burst16_TX
+    while (LL_SPI_IsActiveFlag_RXNE(reg) != SET);
+    data = LL_SPI_ReceiveData16(reg);
+    if (rx != (void *)0)
+    {
+        rx[num - 2 + hi] = data >> 8;
+        rx[num - 1 - hi] = data & 0xFF;
+    }
+    ++spi->state->stat.transfers;
+    spi->state->stat.bytes += num;
+    if (LL_SPI_IsActiveFlag_OVR(reg) == SET)
+    {
+        LL_SPI_ClearFlag_OVR(reg);
+        ++spi->state->stat.overrun;
+        res = ERROR;
+    }
+
+    while (LL_SPI_IsActiveFlag_BSY(reg) == SET);
+    LL_SPI_Disable(reg);
+    LL_SPI_SetDataWidth(reg, LL_SPI_DATAWIDTH_8BIT);
+    LL_SPI_Enable(reg);
+    return res;
 }
 
-// 使用前需要 LIB_SPI_START()
-uint8_t Lib_SPI_Receive_Byte(void)
+/*
+ * @brief   等待块传输完成
+*/
+void Lib_SPI_Wait(const Lib_SPI_Type *const spi)
 {
-    // SPI 全双工工作, 发送的同时也在接收
-    // 接收数据, 可以发送一个任意数据
-    return Lib_SPI_Send_Byte(LIB_SPI_DUMMY);
-}
\ No newline at end of file
+    while (spi->state->busy);
+}
+
+/*
+ * @brief   块传输, 返回时已完成, 参数见 Lib_SPI_Transfer_Start()
+ * @note    使用 DMA 时 CPU 在等待, 但字节之间没有间隔; 不能在屏蔽中断时调用
+*/
+void Lib_SPI_Transfer(const Lib_SPI_Type *const spi, const uint8_t *const tx, uint8_t *const rx, const uint32_t num)
+{
+    Lib_SPI_Wait(spi);
+    Lib_SPI_Transfer_Start(spi, tx, rx, num, (void *)0, (void *)0);
+    Lib_SPI_Wait(spi);
+}
+
+/*
+ * @brief   初始化设备的片选, 输出高电平; 总线由 Lib_SPI_Init() 初始化
+*/
+void Lib_SPI_Device_Init(const Lib_SPI_Device_Type *const dev)
+{
+    LL_GPIO_InitTypeDef gpio_config = {0};
+
+    LL_APB2_GRP1_EnableClock(dev->apb2_periph);
+    LL_GPIO_SetOutputPin(dev->cs_port, dev->cs_pin);
+    gpio_config.Pin = dev->cs_pin;
+    gpio_config.Mode = LL_GPIO_MODE_OUTPUT;
+    gpio_config.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_config.Speed = LL_GPIO_SPEED_FREQ_HIGH;
+    LL_GPIO_Init(dev->cs_port, &gpio_config);
+}
+
+/*
+ * @brief   开始与设备通信: 占用总线, 按需修改通信参数, 拉低片选
+ * @return  SUCCESS; ERROR: 总线已被占用 (例如主循环正在通信时在中断中调用), 不做任何修改
+ * @note    1) 不会阻塞, 主循环中可以循环调用直到成功; 中断中失败时应推迟到下一次
+ *          2) 通信参数与总线当前参数相同时不访问 CR1
+*/
+ErrorStatus Lib_SPI_Begin(const Lib_SPI_Device_Type *const dev)
+{
+    const Lib_SPI_Type *const spi = dev->spi;
+    Lib_SPI_State_Type *const state = spi->state;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t mode = dev->cpol | dev->cpha | dev->bit_order | dev->baud_rate;
+
+    __disable_irq();
+    if (state->locked)
+    {
+        ++state->stat.locked;
+        __set_PRIMASK(primask);
+        return ERROR;
+    }
+    state->locked = 1;
+    __set_PRIMASK(primask);
+
+    // 批处理中保持的片选: 同一设备则继续使用, 否则先结束上一个设备的通信
+    if (state->cs_port == dev->cs_port && state->cs_pin == dev->cs_pin)
+    {
+        state->cs_port = (void *)0;
+        return SUCCESS;
+    }
+    Lib_SPI_Flush(spi);
+    // 修改 CPOL, CPHA, BR 和 LSBFIRST 前需要关闭 SPI
+    if (state->mode != mode)
+    {
+        while (LL_SPI_IsActiveFlag_BSY(spi->spi) == SET);
+        LL_SPI_Disable(spi->spi);
+        MODIFY_REG(spi->spi->CR1, SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_LSBFIRST | SPI_CR1_BR, mode);
+        LL_SPI_Enable(spi->spi);
+        state->mode = mode;
+    }
+    LL_GPIO_ResetOutputPin(dev->cs_port, dev->cs_pin);
+    return SUCCESS;
+}
+
+/*
+ * @brief   结束与设备的通信, 释放总线
+ * @note    1) 先等待未完成的块传输; 设备的 batch 为 1 时片选保持为低, 由下一次 Lib_SPI_Begin() 或 Lib_SPI_Flush() 拉高
+ *          2) 必须与成功的 Lib_SPI_Begin() 成对调用
+*/
+void Lib_SPI_End(const Lib_SPI_Device_Type *const dev)
+{
+    Lib_SPI_State_Type *const state = dev->spi->state;
+
+    Lib_SPI_Wait(dev->spi);
+    if (dev->batch)
+    {
+        state->cs_port = dev->cs_port;
+        state->cs_pin = dev->cs_pin;
+    }
+    else
+    {
+        LL_GPIO_SetOutputPin(dev->cs_port, dev->cs_pin);
+    }
+    state->locked = 0;
+}
+
+/*
+ * @brief   拉高批处理中保持的片选, 例如设备需要片选上升沿, 或进入低功耗前
+ * @note    不能在其他上下文占用总线时调用
+*/
+void Lib_SPI_Flush(const Lib_SPI_Type *const spi)
+{
+    Lib_SPI_State_Type *const state = spi->state;
+
+    if (state->cs_port != (void *)0)
+    {
+        while (LL_SPI_IsActiveFlag_BSY(spi->spi) == SET);
+        LL_GPIO_SetOutputPin(state->cs_port, state->cs_pin);
+        state->cs_port = (void *)0;
+    }
+}
+
+/*
+ * @brief   读取实例的统计, 见 Lib_SPI_Stat_Type
+*/
+void Lib_SPI_Get_Stat(const Lib_SPI_Type *const spi, Lib_SPI_Stat_Type *const stat)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    // DMA 中断可能在拷贝中途修改
+    __disable_irq();
+    *stat = spi->state->stat;
+    __set_PRIMASK(primask);
+}
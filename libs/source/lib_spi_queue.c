@@ -0,0 +1,246 @@
+#include "lib_spi_queue.h"
+
+// 队首描述符的阶段
+#define LIB_SPI_QUEUE_PHASE_IDLE         0         // 还没有开始, 可能在等待总线
+#define LIB_SPI_QUEUE_PHASE_HEADER       1         // 正在传输指令, 地址和空周期
+#define LIB_SPI_QUEUE_PHASE_DATA         2         // 正在传输数据
+#define LIB_SPI_QUEUE_PHASE_WAIT         0xFF      // 等待传输完成, 只在 Lib_SPI_Queue_Step() 中使用
+
+static void Lib_SPI_Queue_Step(Lib_SPI_Queue_Type *const queue);
+
+// 一次传输完成, 由 Lib_SPI_Transfer_Start() 调用; 失败时记录, 队首描述符以 LIB_SPI_QUEUE_RES_ERROR 结束
+static void Lib_SPI_Queue_Done(void *const arg, const ErrorStatus status)
+{
+    if (status != SUCCESS)
+    {
+        ((Lib_SPI_Queue_Type *)arg)->error = 1;
+    }
+    ((Lib_SPI_Queue_Type *)arg)->busy = 0;
+    Lib_SPI_Queue_Step((Lib_SPI_Queue_Type *)arg);
+}
+
+// 是否为同一设备; 设备描述是头文件中的 static const 表, 不同文件中的地址不同, 按片选比较
+static uint8_t Lib_SPI_Queue_Same_Device(const Lib_SPI_Device_Type *const a, const Lib_SPI_Device_Type *const b)
+{
+    return a->cs_port == b->cs_port && a->cs_pin == b->cs_pin;
+}
+
+/*
+ * @brief   推进队列: 开始队首描述符, 进入下一阶段, 或结束队首描述符并开始下一个
+ * @note    1) 在提交, 轮询和传输完成回调中调用; 已经在执行时 (例如不使用 DMA 时回调在传输函数中直接调用,
+ *             或者 DMA 中断打断了主循环中的执行) 只做标记, 由正在执行的一方继续
+ *          2) 等待 DMA 时返回, 由传输完成回调再次调用; 此时提交和轮询不推进队首描述符
+*/
+static void Lib_SPI_Queue_Step(Lib_SPI_Queue_Type *const queue)
+{
+    Lib_SPI_Queue_Trans_Type *trans = (void *)0;
+    uint32_t primask = 0;
+    uint8_t num = 0;
+
+    Lib_SPI_Queue_Lock(primask);
+    if (queue->running)
+    {
+        queue->again = 1;
+        Lib_SPI_Queue_Unlock(primask);
+        return;
+    }
+    queue->running = 1;
+    queue->again = 0;
+    Lib_SPI_Queue_Unlock(primask);
+
+    while (1)
+    {
+        trans = queue->head;
+        switch (queue->busy ? LIB_SPI_QUEUE_PHASE_WAIT : queue->phase)
+        {
+        case LIB_SPI_QUEUE_PHASE_IDLE:
+            if (trans == (void *)0)
+            {
+                break;
+            }
+            // 上一个描述符保持的片选属于其他设备, 先结束
+            if (queue->held != (void *)0 && !Lib_SPI_Queue_Same_Device(queue->held, trans->dev))
+            {
+                Lib_SPI_Queue_End(queue->held);
+                queue->held = (void *)0;
+            }
+            if (queue->held == (void *)0 && Lib_SPI_Queue_Begin(trans->dev) != SUCCESS)
+            {
+                break;  // 总线被占用, 等待 Lib_SPI_Queue_Poll()
+            }
+            queue->held = (void *)0;
+
+            num = 0;
+            if (trans->flags & LIB_SPI_QUEUE_CMD)
+            {
+                queue->header[num++] = trans->cmd;
+            }
+            for (uint8_t i = trans->addr_len; i > 0; --i)
+            {
+                queue->header[num++] = (uint8_t)(trans->addr >> ((i - 1) * 8));
+            }
+            for (uint8_t i = 0; i < trans->dummy_len; ++i)
+            {
+                queue->header[num++] = LIB_SPI_DUMMY;
+            }
+            queue->phase = LIB_SPI_QUEUE_PHASE_HEADER;
+            if (num > 0)
+            {
+                queue->busy = 1;
+                Lib_SPI_Queue_Transfer(trans->dev, queue->header, (void *)0, num, Lib_SPI_Queue_Done, queue);
+                break;
+            }
+            // fall through
+        case LIB_SPI_QUEUE_PHASE_HEADER:
+            queue->phase = LIB_SPI_QUEUE_PHASE_DATA;
+            if (trans->num > 0 && !queue->error)
+            {
+                queue->busy = 1;
+                Lib_SPI_Queue_Transfer(trans->dev, trans->tx, trans->rx, trans->num, Lib_SPI_Queue_Done, queue);
+                break;
+            }
+            // fall through
+        case LIB_SPI_QUEUE_PHASE_DATA:
+            Lib_SPI_Queue_Lock(primask);
+            queue->head = trans->next;
+            if (queue->head == (void *)0)
+            {
+                queue->tail = (void *)0;
+            }
+            Lib_SPI_Queue_Unlock(primask);
+            queue->phase = LIB_SPI_QUEUE_PHASE_IDLE;
+            // 失败时不保持片选, 设备的指令以片选上升沿结束
+            if ((trans->flags & LIB_SPI_QUEUE_CS_HOLD) && !queue->error)
+            {
+                queue->held = trans->dev;
+            }
+            else
+            {
+                Lib_SPI_Queue_End(trans->dev);
+            }
+            trans->result = queue->error ? LIB_SPI_QUEUE_RES_ERROR : LIB_SPI_QUEUE_RES_OK;
+            queue->error = 0;
+            if (trans->callback != (void *)0)
+            {
+                trans->callback(trans);
+            }
+            queue->again = 1;   // 开始下一个
+            break;
+        default:
+            break;
+        }
+
+        // 没有需要继续的事情时退出; 检查和清除标志不能被传输完成中断打断
+        Lib_SPI_Queue_Lock(primask);
+        if (queue->again == 0)
+        {
+            queue->running = 0;
+            Lib_SPI_Queue_Unlock(primask);
+            return;
+        }
+        queue->again = 0;
+        Lib_SPI_Queue_Unlock(primask);
+    }
+}
+
+/*
+ * @brief   初始化队列
+*/
+void Lib_SPI_Queue_Init(Lib_SPI_Queue_Type *const queue)
+{
+    queue->head = (void *)0;
+    queue->tail = (void *)0;
+    queue->held = (void *)0;
+    queue->phase = LIB_SPI_QUEUE_PHASE_IDLE;
+    queue->busy = 0;
+    queue->error = 0;
+    queue->running = 0;
+    queue->again = 0;
+}
+
+/*
+ * @brief   提交描述符到队尾, 总线空闲时立即开始
+ * @note    可以在主循环, 中断和完成回调中调用; 描述符不能已经在队列中
+*/
+void Lib_SPI_Queue_Submit(Lib_SPI_Queue_Type *const queue, Lib_SPI_Queue_Trans_Type *const trans)
+{
+    uint32_t primask = 0;
+
+    trans->next = (void *)0;
+    trans->result = LIB_SPI_QUEUE_RES_PENDING;
+    Lib_SPI_Queue_Lock(primask);
+    if (queue->tail == (void *)0)
+    {
+        queue->head = trans;
+    }
+    else
+    {
+        queue->tail->next = trans;
+    }
+    queue->tail = trans;
+    Lib_SPI_Queue_Unlock(primask);
+    Lib_SPI_Queue_Step(queue);
+}
+
+/*
+ * @brief   取消还没有开始的描述符, 以 LIB_SPI_QUEUE_RES_CANCELLED 调用其回调
+ * @return  SUCCESS; ERROR: 描述符正在传输, 或者不在队列中 (已完成)
+ * @note    取消 LIB_SPI_QUEUE_CS_HOLD 描述符的后续描述符时, 片选保持到下一个其他设备的描述符开始
+*/
+ErrorStatus Lib_SPI_Queue_Cancel(Lib_SPI_Queue_Type *const queue, Lib_SPI_Queue_Trans_Type *const trans)
+{
+    Lib_SPI_Queue_Trans_Type *prev = (void *)0, *p = (void *)0;
+    uint32_t primask = 0;
+
+    Lib_SPI_Queue_Lock(primask);
+    if (trans == queue->head && queue->phase != LIB_SPI_QUEUE_PHASE_IDLE)
+    {
+        Lib_SPI_Queue_Unlock(primask);
+        return ERROR;
+    }
+    for (p = queue->head; p != (void *)0 && p != trans; p = p->next)
+    {
+        prev = p;
+    }
+    if (p == (void *)0)
+    {
+        Lib_SPI_Queue_Unlock(primask);
+        return ERROR;
+    }
+    if (prev == (void *)0)
+    {
+        queue->head = trans->next;
+    }
+    else
+    {
+        prev->next = trans->next;
+    }
+    if (queue->tail == trans)
+    {
+        queue->tail = prev;
+    }
+    Lib_SPI_Queue_Unlock(primask);
+
+    trans->result = LIB_SPI_QUEUE_RES_CANCELLED;
+    if (trans->callback != (void *)0)
+    {
+        trans->callback(trans);
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   总线被占用而暂停时重试, 在主循环或定时中断中调用
+*/
+void Lib_SPI_Queue_Poll(Lib_SPI_Queue_Type *const queue)
+{
+    Lib_SPI_Queue_Step(queue);
+}
+
+/*
+ * @brief   队列是否为空 (所有描述符都已完成或取消)
+*/
+uint8_t Lib_SPI_Queue_Is_Idle(const Lib_SPI_Queue_Type *const queue)
+{
+    return queue->head == (void *)0;
+}
@@ -1,42 +1,116 @@
 #include "lib_usart.h"
 #include <stdarg.h>
+#include "lib_format.h"
+#ifndef LIB_USART_PORT
+#include "lib_tool.h"
+#endif
 
-void Lib_USART_Init(void)
+#if LIB_USART_DMA_EN
+  // 发送环形缓冲区, Head 和 Tail 是自由增长的计数, 取低位作为下标
+  // [Tail, Tail + DMA_Len) 正在由 DMA 发送, [Tail + DMA_Len, Head) 等待发送
+  static uint8_t Lib_USART_TX_Buffer[LIB_USART_TX_BUFFER_SIZE];
+  static volatile uint32_t Lib_USART_TX_Head;     // 写入位置, 只由发送函数修改
+  static volatile uint32_t Lib_USART_TX_Tail;     // DMA 读取位置, 只由 DMA 中断修改
+  static volatile uint32_t Lib_USART_TX_DMA_Len;  // 正在发送的字节数, 0 表示 DMA 空闲
+  static volatile uint32_t Lib_USART_TX_Dropped;  // 因缓冲区满而丢弃的字节数
+
+  static void Lib_USART_TX_Kick(void);
+#endif
+
+// 实例的状态, 控制台的 tx_dropped 在 Lib_USART_TX_Dropped 中
+Lib_USART_State_Type Lib_USART1_State;
+#if LIB_USART2_EN
+  Lib_USART_State_Type Lib_USART2_State;
+  uint8_t Lib_USART2_RX_Buffer[LIB_USART2_RX_BUFFER_SIZE];
+#endif
+#if LIB_USART3_EN
+  Lib_USART_State_Type Lib_USART3_State;
+  uint8_t Lib_USART3_RX_Buffer[LIB_USART3_RX_BUFFER_SIZE];
+#endif
+#if LIB_USART_FLOW_EN
+  static volatile uint8_t Lib_USART_RX_Paused;          // RTS 是否已拉高
+#endif
+
+#if LIB_USART_DMA_RX_EN
+  static Lib_USART_RX_Callback_Type Lib_USART_RX_Callback;  // 接收回调函数
+  static uint32_t Lib_USART_RX_Pos;                         // 已处理的数据在缓冲区中的结束下标
+  static volatile uint32_t Lib_USART_RX_Head;               // DMA 写入的字节计数, 只由接收中断修改
+  static volatile uint32_t Lib_USART_RX_Tail;               // 读取计数, 由 Lib_USART_Receive() 修改; 有回调时跟随 Head
+
+  static void Lib_USART_RX_Process(void);
+#endif
+
+/*
+ * @brief   开启时钟, 配置 TX/RX 引脚和数据帧格式, 不使能 USART
+ * @param   usart       实例
+ *          hw_control  硬件流控 (LL_USART_HWCONTROL_*)
+*/
+static void Lib_USART_Config(const Lib_USART_Type *const usart, const uint32_t hw_control)
 {
   LL_GPIO_InitTypeDef gpio_config = {0};
   LL_USART_InitTypeDef usart_config = {0};
-  #if LIB_USART_DMA_EN
-    LL_DMA_InitTypeDef dma_config = {0};
-  #endif
 
   // 开启外设的时钟
-  LIB_USART_ENCLK();
-  LIB_USART_PORT_ENCLK();
+  if (usart->apb1_periph != 0)
+  {
+    LL_APB1_GRP1_EnableClock(usart->apb1_periph);
+  }
+  LL_APB2_GRP1_EnableClock(usart->apb2_periph);
 
   // TX为复用推挽输出
-  gpio_config.Pin = LIB_USART_TX_PIN;
+  gpio_config.Pin = usart->tx_pin;
   gpio_config.Mode = LL_GPIO_MODE_ALTERNATE;
   gpio_config.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
   gpio_config.Speed = LL_GPIO_SPEED_FREQ_HIGH;
-  LL_GPIO_Init(LIB_USART_TX_PORT, &gpio_config);
+  LL_GPIO_Init(usart->port, &gpio_config);
   // RX为浮空输入
-  gpio_config.Pin = LIB_USART_RX_PIN;
+  gpio_config.Pin = usart->rx_pin;
   gpio_config.Mode = LL_GPIO_MODE_FLOATING;
   gpio_config.Speed = LL_GPIO_SPEED_FREQ_HIGH;
-  LL_GPIO_Init(LIB_USART_RX_PORT, &gpio_config);
+  LL_GPIO_Init(usart->port, &gpio_config);
 
   // 数据帧格式：1位起始位+8位数据+无校验+1位停止位
   usart_config.DataWidth = LL_USART_DATAWIDTH_8B;
   usart_config.Parity = LL_USART_PARITY_NONE;
   usart_config.StopBits = LL_USART_STOPBITS_1;
-  // 波特率由宏USART_BAUD_RATE定义
-  usart_config.BaudRate = LIB_USART_BAUD_RATE;
+  // 上电后的波特率由实例的 baud 定义
+  usart_config.BaudRate = usart->baud;
   // 工作模式为全双工
   usart_config.TransferDirection = LL_USART_DIRECTION_TX_RX;
-  // 不使用硬件控制流，即RTS/CTS
-  usart_config.HardwareFlowControl = LL_USART_HWCONTROL_NONE;
+  usart_config.HardwareFlowControl = hw_control;
   // 初始化USART
-  LL_USART_Init(LIB_USART, &usart_config);
+  LL_USART_Init(usart->usart, &usart_config);
+  usart->state->baud = usart->baud;
+}
+
+/*
+ * @brief   初始化控制台 (USART1), 以及 LIB_USART_IT_EN, LIB_USART_DMA_EN 等配置的功能
+*/
+void Lib_USART_Init(void)
+{
+  #if LIB_USART_FLOW_EN
+    LL_GPIO_InitTypeDef gpio_config = {0};
+  #endif
+  #if LIB_USART_DMA_EN || LIB_USART_DMA_RX_EN
+    LL_DMA_InitTypeDef dma_config = {0};
+  #endif
+
+  #if LIB_USART_FLOW_EN
+    // 硬件控制流只用 CTS, RTS 由软件控制
+    Lib_USART_Config(LIB_USART_CONSOLE, LL_USART_HWCONTROL_CTS);
+    // CTS为浮空输入; RTS为推挽输出, 初始为低, 允许上位机发送
+    gpio_config.Pin = LIB_USART_CTS_PIN;
+    gpio_config.Mode = LL_GPIO_MODE_FLOATING;
+    gpio_config.Speed = LL_GPIO_SPEED_FREQ_HIGH;
+    LL_GPIO_Init(LIB_USART_CTS_PORT, &gpio_config);
+    LL_GPIO_ResetOutputPin(LIB_USART_RTS_PORT, LIB_USART_RTS_PIN);
+    gpio_config.Pin = LIB_USART_RTS_PIN;
+    gpio_config.Mode = LL_GPIO_MODE_OUTPUT;
+    gpio_config.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    LL_GPIO_Init(LIB_USART_RTS_PORT, &gpio_config);
+  #else
+    Lib_USART_Config(LIB_USART_CONSOLE, LL_USART_HWCONTROL_NONE);
+  #endif
 
   // 配置中断
   #if LIB_USART_IT_EN
@@ -58,24 +132,305 @@ void Lib_USART_Init(void)
     dma_config.Direction = LIB_USART_DMA_DIRECTION;
     dma_config.Mode = LIB_USART_DMA_MODE;
     dma_config.PeriphOrM2MSrcAddress = LIB_USART_DMA_PADDR;
-    dma_config.MemoryOrM2MDstAddress = LIB_USART_DMA_MADDR;
+    dma_config.MemoryOrM2MDstAddress = Lib_USART_DMA_Addr(Lib_USART_TX_Buffer); // 每次启动传输时重新设置
     dma_config.PeriphOrM2MSrcIncMode = LIB_USART_DMA_PINC;
     dma_config.MemoryOrM2MDstIncMode = LIB_USART_DMA_MINC;
     dma_config.PeriphOrM2MSrcDataSize = LIB_USART_DMA_PDSIZE;
     dma_config.MemoryOrM2MDstDataSize = LIB_USART_DMA_MDSIZE;
-    dma_config.NbData = LIB_USART_DMA_NDATA;
+    dma_config.NbData = 0;
     LL_DMA_Init(LIB_USART_DMA, LIB_USART_DMA_CH, &dma_config);
+    // 传输完成中断, 用于续传缓冲区中剩余的数据
+    LL_DMA_EnableIT_TC(LIB_USART_DMA, LIB_USART_DMA_CH);
+    NVIC_SetPriority(LIB_USART_DMA_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                    LIB_USART_DMA_PREEMPT_PRIORITY, LIB_USART_DMA_SUB_PRIORITY));
+    NVIC_EnableIRQ(LIB_USART_DMA_IRQ);
     // 允许USART_TX发起DMA请求
     LL_USART_EnableDMAReq_TX(LIB_USART);
   #endif
 
+  // 配置DMA接收
+  #if LIB_USART_DMA_RX_EN
+    LIB_USART_DMA_RX_ENCLK();
+
+    // 外设到内存, 循环模式, 缓冲区写满后自动回到开头
+    dma_config.Priority = LIB_USART_DMA_RX_PRIORITY;
+    dma_config.Direction = LL_DMA_DIRECTION_PERIPH_TO_MEMORY;
+    dma_config.Mode = LL_DMA_MODE_CIRCULAR;
+    dma_config.PeriphOrM2MSrcAddress = Lib_USART_DMA_Addr(&LIB_USART->DR);
+    dma_config.MemoryOrM2MDstAddress = Lib_USART_DMA_Addr(Lib_USART_Buffer);
+    dma_config.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+    dma_config.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+    dma_config.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_BYTE;
+    dma_config.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_BYTE;
+    dma_config.NbData = LIB_USART_BUFFER_MAXSIZE;
+    LL_DMA_Init(LIB_USART_DMA_RX, LIB_USART_DMA_RX_CH, &dma_config);
+    // 半传输和传输完成中断, 保证连续输入时数据在被覆盖前交出
+    LL_DMA_EnableIT_HT(LIB_USART_DMA_RX, LIB_USART_DMA_RX_CH);
+    LL_DMA_EnableIT_TC(LIB_USART_DMA_RX, LIB_USART_DMA_RX_CH);
+    NVIC_SetPriority(LIB_USART_DMA_RX_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                    LIB_USART_DMA_RX_PREEMPT_PRIORITY, LIB_USART_DMA_RX_SUB_PRIORITY));
+    NVIC_EnableIRQ(LIB_USART_DMA_RX_IRQ);
+    LL_DMA_EnableChannel(LIB_USART_DMA_RX, LIB_USART_DMA_RX_CH);
+    // 允许USART_RX发起DMA请求; IDLE 中断用于分帧; 错误中断用于统计 ORE/FE/NE
+    LL_USART_EnableDMAReq_RX(LIB_USART);
+    LL_USART_EnableIT_IDLE(LIB_USART);
+    LL_USART_EnableIT_ERROR(LIB_USART);
+    #if LIB_USART_CMD_EN
+      Lib_USART_RX_Set_Callback(Lib_USART_CMD_Receive);
+    #endif
+  #endif
+
   // 使能USART
   LL_USART_Enable(LIB_USART);
 }
 
+#if LIB_USART_DMA_EN
+/*
+ * @brief   DMA 空闲时, 启动下一段连续数据的发送
+ * @note    必须在屏蔽中断或 DMA 中断中调用; 缓冲区回绕时分两次发送
+*/
+static void Lib_USART_TX_Kick(void)
+{
+  uint32_t pending = Lib_USART_TX_Head - Lib_USART_TX_Tail;
+  uint32_t idx = Lib_USART_TX_Tail & LIB_USART_TX_BUFFER_MASK;
+  uint32_t len = 0;
+
+  if (Lib_USART_TX_DMA_Len != 0 || pending == 0)
+  {
+    return;
+  }
+  // 只发送到缓冲区末尾, 剩余部分在传输完成中断中续传
+  len = LIB_USART_TX_BUFFER_SIZE - idx;
+  if (len > pending)
+  {
+    len = pending;
+  }
+  Lib_USART_TX_DMA_Len = len;
+  LIB_USART_DMA_CH_DIS();
+  LL_DMA_SetMemoryAddress(LIB_USART_DMA, LIB_USART_DMA_CH, Lib_USART_DMA_Addr(&Lib_USART_TX_Buffer[idx]));
+  LL_DMA_SetDataLength(LIB_USART_DMA, LIB_USART_DMA_CH, len);
+  LIB_USART_DMA_CH_EN();
+}
+
+/*
+ * @brief   DMA 传输完成中断, 释放已发送的数据, 并续传剩余数据
+*/
+void Lib_USART_DMA_TX_Handler(void)
+{
+  if (LIB_USART_DMA_IsActiveFlag_TC() == SET)
+  {
+    LIB_USART_DMA_ClearFlag_TC();
+    Lib_USART_TX_Tail += Lib_USART_TX_DMA_Len;
+    Lib_USART_TX_DMA_Len = 0;
+    Lib_USART_TX_Kick();
+  }
+}
+
+/*
+ * @brief   返回因缓冲区满而丢弃的字节数 (LIB_USART_TX_POLICY 为 DROP 或 OVERWRITE 时)
+*/
+uint32_t Lib_USART_TX_Get_Dropped(void)
+{
+  return Lib_USART_TX_Dropped;
+}
+#endif
+
+/*
+ * @brief   发送 num 个字节
+ * @param   data 数据
+ *          num  数据的字节数
+ * @note    LIB_USART_DMA_EN 为 1 时, 数据写入发送缓冲区后立即返回, 缓冲区满时按 LIB_USART_TX_POLICY 处理;
+ *          否则轮询发送, 返回时数据已发送完成
+*/
+void Lib_USART_Send_Data(const uint8_t *const data, const uint32_t num)
+{
+#if LIB_USART_DMA_EN
+  uint32_t p = 0, n = 0, space = 0, idx = 0, primask = 0, start = 0;
+
+  while (p < num)
+  {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    space = LIB_USART_TX_BUFFER_SIZE - (Lib_USART_TX_Head - Lib_USART_TX_Tail);
+    #if LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_OVERWRITE
+      if (space < num - p)
+      {
+        // 丢弃等待发送的旧数据, DMA 正在发送的部分不能动
+        Lib_USART_TX_Dropped += Lib_USART_TX_Head - Lib_USART_TX_Tail - Lib_USART_TX_DMA_Len;
+        Lib_USART_TX_Head = Lib_USART_TX_Tail + Lib_USART_TX_DMA_Len;
+        space = LIB_USART_TX_BUFFER_SIZE - Lib_USART_TX_DMA_Len;
+        // 仍然放不下时, 只保留最新的数据
+        if (space < num - p)
+        {
+          Lib_USART_TX_Dropped += num - p - space;
+          p = num - space;
+        }
+      }
+    #endif
+    n = num - p;
+    if (n > space)
+    {
+      n = space;
+    }
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      idx = (Lib_USART_TX_Head + i) & LIB_USART_TX_BUFFER_MASK;
+      Lib_USART_TX_Buffer[idx] = data[p + i];
+    }
+    Lib_USART_TX_Head += n;
+    p += n;
+    Lib_USART_TX_Kick();
+    __set_PRIMASK(primask);
+
+    #if LIB_USART_TX_POLICY == LIB_USART_TX_POLICY_DROP
+      if (p < num)
+      {
+        Lib_USART_TX_Dropped += num - p;
+        return;
+      }
+    #endif
+    // LIB_USART_TX_POLICY_BLOCK: 等待 DMA 中断腾出空间; 上位机拉高 CTS 时也会停在这里
+    if (p < num && Lib_USART_TX_Head - Lib_USART_TX_Tail == LIB_USART_TX_BUFFER_SIZE)
+    {
+      start = Lib_Tool_DWT_Timer_Start();
+      while (Lib_USART_TX_Head - Lib_USART_TX_Tail == LIB_USART_TX_BUFFER_SIZE);
+      Lib_USART1_State.stat.tx_stall_us += Lib_Tool_DWT_Timer_End(start, 1);
+    }
+  }
+#else
+  Lib_USART_Port_Send_Data(LIB_USART_CONSOLE, data, num);
+#endif
+}
+
+/*
+ * @brief   等待发送缓冲区中的数据全部发送完成
+ * @note    不能在屏蔽中断时调用
+*/
+void Lib_USART_Flush(void)
+{
+#if LIB_USART_DMA_EN
+  while (Lib_USART_TX_Head != Lib_USART_TX_Tail);
+#endif
+  // 最后一个字节离开移位寄存器
+  while (LL_USART_IsActiveFlag_TC(LIB_USART) != SET);
+}
+
+// 实例所在总线的频率: USART1 在 APB2 上, USART2/3 在 APB1 上; 按 RCC 当前的分频读取, 不假设 72 MHz
+static uint32_t Lib_USART_Get_PCLK(const Lib_USART_Type *const usart)
+{
+  LL_RCC_ClocksTypeDef clocks;
+
+  LL_RCC_GetSystemClocksFreq(&clocks);
+  return (usart->usart == USART1) ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+}
+
+// 检查实例是否支持该波特率: 不超过 PCLK / 16, 且分频后误差不超过 1/LIB_USART_BAUD_TOLERANCE
+static ErrorStatus Lib_USART_Baud_Check(const Lib_USART_Type *const usart, const uint32_t baud)
+{
+  uint32_t pclk = Lib_USART_Get_PCLK(usart), brr = 0, actual = 0;
+
+  // 16 倍过采样
+  if (baud == 0 || baud > pclk / 16)
+  {
+    return ERROR;
+  }
+  // BRR = PCLK / baud (12 位整数 + 4 位小数), 四舍五入后实际波特率为 PCLK / BRR
+  brr = (pclk + baud / 2) / baud;
+  actual = pclk / brr;
+  if ((actual > baud ? actual - baud : baud - actual) * LIB_USART_BAUD_TOLERANCE > baud)
+  {
+    return ERROR;
+  }
+  return SUCCESS;
+}
+
+/*
+ * @brief   修改控制台的波特率, 先等待已写入的数据发送完成
+ * @param   baud 新波特率
+ * @return  SUCCESS: 已切换; ERROR: 不支持该波特率, 波特率不变
+ * @note    不能在屏蔽中断时调用; 切换期间收到的字节可能出错, 由上层协议处理
+*/
+ErrorStatus Lib_USART_Set_Baud(const uint32_t baud)
+{
+  if (Lib_USART_Baud_Check(LIB_USART_CONSOLE, baud) != SUCCESS)
+  {
+    return ERROR;
+  }
+  // 否则缓冲区中剩余的数据会以新波特率发出
+  Lib_USART_Flush();
+  return Lib_USART_Port_Set_Baud(LIB_USART_CONSOLE, baud);
+}
+
+/*
+ * @brief   控制台当前的波特率
+*/
+uint32_t Lib_USART_Get_Baud(void)
+{
+  return Lib_USART_Port_Get_Baud(LIB_USART_CONSOLE);
+}
+
+/*
+ * @brief   读取控制台的链路统计, 见 Lib_USART_Stat_Type
+*/
+void Lib_USART_Get_Stat(Lib_USART_Stat_Type *const stat)
+{
+  Lib_USART_Port_Get_Stat(LIB_USART_CONSOLE, stat);
+#if LIB_USART_DMA_EN
+  stat->tx_dropped = Lib_USART_TX_Dropped;
+#endif
+}
+
+#if LIB_USART_FLOW_EN
+/*
+ * @brief   拉高 RTS, 请求上位机暂停发送
+ * @note    上位机 (USB 转串口芯片) 响应前可能还会发出几个字节, 应在缓冲区将满前调用
+*/
+void Lib_USART_RX_Pause(void)
+{
+  if (Lib_USART_RX_Paused == 0)
+  {
+    Lib_USART_RX_Paused = 1;
+    ++Lib_USART1_State.stat.rx_paused;
+    LL_GPIO_SetOutputPin(LIB_USART_RTS_PORT, LIB_USART_RTS_PIN);
+  }
+}
+
+/*
+ * @brief   拉低 RTS, 允许上位机继续发送
+*/
+void Lib_USART_RX_Resume(void)
+{
+  if (Lib_USART_RX_Paused)
+  {
+    Lib_USART_RX_Paused = 0;
+    LL_GPIO_ResetOutputPin(LIB_USART_RTS_PORT, LIB_USART_RTS_PIN);
+  }
+}
+#endif
+
+// 按 SR 统计接收错误; ORE/FE/NE 由之后读 DR 清除
+static void Lib_USART_Count_Errors(volatile Lib_USART_Stat_Type *const stat, const uint32_t sr)
+{
+  if (sr & USART_SR_ORE)
+  {
+    ++stat->overrun;
+  }
+  if (sr & USART_SR_FE)
+  {
+    ++stat->framing;
+  }
+  if (sr & USART_SR_NE)
+  {
+    ++stat->noise;
+  }
+}
+
 // 发送一个字节
 void Lib_USART_Send_Byte(const int8_t data)
 {
+#if LIB_USART_DMA_EN
+  Lib_USART_Send_Data((const uint8_t *)&data, 1);
+#else
   // 等待TXE被硬件置位，表示TDR空，可以写入数据
   while (LL_USART_IsActiveFlag_TXE(LIB_USART) != SET);
   // 向TDR写入数据
@@ -83,290 +438,604 @@ void Lib_USART_Send_Byte(const int8_t data)
   LL_USART_TransmitData8(LIB_USART, data);
   // 等待TC被硬件置位，表示发送完成
   while (LL_USART_IsActiveFlag_TC(LIB_USART) != SET);
+#endif
 }
 
 // 发送字符串
 void Lib_USART_Send_String(const char * str)
 {
-  uint8_t i = 0;
+  uint32_t num = 0;
+
+  while (str[num] != '\0')
+  {
+    ++num;
+  }
+  Lib_USART_Send_Data((const uint8_t *)str, num);
+}
+
+/*
+ * @brief   格式化输出的 sink, 把字符直接交给 Lib_USART_Send_Data()
+*/
+static void Lib_USART_Format_Sink(void *const arg, const char *const data, const uint32_t num)
+{
+  (void)arg;
+  Lib_USART_Send_Data((const uint8_t *)data, num);
+}
+
+/*
+ * @brief   发送格式化字符串, 格式见 lib_format.h
+ * @return  发送的字符数
+*/
+uint32_t Lib_USART_Send_fString(const char * str, ...)
+{
+  uint32_t num = 0;
+  va_list ap;           // 声明ap容纳不定参数
 
-  while (str[i] != '\0')
+  va_start(ap, str);    // 初始化ap
+  num = Lib_Format_vPrint(Lib_USART_Format_Sink, (void *)0, str, ap);
+  va_end(ap);           // 释放ap
+  return num;
+}
+
+/*
+ * @brief   初始化 USART 实例, 例如 Lib_USART_Port_Init(&Lib_USART2)
+ * @note    数据帧为 8 位数据, 无校验, 1 位停止位, 无流控; 实例的 rx_buffer 不为 0 时开启接收中断
+*/
+void Lib_USART_Port_Init(const Lib_USART_Type *const usart)
+{
+  Lib_USART_Config(usart, LL_USART_HWCONTROL_NONE);
+  usart->state->rx_head = 0;
+  usart->state->rx_tail = 0;
+  if (usart->rx_buffer != (void *)0)
+  {
+    NVIC_SetPriority(usart->irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                    usart->preempt_priority, usart->sub_priority));
+    NVIC_EnableIRQ(usart->irq);
+    // RXNE 中断同时报告 ORE; FE/NE 与 RXNE 一起置位, 在中断中读 SR 统计
+    LL_USART_EnableIT_RXNE(usart->usart);
+  }
+  LL_USART_Enable(usart->usart);
+}
+
+/*
+ * @brief   轮询发送 num 个字节, 返回时数据已发送完成
+*/
+void Lib_USART_Port_Send_Data(const Lib_USART_Type *const usart, const uint8_t *const data, const uint32_t num)
+{
+  for (uint32_t i = 0; i < num; ++i)
   {
     // 等待TDR空
-    while (LL_USART_IsActiveFlag_TXE(LIB_USART) != SET);
-    // 写入字符
-    LL_USART_TransmitData8(LIB_USART, str[i]);
-    ++i;
+    while (LL_USART_IsActiveFlag_TXE(usart->usart) != SET);
+    LL_USART_TransmitData8(usart->usart, data[i]);
   }
   // 等待传输完成
-  while (LL_USART_IsActiveFlag_TC(LIB_USART) != SET);
+  while (LL_USART_IsActiveFlag_TC(usart->usart) != SET);
 }
 
-// array为要倒转的序列, st为开始下标, ed为结束下标
-static void Lib_USART_Reverse_String(uint8_t * const array, const uint8_t st, const uint8_t ed)
+// 发送字符串
+void Lib_USART_Port_Send_String(const Lib_USART_Type *const usart, const char *str)
 {
-  uint8_t p1 = st, p2 = ed, tmp = 0;
+  uint32_t num = 0;
 
-  while (p1 < p2)
+  while (str[num] != '\0')
   {
-    tmp = array[p1];
-    array[p1] = array[p2];
-    array[p2] = tmp;
-    ++p1;
-    --p2;
+    ++num;
   }
+  Lib_USART_Port_Send_Data(usart, (const uint8_t *)str, num);
 }
 
-void Lib_USART_Int2Char_DEC(const int num, uint8_t * const buffer)
+// 格式化输出的 sink, arg 为实例
+static void Lib_USART_Port_Format_Sink(void *const arg, const char *const data, const uint32_t num)
 {
-  uint8_t p = 0, st = 0; // p遍历buffer; st记录反转的开始下标
-  int tmp = num;
+  Lib_USART_Port_Send_Data((const Lib_USART_Type *)arg, (const uint8_t *)data, num);
+}
+
+/*
+ * @brief   发送格式化字符串, 格式见 lib_format.h
+ * @return  发送的字符数
+*/
+uint32_t Lib_USART_Port_Send_fString(const Lib_USART_Type *const usart, const char *str, ...)
+{
+  uint32_t num = 0;
+  va_list ap;
+
+  va_start(ap, str);
+  num = Lib_Format_vPrint(Lib_USART_Port_Format_Sink, (void *)usart, str, ap);
+  va_end(ap);
+  return num;
+}
 
-  if (num < 0)
+/*
+ * @brief   从接收缓冲区读取最多 num 个字节
+ * @return  读取的字节数, 0 表示没有新数据
+*/
+uint32_t Lib_USART_Port_Receive(const Lib_USART_Type *const usart, uint8_t *const buffer, const uint32_t num)
+{
+  Lib_USART_State_Type *const state = usart->state;
+  uint32_t n = 0;
+
+  while (n < num && state->rx_tail != state->rx_head)
   {
-    tmp = -tmp;
-    st = 1;
-    buffer[p] = '-';
-    ++p;
+    buffer[n++] = usart->rx_buffer[state->rx_tail & (usart->rx_size - 1)];
+    ++state->rx_tail;
   }
-  else if (num == 0)
+  return n;
+}
+
+/*
+ * @brief   实例的中断处理: 统计接收错误, 把收到的字节写入接收缓冲区, 缓冲区满时丢弃
+ * @note    由 Lib_USART2_IT_Handler() 等中断服务函数调用
+*/
+void Lib_USART_Port_IT_Handler(const Lib_USART_Type *const usart)
+{
+  Lib_USART_State_Type *const state = usart->state;
+  uint32_t sr = LL_USART_ReadReg(usart->usart, SR);
+  uint8_t data = 0;
+
+  Lib_USART_Count_Errors(&state->stat, sr);
+  if (sr & USART_SR_RXNE)
   {
-    buffer[0] = '0';
-    buffer[1] = '\0';
-    return;
+    data = LL_USART_ReceiveData8(usart->usart);
+    if (state->rx_head - state->rx_tail == usart->rx_size)
+    {
+      ++state->stat.rx_dropped;
+      return;
+    }
+    usart->rx_buffer[state->rx_head & (usart->rx_size - 1)] = data;
+    ++state->rx_head;
   }
-  while (tmp > 0)
+}
+
+/*
+ * @brief   修改实例的波特率, 先等待最后一个字节发送完成
+ * @return  SUCCESS: 已切换; ERROR: 不支持该波特率, 波特率不变
+*/
+ErrorStatus Lib_USART_Port_Set_Baud(const Lib_USART_Type *const usart, const uint32_t baud)
+{
+  if (Lib_USART_Baud_Check(usart, baud) != SUCCESS)
   {
-    buffer[p] = tmp % 10 + '0';
-    ++p;
-    tmp /= 10;
+    return ERROR;
   }
-  Lib_USART_Reverse_String(buffer, st, p - 1);
-  buffer[p] = '\0';
+  while (LL_USART_IsActiveFlag_TC(usart->usart) != SET);
+  LL_USART_Disable(usart->usart);
+  LL_USART_SetBaudRate(usart->usart, Lib_USART_Get_PCLK(usart), baud);
+  LL_USART_Enable(usart->usart);
+  usart->state->baud = baud;
+  return SUCCESS;
+}
+
+// 实例当前的波特率
+uint32_t Lib_USART_Port_Get_Baud(const Lib_USART_Type *const usart)
+{
+  return usart->state->baud;
 }
 
-void Lib_USART_Int2Char_HEX(const int num, uint8_t * const buffer)
+// 读取实例的链路统计, 见 Lib_USART_Stat_Type
+void Lib_USART_Port_Get_Stat(const Lib_USART_Type *const usart, Lib_USART_Stat_Type *const stat)
 {
-  uint8_t p = 0, st = 0, v = 0; // p遍历buffer; st记录反转的开始下标; v为取余的结果
-  int tmp = num;
+  *stat = usart->state->stat;
+}
 
-  buffer[0] = '0';
-  buffer[1] = 'x';
-  p = 2;
-  if (num < 0)
+#if LIB_USART2_EN
+  void Lib_USART2_IT_Handler(void)
   {
-    tmp = -tmp;
-    buffer[p] = '-';
-    ++p;
+    Lib_USART_Port_IT_Handler(&Lib_USART2);
   }
-  else if (num == 0)
+#endif
+
+#if LIB_USART3_EN
+  void Lib_USART3_IT_Handler(void)
   {
-    buffer[2] = '0';
-    buffer[3] = '\0';
-    return;
+    Lib_USART_Port_IT_Handler(&Lib_USART3);
   }
-  st = p;
-  while (tmp > 0)
-  {
-    v = tmp % 16;
-    if (v < 10)
+#endif
+
+#if LIB_USART_IT_EN
+  uint8_t Lib_USART_Buffer[LIB_USART_BUFFER_MAXSIZE];
+  #if LIB_USART_DMA_RX_EN
+    /*
+     * @brief   设置接收回调函数, 为 0 时数据留在缓冲区中, 由 Lib_USART_Receive() 读取
+    */
+    void Lib_USART_RX_Set_Callback(const Lib_USART_RX_Callback_Type callback)
     {
-      buffer[p] = v + '0';
+      Lib_USART_RX_Callback = callback;
     }
-    else
+
+    /*
+     * @brief   把 [Lib_USART_RX_Pos, DMA 写入位置) 之间的新数据交给回调函数, 没有回调时只更新写入计数
+     * @note    1) 在 USART 和 DMA 中断中调用, 两个中断的优先级应相同, 避免互相抢占
+     *          2) 未读取的数据超过高水位时拉高 RTS (LIB_USART_FLOW_EN)
+    */
+    static void Lib_USART_RX_Process(void)
     {
-      buffer[p] = v - 10 + 'A';
+      // DMA 剩余传输数为 0 时表示刚好写满, 下一次从 0 开始
+      uint32_t pos = LIB_USART_BUFFER_MAXSIZE - LL_DMA_GetDataLength(LIB_USART_DMA_RX, LIB_USART_DMA_RX_CH);
+
+      if (pos == Lib_USART_RX_Pos)
+      {
+        return;
+      }
+      Lib_USART_RX_Head += (pos > Lib_USART_RX_Pos) ? pos - Lib_USART_RX_Pos
+                                                    : pos + LIB_USART_BUFFER_MAXSIZE - Lib_USART_RX_Pos;
+      if (Lib_USART_RX_Callback != (void *)0)
+      {
+        if (pos > Lib_USART_RX_Pos)
+        {
+          Lib_USART_RX_Callback(&Lib_USART_Buffer[Lib_USART_RX_Pos], pos - Lib_USART_RX_Pos);
+        }
+        else // DMA 已回绕
+        {
+          Lib_USART_RX_Callback(&Lib_USART_Buffer[Lib_USART_RX_Pos], LIB_USART_BUFFER_MAXSIZE - Lib_USART_RX_Pos);
+          if (pos > 0)
+          {
+            Lib_USART_RX_Callback(&Lib_USART_Buffer[0], pos);
+          }
+        }
+        Lib_USART_RX_Tail = Lib_USART_RX_Head;
+      }
+      #if LIB_USART_FLOW_EN
+        else if (Lib_USART_RX_Head - Lib_USART_RX_Tail >= LIB_USART_RX_HIGH_WATERMARK)
+        {
+          Lib_USART_RX_Pause();
+        }
+      #endif
+      Lib_USART_RX_Pos = (pos == LIB_USART_BUFFER_MAXSIZE) ? 0 : pos;
     }
-    ++p;
-    tmp /= 16;
-  }
-  Lib_USART_Reverse_String(buffer, st, p - 1);
-  buffer[p] = '\0';
-}
 
-// num_frac_bits指定小数位数，只是截断显示
-void Lib_USART_Double2Char(const double num, uint8_t * const buffer, const uint8_t num_frac_bits)
-{
-  uint8_t p = 0, st = 0;
-  int int_part = 0;            // 存num的整数部分
-  double frac_part = 0;        // 存num的小数部分
+    /*
+     * @brief   没有设置接收回调时, 从接收缓冲区读取最多 num 个字节
+     * @return  读取的字节数
+     * @note    1) 在主循环中调用; 先取走 DMA 已写入但还没等到 IDLE 或半传输中断的数据
+     *          2) 没有及时读取, 被 DMA 覆盖的字节计入 rx_dropped
+     *          3) 未读取的数据降到低水位以下时拉低 RTS (LIB_USART_FLOW_EN)
+    */
+    uint32_t Lib_USART_Receive(uint8_t *const buffer, const uint32_t num)
+    {
+      uint32_t primask = __get_PRIMASK(), head = 0, tail = 0, n = 0;
 
-  if (num < 0.0)
+      __disable_irq();
+      Lib_USART_RX_Process();
+      head = Lib_USART_RX_Head;
+      tail = Lib_USART_RX_Tail;
+      if (head - tail > LIB_USART_BUFFER_MAXSIZE)
+      {
+        Lib_USART1_State.stat.rx_dropped += head - tail - LIB_USART_BUFFER_MAXSIZE;
+        tail = head - LIB_USART_BUFFER_MAXSIZE;
+      }
+      __set_PRIMASK(primask);
+
+      while (n < num && tail != head)
+      {
+        buffer[n++] = Lib_USART_Buffer[tail & (LIB_USART_BUFFER_MAXSIZE - 1)];
+        ++tail;
+      }
+
+      __disable_irq();
+      Lib_USART_RX_Tail = tail;
+      #if LIB_USART_FLOW_EN
+        if (Lib_USART_RX_Head - tail <= LIB_USART_RX_LOW_WATERMARK)
+        {
+          Lib_USART_RX_Resume();
+        }
+      #endif
+      __set_PRIMASK(primask);
+      return n;
+    }
+
+    // USART 空闲中断: 线路空闲一个字节时间, 表示一帧结束
+    void Lib_USART_IT_Handler(void)
+    {
+      uint32_t sr = LL_USART_ReadReg(LIB_USART, SR);
+
+      Lib_USART_Count_Errors(&Lib_USART1_State.stat, sr);
+      if (sr & (USART_SR_IDLE | USART_SR_ORE | USART_SR_FE | USART_SR_NE))
+      {
+        // 读 SR 再读 DR 清除 IDLE 和错误标志; 出错的字节已由 DMA 读走或已丢失
+        (void)LL_USART_ReceiveData8(LIB_USART);
+      }
+      if (sr & USART_SR_IDLE)
+      {
+        Lib_USART_RX_Process();
+      }
+    }
+
+    // DMA 半传输/传输完成中断: 连续输入没有空闲时, 每半个缓冲区交出一次数据
+    void Lib_USART_DMA_RX_Handler(void)
+    {
+      if (LL_DMA_IsActiveFlag_HT5(LIB_USART_DMA_RX) == SET)
+      {
+        LL_DMA_ClearFlag_HT5(LIB_USART_DMA_RX);
+        Lib_USART_RX_Process();
+      }
+      if (LL_DMA_IsActiveFlag_TC5(LIB_USART_DMA_RX) == SET)
+      {
+        LL_DMA_ClearFlag_TC5(LIB_USART_DMA_RX);
+        Lib_USART_RX_Process();
+      }
+    }
+  #else
+    void Lib_USART_IT_Handler(void)
+    {
+      uint8_t tmp = 0;
+      uint32_t sr = LL_USART_ReadReg(LIB_USART, SR);
+
+      Lib_USART_Count_Errors(&Lib_USART1_State.stat, sr);
+      if (sr & USART_SR_RXNE)
+      {
+        tmp = LL_USART_ReceiveData8(LIB_USART);
+        #if LIB_USART_CMD_EN
+          Lib_USART_CMD_Receive(&tmp, 1);
+        #else
+          Lib_USART_Send_fString("RX IT: 0x%X\n", tmp);
+        #endif
+      }
+    }
+  #endif
+#endif
+
+#if LIB_USART_CMD_EN
+  static Lib_Frame_Decoder_Type Lib_USART_CMD_Decoder;                       // 接收帧解码器
+  static Lib_Frame_Type Lib_USART_CMD_Queue[LIB_USART_CMD_QUEUE_SIZE];        // 待处理帧队列
+  static Lib_Frame_Type Lib_USART_CMD_Discard;                               // 队列满时的解码目标
+  static volatile uint32_t Lib_USART_CMD_Queue_Head;                         // 只由接收中断修改
+  static volatile uint32_t Lib_USART_CMD_Queue_Tail;                         // 只由 Lib_USART_CMD_Process() 修改
+  static uint8_t Lib_USART_CMD_Started;                                      // 是否已开启指令模式
+  static uint32_t Lib_USART_CMD_Baud_New;                                    // 待切换的波特率, 0 表示没有
+  static uint32_t Lib_USART_CMD_Baud_Old;                                    // 切换前的波特率, 0 表示不在校验中
+  static uint32_t Lib_USART_CMD_Baud_Start;                                  // 切换的时刻 (DWT)
+
+  static uint8_t Lib_USART_CMD_Start(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_Stop(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_RTC_Unix(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_Ping(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_Baud(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_Baud_Check(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+  static uint8_t Lib_USART_CMD_Stat(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply);
+
+  /*
+   * @brief   指令表: 指令, 负载最小长度, 负载最大长度, 处理函数
+  */
+  static const struct
+  {
+    uint8_t cmd;
+    uint8_t min_len;
+    uint8_t max_len;
+    Lib_USART_CMD_Handler_Type handler;
+  } Lib_USART_CMD_Table[] =
   {
-    buffer[p] = '-';
-    ++p;
-    int_part = (uint32_t)(-num);
-    frac_part = (-num) - int_part;
+    {LIB_USART_CMD_START,      0, 0,                         Lib_USART_CMD_Start},
+    {LIB_USART_CMD_STOP,       0, 0,                         Lib_USART_CMD_Stop},
+    {LIB_USART_CMD_RTC_UNIX,   4, 4,                         Lib_USART_CMD_RTC_Unix},
+    {LIB_USART_CMD_PING,       0, LIB_FRAME_PAYLOAD_MAXSIZE, Lib_USART_CMD_Ping},
+    {LIB_USART_CMD_BAUD,       4, 4,                         Lib_USART_CMD_Baud},
+    {LIB_USART_CMD_BAUD_CHECK, 0, LIB_FRAME_PAYLOAD_MAXSIZE, Lib_USART_CMD_Baud_Check},
+    {LIB_USART_CMD_STAT,       0, 0,                         Lib_USART_CMD_Stat},
+  };
+
+  static uint8_t Lib_USART_CMD_Start(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
+  {
+    (void)req;
+    (void)reply;
+    Lib_USART_CMD_Started = 1;
+    return LIB_USART_CMD_RES_OK;
   }
-  else
+
+  static uint8_t Lib_USART_CMD_Stop(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    int_part = (uint32_t)num;
-    frac_part = num - int_part;
+    (void)req;
+    (void)reply;
+    Lib_USART_CMD_Started = 0;
+    return LIB_USART_CMD_RES_OK;
   }
-  // 处理整数部分
-  if (int_part == 0)
+
+  static uint8_t Lib_USART_CMD_RTC_Unix(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    buffer[p] = '0';
-    ++p;
+    uint32_t ts = (uint32_t)req->payload[0]
+                | ((uint32_t)req->payload[1] << 8)
+                | ((uint32_t)req->payload[2] << 16)
+                | ((uint32_t)req->payload[3] << 24);
+    (void)reply;
+    Lib_RTC_Set_Time((Lib_RTC_UnixType)ts);
+    return LIB_USART_CMD_RES_OK;
   }
-  else
+
+  static uint8_t Lib_USART_CMD_Ping(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    st = p;
-    while (int_part > 0)
+    for (uint8_t i = 0; i < req->len; ++i)
     {
-      buffer[p] = int_part % 10 + '0';
-      ++p;
-      int_part /= 10;
+      reply->payload[i] = req->payload[i];
     }
-    Lib_USART_Reverse_String(buffer, st, p - 1);
+    reply->len = req->len;
+    return LIB_USART_CMD_RES_OK;
   }
-  buffer[p] = '.';
-  ++p;
-  // 处理小数部分
-  if (frac_part == 0.0)
+
+  /*
+   * @brief   协商波特率, 只检查是否支持, 在 ACK 发出后由 Lib_USART_CMD_Process() 切换
+   * @note    协商过程:
+   *          1) 上位机以当前波特率发送 BAUD, 收到 OK 后双方切换到新波特率
+   *          2) 上位机发送带测试图样的 BAUD_CHECK, 单片机原样返回, 上位机比较
+   *          3) 上位机发送空的 BAUD_CHECK 确认; 单片机在超时前没收到确认则退回原波特率,
+   *             上位机在第 2, 3 步失败时同样退回原波特率
+  */
+  static uint8_t Lib_USART_CMD_Baud(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    buffer[p] = '0';
-    ++p;
+    uint32_t baud = (uint32_t)req->payload[0]
+                  | ((uint32_t)req->payload[1] << 8)
+                  | ((uint32_t)req->payload[2] << 16)
+                  | ((uint32_t)req->payload[3] << 24);
+
+    (void)reply;
+    // 上一次协商未结束, 或不支持该波特率; 切换前就要知道能否成功
+    if (Lib_USART_CMD_Baud_Old != 0 || Lib_USART_Baud_Check(LIB_USART_CONSOLE, baud) != SUCCESS)
+    {
+      return LIB_USART_CMD_RES_FAIL;
+    }
+    Lib_USART_CMD_Baud_New = baud;
+    return LIB_USART_CMD_RES_OK;
   }
-  else
+
+  static uint8_t Lib_USART_CMD_Baud_Check(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    // num_frac_bits显示小数位数
-    for (uint8_t i = 0; i < num_frac_bits + 1; ++i)
+    if (Lib_USART_CMD_Baud_Old == 0)
+    {
+      // 不在校验中: 上位机重发的确认 (上一次的 ACK 丢失), 当作成功
+      return req->len == 0 ? LIB_USART_CMD_RES_OK : LIB_USART_CMD_RES_FAIL;
+    }
+    if (req->len == 0)
     {
-      frac_part *= 10;
-      buffer[p] = (uint8_t)frac_part + '0';
-      ++p;
-      frac_part = frac_part - (uint8_t)frac_part;
+      Lib_USART_CMD_Baud_Old = 0;     // 确认, 保持新波特率
+      return LIB_USART_CMD_RES_OK;
     }
-    if (buffer[p - 1] > '4') buffer[p - 2] += 1;
-    --p;
+    // 收到测试图样说明上位机到单片机方向正常, 延长超时, 等待确认
+    Lib_USART_CMD_Baud_Start = Lib_Tool_DWT_Timer_Start();
+    return Lib_USART_CMD_Ping(req, reply);
   }
-  buffer[p] = '\0';
-}
-
-// 发送格式化字符串
-// %d: 十进制整型; %x: 十六进制整型; %f: 浮点数(double); 
-void Lib_USART_Send_fString(const char * str, ...)
-{
-  uint8_t i = 0;          // 遍历字符串
 
-  int arg_int = 0;          // 整型参数
-  double arg_double = 0.0;  // 浮点型
-  char* arg_str = (void*)0;     // 字符串
-  uint8_t buffer[20] = {0}; // 缓冲区
-  
-  va_list ap;           // 声明ap容纳不定参数
-  va_start(ap, str);    // 初始化ap
-
-  while (str[i] != '\0')
+  static uint8_t Lib_USART_CMD_Stat(const Lib_Frame_Type *const req, Lib_Frame_Type *const reply)
   {
-    // 非格式化字符
-    if (str[i] != '%')
+    Lib_USART_Stat_Type stat;
+    const uint32_t *const p = (const uint32_t *)&stat;
+
+    (void)req;
+    Lib_USART_Get_Stat(&stat);
+    for (uint8_t i = 0; i < sizeof(stat) / sizeof(uint32_t); ++i)
     {
-      while (LL_USART_IsActiveFlag_TXE(LIB_USART) != SET);
-      LL_USART_TransmitData8(LIB_USART, str[i]);
-      ++i;
+      reply->payload[reply->len++] = p[i] & 0xFF;
+      reply->payload[reply->len++] = (p[i] >> 8) & 0xFF;
+      reply->payload[reply->len++] = (p[i] >> 16) & 0xFF;
+      reply->payload[reply->len++] = (p[i] >> 24) & 0xFF;
     }
-    else // 格式化字符
+    return LIB_USART_CMD_RES_OK;
+  }
+
+  /*
+   * @brief   输入收到的字节, 解出完整的帧后放入队列
+   * @note    在接收中断中调用; 队列满或帧错误时丢弃该帧, 上位机因收不到应答而重发
+  */
+  void Lib_USART_CMD_Receive(const uint8_t *const data, const uint32_t num)
+  {
+    Lib_Frame_Type *frame = (void *)0;
+
+    for (uint32_t i = 0; i < num; ++i)
     {
-      ++i;
-      switch (str[i])
+      // 队列已满时仍要解码, 以便找到下一帧的开头, 但结果丢弃
+      if (Lib_USART_CMD_Queue_Head - Lib_USART_CMD_Queue_Tail == LIB_USART_CMD_QUEUE_SIZE)
       {
-        // 十进制整型
-        case 'd':
-          arg_int = va_arg(ap, int);
-          Lib_USART_Int2Char_DEC(arg_int, buffer);
-          ++i;
-          break;
-        // 十六进制整型
-        case 'x':
-          arg_int = va_arg(ap, int);
-          Lib_USART_Int2Char_HEX(arg_int, buffer);
-          ++i;
-          break;
-        // 浮点数
-        case 'f':
-          arg_double = va_arg(ap, double);
-          // 默认打印3位小数
-          Lib_USART_Double2Char(arg_double, buffer, 3);
-          ++i;
-          break;
-        // 字符串
-        case 's':
-          arg_str = va_arg(ap, char*);
-          Lib_USART_Send_String(arg_str);
-          ++i;
-          continue;
-        default:
-          // 报错，待实现
-          break;
+        frame = &Lib_USART_CMD_Discard;
       }
-      // 发送buffer数据
-      for (uint8_t i = 0; buffer[i] != '\0'; ++i)
+      else
       {
-        while (LL_USART_IsActiveFlag_TXE(LIB_USART) != SET);
-        LL_USART_TransmitData8(LIB_USART, buffer[i]);
+        frame = &Lib_USART_CMD_Queue[Lib_USART_CMD_Queue_Head & (LIB_USART_CMD_QUEUE_SIZE - 1)];
+      }
+      if (Lib_Frame_Decode_Byte(&Lib_USART_CMD_Decoder, data[i], frame) == LIB_FRAME_READY)
+      {
+        if (frame == &Lib_USART_CMD_Discard)
+        {
+          ++Lib_USART1_State.stat.rx_dropped;
+          continue;
+        }
+        ++Lib_USART_CMD_Queue_Head;
+        #if LIB_USART_FLOW_EN
+          // 只剩一个空位时暂停, 留给上位机响应 RTS 前已经在发送的帧
+          if (Lib_USART_CMD_Queue_Head - Lib_USART_CMD_Queue_Tail >= LIB_USART_CMD_QUEUE_SIZE - 1)
+          {
+            Lib_USART_RX_Pause();
+          }
+        #endif
       }
     }
   }
-  // 确保发送完成
-  while (LL_USART_IsActiveFlag_TC(LIB_USART) != SET);
 
-  va_end(ap);           // 释放ap
-}
+  // 发送一帧
+  static void Lib_USART_CMD_Send_Frame(const Lib_Frame_Type *const frame)
+  {
+    uint8_t buffer[LIB_FRAME_ENCODED_MAXSIZE];
+    uint32_t num = Lib_Frame_Encode(frame, buffer);
 
-#if LIB_USART_IT_EN
-  uint8_t Lib_USART_Buffer[LIB_USART_BUFFER_MAXSIZE];
-  #if LIB_USART_CMD_EN
-    uint8_t Lib_USART_CMD_Status1;        // bit 0: 是否进入指令模式, bit 1: 是否使用缓冲区
-    uint8_t Lib_USART_CMD_Status2;        // bit 2: 0x03
-    uint32_t Lib_USART_CMD_Data;
-    void Lib_USART_IT_Handler(void)
+    Lib_USART_Send_Data(buffer, num);
+  }
+
+  /*
+   * @brief   执行队列中所有的帧, 然后用一个 ACK 帧批量应答
+   * @note    在主循环中调用
+  */
+  void Lib_USART_CMD_Process(void)
+  {
+    Lib_Frame_Type *req = (void *)0;
+    Lib_Frame_Type reply = {0}, ack = {0};
+    uint8_t res = 0;
+    uint32_t i = 0;
+
+    ack.cmd = LIB_USART_CMD_ACK;
+    while (Lib_USART_CMD_Queue_Tail != Lib_USART_CMD_Queue_Head)
     {
-      uint8_t data = 0;
-      if (LL_USART_IsActiveFlag_RXNE(LIB_USART) == SET)
+      req = &Lib_USART_CMD_Queue[Lib_USART_CMD_Queue_Tail & (LIB_USART_CMD_QUEUE_SIZE - 1)];
+      reply.seq = req->seq;
+      reply.cmd = req->cmd;
+      reply.len = 0;
+
+      for (i = 0; i < sizeof(Lib_USART_CMD_Table) / sizeof(Lib_USART_CMD_Table[0]); ++i)
       {
-        data = LL_USART_ReceiveData8(LIB_USART);
-        if ((Lib_USART_CMD_Status1 & 0x02))
+        if (Lib_USART_CMD_Table[i].cmd == req->cmd)
         {
-
+          break;
         }
+      }
+      if (i == sizeof(Lib_USART_CMD_Table) / sizeof(Lib_USART_CMD_Table[0]))
+      {
+        res = LIB_USART_CMD_RES_UNKNOWN;
+      }
+      else if (req->len < Lib_USART_CMD_Table[i].min_len || req->len > Lib_USART_CMD_Table[i].max_len)
+      {
+        res = LIB_USART_CMD_RES_BAD_LEN;
+      }
+      else if (Lib_USART_CMD_Started == 0 && req->cmd != LIB_USART_CMD_START)
+      {
+        res = LIB_USART_CMD_RES_NOT_STARTED;
+      }
+      else
+      {
+        res = Lib_USART_CMD_Table[i].handler(req, &reply);
+      }
+      if (reply.len > 0)
+      {
+        Lib_USART_CMD_Send_Frame(&reply);
+      }
 
-        if ((Lib_USART_CMD_Status1 & 0x01))
-        {
-          if ()
-          switch (data)
-          {
-            case LIB_USART_CMD_STOP:
-              Lib_USART_CMD_Status1 &= ~0x01;
-              Lib_USART_CMD_Status2 = 0;
-              break;
-            case LIB_USART_CMD_RTC_UNIX:
-              Lib_USART_CMD_Status2 |= 0x03;
-              break;
-          }
-        }
-        else
-        {
-          swtich (data)
-          {
-            case LIB_USART_CMD_START:
-              Lib_USART_CMD_Status1 |= 0x01;
-              break;
-          }
-        }
-        Lib_USART_Send_Byte(LIB_USART_CMD_ACK);
+      ack.payload[ack.len++] = req->seq;
+      ack.payload[ack.len++] = res;
+      ++Lib_USART_CMD_Queue_Tail;
+      // ACK 负载已满, 先发出去
+      if (ack.len + 2 > LIB_FRAME_PAYLOAD_MAXSIZE)
+      {
+        Lib_USART_CMD_Send_Frame(&ack);
+        ++ack.seq;
+        ack.len = 0;
       }
     }
-  #else
-    void Lib_USART_IT_Handler(void)
+    if (ack.len > 0)
     {
-      uint8_t tmp = 0;
-      if (LL_USART_IsActiveFlag_RXNE(LIB_USART) == SET)
-      {
-        tmp = LL_USART_ReceiveData8(LIB_USART);
-        Lib_USART_Send_fString("RX IT: %x\n", tmp);
-      }
+      Lib_USART_CMD_Send_Frame(&ack);
     }
-  #endif
-#endif
\ No newline at end of file
+    #if LIB_USART_FLOW_EN
+      // 队列已清空
+      Lib_USART_RX_Resume();
+    #endif
+
+    // BAUD 的 ACK 已经以原波特率发出, 现在切换
+    if (Lib_USART_CMD_Baud_New != 0)
+    {
+      Lib_USART_CMD_Baud_Old = Lib_USART_Get_Baud();
+      Lib_USART_Set_Baud(Lib_USART_CMD_Baud_New);
+      Lib_USART_CMD_Baud_New = 0;
+      Lib_USART_CMD_Baud_Start = Lib_Tool_DWT_Timer_Start();
+    }
+    // 超时未确认, 退回原波特率
+    else if (Lib_USART_CMD_Baud_Old != 0
+             && Lib_Tool_DWT_Timer_End(Lib_USART_CMD_Baud_Start, 0) > LIB_USART_CMD_BAUD_TIMEOUT_MS)
+    {
+      Lib_USART_Set_Baud(Lib_USART_CMD_Baud_Old);
+      Lib_USART_CMD_Baud_Old = 0;
+    }
+  }
+#endif
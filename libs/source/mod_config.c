@@ -0,0 +1,577 @@
+#include "mod_config.h"
+#include "lib_frame.h"
+#include <string.h>
+
+#define MOD_CONFIG_MAGIC               0x31474643                    // "CFG1"
+#define MOD_CONFIG_KEY_NONE            0xFFFF                        // 哈希表的空位, 也是擦除后的键
+#define MOD_CONFIG_SECTOR_NONE         0xFF                          // 没有预擦除的扇区
+#define MOD_CONFIG_HEADER_SIZE         16                            // 扇区头部
+
+// 条目的标志, 擦除后为 1, 编程时清零表示有效
+#define MOD_CONFIG_FLAG_COMMIT         0x01                          // 事务的最后一个条目
+#define MOD_CONFIG_FLAG_DELETE         0x02                          // 删除键, 没有值
+#define Mod_Config_Flag(flags, flag)   (((flags) & (flag)) == 0)
+
+#if MOD_CONFIG_SECTORS < 2
+    #error "MOD_FLASH_CONFIG_SIZE must hold at least 2 sectors"
+#endif
+#if MOD_CONFIG_INDEX_SIZE & (MOD_CONFIG_INDEX_SIZE - 1) || MOD_CONFIG_INDEX_SIZE < 2 * MOD_CONFIG_KEYS_MAXNUM
+    #error "MOD_CONFIG_INDEX_SIZE must be a power of 2 and at least twice MOD_CONFIG_KEYS_MAXNUM"
+#endif
+// 整理后的全部键值加上一次提交必须放得下, 否则整理后也不能提交
+#if MOD_CONFIG_HEADER_SIZE + MOD_CONFIG_KEYS_MAXNUM * (MOD_CONFIG_ENTRY_HEADER_SIZE + MOD_CONFIG_DATA_MAXSIZE) \
+    + MOD_CONFIG_TXN_SIZE > MOD_FLASH_SECTOR_SIZE
+    #error "MOD_CONFIG_KEYS_MAXNUM * MOD_CONFIG_DATA_MAXSIZE is too large for one sector"
+#endif
+
+// 扇区头部, 整理写入全部键值之后才编程
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;               // 每次整理加 1
+    uint32_t bytes;             // 整理写入的字节数, 包括头部; 之后是追加的条目
+    uint32_t check;             // ~(magic ^ seq ^ bytes)
+} Mod_Config_Sector_Type;
+
+// 条目头部, 之后是 len 字节的值; crc 覆盖 key, len, flags 和值
+typedef struct
+{
+    uint16_t key;
+    uint8_t len;
+    uint8_t flags;
+    uint16_t crc;
+} Mod_Config_Entry_Type;
+
+// 哈希表的一项
+typedef struct
+{
+    uint16_t key;               // MOD_CONFIG_KEY_NONE 为空
+    uint8_t len;
+    uint16_t offset;            // 条目在当前扇区内的位置
+    uint32_t value;             // 不超过 4 字节的值
+} Mod_Config_Slot_Type;
+
+typedef struct
+{
+    uint8_t head;               // 当前扇区
+    uint8_t ahead;              // 已经擦除或正在擦除的扇区, MOD_CONFIG_SECTOR_NONE 表示没有
+    uint32_t seq;
+    uint16_t offset;            // 下一个条目的位置, MOD_FLASH_SECTOR_SIZE 表示下次提交前必须整理
+    uint16_t snapshot;          // 整理写入的字节数
+    uint16_t logs;              // 整理后追加的条目数
+    uint16_t keys;
+    Mod_Config_Slot_Type index[MOD_CONFIG_INDEX_SIZE];
+    // 暂存的事务
+    uint8_t txn_open;
+    uint16_t txn_num;           // 条目数
+    uint16_t txn_size;          // 字节数
+    uint16_t txn_last;          // 最后一个条目的位置
+    uint8_t txn[MOD_CONFIG_TXN_SIZE];
+} Mod_Config_State_Type;
+
+static Mod_Config_State_Type Mod_Config_State;
+static Mod_Config_Stat_Type Mod_Config_Stat;
+
+#define Mod_Config_Addr(sector)        (MOD_CONFIG_START + (uint32_t)(sector) * MOD_FLASH_SECTOR_SIZE)
+#define Mod_Config_Next_Sector(sector) ((sector) + 1u < MOD_CONFIG_SECTORS ? (sector) + 1u : 0u)
+#define Mod_Config_Hash(key)           ((uint16_t)((uint32_t)(key) * 0x9E3779B1u >> 16) & (MOD_CONFIG_INDEX_SIZE - 1))
+
+// 条目的 CRC, 覆盖头部的前 4 个字节和值
+static uint16_t Mod_Config_CRC(const Mod_Config_Entry_Type *const entry, const uint8_t *const data)
+{
+    return Lib_Frame_CRC16(data, entry->len, Lib_Frame_CRC16((const uint8_t *)entry, 4, 0xFFFF));
+}
+
+// 键在哈希表中的位置, 没有时为插入的空位; 表中的键数少于一半, 总能找到空位
+static uint16_t Mod_Config_Find(const uint16_t key)
+{
+    uint16_t i = Mod_Config_Hash(key);
+
+    while (Mod_Config_State.index[i].key != MOD_CONFIG_KEY_NONE && Mod_Config_State.index[i].key != key)
+    {
+        i = (i + 1) & (MOD_CONFIG_INDEX_SIZE - 1);
+    }
+    return i;
+}
+
+// 删除哈希表中的一项, 之后同一段连续的项前移, 不留下删除标记
+static void Mod_Config_Remove(uint16_t i)
+{
+    uint16_t j = i, k = 0;
+
+    while (1)
+    {
+        j = (j + 1) & (MOD_CONFIG_INDEX_SIZE - 1);
+        if (Mod_Config_State.index[j].key == MOD_CONFIG_KEY_NONE)
+        {
+            break;
+        }
+        // j 的理想位置 k 不在 (i, j] 中时, 可以移到 i
+        k = Mod_Config_Hash(Mod_Config_State.index[j].key);
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j))
+        {
+            Mod_Config_State.index[i] = Mod_Config_State.index[j];
+            i = j;
+        }
+    }
+    Mod_Config_State.index[i].key = MOD_CONFIG_KEY_NONE;
+    --Mod_Config_State.keys;
+}
+
+// 把一个条目应用到哈希表, data 为值 (只使用前 4 个字节)
+static void Mod_Config_Apply(const Mod_Config_Entry_Type *const entry, const uint16_t offset, const uint8_t *const data)
+{
+    const uint16_t i = Mod_Config_Find(entry->key);
+    Mod_Config_Slot_Type *const slot = &Mod_Config_State.index[i];
+
+    if (Mod_Config_Flag(entry->flags, MOD_CONFIG_FLAG_DELETE))
+    {
+        if (slot->key != MOD_CONFIG_KEY_NONE)
+        {
+            Mod_Config_Remove(i);
+        }
+        return;
+    }
+    if (slot->key == MOD_CONFIG_KEY_NONE)
+    {
+        slot->key = entry->key;
+        ++Mod_Config_State.keys;
+    }
+    slot->len = entry->len;
+    slot->offset = offset;
+    slot->value = 0;
+    if (entry->len <= sizeof(slot->value))
+    {
+        memcpy(&slot->value, data, entry->len);
+    }
+}
+
+// 读取当前扇区 offset 处的条目, 返回是否有效; 擦除后的位置 (键为 0xFFFF) 无效, end 为 1
+static uint8_t Mod_Config_Read_Entry(const uint16_t offset, Mod_Config_Entry_Type *const entry, uint8_t *const data,
+                                     uint8_t *const end)
+{
+    *end = 0;
+    if (offset + MOD_CONFIG_ENTRY_HEADER_SIZE > MOD_FLASH_SECTOR_SIZE)
+    {
+        *end = 1;
+        return 0;
+    }
+    Mod_Flash_Read((uint8_t *)entry, Mod_Config_Addr(Mod_Config_State.head) + offset, MOD_CONFIG_ENTRY_HEADER_SIZE);
+    if (entry->key == MOD_CONFIG_KEY_NONE)
+    {
+        *end = entry->len == 0xFF && entry->flags == 0xFF && entry->crc == 0xFFFF;
+        return 0;
+    }
+    if (entry->len > MOD_CONFIG_DATA_MAXSIZE || offset + MOD_CONFIG_ENTRY_HEADER_SIZE + entry->len > MOD_FLASH_SECTOR_SIZE)
+    {
+        return 0;
+    }
+    Mod_Flash_Read(data, Mod_Config_Addr(Mod_Config_State.head) + offset + MOD_CONFIG_ENTRY_HEADER_SIZE, entry->len);
+    return Mod_Config_CRC(entry, data) == entry->crc;
+}
+
+// FLASH 的 num 字节是否全为 0xFF
+static uint8_t Mod_Config_Is_Erased(const uint32_t addr, const uint32_t num)
+{
+    uint8_t data[32];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < num; i += n)
+    {
+        n = num - i < sizeof(data) ? num - i : sizeof(data);
+        Mod_Flash_Read(data, addr + i, n);
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            if (data[j] != 0xFF)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * @brief   上电时找到最新的扇区, 重放其中的条目, 建立哈希表
+ * @note    1) 读取 MOD_CONFIG_SECTORS 个扇区头部, 序号最大的有效扇区是当前扇区
+ *          2) 只有带提交标志的条目结束的事务才应用; 之后的部分 (掉电时没有完成的提交) 不应用,
+ *             下次提交前先整理, 不在其后追加
+ *          3) 掉电时编程了一半的条目头部可能仍为 0xFF, 所以检查结束位置之后一次提交的范围也已擦除
+*/
+void Mod_Config_Init(void)
+{
+    Mod_Config_Sector_Type header;
+    Mod_Config_Entry_Type entry;
+    uint8_t data[MOD_CONFIG_DATA_MAXSIZE];
+    uint16_t offset = 0, txn = 0, check = 0;
+    uint8_t found = 0, end = 0;
+
+    memset(&Mod_Config_State, 0, sizeof(Mod_Config_State));
+    memset(Mod_Config_State.index, 0xFF, sizeof(Mod_Config_State.index));
+    Mod_Config_State.head = MOD_CONFIG_SECTORS - 1;
+    Mod_Config_State.ahead = MOD_CONFIG_SECTOR_NONE;
+    Mod_Config_State.offset = MOD_FLASH_SECTOR_SIZE;
+    Mod_Config_Stat.replayed = 0;
+
+    for (uint8_t i = 0; i < MOD_CONFIG_SECTORS; ++i)
+    {
+        Mod_Flash_Read((uint8_t *)&header, Mod_Config_Addr(i), sizeof(header));
+        if (header.magic != MOD_CONFIG_MAGIC || header.check != ~(header.magic ^ header.seq ^ header.bytes)
+            || header.bytes < MOD_CONFIG_HEADER_SIZE || header.bytes > MOD_FLASH_SECTOR_SIZE)
+        {
+            continue;
+        }
+        if (!found || (int32_t)(header.seq - Mod_Config_State.seq) > 0)
+        {
+            found = 1;
+            Mod_Config_State.head = i;
+            Mod_Config_State.seq = header.seq;
+            Mod_Config_State.snapshot = header.bytes;
+        }
+    }
+    if (!found)
+    {
+        return;
+    }
+
+    // 重放, 条目先暂存, 遇到提交标志时再从事务开始处应用
+    offset = txn = MOD_CONFIG_HEADER_SIZE;
+    while (Mod_Config_Read_Entry(offset, &entry, data, &end))
+    {
+        offset += MOD_CONFIG_ENTRY_HEADER_SIZE + entry.len;
+        ++Mod_Config_Stat.replayed;
+        if (!Mod_Config_Flag(entry.flags, MOD_CONFIG_FLAG_COMMIT))
+        {
+            continue;
+        }
+        while (txn < offset)
+        {
+            Mod_Config_Read_Entry(txn, &entry, data, &end);
+            Mod_Config_Apply(&entry, txn, data);
+            Mod_Config_State.logs += txn >= Mod_Config_State.snapshot;
+            txn += MOD_CONFIG_ENTRY_HEADER_SIZE + entry.len;
+        }
+    }
+    if (end && txn == offset)
+    {
+        check = MOD_FLASH_SECTOR_SIZE - offset < MOD_CONFIG_TXN_SIZE ? MOD_FLASH_SECTOR_SIZE - offset : MOD_CONFIG_TXN_SIZE;
+        if (Mod_Config_Is_Erased(Mod_Config_Addr(Mod_Config_State.head) + offset, check))
+        {
+            Mod_Config_State.offset = offset;
+        }
+    }
+}
+
+// 编程整理的一段, 打开读出校验时比较; 1: 成功; 0: 读出不同
+static uint8_t Mod_Config_Program(const uint8_t *const pbuffer, const uint32_t addr, const uint16_t num)
+{
+    Mod_Flash_Write(pbuffer, addr, num);
+#if MOD_FLASH_VERIFY_EN
+    return Mod_Flash_Compare(pbuffer, addr, num);
+#else
+    return 1;
+#endif
+}
+
+/*
+ * @brief   整理: 把全部键值写入下一个扇区, 最后编程头部, 之后在后台擦除再下一个扇区
+ * @return  SUCCESS; ERROR: 在 Mod_Config_Begin() 之后的提交中, 或者写入后读出不同; 都仍使用原来的扇区
+ * @note    1) 掉电时头部没有编程, 上电后仍使用原来的扇区
+ *          2) 失败时目标扇区下次整理前重新擦除
+*/
+ErrorStatus Mod_Config_Compact(void)
+{
+    Mod_Config_Sector_Type header;
+    Mod_Config_Entry_Type entry;
+    uint8_t buffer[MOD_FLASH_PAGE_SIZE];
+    uint16_t num = 0, offset = MOD_CONFIG_HEADER_SIZE;
+    const uint8_t target = Mod_Config_Next_Sector(Mod_Config_State.head);
+    const uint32_t addr = Mod_Config_Addr(target);
+
+    if (Mod_Config_State.txn_open)
+    {
+        return ERROR;
+    }
+    if (Mod_Config_State.ahead != target)
+    {
+        Mod_Flash_Erase_Start(addr);    // 下面的编程等待擦除完成
+    }
+    // 索引中的位置在头部编程之后才改为新扇区的位置, 在此之前较长的值仍从原来的扇区读取
+    for (uint16_t i = 0; i < MOD_CONFIG_INDEX_SIZE; ++i)
+    {
+        const Mod_Config_Slot_Type *const slot = &Mod_Config_State.index[i];
+
+        if (slot->key == MOD_CONFIG_KEY_NONE)
+        {
+            continue;
+        }
+        if (num + MOD_CONFIG_ENTRY_HEADER_SIZE + slot->len > MOD_FLASH_PAGE_SIZE)
+        {
+            if (!Mod_Config_Program(buffer, addr + offset - num, num))
+            {
+                Mod_Config_State.ahead = MOD_CONFIG_SECTOR_NONE;
+                return ERROR;
+            }
+            num = 0;
+        }
+        entry.key = slot->key;
+        entry.len = slot->len;
+        entry.flags = (uint8_t)~MOD_CONFIG_FLAG_COMMIT;
+        if (slot->len <= sizeof(slot->value))
+        {
+            memcpy(buffer + num + MOD_CONFIG_ENTRY_HEADER_SIZE, &slot->value, slot->len);
+        }
+        else
+        {
+            Mod_Flash_Read(buffer + num + MOD_CONFIG_ENTRY_HEADER_SIZE,
+                           Mod_Config_Addr(Mod_Config_State.head) + slot->offset + MOD_CONFIG_ENTRY_HEADER_SIZE, slot->len);
+        }
+        entry.crc = Mod_Config_CRC(&entry, buffer + num + MOD_CONFIG_ENTRY_HEADER_SIZE);
+        memcpy(buffer + num, &entry, MOD_CONFIG_ENTRY_HEADER_SIZE);
+        num += MOD_CONFIG_ENTRY_HEADER_SIZE + slot->len;
+        offset += MOD_CONFIG_ENTRY_HEADER_SIZE + slot->len;
+    }
+
+    header.magic = MOD_CONFIG_MAGIC;
+    header.seq = Mod_Config_State.seq + 1;
+    header.bytes = offset;
+    header.check = ~(header.magic ^ header.seq ^ header.bytes);
+    if ((num > 0 && !Mod_Config_Program(buffer, addr + offset - num, num))
+        || !Mod_Config_Program((const uint8_t *)&header, addr, sizeof(header)))
+    {
+        Mod_Config_State.ahead = MOD_CONFIG_SECTOR_NONE;
+        return ERROR;
+    }
+
+    // 按相同的顺序更新索引中的位置
+    offset = MOD_CONFIG_HEADER_SIZE;
+    for (uint16_t i = 0; i < MOD_CONFIG_INDEX_SIZE; ++i)
+    {
+        Mod_Config_Slot_Type *const slot = &Mod_Config_State.index[i];
+
+        if (slot->key != MOD_CONFIG_KEY_NONE)
+        {
+            slot->offset = offset;
+            offset += MOD_CONFIG_ENTRY_HEADER_SIZE + slot->len;
+        }
+    }
+    Mod_Config_State.head = target;
+    Mod_Config_State.seq = header.seq;
+    Mod_Config_State.offset = offset;
+    Mod_Config_State.snapshot = offset;
+    Mod_Config_State.logs = 0;
+    ++Mod_Config_Stat.compactions;
+    // 最旧的扇区, 下次整理时已经擦除完成
+    Mod_Config_State.ahead = Mod_Config_Next_Sector(target);
+    Mod_Flash_Erase_Start(Mod_Config_Addr(Mod_Config_State.ahead));
+    return SUCCESS;
+}
+
+/*
+ * @brief   读取键的值
+ * @param   size 值的字节数, 必须与写入时相同
+ * @return  SUCCESS; ERROR: 没有该键或长度不同
+ * @note    不超过 4 字节的值从哈希表读取, 否则读取一次 FLASH
+*/
+ErrorStatus Mod_Config_Get(const uint16_t key, void *const pbuffer, const uint8_t size)
+{
+    const Mod_Config_Slot_Type *const slot = &Mod_Config_State.index[Mod_Config_Find(key)];
+
+    if (key == MOD_CONFIG_KEY_NONE || slot->key != key || slot->len != size)
+    {
+        return ERROR;
+    }
+    if (size <= sizeof(slot->value))
+    {
+        memcpy(pbuffer, &slot->value, size);
+    }
+    else
+    {
+        Mod_Flash_Read(pbuffer, Mod_Config_Addr(Mod_Config_State.head) + slot->offset + MOD_CONFIG_ENTRY_HEADER_SIZE, size);
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   读取 4 字节的值
+ * @param   value 没有该键时返回的默认值
+*/
+uint32_t Mod_Config_Get_U32(const uint16_t key, const uint32_t value)
+{
+    uint32_t result = value;
+
+    return Mod_Config_Get(key, &result, sizeof(result)) == SUCCESS ? result : value;
+}
+
+/*
+ * @brief   开始一次提交, 之后的 Mod_Config_Set(), Mod_Config_Delete() 在 Mod_Config_Commit() 时一起写入
+*/
+void Mod_Config_Begin(void)
+{
+    Mod_Config_State.txn_open = 1;
+    Mod_Config_State.txn_num = 0;
+    Mod_Config_State.txn_size = 0;
+}
+
+// 暂存一个条目; 不在提交中时立即提交
+static ErrorStatus Mod_Config_Stage(const uint16_t key, const void *const data, const uint8_t len, const uint8_t flags)
+{
+    Mod_Config_Entry_Type entry;
+    const uint8_t open = Mod_Config_State.txn_open;
+
+    if (key == MOD_CONFIG_KEY_NONE || len > MOD_CONFIG_DATA_MAXSIZE)
+    {
+        return ERROR;
+    }
+    if (!open)
+    {
+        Mod_Config_Begin();
+    }
+    if (Mod_Config_State.txn_size + MOD_CONFIG_ENTRY_HEADER_SIZE + len > MOD_CONFIG_TXN_SIZE)
+    {
+        Mod_Config_State.txn_open = open;
+        return ERROR;
+    }
+    entry.key = key;
+    entry.len = len;
+    entry.flags = flags;
+    entry.crc = 0;      // 提交时计算
+    memcpy(Mod_Config_State.txn + Mod_Config_State.txn_size, &entry, MOD_CONFIG_ENTRY_HEADER_SIZE);
+    if (len > 0)
+    {
+        memcpy(Mod_Config_State.txn + Mod_Config_State.txn_size + MOD_CONFIG_ENTRY_HEADER_SIZE, data, len);
+    }
+    Mod_Config_State.txn_last = Mod_Config_State.txn_size;
+    Mod_Config_State.txn_size += MOD_CONFIG_ENTRY_HEADER_SIZE + len;
+    ++Mod_Config_State.txn_num;
+    return open ? SUCCESS : Mod_Config_Commit();
+}
+
+/*
+ * @brief   设置键的值
+ * @return  SUCCESS; ERROR: 键为 0xFFFF, 值太长, 或者一次提交的条目太多; 不在提交中时见 Mod_Config_Commit()
+*/
+ErrorStatus Mod_Config_Set(const uint16_t key, const void *const data, const uint8_t len)
+{
+    return Mod_Config_Stage(key, data, len, 0xFF);
+}
+
+ErrorStatus Mod_Config_Set_U32(const uint16_t key, const uint32_t value)
+{
+    return Mod_Config_Set(key, &value, sizeof(value));
+}
+
+/*
+ * @brief   删除键, 没有该键时也写入
+*/
+ErrorStatus Mod_Config_Delete(const uint16_t key)
+{
+    return Mod_Config_Stage(key, (void *)0, 0, (uint8_t)~MOD_CONFIG_FLAG_DELETE);
+}
+
+// 提交后的键数 (删除不计), 检查键数不超过 MOD_CONFIG_KEYS_MAXNUM
+static uint16_t Mod_Config_Count_Keys(void)
+{
+    Mod_Config_Entry_Type entry, other;
+    uint16_t keys = Mod_Config_State.keys;
+
+    for (uint16_t i = 0; i < Mod_Config_State.txn_size; i += MOD_CONFIG_ENTRY_HEADER_SIZE + entry.len)
+    {
+        uint16_t j = 0;
+
+        memcpy(&entry, Mod_Config_State.txn + i, MOD_CONFIG_ENTRY_HEADER_SIZE);
+        if (Mod_Config_Flag(entry.flags, MOD_CONFIG_FLAG_DELETE)
+            || Mod_Config_State.index[Mod_Config_Find(entry.key)].key == entry.key)
+        {
+            continue;
+        }
+        // 同一次提交中重复的键只计一次
+        for (j = 0; j < i; j += MOD_CONFIG_ENTRY_HEADER_SIZE + other.len)
+        {
+            memcpy(&other, Mod_Config_State.txn + j, MOD_CONFIG_ENTRY_HEADER_SIZE);
+            if (other.key == entry.key)
+            {
+                break;
+            }
+        }
+        keys += j == i;
+    }
+    return keys;
+}
+
+/*
+ * @brief   写入 Mod_Config_Begin() 之后的全部条目
+ * @return  SUCCESS; ERROR: 键数超过 MOD_CONFIG_KEYS_MAXNUM, 或者写入或整理后读出不同; 都不改变已有的键值
+ * @note    1) 当前扇区放不下或追加的条目超过 MOD_CONFIG_LOG_MAXNUM 时先整理
+ *          2) 一次编程, 上电后要么全部有效, 要么全部无效
+*/
+ErrorStatus Mod_Config_Commit(void)
+{
+    Mod_Config_Entry_Type entry;
+    uint16_t offset = 0;
+
+    Mod_Config_State.txn_open = 0;
+    if (Mod_Config_State.txn_num == 0)
+    {
+        return SUCCESS;
+    }
+    if (Mod_Config_Count_Keys() > MOD_CONFIG_KEYS_MAXNUM)
+    {
+        return ERROR;
+    }
+    // 最后一个条目带提交标志, 然后计算 CRC
+    Mod_Config_State.txn[Mod_Config_State.txn_last + 3] &= (uint8_t)~MOD_CONFIG_FLAG_COMMIT;
+    for (uint16_t i = 0; i < Mod_Config_State.txn_size; i += MOD_CONFIG_ENTRY_HEADER_SIZE + entry.len)
+    {
+        memcpy(&entry, Mod_Config_State.txn + i, MOD_CONFIG_ENTRY_HEADER_SIZE);
+        entry.crc = Mod_Config_CRC(&entry, Mod_Config_State.txn + i + MOD_CONFIG_ENTRY_HEADER_SIZE);
+        memcpy(Mod_Config_State.txn + i, &entry, MOD_CONFIG_ENTRY_HEADER_SIZE);
+    }
+
+    for (uint8_t retry = 0; ; ++retry)
+    {
+        if (Mod_Config_State.offset + Mod_Config_State.txn_size > MOD_FLASH_SECTOR_SIZE
+            || Mod_Config_State.logs + Mod_Config_State.txn_num > MOD_CONFIG_LOG_MAXNUM)
+        {
+            if (Mod_Config_Compact() != SUCCESS)
+            {
+                return ERROR;
+            }
+        }
+        offset = Mod_Config_State.offset;
+        Mod_Flash_Write(Mod_Config_State.txn, Mod_Config_Addr(Mod_Config_State.head) + offset, Mod_Config_State.txn_size);
+        Mod_Config_State.offset += Mod_Config_State.txn_size;
+#if MOD_FLASH_VERIFY_EN
+        if (!Mod_Flash_Compare(Mod_Config_State.txn, Mod_Config_Addr(Mod_Config_State.head) + offset, Mod_Config_State.txn_size))
+        {
+            // 整理到下一个扇区后重试一次; 写坏的条目留在原来的扇区
+            Mod_Config_State.offset = MOD_FLASH_SECTOR_SIZE;
+            if (retry == 0)
+            {
+                continue;
+            }
+            return ERROR;
+        }
+#endif
+        break;
+    }
+
+    for (uint16_t i = 0; i < Mod_Config_State.txn_size; i += MOD_CONFIG_ENTRY_HEADER_SIZE + entry.len)
+    {
+        memcpy(&entry, Mod_Config_State.txn + i, MOD_CONFIG_ENTRY_HEADER_SIZE);
+        Mod_Config_Apply(&entry, offset + i, Mod_Config_State.txn + i + MOD_CONFIG_ENTRY_HEADER_SIZE);
+    }
+    Mod_Config_State.logs += Mod_Config_State.txn_num;
+    ++Mod_Config_Stat.commits;
+    return SUCCESS;
+}
+
+/*
+ * @brief   读取配置存储的统计
+*/
+void Mod_Config_Get_Stat(Mod_Config_Stat_Type *const stat)
+{
+    Mod_Config_Stat.keys = Mod_Config_State.keys;
+    Mod_Config_Stat.used = Mod_Config_State.offset;
+    *stat = Mod_Config_Stat;
+}
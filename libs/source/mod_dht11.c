@@ -1,10 +1,14 @@
 #include "mod_dht11.h"
 #include "lib_tool.h"
 #include "lib_usart.h"
+#include "lib_log.h"
 #include "lib_i2c.h"
 #include "mod_oled.h"
 #include "lib_spi.h"
 #include "mod_flash.h"
+#include "mod_record.h"
+#include "mod_config.h"
+#include "lib_rtc.h"
 #include "ff.h"
 
 /*
@@ -16,6 +20,9 @@ static void Mod_DHT11_GPIO_Init(void);
 static void Mod_DHT11_Change_Output_Type(const uint8_t opt);
 static Mod_DHT11_Data_Type Mod_DHT11_Once_Com(void);
 static void Mod_DHT11_Error(const Mod_DHT11_Error_Type error_idx);
+static uint32_t Mod_DHT11_Config_Init(void);
+static void Mod_DHT11_Log_Init(void);
+static void Mod_DHT11_Log_Append(const Mod_DHT11_Data_Type data);
 
 /*
  * @brief   使 DATA 引脚输出高电平
@@ -227,29 +234,34 @@ static void Mod_DHT11_Error(const Mod_DHT11_Error_Type error_idx)
     while (1);
 }
 
-// 返回绝对值
-#define    Mod_DHT11_Abs(num)      (num < 0 ? -num : num)
-
 /*
  * @brief   DHT11 温湿度传感器的任务: 读取实时温湿度数据, 周期为2s.
  * @param   无
  * @return  无
+ * @note    记录的时间戳来自 RTC, 需要在 SystemClock_Config() 中选择 LSE 作为 RTC 的时钟
 */
 void Mod_DHT11_Task(void)
 {
     Mod_Oled_Pos_Type pos = {0, 0};
     FATFS fs;
+    uint8_t temp_str[LIB_USART_NUM_BUFFER_SIZE] = {0}, humi_str[LIB_USART_NUM_BUFFER_SIZE] = {0};
+    uint16_t temp_abs = 0;
+    uint32_t interval = 0;
 
     Lib_Tool_Init();
     Lib_USART_Init();
+    // RTC, 记录的时间戳
+    Lib_RTC_Init();
     // OLED
-    Lib_I2C_Init();
+    Mod_Oled_COM_Init();
     Mod_Oled_Power_Up();
     // Flash
-    Lib_SPI_Init();
+    Mod_Flash_COM_Init();
+    // 配置存储: 波特率, 时区, RTC 时间和采样间隔
+    interval = Mod_DHT11_Config_Init();
     // FatFs
     Mod_Flash_FatFs_Check(&fs);
-    Mod_DHT11_Log_Init("0:/DHT11");
+    Mod_DHT11_Log_Init();
 
     // 配置 DATA 总线
     Mod_DHT11_GPIO_Init();     // 主机开漏输出, DHT11 输入
@@ -262,52 +274,111 @@ void Mod_DHT11_Task(void)
         Real_Time_TempHumi = Mod_DHT11_Once_Com();
         Lib_Tool_SysTick_Delay_ms(100); // 间隔 100ms, 采集数据
         Real_Time_TempHumi = Mod_DHT11_Once_Com();
+        Mod_DHT11_Log_Append(Real_Time_TempHumi);
         
-        // 上位机显示
-        Lib_USART_Send_fString("Temperature: %d.%d\n", Real_Time_TempHumi.temp / 10, Mod_DHT11_Abs(Real_Time_TempHumi.temp % 10));
-        Lib_USART_Send_fString("Humidity: %d.%d\n\n", Real_Time_TempHumi.humi / 10, Real_Time_TempHumi.humi % 10);
+        // temp 和 humi 都是实际值 * 10, 直接按 1 位小数显示, 不经过浮点运算
+        Lib_USART_Scaled2Char(Real_Time_TempHumi.temp, temp_str, 1);
+        Lib_USART_Scaled2Char(Real_Time_TempHumi.humi, humi_str, 1);
+
+        // 上位机显示, 延迟日志只发送数值, 由上位机还原文本 (见 lib_log.h); 参数只能是整数, 负号写在格式字符串中
+        if (Real_Time_TempHumi.temp < 0)
+        {
+            temp_abs = -Real_Time_TempHumi.temp;
+            LIB_LOG("Temperature: -%u.%u\nHumidity: %u.%u\n\n", temp_abs / 10, temp_abs % 10,
+                    Real_Time_TempHumi.humi / 10, Real_Time_TempHumi.humi % 10);
+        }
+        else
+        {
+            temp_abs = Real_Time_TempHumi.temp;
+            LIB_LOG("Temperature: %u.%u\nHumidity: %u.%u\n\n", temp_abs / 10, temp_abs % 10,
+                    Real_Time_TempHumi.humi / 10, Real_Time_TempHumi.humi % 10);
+        }
         
         // OLED 显示
         Mod_Oled_Clear_Screen();
         pos = (Mod_Oled_Pos_Type){0, 0};
-        pos = Mod_Oled_Show_fString(pos, "Temp: %d.%d deg", Real_Time_TempHumi.temp / 10, Mod_DHT11_Abs(Real_Time_TempHumi.temp % 10));
+        pos = Mod_Oled_Show_fString(pos, "Temp: %s deg", (char *)temp_str);
         pos = (Mod_Oled_Pos_Type){pos.page += 2, 0};
-        pos = Mod_Oled_Show_fString(pos, "Humi: %d.%d%%", Real_Time_TempHumi.humi / 10, Real_Time_TempHumi.humi % 10);
+        pos = Mod_Oled_Show_fString(pos, "Humi: %s%%", (char *)humi_str);
 
         // 读取间隔大于 2s
-        Lib_Tool_SysTick_Delay_ms(2000);
+        Lib_Tool_SysTick_Delay_ms((uint16_t)interval);
     }
 }
 
-void Mod_DHT11_Log_Init(const TCHAR* path)
+/*
+ * @brief   从配置存储 (mod_config.h) 读取运行时设置, 没有设置的键保持编译时的默认值
+ * @return  采样间隔 (毫秒), DHT11 要求不小于 2s
+ * @note    1) 需要先 Lib_USART_Init(), Lib_RTC_Init() 和 Mod_Flash_COM_Init()
+ *          2) MOD_CONFIG_KEY_RTC_UNIX 代替 Lib_RTC_Init() 设置的 LIB_RTC_UNIX, 之后仍由 Mod_DHT11_Log_Init() 保证时间戳不减
+ *          3) 无效的波特率和时区不生效, 输出错误
+*/
+static uint32_t Mod_DHT11_Config_Init(void)
 {
-    FRESULT fres;
-    DIR dir;
+    uint32_t baud = 0, ts = 0, interval = 0;
+    int32_t timezone = 0;
 
-    fres = f_opendir(&dir, path);
-    if (fres == FR_NO_PATH)
+    Mod_Config_Init();
+    if (Mod_Config_Get(MOD_CONFIG_KEY_BAUDRATE, &baud, sizeof(baud)) == SUCCESS && Lib_USART_Set_Baud(baud) != SUCCESS)
     {
-        Lib_USART_Send_String("There is no log. Initizlize.\n");
-        fres = f_mkdir(path);
-        if (fres != FR_OK)
-        {
-            Lib_USART_Send_fString("Error: fail to initizlize logs. FRESULT is %d Stop...\n", fres);
-            while (1);
-        }
+        Lib_USART_Send_fString("Error: unsupported baud rate %u.\n", baud);
+    }
+    if (Mod_Config_Get(MOD_CONFIG_KEY_TIMEZONE, &timezone, sizeof(timezone)) == SUCCESS
+        && Lib_RTC_Set_Timezone(timezone) != SUCCESS)
+    {
+        Lib_USART_Send_fString("Error: invalid timezone %d.\n", timezone);
+    }
+    if (Mod_Config_Get(MOD_CONFIG_KEY_RTC_UNIX, &ts, sizeof(ts)) == SUCCESS)
+    {
+        Lib_RTC_Set_Time((Lib_RTC_UnixType)ts);
+    }
+    interval = Mod_Config_Get_U32(MOD_CONFIG_KEY_SAMPLE_INTERVAL, 2000);
+    return interval < 2000 ? 2000 : interval > 60000 ? 60000 : interval;
+}
+
+/*
+ * @brief   温湿度记录: 记录存储 (mod_record.h) 上电恢复, 输出最新的记录的时间戳
+ * @note    1) 需要先 Mod_Flash_COM_Init() 和 Lib_RTC_Init()
+ *          2) Lib_RTC_Init() 把时间设为 LIB_RTC_UNIX (或 MOD_CONFIG_KEY_RTC_UNIX); 早于最新的记录时设为该记录的时间, 保持时间戳不减,
+ *             Mod_Record_Seek() 要求如此
+ *          3) 只读取 O(log n) 个扇区头部和最新的扇区, 不遍历全部记录
+*/
+static void Mod_DHT11_Log_Init(void)
+{
+    uint32_t last = 0;
+
+    Mod_Record_Init();
+    if (Mod_Record_Last_Time(&last) != SUCCESS)
+    {
+        Lib_USART_Send_String("Succeed to initialize logs. No records.\n");
+        return;
     }
-    else if (fres != FR_OK)
+    if ((uint32_t)Lib_RTC_Read_Time() < last)
     {
-        Lib_USART_Send_fString("Error: FRESULT is %d. Stop...\n", fres);
-        while (1);
+        Lib_RTC_Set_Time((Lib_RTC_UnixType)last);
     }
-    Lib_USART_Send_String("Succeed to initialize logs.\n");
+    Lib_USART_Send_fString("Succeed to initialize logs. Last record at %u.\n", last);
 }
 
-void Mod_DHT11_Log_Append(const Mod_DHT11_Data_Type data, const TCHAR* path)
+/*
+ * @brief   追加一条温湿度记录, 时间戳为 RTC 的 Unix 时间
+ * @note    只复制到记录存储的缓存, 凑满一页时编程, 不等待擦除; 每 MOD_DHT11_FLUSH_NUM 条编程一次不满一页的部分
+*/
+static void Mod_DHT11_Log_Append(const Mod_DHT11_Data_Type data)
 {
-    FIL file;
-    FRESULT fres;
+    static uint32_t num = 0;
 
-    fres = f_open(&file, path, FA_OPEN_APPEND | FA_WRITE);
-    f_write()
-}
\ No newline at end of file
+    if (Mod_Record_Append(Lib_RTC_Read_Time(), &data, sizeof(data)) != SUCCESS)
+    {
+        Lib_USART_Send_String("Error: fail to append log.\n");
+    }
+    if (++num >= MOD_DHT11_FLUSH_NUM)
+    {
+        num = 0;
+        Mod_Record_Flush();
+    }
+    else
+    {
+        Mod_Record_Poll();
+    }
+}
@@ -1,16 +1,80 @@
 #include "mod_flash.h"
+#ifndef MOD_FLASH_PORT
 #include "lib_usart.h"
+#endif
 #include "ff.h"
+#include "lib_format.h"
+#include <string.h>
+
+// 后台操作: 擦除或页编程的指令已发出, 不等待 FLASH 完成
+#define MOD_FLASH_OP_NONE              0
+#define MOD_FLASH_OP_ERASE             1
+#define MOD_FLASH_OP_PROGRAM           2
+
+typedef struct
+{
+    volatile uint8_t op;            // MOD_FLASH_OP_*, Mod_Flash_Poll() 发现完成后清零
+    volatile uint8_t suspended;     // 为读取而暂停, 此时 BUSY 为 0 但操作没有完成
+    uint32_t addr;                  // 操作的地址范围, 暂停期间这部分数据不确定, 不能读取
+    uint32_t num;
+    uint32_t resume_time;           // 上一次 ERASE_RESUME 的 DWT 计数
+} Mod_Flash_Pending_Type;
+
+static Mod_Flash_Pending_Type Mod_Flash_Pending;
+static Mod_Flash_Stat_Type Mod_Flash_Stat;
+
+// W25Q64JV 数据手册的参数, Mod_Flash_Detect() 之前或没有 SFDP 时使用
+#define MOD_FLASH_GEOMETRY_DEFAULT                                                          \
+{                                                                                           \
+    .jedec_id = MOD_FLASH_JEDEC_ID,                                                         \
+    .capacity = 8388608,                                                                    \
+    .page_size = MOD_FLASH_PAGE_SIZE,                                                       \
+    .sfdp = 0,                                                                              \
+    .erase =                                                                                \
+    {                                                                                       \
+        {MOD_FLASH_SECTOR_SIZE, MOD_FLASH_W25Q64_SECTOR_ERASE_4KB, 45},                     \
+        {MOD_FLASH_BLOCK_32K_SIZE, MOD_FLASH_W25Q64_BLOCK_ERASE_32KB, 120},                 \
+        {MOD_FLASH_BLOCK_64K_SIZE, MOD_FLASH_W25Q64_BLOCK_ERASE_64KB, 150},                 \
+        {0, 0, 0},                                                                          \
+    },                                                                                      \
+    .program_us = 400,                                                                      \
+    .chip_erase_ms = 20000,                                                                 \
+}
+
+Mod_Flash_Geometry_Type Mod_Flash_Geometry = MOD_FLASH_GEOMETRY_DEFAULT;
+
+// f_mkfs() 的参数: 格式自动选择, FAT 和根目录项数默认, 簇大小和数据区对齐为 MOD_FLASH_FATFS_CLUSTER
+const MKFS_PARM Mod_Flash_FatFs_Format = {FM_ANY, 0, MOD_FLASH_FATFS_CLUSTER / MOD_FLASH_SECTOR_SIZE, 0, MOD_FLASH_FATFS_CLUSTER};
+
+// SFDP (JESD216): 头部 8 字节, 之后是参数头部; 基本参数表 (BFPT) 的 ID 为 0xFF00
+#define MOD_FLASH_SFDP_SIGNATURE       0x50444653                    // "SFDP"
+#define MOD_FLASH_SFDP_BFPT_DWORDS     11                            // 读取 BFPT 的前 11 个 DWORD: 容量, 擦除指令和时间, 页大小
+
+#define MOD_FLASH_PAGES_PER_SECTOR     (MOD_FLASH_SECTOR_SIZE / MOD_FLASH_PAGE_SIZE)
 
 static void Mod_Flash_Wait_Busy();
 static void Mod_Flash_Write_Enable(void);
 static void Mod_Flash_Send_Addr(const uint32_t addr);
+static void Mod_Flash_Read_Start(const uint32_t addr);
 static ErrorStatus Mod_Flash_Write_Page(const uint8_t *const pbuffer, const uint32_t addr, const uint16_t num_write);
+static uint8_t Mod_Flash_Suspend(const uint32_t addr, const uint32_t num);
+static void Mod_Flash_Resume(void);
+static void Mod_Flash_Erase_Cmd(const uint8_t cmd, const uint32_t addr, const uint32_t size);
+static uint8_t Mod_Flash_Page_Diff(const uint8_t *const pbuffer, const uint8_t *const old, uint16_t *const first, uint16_t *const last);
 
-// 读取 JEDCE_ID
+/*
+ * @brief   读取 JEDCE_ID
+ * @note    FLASH 忙碌时不响应; 后台有擦除或编程 (包括暂停中的) 时不访问总线, 返回 Mod_Flash_Detect() 检测到的 ID,
+ *          不等待擦除完成
+*/
 uint32_t Mod_Flash_Read_JEDCE_ID(void)
 {
     uint32_t manufacturer = 0, memory_type = 0, capability = 0;
+
+    if (Mod_Flash_Pending.op != MOD_FLASH_OP_NONE)
+    {
+        return Mod_Flash_Geometry.jedec_id;
+    }
     // 开始通信
     Mod_Flash_COM_Start();
 
@@ -25,6 +89,157 @@ uint32_t Mod_Flash_Read_JEDCE_ID(void)
     return (manufacturer << 16) | (memory_type << 8) | capability;
 }
 
+// 读取 SFDP, 与 FAST_READ 相同: 3 字节地址和 1 个空字节
+static void Mod_Flash_Read_SFDP(uint8_t *const pbuffer, const uint32_t addr, const uint32_t num)
+{
+    Mod_Flash_Sync();
+    Mod_Flash_COM_Start();
+    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_READ_SFDP);
+    Mod_Flash_Send_Addr(addr);
+    Mod_Flash_Send_Byte(LIB_SPI_DUMMY);
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        pbuffer[i] = Mod_Flash_Receive_Byte();
+    }
+    Mod_Flash_COM_Stop();
+}
+
+// SFDP 中的数据都是小端
+static uint32_t Mod_Flash_SFDP_U32(const uint8_t *const pbuffer)
+{
+    return pbuffer[0] | ((uint32_t)pbuffer[1] << 8) | ((uint32_t)pbuffer[2] << 16) | ((uint32_t)pbuffer[3] << 24);
+}
+
+// SFDP 中的时间: (count + 1) * unit
+static uint32_t Mod_Flash_SFDP_Time(const uint32_t count, const uint32_t unit)
+{
+    return (count + 1) * unit;
+}
+
+/*
+ * @brief   从 SFDP 的基本参数表读取容量, 页大小, 擦除指令和时间
+ * @return  SUCCESS; ERROR: 没有 SFDP 或基本参数表太短
+*/
+static ErrorStatus Mod_Flash_Parse_SFDP(Mod_Flash_Geometry_Type *const geometry)
+{
+    // 4 KB 以上的擦除时间单位 (毫秒), 整片擦除的时间单位
+    static const uint16_t erase_unit[4] = {1, 16, 128, 1000};
+    static const uint32_t chip_unit[4] = {16, 256, 4000, 64000};
+    uint8_t header[16] = {0};
+    uint8_t buffer[MOD_FLASH_SFDP_BFPT_DWORDS * 4] = {0};
+    uint32_t dword[MOD_FLASH_SFDP_BFPT_DWORDS] = {0};
+    uint32_t table = 0, bits = 0;
+    uint8_t length = 0, n = 0;
+
+    Mod_Flash_Read_SFDP(header, 0, sizeof(header));
+    if (Mod_Flash_SFDP_U32(header) != MOD_FLASH_SFDP_SIGNATURE || header[5] != 1 || header[8] != 0x00 || header[15] != 0xFF)
+    {
+        return ERROR;
+    }
+    // 第一个参数头部一定是 BFPT
+    length = header[11];
+    table = header[12] | ((uint32_t)header[13] << 8) | ((uint32_t)header[14] << 16);
+    if (length < 9)
+    {
+        return ERROR;
+    }
+    length = length < MOD_FLASH_SFDP_BFPT_DWORDS ? length : MOD_FLASH_SFDP_BFPT_DWORDS;
+    Mod_Flash_Read_SFDP(buffer, table, length * 4u);
+    for (uint8_t i = 0; i < length; ++i)
+    {
+        dword[i] = Mod_Flash_SFDP_U32(&buffer[i * 4]);
+    }
+
+    // DWORD 2: 容量, 最高位为 0 时为位数减 1, 为 1 时为位数的 log2; 超过 24 位地址的部分不使用
+    bits = dword[1] & 0x7FFFFFFF;
+    if (dword[1] & 0x80000000)
+    {
+        geometry->capacity = bits >= 3 + 24 ? MOD_FLASH_CHIP_MAXSIZE : 1u << (bits - 3);
+    }
+    else
+    {
+        geometry->capacity = bits / 8 >= MOD_FLASH_CHIP_MAXSIZE ? MOD_FLASH_CHIP_MAXSIZE : (bits + 1) / 8;
+    }
+    // DWORD 8, 9: 4 种擦除, 大小为 2 的幂
+    memset(geometry->erase, 0, sizeof(geometry->erase));
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        const uint8_t size = (dword[7 + i / 2] >> (16 * (i % 2))) & 0xFF;
+
+        if (size == 0 || size >= 32)
+        {
+            continue;
+        }
+        geometry->erase[n].size = 1u << size;
+        geometry->erase[n].cmd = (dword[7 + i / 2] >> (16 * (i % 2) + 8)) & 0xFF;
+        // DWORD 10: 各种擦除的典型时间, 每种 5 位计数和 2 位单位
+        if (length >= 10)
+        {
+            geometry->erase[n].time_ms = Mod_Flash_SFDP_Time((dword[9] >> (4 + 7 * i)) & 0x1F,
+                                                             erase_unit[(dword[9] >> (9 + 7 * i)) & 0x3]);
+        }
+        ++n;
+    }
+    // 按大小排序, 最多 4 个
+    for (uint8_t i = 1; i < n; ++i)
+    {
+        for (uint8_t j = i; j > 0 && geometry->erase[j].size < geometry->erase[j - 1].size; --j)
+        {
+            const Mod_Flash_Erase_Type t = geometry->erase[j];
+
+            geometry->erase[j] = geometry->erase[j - 1];
+            geometry->erase[j - 1] = t;
+        }
+    }
+    // DWORD 11: 页大小, 页编程和整片擦除的典型时间
+    if (length >= 11)
+    {
+        geometry->page_size = 1u << ((dword[10] >> 4) & 0xF);
+        geometry->program_us = Mod_Flash_SFDP_Time((dword[10] >> 8) & 0x1F, (dword[10] >> 13) & 1 ? 64 : 8);
+        geometry->chip_erase_ms = Mod_Flash_SFDP_Time((dword[10] >> 24) & 0x1F, chip_unit[(dword[10] >> 29) & 0x3]);
+    }
+    geometry->sfdp = 1;
+    return SUCCESS;
+}
+
+/*
+ * @brief   读取 JEDEC ID 和 SFDP, 得到容量, 页大小, 擦除指令和时间, 保存在 Mod_Flash_Geometry
+ * @return  SUCCESS; ERROR: 没有检测到 FLASH, 或页大小, 4 KB 擦除与驱动不符, 此时 jedec_id 为 0, disk_status() 报告没有初始化
+ * @note    1) Mod_Flash_COM_Init() 调用; FatFs (disk_ioctl() 的 GET_SECTOR_COUNT), Mod_Flash_Erase_Range() 的合并,
+ *             FTL, 记录和配置存储的位置都使用检测到的参数, 换用 W25Q32/W25Q128 不需要修改代码
+ *          2) 没有 SFDP 的旧芯片: 容量按 JEDEC ID 的最后一个字节 (2 的幂) 推算, 擦除指令和时间使用 W25Q64 的值
+ *          3) 读取约 60 字节, 几十微秒
+*/
+ErrorStatus Mod_Flash_Detect(void)
+{
+    static const Mod_Flash_Geometry_Type fallback = MOD_FLASH_GEOMETRY_DEFAULT;
+    Mod_Flash_Geometry_Type geometry = fallback;
+    const uint32_t id = Mod_Flash_Read_JEDCE_ID();
+
+    geometry.jedec_id = id;
+    if ((id >> 16) == 0x00 || (id >> 16) == 0xFF)
+    {
+        Mod_Flash_Geometry.jedec_id = 0;
+        return ERROR;
+    }
+    if (Mod_Flash_Parse_SFDP(&geometry) != SUCCESS)
+    {
+        geometry = fallback;
+        geometry.jedec_id = id;
+        // 容量字节为 log2(字节数), 例如 W25Q64 为 0x17
+        geometry.capacity = (id & 0xFF) >= 16 && (id & 0xFF) <= 24 ? 1u << (id & 0xFF) : MOD_FLASH_CHIP_MAXSIZE;
+    }
+    if (geometry.page_size != MOD_FLASH_PAGE_SIZE || geometry.erase[0].size != MOD_FLASH_SECTOR_SIZE
+        || geometry.capacity < MOD_FLASH_RECORD_SIZE + MOD_FLASH_CONFIG_SIZE + MOD_FLASH_BLOCK_64K_SIZE)
+    {
+        // 分区地址仍按 W25Q64 计算, 不会下溢
+        geometry = fallback;
+        geometry.jedec_id = 0;
+    }
+    Mod_Flash_Geometry = geometry;
+    return geometry.jedec_id != 0 ? SUCCESS : ERROR;
+}
+
 // 等待 FLASH 忙碌
 static void Mod_Flash_Wait_Busy()
 {
@@ -58,24 +273,185 @@ static void Mod_Flash_Send_Addr(const uint32_t addr)
     Mod_Flash_Send_Byte(addr & 0x0000FF);
 }
 
-// 擦除扇区
-// addr 必须对齐扇区大小
-ErrorStatus Mod_Flash_Erase_Sector(const uint32_t addr)
+/*
+ * @brief   开始擦除扇区, 不等待完成
+ * @param   addr 必须对齐扇区大小
+ * @return  SUCCESS; ERROR: 没有对齐
+ * @note    1) 擦除最长 400 ms, 期间 Mod_Flash_Read() 用 ERASE_SUSPEND 暂停擦除, 读取后继续, 读取只多几十微秒;
+ *             读取正在擦除的扇区时等待擦除完成
+ *          2) 上一个擦除或编程没有完成时先等待
+*/
+ErrorStatus Mod_Flash_Erase_Start(const uint32_t addr)
 {
     if (addr % MOD_FLASH_SECTOR_SIZE != 0)
     {
         return ERROR; // 扇区擦除必须对齐
     }
 
+    Mod_Flash_Erase_Cmd(Mod_Flash_Geometry.erase[0].cmd, addr, MOD_FLASH_SECTOR_SIZE);
+    return SUCCESS;
+}
+
+// 发送擦除指令, 不等待完成; addr 对齐 size, 整片擦除时没有地址
+static void Mod_Flash_Erase_Cmd(const uint8_t cmd, const uint32_t addr, const uint32_t size)
+{
+    Mod_Flash_Sync();
     Mod_Flash_Write_Enable();
+    Mod_Flash_COM_Start();
+    Mod_Flash_Send_Byte(cmd);
+    if (cmd != MOD_FLASH_W25Q64_CHIP_ERASE)
+    {
+        // FLASH 有 24 位地址, MSB 在前
+        Mod_Flash_Send_Addr(addr);
+    }
+    Mod_Flash_Pending.addr = addr;
+    Mod_Flash_Pending.num = size;
+    Mod_Flash_Pending.op = MOD_FLASH_OP_ERASE;
+    Mod_Flash_COM_Stop();
+    ++Mod_Flash_Stat.erase_cmds;
+}
+
+/*
+ * @brief   擦除一段范围, 用 Mod_Flash_Detect() 得到的擦除指令, 总的典型时间最短, 等待完成
+ * @param   addr, len 都必须对齐扇区大小, 不能超出 FLASH
+ * @return  SUCCESS; ERROR: 没有对齐或超出范围, 不做任何擦除
+ * @note    1) 每一步取当前地址对齐, 不超过剩余长度, 且比用 4 KB 擦除更快的最大的块; 整片时用 CHIP_ERASE
+ *          2) W25Q64: 64 KB 块擦除典型 150 ms, 16 次 4 KB 擦除典型 16 * 45 ms = 720 ms
+ *          3) 例如 FatFs 的 CTRL_TRIM (f_mkfs, 删除文件) 和日志清空
+*/
+ErrorStatus Mod_Flash_Erase_Range(const uint32_t addr, const uint32_t len)
+{
+    const Mod_Flash_Erase_Type *const erase = Mod_Flash_Geometry.erase;
+    uint32_t pa = addr, end = addr + len;
+    uint8_t k = 0;
+
+    if (addr % MOD_FLASH_SECTOR_SIZE != 0 || len % MOD_FLASH_SECTOR_SIZE != 0
+        || len > MOD_FLASH_CHIP_SIZE || addr > MOD_FLASH_CHIP_SIZE - len)
+    {
+        return ERROR;
+    }
+
+    if (len == MOD_FLASH_CHIP_SIZE)
+    {
+        Mod_Flash_Erase_Cmd(MOD_FLASH_W25Q64_CHIP_ERASE, 0, MOD_FLASH_CHIP_SIZE);
+        pa = end;
+    }
+    while (pa < end)
+    {
+        for (k = 3; k > 0; --k)
+        {
+            if (erase[k].size != 0 && pa % erase[k].size == 0 && end - pa >= erase[k].size
+                && (erase[k].time_ms == 0 || erase[0].time_ms == 0
+                    || erase[k].time_ms < erase[k].size / MOD_FLASH_SECTOR_SIZE * erase[0].time_ms))
+            {
+                break;
+            }
+        }
+        Mod_Flash_Erase_Cmd(erase[k].cmd, pa, erase[k].size);
+        pa += erase[k].size;
+    }
+    Mod_Flash_Sync();
+    return SUCCESS;
+}
+
+// 擦除扇区, 等待完成
+// addr 必须对齐扇区大小
+ErrorStatus Mod_Flash_Erase_Sector(const uint32_t addr)
+{
+    if (Mod_Flash_Erase_Start(addr) != SUCCESS)
+    {
+        return ERROR;
+    }
+    Mod_Flash_Sync();
+    return SUCCESS;
+}
+
+/*
+ * @brief   检查后台的擦除或编程是否完成, 在主循环或定时中断中调用
+ * @note    1) 只读一次状态寄存器, 不会阻塞; 总线被占用或擦除被暂停时直接返回, 下次再检查
+ *          2) 不调用也可以, 下一个擦除, 编程或 Mod_Flash_Sync() 会等待; 调用后它们不必再读状态
+*/
+void Mod_Flash_Poll(void)
+{
+    uint8_t status = 0;
+
+    if (Mod_Flash_Pending.op == MOD_FLASH_OP_NONE || Mod_Flash_Pending.suspended)
+    {
+        return;
+    }
+    if (!Mod_Flash_COM_Try_Start())
+    {
+        return;
+    }
+    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_READ_STATUS_REGISTER_1);
+    status = Mod_Flash_Receive_Byte();
+    // 占用总线期间主循环不会暂停操作, 可以直接清零
+    if ((status & MOD_FLASH_BUSY_Msk) == 0)
+    {
+        Mod_Flash_Pending.op = MOD_FLASH_OP_NONE;
+    }
+    Mod_Flash_COM_Stop();
+}
+
+/*
+ * @brief   等待后台的擦除或编程完成
+ * @note    例如 FatFs 的 CTRL_SYNC, 断电前, 或读取 JEDEC ID 等 FLASH 忙碌时不响应的指令之前
+*/
+void Mod_Flash_Sync(void)
+{
+    if (Mod_Flash_Pending.op == MOD_FLASH_OP_NONE)
+    {
+        return;
+    }
     Mod_Flash_Wait_Busy();
+    Mod_Flash_Pending.op = MOD_FLASH_OP_NONE;
+}
+
+/*
+ * @brief   是否有擦除或编程没有完成 (以最近一次 Mod_Flash_Poll() 为准)
+*/
+uint8_t Mod_Flash_Is_Busy(void)
+{
+    return Mod_Flash_Pending.op != MOD_FLASH_OP_NONE;
+}
+
+/*
+ * @brief   读取前暂停后台的擦除或编程
+ * @param   addr, num 将要读取的范围
+ * @return  是否已暂停, 为 1 时读取后需要 Mod_Flash_Resume()
+ * @note    读取范围与操作范围重叠时, 暂停期间数据不确定, 改为等待操作完成
+*/
+static uint8_t Mod_Flash_Suspend(const uint32_t addr, const uint32_t num)
+{
+    if (Mod_Flash_Pending.op == MOD_FLASH_OP_NONE)
+    {
+        return 0;
+    }
+    if (addr < Mod_Flash_Pending.addr + Mod_Flash_Pending.num && Mod_Flash_Pending.addr < addr + num)
+    {
+        Mod_Flash_Sync();
+        return 0;
+    }
+    // 距离上一次继续不足 tSUS 时, FLASH 不接受暂停
+    while (Lib_Tool_DWT_Timer_End(Mod_Flash_Pending.resume_time, 1) < MOD_FLASH_SUSPEND_US);
+    // 先标记, Mod_Flash_Poll() 不会把暂停后的 BUSY 为 0 当作完成
+    Mod_Flash_Pending.suspended = 1;
     Mod_Flash_COM_Start();
-    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_SECTOR_ERASE_4KB);
-    // FLASH 有 24 位地址, 需对齐 4KB, MSB 在前
-    Mod_Flash_Send_Addr(addr);
+    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_ERASE_SUSPEND);
     Mod_Flash_COM_Stop();
+    // 最多 tSUS 后 BUSY 为 0; 操作已经完成时 FLASH 忽略暂停指令
     Mod_Flash_Wait_Busy();
-    return SUCCESS;
+    return 1;
+}
+
+// 继续被暂停的擦除或编程
+static void Mod_Flash_Resume(void)
+{
+    Mod_Flash_COM_Start();
+    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_ERASE_RESUME);
+    Mod_Flash_COM_Stop();
+    Mod_Flash_Pending.resume_time = Lib_Tool_DWT_Timer_Start();
+    Mod_Flash_Pending.suspended = 0;
 }
 
 // 若 addr 与页大小对齐, num_write 要不大于页大小
@@ -90,16 +466,17 @@ static ErrorStatus Mod_Flash_Write_Page(const uint8_t *const pbuffer, const uint
         return ERROR; // 写入数据大于剩余页大小
     }
 
+    // 等待上一页编程完成, 最后一页的编程在后台完成
+    Mod_Flash_Sync();
     Mod_Flash_Write_Enable();
     Mod_Flash_COM_Start();
     Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_PAGE_PROGRAM);
     Mod_Flash_Send_Addr(addr);
-    for (uint16_t i = 0; i < num_write; ++i)
-    {
-        Mod_Flash_Send_Byte(pbuffer[i]);
-    }
+    Mod_Flash_Send_Data(pbuffer, num_write);
+    Mod_Flash_Pending.addr = addr;
+    Mod_Flash_Pending.num = num_write;
+    Mod_Flash_Pending.op = MOD_FLASH_OP_PROGRAM;
     Mod_Flash_COM_Stop();
-    Mod_Flash_Wait_Busy();
     return SUCCESS;
 }
 
@@ -107,7 +484,8 @@ static ErrorStatus Mod_Flash_Write_Page(const uint8_t *const pbuffer, const uint
 void Mod_Flash_Write(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t num_write)
 {
     uint32_t num_pages = 0, num_front = 0, num_tail = 0;
-    uint32_t pb = (uint32_t)pbuffer, pa = addr; // pb 指向缓冲区, pa 指向 Flash 地址
+    const uint8_t *pb = pbuffer;                // pb 指向缓冲区, pa 指向 Flash 地址
+    uint32_t pa = addr;
 
     num_front = MOD_FLASH_PAGE_SIZE - addr % MOD_FLASH_PAGE_SIZE; // 头部部分页大小
     if (num_front >= num_write)                                   // 不需要跨页
@@ -123,35 +501,268 @@ void Mod_Flash_Write(const uint8_t *const pbuffer, const uint32_t addr, const ui
         num_pages = (num_write - num_front) / MOD_FLASH_PAGE_SIZE; // 按完整页写入的页数
         num_tail = (num_write - num_front) % MOD_FLASH_PAGE_SIZE;  // 尾部剩余的部分页
         // 写入头部部分页
-        Mod_Flash_Write_Page((uint8_t *)pb, pa, num_front);
+        Mod_Flash_Write_Page(pb, pa, num_front);
         pb += num_front;
         pa += num_front;
         // 写入完整页
         for (uint32_t i = 0; i < num_pages; ++i)
         {
-            Mod_Flash_Write_Page((uint8_t *)pb, pa, MOD_FLASH_PAGE_SIZE);
+            Mod_Flash_Write_Page(pb, pa, MOD_FLASH_PAGE_SIZE);
             pb += MOD_FLASH_PAGE_SIZE;
             pa += MOD_FLASH_PAGE_SIZE;
         }
         // 写入尾部剩余剩余页
         if (num_tail > 0)
         {
-            Mod_Flash_Write_Page((uint8_t *)pb, pa, num_tail);
+            Mod_Flash_Write_Page(pb, pa, num_tail);
         }
     }
 }
 
+// 开始通信并发送读取指令, 地址和空字节; 之后 FLASH 从 addr 开始连续输出数据, 直到通信结束
+static void Mod_Flash_Read_Start(const uint32_t addr)
+{
+    uint8_t header[4 + MOD_FLASH_READ_DUMMY] = {0};
+
+    header[0] = MOD_FLASH_READ_CMD;
+    header[1] = (addr & 0xFF0000) >> 16;    // MSB 在前
+    header[2] = (addr & 0x00FF00) >> 8;
+    header[3] = addr & 0x0000FF;
+    // 空字节为 0; 几个字节的头部用轮询连续发送, 比 DMA 的配置快
+    Mod_Flash_COM_Start();
+    Mod_Flash_Send_Burst(header, sizeof(header));
+}
+
 // 读取 Flash 没有地址对齐的要求
+// 数据用 DMA 直接接收到 pbuffer; 后台有擦除或编程时先暂停, 读取后继续
 void Mod_Flash_Read(uint8_t *const pbuffer, const uint32_t addr, const uint32_t num_read)
 {
-    Mod_Flash_COM_Start();
-    Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_READ_DATA); // flash 开始读取, 就会一直发送数据, 直到通信结束
-    Mod_Flash_Send_Addr(addr);
-    for (uint32_t i = 0; i < num_read; ++i)
+    uint8_t suspended = Mod_Flash_Suspend(addr, num_read);
+
+    Mod_Flash_Read_Start(addr);
+    Mod_Flash_Receive_Data(pbuffer, num_read);
+    Mod_Flash_COM_Stop();
+    if (suspended)
     {
-        pbuffer[i] = Mod_Flash_Receive_Byte();
+        Mod_Flash_Resume();
+    }
+}
+
+/*
+ * @brief   分散读取: 从 addr 开始的连续数据依次读取到 vector 中的各个缓冲区
+ * @param   vector      缓冲区和字节数, num 可以为 0
+ *          num_vector  vector 的个数
+ *          addr        FLASH 地址, 没有对齐要求
+ * @note    整个读取只有一个片选周期, 只发送一次指令和地址, 例如 FatFs 的多个扇区读取到不连续的缓冲区
+*/
+void Mod_Flash_Read_Vector(const Mod_Flash_Vector_Type *const vector, const uint32_t num_vector, const uint32_t addr)
+{
+    uint32_t num_read = 0;
+    uint8_t suspended = 0;
+
+    for (uint32_t i = 0; i < num_vector; ++i)
+    {
+        num_read += vector[i].num;
+    }
+    suspended = Mod_Flash_Suspend(addr, num_read);
+    Mod_Flash_Read_Start(addr);
+    for (uint32_t i = 0; i < num_vector; ++i)
+    {
+        Mod_Flash_Receive_Data(vector[i].buffer, vector[i].num);
     }
     Mod_Flash_COM_Stop();
+    if (suspended)
+    {
+        Mod_Flash_Resume();
+    }
+}
+
+/*
+ * @brief   比较一页的新数据与 FLASH 中的数据
+ * @param   pbuffer     新数据, MOD_FLASH_PAGE_SIZE 字节
+ *          old         FLASH 中的数据; 为 0 表示已擦除 (全为 0xFF)
+ *          first, last 需要编程的范围 (包含 last); first > last 表示内容相同
+ * @return  1: 有位需要从 0 变为 1, 只能擦除后编程, 此时 first, last 不完整; 0: 可以直接编程
+*/
+static uint8_t Mod_Flash_Page_Diff(const uint8_t *const pbuffer, const uint8_t *const old, uint16_t *const first, uint16_t *const last)
+{
+    uint8_t o = 0;
+
+    *first = MOD_FLASH_PAGE_SIZE;
+    *last = 0;
+    for (uint16_t i = 0; i < MOD_FLASH_PAGE_SIZE; ++i)
+    {
+        o = old != (void *)0 ? old[i] : 0xFF;
+        if (pbuffer[i] == o)
+        {
+            continue;
+        }
+        if ((pbuffer[i] & o) != pbuffer[i])
+        {
+            return 1;
+        }
+        if (*first == MOD_FLASH_PAGE_SIZE)
+        {
+            *first = i;
+        }
+        *last = i;
+    }
+    return 0;
+}
+
+// 编程一页中 first 到 last 的部分 (包含 last), first > last 时跳过
+static void Mod_Flash_Program_Span(const uint8_t *const pbuffer, const uint32_t addr, const uint16_t first, const uint16_t last)
+{
+    if (first > last)
+    {
+        ++Mod_Flash_Stat.pages_skipped;
+        return;
+    }
+    Mod_Flash_Write_Page(pbuffer + first, addr + first, last - first + 1);
+    ++Mod_Flash_Stat.pages_programmed;
+    Mod_Flash_Stat.bytes_programmed += last - first + 1;
+}
+
+/*
+ * @brief   比较一个扇区, 不需要擦除时直接编程变化的部分
+ * @return  0: 已完成 (内容相同或只有 1 变为 0); 1: 需要擦除, 没有做任何修改
+ * @note    逐页读取, 发现需要擦除就停止
+*/
+static uint8_t Mod_Flash_Sector_Delta(const uint8_t *const pbuffer, const uint32_t addr)
+{
+    uint8_t page[MOD_FLASH_PAGE_SIZE];
+    uint16_t first[MOD_FLASH_PAGES_PER_SECTOR], last[MOD_FLASH_PAGES_PER_SECTOR];
+    uint32_t skipped = Mod_Flash_Stat.pages_skipped;
+
+    for (uint32_t i = 0; i < MOD_FLASH_PAGES_PER_SECTOR; ++i)
+    {
+        Mod_Flash_Read(page, addr + i * MOD_FLASH_PAGE_SIZE, MOD_FLASH_PAGE_SIZE);
+        if (Mod_Flash_Page_Diff(pbuffer + i * MOD_FLASH_PAGE_SIZE, page, &first[i], &last[i]))
+        {
+            return 1;
+        }
+    }
+    for (uint32_t i = 0; i < MOD_FLASH_PAGES_PER_SECTOR; ++i)
+    {
+        Mod_Flash_Program_Span(pbuffer + i * MOD_FLASH_PAGE_SIZE, addr + i * MOD_FLASH_PAGE_SIZE, first[i], last[i]);
+    }
+    ++Mod_Flash_Stat.erases_avoided;
+    if (Mod_Flash_Stat.pages_skipped - skipped == MOD_FLASH_PAGES_PER_SECTOR)
+    {
+        ++Mod_Flash_Stat.sectors_skipped;
+    }
+    return 0;
+}
+
+// 编程已擦除的扇区, 跳过全为 0xFF 的部分
+static void Mod_Flash_Sector_Program(const uint8_t *const pbuffer, const uint32_t addr)
+{
+    uint16_t first = 0, last = 0;
+
+    for (uint32_t i = 0; i < MOD_FLASH_PAGES_PER_SECTOR; ++i)
+    {
+        Mod_Flash_Page_Diff(pbuffer + i * MOD_FLASH_PAGE_SIZE, (void *)0, &first, &last);
+        Mod_Flash_Program_Span(pbuffer + i * MOD_FLASH_PAGE_SIZE, addr + i * MOD_FLASH_PAGE_SIZE, first, last);
+    }
+}
+
+/*
+ * @brief   写入连续的多个扇区: 先比较, 只在需要时擦除, 只编程变化的部分, 最后读出校验
+ * @param   pbuffer     新数据, count * MOD_FLASH_SECTOR_SIZE 字节
+ *          addr        必须对齐扇区大小
+ *          count       扇区数
+ * @return  SUCCESS; ERROR: 没有对齐, 或校验失败 (MOD_FLASH_VERIFY_EN)
+ * @note    1) 按 64 KB 块分组处理: 先逐个比较, 内容相同的页跳过, 只有 1 变为 0 的扇区直接编程;
+ *             剩下需要擦除的扇区中连续的部分用一次 Mod_Flash_Erase_Range() 擦除 (对齐时用 32 KB / 64 KB 块擦除),
+ *             再编程不全为 0xFF 的部分
+ *          2) FLASH 不能同时擦除和编程, 所以先集中擦除再编程; 块擦除 64 KB 典型 150 ms, 逐扇区擦除典型 720 ms
+ *          3) 需要 MOD_FLASH_PAGE_SIZE 字节的栈; 比较每个扇区约 1 ms, 校验约 1 ms
+*/
+ErrorStatus Mod_Flash_Write_Sectors(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t count)
+{
+    uint32_t n = 0, a = 0, j = 0;
+    uint16_t erase = 0;     // 块中需要擦除的扇区
+
+    if (addr % MOD_FLASH_SECTOR_SIZE != 0)
+    {
+        return ERROR;
+    }
+    for (uint32_t w = 0; w < count; w += n)
+    {
+        // 到下一个 64 KB 边界为止
+        a = addr + w * MOD_FLASH_SECTOR_SIZE;
+        n = (MOD_FLASH_BLOCK_64K_SIZE - a % MOD_FLASH_BLOCK_64K_SIZE) / MOD_FLASH_SECTOR_SIZE;
+        n = n < count - w ? n : count - w;
+        erase = 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            erase |= Mod_Flash_Sector_Delta(pbuffer + (w + i) * MOD_FLASH_SECTOR_SIZE, a + i * MOD_FLASH_SECTOR_SIZE) << i;
+        }
+        for (uint32_t i = 0; i < n; i = j)
+        {
+            for (j = i; j < n && ((erase >> j) & 1); ++j);
+            if (j == i)
+            {
+                ++j;
+                continue;
+            }
+            Mod_Flash_Erase_Range(a + i * MOD_FLASH_SECTOR_SIZE, (j - i) * MOD_FLASH_SECTOR_SIZE);
+            Mod_Flash_Stat.erases += j - i;
+            for (uint32_t k = i; k < j; ++k)
+            {
+                Mod_Flash_Sector_Program(pbuffer + (w + k) * MOD_FLASH_SECTOR_SIZE, a + k * MOD_FLASH_SECTOR_SIZE);
+            }
+        }
+#if MOD_FLASH_VERIFY_EN
+        if (!Mod_Flash_Compare(pbuffer + w * MOD_FLASH_SECTOR_SIZE, a, n * MOD_FLASH_SECTOR_SIZE))
+        {
+            ++Mod_Flash_Stat.verify_errors;
+            return ERROR;
+        }
+#endif
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   更新一个扇区, 见 Mod_Flash_Write_Sectors()
+*/
+ErrorStatus Mod_Flash_Update_Sector(const uint8_t *const pbuffer, const uint32_t addr)
+{
+    return Mod_Flash_Write_Sectors(pbuffer, addr, 1);
+}
+
+/*
+ * @brief   比较 FLASH 中的数据与 pbuffer 是否相同
+ * @return  1: 相同; 0: 不同
+ * @note    逐页读取, 需要 MOD_FLASH_PAGE_SIZE 字节的栈; 发现不同就停止
+*/
+uint8_t Mod_Flash_Compare(const uint8_t *const pbuffer, const uint32_t addr, const uint32_t num)
+{
+    uint8_t page[MOD_FLASH_PAGE_SIZE];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < num; i += n)
+    {
+        n = num - i > MOD_FLASH_PAGE_SIZE ? MOD_FLASH_PAGE_SIZE : num - i;
+        Mod_Flash_Read(page, addr + i, n);
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            if (page[j] != pbuffer[i + j])
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * @brief   读取 Mod_Flash_Write_Sectors() 的统计
+*/
+void Mod_Flash_Get_Stat(Mod_Flash_Stat_Type *const stat)
+{
+    *stat = Mod_Flash_Stat;
 }
 
 /*
@@ -168,7 +779,7 @@ void Mod_Flash_FatFs_Check(FATFS* fs)
         Lib_USART_Send_String("No Fatfs. Start to create.\n");
         // 创建文件系统
         BYTE work[FF_MAX_SS];                            // 创建文件系统需要工作缓冲区, 最少为 FF_MAX_SS
-        fres = f_mkfs("0:", (void *)0, work, FF_MAX_SS); // 使用默认参数初始化
+        fres = f_mkfs("0:", &Mod_Flash_FatFs_Format, work, FF_MAX_SS); // 簇大小为 MOD_FLASH_FATFS_CLUSTER
         if (fres == FR_OK)                               // 成功创建
         {
             Lib_USART_Send_String("Have created FatFs sucessfully.\n");
@@ -190,4 +801,28 @@ void Mod_Flash_FatFs_Check(FATFS* fs)
     {
         Lib_USART_Send_String("FatFs exsisted, and succeed to mount.\n");
     }
-}
\ No newline at end of file
+}
+
+// 格式化输出函数, arg 为已打开的文件
+static void Mod_Flash_FatFs_Sink(void *const arg, const char *const data, const uint32_t num)
+{
+    UINT bw = 0;
+    f_write((FIL *)arg, data, num, &bw);
+}
+
+/*
+ * @brief   格式化写入文件, FatFs 未开启 f_printf (FF_USE_STRFUNC 为 0), 用 lib_format 代替
+ * @param   fp  以 FA_WRITE 打开的文件
+ *          str 格式字符串, 格式见 lib_format.h
+ * @return  格式化结果的字节数; 写入失败的部分不会重试, 可用 f_error() 检查
+*/
+UINT Mod_Flash_FatFs_Printf(FIL *const fp, const char *const str, ...)
+{
+    UINT num = 0;
+    va_list ap;
+
+    va_start(ap, str);
+    num = Lib_Format_vPrint(Mod_Flash_FatFs_Sink, fp, str, ap);
+    va_end(ap);
+    return num;
+}
@@ -0,0 +1,514 @@
+#include "mod_ftl.h"
+#include <string.h>
+
+#define MOD_FTL_MAGIC                  0x314C5446                    // "FTL1"
+#define MOD_FTL_BANK_SIZE              (MOD_FTL_BANK_SECTORS * MOD_FLASH_SECTOR_SIZE)
+#define MOD_FTL_SNAPSHOT_OFFSET        MOD_FLASH_PAGE_SIZE           // 快照在日志区中的位置, 第一页为头部
+#define MOD_FTL_SNAPSHOT_SIZE          (Mod_FTL_State.logical * 2)
+// 记录从快照之后的下一页开始
+#define Mod_FTL_Journal_Offset(size)   (MOD_FTL_SNAPSHOT_OFFSET + ((size) + MOD_FLASH_PAGE_SIZE - 1) / MOD_FLASH_PAGE_SIZE * MOD_FLASH_PAGE_SIZE)
+#define MOD_FTL_JOURNAL_OFFSET         Mod_FTL_Journal_Offset(MOD_FTL_SNAPSHOT_SIZE)
+
+#if Mod_FTL_Journal_Offset(MOD_FTL_LOGICAL_MAXNUM * 2) >= MOD_FTL_BANK_SIZE
+    #error "MOD_FTL_BANK_SECTORS is too small for the snapshot"
+#endif
+#if MOD_FTL_FLASH_MAXSIZE > MOD_FLASH_CHIP_MAXSIZE || MOD_FTL_FLASH_MAXSIZE % MOD_FLASH_BLOCK_64K_SIZE
+    #error "MOD_FTL_FLASH_MAXSIZE must be a multiple of 64 KB and at most MOD_FLASH_CHIP_MAXSIZE"
+#endif
+#if MOD_FTL_SPARE < 2
+    #error "MOD_FTL_SPARE must be at least 2"
+#endif
+#if MOD_FTL_ERASED_NUM < 1 || MOD_FTL_ERASED_NUM > MOD_FTL_SPARE - 2
+    #error "MOD_FTL_ERASED_NUM must be in [1, MOD_FTL_SPARE - 2]"
+#endif
+
+// 日志区头部, 快照写完后最后写入
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;               // 每次写快照加 1, 上电时使用较大的一个
+    uint32_t logical;           // 逻辑扇区数, 与配置不同时视为无效
+    uint32_t check;             // ~(magic ^ seq ^ logical)
+} Mod_FTL_Header_Type;
+
+// 一次映射修改; 全为 0xFF 表示日志结束, check 不对 (写入时掉电) 的记录跳过
+typedef struct
+{
+    uint16_t lba;
+    uint16_t pba;               // MOD_FTL_NONE 表示取消映射
+    uint32_t check;             // ~((lba << 16) | pba)
+} Mod_FTL_Record_Type;
+
+typedef struct
+{
+    uint16_t map[MOD_FTL_LOGICAL_MAXNUM];           // 逻辑扇区 -> 物理扇区
+    uint8_t used[(MOD_FTL_SECTORS_MAXNUM + 7) / 8]; // 物理扇区是否被映射
+    uint16_t sectors;                               // 管理的物理扇区数, 按 FLASH 容量确定
+    uint16_t logical;                               // 逻辑扇区数
+    uint32_t seq;
+    uint8_t bank;                                   // 正在使用的日志区, 0 或 1
+    uint32_t journal;                               // 下一条记录的地址
+    uint16_t next;                                  // 分配空闲扇区的游标
+    uint16_t erased[MOD_FTL_ERASED_NUM];            // 已经开始擦除的空闲扇区, 先进先出
+    uint8_t erased_head;                            // 最早的一个在 erased 中的下标
+    uint8_t erased_num;
+    uint16_t cold;                                  // 静态磨损均衡的游标
+    uint32_t count;                                 // 距离上一次搬动的写入次数
+} Mod_FTL_State_Type;
+
+static Mod_FTL_State_Type Mod_FTL_State;
+static Mod_FTL_Stat_Type Mod_FTL_Stat;
+
+#define Mod_FTL_Addr(pba)              ((uint32_t)(pba) * MOD_FLASH_SECTOR_SIZE)
+#define Mod_FTL_Bank_Addr(bank)        ((uint32_t)(bank) * MOD_FTL_BANK_SIZE)
+#define Mod_FTL_Is_Used(pba)           ((Mod_FTL_State.used[(pba) / 8] >> ((pba) % 8)) & 1)
+#define Mod_FTL_Set_Used(pba)          (Mod_FTL_State.used[(pba) / 8] |= 1 << ((pba) % 8))
+#define Mod_FTL_Clear_Used(pba)        (Mod_FTL_State.used[(pba) / 8] &= ~(1 << ((pba) % 8)))
+#define Mod_FTL_Is_Pool(pba)           ((pba) >= MOD_FTL_POOL_START && (pba) < Mod_FTL_State.sectors)
+
+static void Mod_FTL_Checkpoint(void);
+
+// 空闲扇区是否已经预先擦除
+static uint8_t Mod_FTL_Is_Erased(const uint16_t pba)
+{
+    for (uint8_t i = 0; i < Mod_FTL_State.erased_num; ++i)
+    {
+        if (Mod_FTL_State.erased[(Mod_FTL_State.erased_head + i) % MOD_FTL_ERASED_NUM] == pba)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * @brief   找到下一个没有预先擦除的空闲物理扇区, 从游标开始轮流
+ * @note    空闲扇区至少有 MOD_FTL_SPARE - 1 个 (写入期间新旧两个扇区都被占用), 其中预先擦除的不超过
+ *          MOD_FTL_SPARE - 2 个, 一定能找到
+*/
+static uint16_t Mod_FTL_Find_Free(void)
+{
+    uint16_t pba = Mod_FTL_State.next;
+
+    do
+    {
+        pba = pba + 1 < Mod_FTL_State.sectors ? pba + 1 : MOD_FTL_POOL_START;
+    } while (Mod_FTL_Is_Used(pba) || Mod_FTL_Is_Erased(pba));
+    Mod_FTL_State.next = pba;
+    return pba;
+}
+
+// 把空闲扇区加到预先擦除的队列末尾
+static void Mod_FTL_Push_Erased(const uint16_t pba)
+{
+    Mod_FTL_State.erased[(Mod_FTL_State.erased_head + Mod_FTL_State.erased_num) % MOD_FTL_ERASED_NUM] = pba;
+    ++Mod_FTL_State.erased_num;
+}
+
+// 在后台擦除下一个空闲扇区, 之后的写入直接使用; 队列已满时不做任何事
+static void Mod_FTL_Pre_Erase(void)
+{
+    uint16_t pba = 0;
+
+    if (Mod_FTL_State.erased_num >= MOD_FTL_ERASED_NUM)
+    {
+        return;
+    }
+    pba = Mod_FTL_Find_Free();
+    Mod_Flash_Erase_Start(Mod_FTL_Addr(pba));
+    Mod_FTL_Push_Erased(pba);
+}
+
+// 分配最早预先擦除 (或正在擦除) 的空闲扇区, 标记为占用
+static uint16_t Mod_FTL_Alloc(void)
+{
+    uint16_t pba = 0;
+
+    if (Mod_FTL_State.erased_num == 0)
+    {
+        ++Mod_FTL_Stat.erase_waits;
+        Mod_FTL_Pre_Erase();
+    }
+    pba = Mod_FTL_State.erased[Mod_FTL_State.erased_head];
+    Mod_FTL_State.erased_head = (Mod_FTL_State.erased_head + 1) % MOD_FTL_ERASED_NUM;
+    --Mod_FTL_State.erased_num;
+    Mod_FTL_Set_Used(pba);
+    return pba;
+}
+
+// 整个物理扇区是否全为 0xFF, 逐页读取
+static uint8_t Mod_FTL_Is_Blank(const uint16_t pba)
+{
+    uint32_t page[MOD_FLASH_PAGE_SIZE / 4];
+
+    for (uint32_t i = 0; i < MOD_FLASH_SECTOR_SIZE; i += MOD_FLASH_PAGE_SIZE)
+    {
+        Mod_Flash_Read((uint8_t *)page, Mod_FTL_Addr(pba) + i, MOD_FLASH_PAGE_SIZE);
+        for (uint32_t j = 0; j < MOD_FLASH_PAGE_SIZE / 4; ++j)
+        {
+            if (page[j] != 0xFFFFFFFF)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * @brief   上电时重建预先擦除的队列: 检查游标之后的空闲扇区, 全为 0xFF 的加入队列
+ * @note    1) 预先擦除的扇区按游标的顺序分配, 最多检查 2 * MOD_FTL_ERASED_NUM 个; 跳过的扇区以后轮到时再擦除
+ *          2) 擦除中途掉电的扇区读出有 0 时跳过; 读出全为 0xFF 但擦除不完全的, 编程后由 MOD_FLASH_VERIFY_EN 的校验发现
+*/
+static void Mod_FTL_Scan_Erased(void)
+{
+    uint16_t pba = 0;
+
+    for (uint32_t i = 0; i < 2 * MOD_FTL_ERASED_NUM && Mod_FTL_State.erased_num < MOD_FTL_ERASED_NUM; ++i)
+    {
+        pba = Mod_FTL_Find_Free();
+        if (Mod_FTL_Is_Blank(pba))
+        {
+            Mod_FTL_Push_Erased(pba);
+        }
+    }
+}
+
+/*
+ * @brief   修改映射并写入记录; 日志区写满时改为写快照
+ * @note    数据必须已经写入 pba; FLASH 的操作依次完成, 记录一定在数据之后生效
+*/
+static void Mod_FTL_Commit(const uint16_t lba, const uint16_t pba)
+{
+    Mod_FTL_Record_Type record = {0};
+    uint16_t old = Mod_FTL_State.map[lba];
+
+    Mod_FTL_State.map[lba] = pba;
+    if (Mod_FTL_Is_Pool(pba))
+    {
+        Mod_FTL_Set_Used(pba);
+    }
+    if (Mod_FTL_Is_Pool(old))
+    {
+        Mod_FTL_Clear_Used(old);
+    }
+
+    if (Mod_FTL_State.journal + sizeof(record) > Mod_FTL_Bank_Addr(Mod_FTL_State.bank) + MOD_FTL_BANK_SIZE)
+    {
+        Mod_FTL_Checkpoint();
+        return;
+    }
+    record.lba = lba;
+    record.pba = pba;
+    record.check = ~(((uint32_t)lba << 16) | pba);
+    Mod_Flash_Write((const uint8_t *)&record, Mod_FTL_State.journal, sizeof(record));
+    Mod_FTL_State.journal += sizeof(record);
+}
+
+/*
+ * @brief   把 RAM 中的映射表写到另一个日志区, 之后切换到该日志区
+ * @note    头部最后写入; 写完前掉电时, 上电仍使用原来的日志区
+*/
+static void Mod_FTL_Checkpoint(void)
+{
+    Mod_FTL_Header_Type header = {0};
+    const uint8_t bank = Mod_FTL_State.bank ^ 1;
+    const uint32_t addr = Mod_FTL_Bank_Addr(bank);
+
+    Mod_Flash_Erase_Range(addr, MOD_FTL_BANK_SIZE);
+    Mod_Flash_Write((const uint8_t *)Mod_FTL_State.map, addr + MOD_FTL_SNAPSHOT_OFFSET, MOD_FTL_SNAPSHOT_SIZE);
+    header.magic = MOD_FTL_MAGIC;
+    header.seq = Mod_FTL_State.seq + 1;
+    header.logical = Mod_FTL_State.logical;
+    header.check = ~(header.magic ^ header.seq ^ header.logical);
+    Mod_Flash_Write((const uint8_t *)&header, addr, sizeof(header));
+
+    Mod_FTL_State.bank = bank;
+    Mod_FTL_State.seq = header.seq;
+    Mod_FTL_State.journal = addr + MOD_FTL_JOURNAL_OFFSET;
+    ++Mod_FTL_Stat.checkpoints;
+}
+
+// 读取日志区头部, 返回是否有效
+static uint8_t Mod_FTL_Read_Header(const uint8_t bank, Mod_FTL_Header_Type *const header)
+{
+    Mod_Flash_Read((uint8_t *)header, Mod_FTL_Bank_Addr(bank), sizeof(*header));
+    return header->magic == MOD_FTL_MAGIC && header->logical == Mod_FTL_State.logical
+           && header->check == ~(header->magic ^ header->seq ^ header->logical);
+}
+
+// 读取快照, 并依次应用之后的记录
+static void Mod_FTL_Replay(void)
+{
+    Mod_FTL_Record_Type record[MOD_FLASH_PAGE_SIZE / sizeof(Mod_FTL_Record_Type)];
+    const uint32_t end = Mod_FTL_Bank_Addr(Mod_FTL_State.bank) + MOD_FTL_BANK_SIZE;
+    uint32_t addr = Mod_FTL_Bank_Addr(Mod_FTL_State.bank) + MOD_FTL_JOURNAL_OFFSET;
+
+    Mod_Flash_Read((uint8_t *)Mod_FTL_State.map, Mod_FTL_Bank_Addr(Mod_FTL_State.bank) + MOD_FTL_SNAPSHOT_OFFSET,
+                   MOD_FTL_SNAPSHOT_SIZE);
+    Mod_FTL_State.journal = addr;
+    for (; addr < end; addr += sizeof(record))
+    {
+        Mod_Flash_Read((uint8_t *)record, addr, sizeof(record));
+        for (uint32_t i = 0; i < sizeof(record) / sizeof(record[0]); ++i)
+        {
+            if (record[i].lba == 0xFFFF && record[i].pba == 0xFFFF && record[i].check == 0xFFFFFFFF)
+            {
+                return;     // 日志结束
+            }
+            Mod_FTL_State.journal = addr + (i + 1) * sizeof(record[0]);
+            if (record[i].check != ~(((uint32_t)record[i].lba << 16) | record[i].pba) || record[i].lba >= Mod_FTL_State.logical)
+            {
+                continue;   // 写入时掉电
+            }
+            Mod_FTL_State.map[record[i].lba] = record[i].pba;
+            if (Mod_FTL_Is_Pool(record[i].pba))
+            {
+                Mod_FTL_State.next = record[i].pba;     // 从最后使用的位置继续轮流
+            }
+        }
+    }
+}
+
+/*
+ * @brief   上电时重建映射表, 没有有效的日志区时格式化 (所有逻辑扇区为空)
+ * @note    1) 需要先 Mod_Flash_COM_Init(); 读取快照和全部记录, 日志区 16 KB 时约 5 ms
+ *          2) 逻辑扇区数由 FatFs 分区的大小确定; 换用不同容量的芯片时与日志区头部不符, 重新格式化
+*/
+void Mod_FTL_Init(void)
+{
+    Mod_FTL_Header_Type header[2];
+    uint8_t valid[2] = {0};
+    const uint32_t sectors = MOD_FLASH_FATFS_SIZE / MOD_FLASH_SECTOR_SIZE;
+
+    Mod_FTL_State.sectors = sectors < MOD_FTL_SECTORS_MAXNUM ? sectors : MOD_FTL_SECTORS_MAXNUM;
+    Mod_FTL_State.logical = Mod_FTL_State.sectors - MOD_FTL_POOL_START - MOD_FTL_SPARE;
+    valid[0] = Mod_FTL_Read_Header(0, &header[0]);
+    valid[1] = Mod_FTL_Read_Header(1, &header[1]);
+    memset(Mod_FTL_State.used, 0, sizeof(Mod_FTL_State.used));
+    Mod_FTL_State.next = MOD_FTL_POOL_START;
+    Mod_FTL_State.erased_head = 0;
+    Mod_FTL_State.erased_num = 0;
+    Mod_FTL_State.cold = 0;
+    Mod_FTL_State.count = 0;
+
+    if (!valid[0] && !valid[1])
+    {
+        memset(Mod_FTL_State.map, 0xFF, sizeof(Mod_FTL_State.map));
+        Mod_FTL_State.bank = 1;
+        Mod_FTL_State.seq = 0;
+        Mod_FTL_Checkpoint();   // 写到日志区 0
+        Mod_FTL_Scan_Erased();
+        return;
+    }
+    // seq 较大的较新, 允许回绕
+    Mod_FTL_State.bank = !valid[0] || (valid[1] && (int32_t)(header[1].seq - header[0].seq) > 0);
+    Mod_FTL_State.seq = header[Mod_FTL_State.bank].seq;
+    Mod_FTL_Replay();
+
+    // 重建使用位图; 超出范围或重复的物理扇区视为损坏, 取消映射
+    for (uint32_t lba = 0; lba < Mod_FTL_State.logical; ++lba)
+    {
+        uint16_t pba = Mod_FTL_State.map[lba];
+        if (pba == MOD_FTL_NONE)
+        {
+            continue;
+        }
+        if (!Mod_FTL_Is_Pool(pba) || Mod_FTL_Is_Used(pba))
+        {
+            Mod_FTL_State.map[lba] = MOD_FTL_NONE;
+            continue;
+        }
+        Mod_FTL_Set_Used(pba);
+    }
+    Mod_FTL_Scan_Erased();
+}
+
+/*
+ * @brief   读取连续的逻辑扇区
+ * @return  SUCCESS; ERROR: 超出范围
+ * @note    物理扇区也连续的部分合并为一次读取; 没有映射的扇区读出全为 0xFF
+*/
+ErrorStatus Mod_FTL_Read(uint8_t *const pbuffer, const uint32_t lba, const uint32_t count)
+{
+    uint32_t n = 0;
+    uint16_t pba = 0;
+
+    if (lba >= Mod_FTL_State.logical || count > Mod_FTL_State.logical - lba)
+    {
+        return ERROR;
+    }
+    for (uint32_t i = 0; i < count; i += n)
+    {
+        pba = Mod_FTL_State.map[lba + i];
+        n = 1;
+        if (pba == MOD_FTL_NONE)
+        {
+            memset(pbuffer + i * MOD_FLASH_SECTOR_SIZE, 0xFF, MOD_FLASH_SECTOR_SIZE);
+            continue;
+        }
+        while (i + n < count && Mod_FTL_State.map[lba + i + n] == pba + n)
+        {
+            ++n;
+        }
+        Mod_Flash_Read(pbuffer + i * MOD_FLASH_SECTOR_SIZE, Mod_FTL_Addr(pba), n * MOD_FLASH_SECTOR_SIZE);
+    }
+    return SUCCESS;
+}
+
+// 静态磨损均衡: 把下一个有映射的逻辑扇区搬到新的物理扇区, 逐页复制
+static void Mod_FTL_Move(void)
+{
+    uint8_t page[MOD_FLASH_PAGE_SIZE];
+    uint16_t lba = Mod_FTL_State.cold, src = 0, dst = 0;
+
+    for (uint32_t i = 0; i < Mod_FTL_State.logical; ++i)
+    {
+        lba = lba + 1 < Mod_FTL_State.logical ? lba + 1 : 0;
+        if (Mod_FTL_State.map[lba] != MOD_FTL_NONE)
+        {
+            break;
+        }
+    }
+    Mod_FTL_State.cold = lba;
+    src = Mod_FTL_State.map[lba];
+    if (src == MOD_FTL_NONE)
+    {
+        return;     // 没有任何数据
+    }
+    dst = Mod_FTL_Alloc();
+    for (uint32_t i = 0; i < MOD_FLASH_SECTOR_SIZE; i += MOD_FLASH_PAGE_SIZE)
+    {
+        Mod_Flash_Read(page, Mod_FTL_Addr(src) + i, MOD_FLASH_PAGE_SIZE);
+        Mod_Flash_Write(page, Mod_FTL_Addr(dst) + i, MOD_FLASH_PAGE_SIZE);
+    }
+    Mod_FTL_Commit(lba, dst);
+    ++Mod_FTL_Stat.moves;
+}
+
+/*
+ * @brief   写入一个逻辑扇区
+ * @param   pbuffer MOD_FLASH_SECTOR_SIZE 字节
+ * @return  SUCCESS; ERROR: 超出范围, 或读出校验失败 (MOD_FLASH_VERIFY_EN)
+ * @note    1) 内容与原来相同时不写入; 否则写到已在后台擦除的空闲扇区, 不等待擦除 (除非上一次擦除还没有完成)
+ *          2) 最后一页的编程和记录在后台完成, 断电前需要 Mod_Flash_Sync()
+*/
+ErrorStatus Mod_FTL_Write(const uint8_t *const pbuffer, const uint32_t lba)
+{
+    uint16_t pba = 0;
+
+    if (lba >= Mod_FTL_State.logical)
+    {
+        return ERROR;
+    }
+    pba = Mod_FTL_State.map[lba];
+    if (pba != MOD_FTL_NONE && Mod_Flash_Compare(pbuffer, Mod_FTL_Addr(pba), MOD_FLASH_SECTOR_SIZE))
+    {
+        ++Mod_FTL_Stat.skipped;
+        return SUCCESS;
+    }
+
+    pba = Mod_FTL_Alloc();
+    Mod_Flash_Write(pbuffer, Mod_FTL_Addr(pba), MOD_FLASH_SECTOR_SIZE);
+#if MOD_FLASH_VERIFY_EN
+    // 校验失败时不修改映射, 原来的数据仍然有效
+    if (!Mod_Flash_Compare(pbuffer, Mod_FTL_Addr(pba), MOD_FLASH_SECTOR_SIZE))
+    {
+        Mod_FTL_Clear_Used(pba);
+        return ERROR;
+    }
+#endif
+    Mod_FTL_Commit(lba, pba);
+    ++Mod_FTL_Stat.writes;
+
+#if MOD_FTL_STATIC_PERIOD
+    if (++Mod_FTL_State.count >= MOD_FTL_STATIC_PERIOD)
+    {
+        Mod_FTL_State.count = 0;
+        Mod_FTL_Move();
+    }
+#endif
+    // 预先擦除的扇区用完时才在写入后擦除, 否则 FLASH 忙碌, 下一次写入要等待; 其余由 Mod_FTL_Poll() 补充
+    if (Mod_FTL_State.erased_num == 0)
+    {
+        Mod_FTL_Pre_Erase();
+    }
+    return SUCCESS;
+}
+
+/*
+ * @brief   取消逻辑扇区的映射 (FatFs 的 CTRL_TRIM), 物理扇区变为空闲
+ * @return  SUCCESS; ERROR: 超出范围
+ * @note    需要修改的扇区不超过 MOD_FTL_TRIM_RECORDS 个时逐个写记录, 否则写一次快照 (f_mkfs() 等)
+*/
+ErrorStatus Mod_FTL_Trim(const uint32_t lba, const uint32_t count)
+{
+    uint32_t num = 0;
+
+    if (lba >= Mod_FTL_State.logical || count > Mod_FTL_State.logical - lba)
+    {
+        return ERROR;
+    }
+    for (uint32_t i = lba; i < lba + count; ++i)
+    {
+        num += Mod_FTL_State.map[i] != MOD_FTL_NONE;
+    }
+    if (num == 0)
+    {
+        return SUCCESS;
+    }
+    for (uint32_t i = lba; i < lba + count; ++i)
+    {
+        if (Mod_FTL_State.map[i] == MOD_FTL_NONE)
+        {
+            continue;
+        }
+        if (num <= MOD_FTL_TRIM_RECORDS)
+        {
+            Mod_FTL_Commit(i, MOD_FTL_NONE);
+        }
+        else
+        {
+            Mod_FTL_Clear_Used(Mod_FTL_State.map[i]);
+            Mod_FTL_State.map[i] = MOD_FTL_NONE;
+        }
+    }
+    if (num > MOD_FTL_TRIM_RECORDS)
+    {
+        Mod_FTL_Checkpoint();
+    }
+    Mod_FTL_Stat.trims += num;
+    return SUCCESS;
+}
+
+/*
+ * @brief   读取 FTL 统计
+*/
+void Mod_FTL_Get_Stat(Mod_FTL_Stat_Type *const stat)
+{
+    *stat = Mod_FTL_Stat;
+}
+
+/*
+ * @brief   读取逻辑扇区数, 即 FatFs 卷的大小 (disk_ioctl() 的 GET_SECTOR_COUNT)
+ * @note    Mod_FTL_Init() 之后有效
+*/
+uint32_t Mod_FTL_Get_Logical(void)
+{
+    return Mod_FTL_State.logical;
+}
+
+/*
+ * @brief   补充预先擦除的空闲扇区, 在主循环中调用, 代替 Mod_Flash_Poll()
+ * @note    1) 先 Mod_Flash_Poll(); FLASH 空闲且队列不满时开始擦除一个空闲扇区, 不会阻塞
+ *          2) Mod_FTL_Init() 之前 (例如 MOD_FTL_EN 为 0) 只调用 Mod_Flash_Poll()
+*/
+void Mod_FTL_Poll(void)
+{
+    Mod_Flash_Poll();
+    if (Mod_FTL_State.sectors == 0 || Mod_FTL_State.erased_num >= MOD_FTL_ERASED_NUM || Mod_Flash_Is_Busy())
+    {
+        return;
+    }
+    Mod_FTL_Pre_Erase();
+}
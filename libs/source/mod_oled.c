@@ -2,7 +2,7 @@
 #include "mod_oled.h"
 #include "lib_font.h"
 #include "lib_tool.h"
-#include "lib_usart.h"
+#include "lib_format.h"
 
 static void Mod_Oled_Set_Addr_Mode(const uint8_t mode);
 static Mod_Oled_Pos_Type Mod_Oled_Show_Char(const Mod_Oled_Pos_Type pos, const uint8_t ch);
@@ -178,78 +178,30 @@ void Mod_Oled_Fill_Screen(const uint8_t data)
         Mod_Oled_Send_Data(arr, 129);
 }
 
+// 格式化输出函数, arg 为当前光标坐标
+static void Mod_Oled_Format_Sink(void *const arg, const char *const data, const uint32_t num)
+{
+    Mod_Oled_Pos_Type *const addr = (Mod_Oled_Pos_Type *)arg;
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        *addr = Mod_Oled_Show_Char(*addr, data[i]);
+    }
+}
+
 /*
  * @brief   显示格式化字符串, 字体由 MOD_OLED_CHARS 决定
  * @param   pos 指定的显示坐标
- *          ch  显示的字符
- *          ... --%d: 十进制表示符号32位整型
- *              --%x: 十六进制表示符号32位整型
- *              --%.xf: x 位浮点数
- *              --%s: 字符串
+ *          str 格式字符串, 格式见 lib_format.h
  * @return  成功显示的最后一个字符, 它的坐标的下一个字符位
  */
 Mod_Oled_Pos_Type Mod_Oled_Show_fString(const Mod_Oled_Pos_Type pos, const char *const str, ...)
 {
     Mod_Oled_Pos_Type addr = pos;
-    int arg_int = 0;           // 整型参数
-    double arg_double = 0.0;   // 浮点型
-    char *arg_str = (void *)0; // 字符串
-    uint8_t buffer[20] = {0};  // 缓冲区
+    va_list ap;
 
-    va_list ap;        // 声明ap容纳不定参数
-    va_start(ap, str); // 初始化ap
-
-    for (uint8_t i = 0; str[i] != '\0'; ++i)
-    {
-        // 非格式化字符
-        if (str[i] != '%')
-        {
-            addr = Mod_Oled_Show_Char(addr, str[i]);
-        }
-        else // 格式化字符
-        {
-            ++i;
-            switch (str[i])
-            {
-            // 字符 %
-            case '%':
-                addr = Mod_Oled_Show_Char(addr, '%');
-                continue;
-            // 十进制整型
-            case 'd':
-                arg_int = va_arg(ap, int);
-                Lib_USART_Int2Char_DEC(arg_int, buffer);
-                break;
-            // 十六进制整型
-            case 'x':
-                arg_int = va_arg(ap, int);
-                Lib_USART_Int2Char_HEX(arg_int, buffer);
-                break;
-            // 字符串
-            case 's':
-                arg_str = va_arg(ap, char *);
-                addr = Mod_Oled_Show_String(addr, arg_str);
-                continue;
-            // 浮点数
-            case '.':
-                // %.3f -- 3位小数
-                arg_double = va_arg(ap, double);
-                // 默认打印3位小数
-                Lib_USART_Double2Char(arg_double, buffer, str[i + 1] - '0');
-                i += 2;
-                break;
-            default:
-                // 报错，待实现
-                break;
-            }
-            // 发送buffer数据
-            for (uint8_t j = 0; buffer[j] != '\0'; ++j)
-            {
-                addr = Mod_Oled_Show_Char(addr, buffer[j]);                
-            }
-        }
-    }
-    va_end(ap); // 释放ap
+    va_start(ap, str);
+    Lib_Format_vPrint(Mod_Oled_Format_Sink, &addr, str, ap);
+    va_end(ap);
 
     return addr;
-}
\ No newline at end of file
+}
@@ -0,0 +1,517 @@
+#include "mod_record.h"
+#include "lib_frame.h"
+#include <string.h>
+
+#define MOD_RECORD_MAGIC               0x31434552                    // "REC1"
+#define MOD_RECORD_NONE                0xFFFF                        // 没有预擦除的扇区
+#define MOD_RECORD_LEN_END             0xFFFF                        // 擦除后的长度, 扇区内没有更多记录
+
+#if MOD_RECORD_BUFFER_SIZE < 2 * MOD_FLASH_PAGE_SIZE
+    #error "MOD_RECORD_BUFFER_SIZE must be at least 2 pages"
+#endif
+#if MOD_FLASH_RECORD_SIZE % MOD_FLASH_BLOCK_64K_SIZE != 0 || MOD_RECORD_SECTORS < 2
+    #error "MOD_FLASH_RECORD_SIZE must be a non-zero multiple of 64 KB"
+#endif
+
+// 扇区头部, 打开扇区时与第一条记录一起写入
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;               // 每打开一个扇区加 1, 沿环形连续
+    uint32_t time;              // 第一条记录的时间戳, 按时间查找的索引
+    uint32_t check;             // ~(magic ^ seq ^ time)
+} Mod_Record_Sector_Type;
+
+// 记录头部, 之后是 len 字节的数据; crc 覆盖 len, time 和数据
+typedef struct
+{
+    uint16_t len;
+    uint16_t crc;
+    uint32_t time;
+} Mod_Record_Header_Type;
+
+// Mod_Record_Parse() 的结果
+#define MOD_RECORD_PARSE_OK            0
+#define MOD_RECORD_PARSE_END           1         // 扇区内没有更多记录
+#define MOD_RECORD_PARSE_CORRUPT       2         // 长度或 CRC 错误
+
+typedef struct
+{
+    uint16_t head;                              // 正在追加的扇区
+    uint32_t head_seq;                          // 其序号
+    uint32_t tail_seq;                          // 最旧的扇区的序号, 大于 head_seq 表示没有记录
+    uint16_t offset;                            // 下一条记录在扇区内的位置, 包括缓存中的记录
+    uint16_t prog;                              // 已经编程到的位置, 缓存从这里开始
+    uint16_t ahead;                             // 已经擦除或正在擦除的下一个扇区, MOD_RECORD_NONE 表示没有
+    uint8_t erasing;                            // 预擦除是否还没有完成
+    uint32_t last_time;                         // 最新的记录的时间戳, 见 Mod_Record_Last_Time()
+    uint8_t buffer[MOD_RECORD_BUFFER_SIZE];     // 扇区中 [prog, offset) 的内容
+} Mod_Record_State_Type;
+
+static Mod_Record_State_Type Mod_Record_State;
+static Mod_Record_Stat_Type Mod_Record_Stat;
+
+#define Mod_Record_Addr(sector)        (MOD_RECORD_START + (uint32_t)(sector) * MOD_FLASH_SECTOR_SIZE)
+#define Mod_Record_Next_Sector(sector) ((sector) + 1u < MOD_RECORD_SECTORS ? (sector) + 1u : 0u)
+// 序号对应的扇区, seq 在 tail_seq 和 head_seq 之间
+#define Mod_Record_Sector_Of(seq)      ((uint16_t)((Mod_Record_State.head + MOD_RECORD_SECTORS \
+                                        - (Mod_Record_State.head_seq - (seq)) % MOD_RECORD_SECTORS) % MOD_RECORD_SECTORS))
+
+// 记录的 CRC, 覆盖长度, 时间戳和数据
+static uint16_t Mod_Record_CRC(const Mod_Record_Header_Type *const header, const uint8_t *const data)
+{
+    uint16_t crc = Lib_Frame_CRC16((const uint8_t *)&header->len, sizeof(header->len), 0xFFFF);
+
+    crc = Lib_Frame_CRC16((const uint8_t *)&header->time, sizeof(header->time), crc);
+    return Lib_Frame_CRC16(data, header->len, crc);
+}
+
+// 读取扇区头部, 返回是否有效
+static uint8_t Mod_Record_Read_Sector(const uint16_t sector, Mod_Record_Sector_Type *const header)
+{
+    Mod_Flash_Read((uint8_t *)header, Mod_Record_Addr(sector), sizeof(*header));
+    return header->magic == MOD_RECORD_MAGIC && header->check == ~(header->magic ^ header->seq ^ header->time);
+}
+
+// 读取序号为 seq 的扇区中 offset 开始的 num 字节; 最新扇区中还没有编程的部分从缓存读取
+static void Mod_Record_Read(const uint32_t seq, const uint16_t offset, uint8_t *const pbuffer, const uint16_t num)
+{
+    uint16_t n = num;
+
+    if (seq == Mod_Record_State.head_seq && offset + num > Mod_Record_State.prog)
+    {
+        n = offset < Mod_Record_State.prog ? Mod_Record_State.prog - offset : 0;
+        memcpy(pbuffer + n, Mod_Record_State.buffer + (offset + n - Mod_Record_State.prog), num - n);
+    }
+    if (n > 0)
+    {
+        Mod_Flash_Read(pbuffer, Mod_Record_Addr(Mod_Record_Sector_Of(seq)) + offset, n);
+    }
+}
+
+// 读取并检查扇区 seq 中 offset 处的记录, 记录不能超过 end
+static uint8_t Mod_Record_Parse(const uint32_t seq, const uint16_t offset, const uint16_t end, Mod_Record_Type *const record)
+{
+    Mod_Record_Header_Type header;
+
+    if (offset + MOD_RECORD_HEADER_SIZE > end)
+    {
+        return MOD_RECORD_PARSE_END;
+    }
+    Mod_Record_Read(seq, offset, (uint8_t *)&header, sizeof(header));
+    if (header.len == MOD_RECORD_LEN_END)
+    {
+        return MOD_RECORD_PARSE_END;
+    }
+    if (header.len > MOD_RECORD_DATA_MAXSIZE || offset + MOD_RECORD_HEADER_SIZE + header.len > end)
+    {
+        return MOD_RECORD_PARSE_CORRUPT;
+    }
+    Mod_Record_Read(seq, offset + MOD_RECORD_HEADER_SIZE, record->data, header.len);
+    if (Mod_Record_CRC(&header, record->data) != header.crc)
+    {
+        return MOD_RECORD_PARSE_CORRUPT;
+    }
+    record->time = header.time;
+    record->len = header.len;
+    return MOD_RECORD_PARSE_OK;
+}
+
+// 预擦除是否完成, 不等待
+static void Mod_Record_Check_Erase(void)
+{
+    if (!Mod_Record_State.erasing)
+    {
+        return;
+    }
+    Mod_Flash_Poll();
+    if (!Mod_Flash_Is_Busy())
+    {
+        Mod_Record_State.erasing = 0;
+    }
+}
+
+// 等待预擦除完成
+static void Mod_Record_Wait_Erase(void)
+{
+    Mod_Record_Check_Erase();
+    if (Mod_Record_State.erasing)
+    {
+        ++Mod_Record_Stat.stalls;
+        Mod_Flash_Sync();
+        Mod_Record_State.erasing = 0;
+    }
+}
+
+/*
+ * @brief   编程缓存中的记录
+ * @param   force 0: 只编程到页边界, 擦除中不编程; 1: 全部编程, 擦除中则等待
+*/
+static void Mod_Record_Drain(const uint8_t force)
+{
+    const uint16_t end = force ? Mod_Record_State.offset : Mod_Record_State.offset / MOD_FLASH_PAGE_SIZE * MOD_FLASH_PAGE_SIZE;
+
+    if (end <= Mod_Record_State.prog)
+    {
+        return;
+    }
+    if (force)
+    {
+        Mod_Record_Wait_Erase();
+    }
+    else
+    {
+        Mod_Record_Check_Erase();
+        if (Mod_Record_State.erasing)
+        {
+            return;
+        }
+    }
+    Mod_Flash_Write(Mod_Record_State.buffer, Mod_Record_Addr(Mod_Record_State.head) + Mod_Record_State.prog,
+                    end - Mod_Record_State.prog);
+    Mod_Record_Stat.pages += (end - 1) / MOD_FLASH_PAGE_SIZE - Mod_Record_State.prog / MOD_FLASH_PAGE_SIZE + 1;
+    memmove(Mod_Record_State.buffer, Mod_Record_State.buffer + (end - Mod_Record_State.prog), Mod_Record_State.offset - end);
+    Mod_Record_State.prog = end;
+}
+
+// 在后台擦除正在追加的扇区的下一个; 下一个扇区是最旧的扇区时丢弃它
+static void Mod_Record_Pre_Erase(void)
+{
+    const uint16_t next = Mod_Record_Next_Sector(Mod_Record_State.head);
+
+    if (Mod_Record_State.ahead == next)
+    {
+        return;
+    }
+    if (Mod_Record_State.tail_seq <= Mod_Record_State.head_seq
+        && Mod_Record_State.head_seq - Mod_Record_State.tail_seq + 1 >= MOD_RECORD_SECTORS)
+    {
+        ++Mod_Record_State.tail_seq;
+        ++Mod_Record_Stat.dropped;
+    }
+    Mod_Flash_Erase_Start(Mod_Record_Addr(next));
+    Mod_Record_State.ahead = next;
+    Mod_Record_State.erasing = 1;
+    ++Mod_Record_Stat.erases;
+}
+
+// 当前扇区放不下时打开下一个扇区, 头部的时间戳为第一条记录的时间戳
+static void Mod_Record_Open(const uint32_t time)
+{
+    Mod_Record_Sector_Type header;
+
+    Mod_Record_Drain(1);
+    Mod_Record_Pre_Erase();     // 通常已经擦除完成
+    Mod_Record_Wait_Erase();
+    Mod_Record_State.head = Mod_Record_State.ahead;
+    Mod_Record_State.ahead = MOD_RECORD_NONE;
+    ++Mod_Record_State.head_seq;    // 没有记录时 tail_seq 等于新的 head_seq
+
+    header.magic = MOD_RECORD_MAGIC;
+    header.seq = Mod_Record_State.head_seq;
+    header.time = time;
+    header.check = ~(header.magic ^ header.seq ^ header.time);
+    memcpy(Mod_Record_State.buffer, &header, sizeof(header));
+    Mod_Record_State.prog = 0;
+    Mod_Record_State.offset = sizeof(header);
+    Mod_Record_Pre_Erase();
+}
+
+// 没有记录的状态, 下一条记录打开扇区 0
+static void Mod_Record_Reset(void)
+{
+    Mod_Record_State.head = MOD_RECORD_SECTORS - 1;
+    Mod_Record_State.head_seq = 0;
+    Mod_Record_State.tail_seq = 1;
+    Mod_Record_State.offset = MOD_FLASH_SECTOR_SIZE;
+    Mod_Record_State.prog = MOD_FLASH_SECTOR_SIZE;
+    Mod_Record_State.ahead = MOD_RECORD_NONE;
+    Mod_Record_State.erasing = 0;
+    Mod_Record_State.last_time = 0;
+}
+
+// FLASH 的 num 字节是否全为 0xFF
+static uint8_t Mod_Record_Is_Erased(const uint32_t addr, const uint32_t num)
+{
+    uint8_t data[64];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < num; i += n)
+    {
+        n = num - i < sizeof(data) ? num - i : sizeof(data);
+        Mod_Flash_Read(data, addr + i, n);
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            if (data[j] != 0xFF)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * @brief   上电时找到最新和最旧的扇区, 以及追加的位置
+ * @note    1) 第一个有效的扇区 base 开始, 序号连续的最后一个为最新的扇区; 其后第一个与它序号连续的为最旧的扇区,
+ *             两者都是单调的, 用二分查找, 约 2 * log2(MOD_RECORD_SECTORS) 次读取头部
+ *          2) 最新的扇区中, 最后一条完整记录之后不全为 0xFF (掉电时写了一半) 时不再追加, 下一条记录打开新扇区
+ *          3) 在后台擦除下一个扇区, 上电前可能没有擦除完成
+*/
+void Mod_Record_Init(void)
+{
+    Mod_Record_Sector_Type header;
+    Mod_Record_Type record;
+    uint32_t base_seq = 0, lo = 0, hi = 0, mid = 0;
+    uint16_t base = 0, sector = 0;
+    uint8_t result = 0;
+
+    Mod_Record_Reset();
+    for (base = 0; base < MOD_RECORD_SECTORS; ++base)
+    {
+        if (Mod_Record_Read_Sector(base, &header))
+        {
+            break;
+        }
+    }
+    if (base == MOD_RECORD_SECTORS)
+    {
+        Mod_Record_Pre_Erase();
+        return;
+    }
+
+    // 最新的扇区: base 之后第 lo 个
+    base_seq = header.seq;
+    lo = 0;
+    hi = MOD_RECORD_SECTORS - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        sector = (base + mid) % MOD_RECORD_SECTORS;
+        if (Mod_Record_Read_Sector(sector, &header) && header.seq == base_seq + mid)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    Mod_Record_State.head = (base + lo) % MOD_RECORD_SECTORS;
+    Mod_Record_State.head_seq = base_seq + lo;
+
+    // 最旧的扇区: 最新的扇区之后第 lo 个, 为 MOD_RECORD_SECTORS 时即最新的扇区
+    lo = 1;
+    hi = MOD_RECORD_SECTORS;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        sector = (Mod_Record_State.head + mid) % MOD_RECORD_SECTORS;
+        if (Mod_Record_Read_Sector(sector, &header) && header.seq == Mod_Record_State.head_seq - MOD_RECORD_SECTORS + mid)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    Mod_Record_State.tail_seq = Mod_Record_State.head_seq - MOD_RECORD_SECTORS + lo;
+
+    // 追加的位置, 同时得到最新的记录的时间戳; 扇区头部是其中第一条记录的时间戳
+    Mod_Record_Read_Sector(Mod_Record_State.head, &header);
+    Mod_Record_State.last_time = header.time;
+    Mod_Record_State.offset = sizeof(header);
+    while ((result = Mod_Record_Parse(Mod_Record_State.head_seq, Mod_Record_State.offset, MOD_FLASH_SECTOR_SIZE, &record))
+           == MOD_RECORD_PARSE_OK)
+    {
+        Mod_Record_State.offset += MOD_RECORD_HEADER_SIZE + record.len;
+        Mod_Record_State.last_time = record.time;
+    }
+    if (result == MOD_RECORD_PARSE_CORRUPT
+        || !Mod_Record_Is_Erased(Mod_Record_Addr(Mod_Record_State.head) + Mod_Record_State.offset,
+                                 MOD_FLASH_SECTOR_SIZE - Mod_Record_State.offset))
+    {
+        Mod_Record_State.offset = MOD_FLASH_SECTOR_SIZE;
+    }
+    Mod_Record_State.prog = Mod_Record_State.offset;
+    Mod_Record_Pre_Erase();
+}
+
+/*
+ * @brief   追加一条记录
+ * @param   time 时间戳, 不减
+ *          data, len 数据, len 不大于 MOD_RECORD_DATA_MAXSIZE
+ * @return  SUCCESS; ERROR: 数据太长
+ * @note    通常只复制到缓存; 凑满一页时编程, 擦除中则留在缓存
+*/
+ErrorStatus Mod_Record_Append(const uint32_t time, const void *const data, const uint16_t len)
+{
+    Mod_Record_Header_Type header;
+    const uint16_t size = MOD_RECORD_HEADER_SIZE + len;
+
+    if (len > MOD_RECORD_DATA_MAXSIZE)
+    {
+        return ERROR;
+    }
+    if (Mod_Record_State.offset + size > MOD_FLASH_SECTOR_SIZE)
+    {
+        Mod_Record_Open(time);
+    }
+    // 缓存放不下: 擦除还没有完成, 只能等待
+    if (Mod_Record_State.offset - Mod_Record_State.prog + size > MOD_RECORD_BUFFER_SIZE)
+    {
+        Mod_Record_Wait_Erase();
+        Mod_Record_Drain(0);
+    }
+
+    header.len = len;
+    header.time = time;
+    header.crc = Mod_Record_CRC(&header, data);
+    memcpy(Mod_Record_State.buffer + (Mod_Record_State.offset - Mod_Record_State.prog), &header, sizeof(header));
+    memcpy(Mod_Record_State.buffer + (Mod_Record_State.offset - Mod_Record_State.prog) + sizeof(header), data, len);
+    Mod_Record_State.offset += size;
+    Mod_Record_State.last_time = time;
+    ++Mod_Record_Stat.records;
+    Mod_Record_Stat.bytes += size;
+
+    Mod_Record_Drain(0);
+    return SUCCESS;
+}
+
+/*
+ * @brief   最新的记录的时间戳, 不读取 FLASH; 上电后由 Mod_Record_Init() 扫描最新的扇区得到
+ * @return  SUCCESS; ERROR: 没有记录
+*/
+ErrorStatus Mod_Record_Last_Time(uint32_t *const time)
+{
+    *time = Mod_Record_State.last_time;
+    return Mod_Record_State.tail_seq > Mod_Record_State.head_seq ? ERROR : SUCCESS;
+}
+
+/*
+ * @brief   预擦除完成后编程缓存中完整的页, 在主循环中调用
+*/
+void Mod_Record_Poll(void)
+{
+    Mod_Record_Drain(0);
+}
+
+/*
+ * @brief   编程缓存中全部的记录并等待完成, 例如掉电前
+ * @note    不满一页的部分之后继续追加到同一页, 不浪费空间
+*/
+void Mod_Record_Flush(void)
+{
+    Mod_Record_Drain(1);
+    Mod_Flash_Sync();
+}
+
+/*
+ * @brief   删除全部记录, 擦除整个分区 (块擦除, 约 MOD_FLASH_RECORD_SIZE / 64 KB 次)
+*/
+void Mod_Record_Clear(void)
+{
+    Mod_Record_Reset();
+    Mod_Flash_Erase_Range(MOD_RECORD_START, MOD_FLASH_RECORD_SIZE);
+    Mod_Record_State.ahead = 0;
+}
+
+/*
+ * @brief   迭代器指向最旧的记录
+*/
+void Mod_Record_Begin(Mod_Record_Iter_Type *const iter)
+{
+    iter->seq = Mod_Record_State.tail_seq;
+    iter->offset = sizeof(Mod_Record_Sector_Type);
+}
+
+/*
+ * @brief   迭代器指向第一条时间戳不小于 time 的记录
+ * @note    二分查找扇区头部的时间戳, 再在扇区内顺序查找
+*/
+void Mod_Record_Seek(Mod_Record_Iter_Type *const iter, const uint32_t time)
+{
+    Mod_Record_Sector_Type header;
+    Mod_Record_Type record;
+    Mod_Record_Iter_Type prev;
+    uint32_t lo = Mod_Record_State.tail_seq, hi = Mod_Record_State.head_seq, mid = 0;
+
+    Mod_Record_Begin(iter);
+    if (Mod_Record_State.tail_seq > Mod_Record_State.head_seq)
+    {
+        return;
+    }
+    // 最后一个第一条记录早于 time 的扇区; 时间戳相同的记录可能跨越多个扇区, 从第一个开始
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo + 1) / 2;
+        Mod_Record_Read(mid, 0, (uint8_t *)&header, sizeof(header));
+        if (header.time < time)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    iter->seq = lo;
+    while (1)
+    {
+        prev = *iter;
+        if (Mod_Record_Next(iter, &record) != SUCCESS || record.time >= time)
+        {
+            *iter = prev;
+            return;
+        }
+    }
+}
+
+/*
+ * @brief   读取迭代器指向的记录, 迭代器指向下一条
+ * @return  SUCCESS; ERROR: 没有更多记录 (之后追加的记录仍可以用同一个迭代器读取)
+ * @note    跳过损坏的记录及其所在扇区之后的部分; 迭代器指向的扇区已被覆盖时从最旧的记录继续
+*/
+ErrorStatus Mod_Record_Next(Mod_Record_Iter_Type *const iter, Mod_Record_Type *const record)
+{
+    uint16_t end = 0;
+    uint8_t result = 0;
+
+    while (1)
+    {
+        if (Mod_Record_State.tail_seq > Mod_Record_State.head_seq || (int32_t)(iter->seq - Mod_Record_State.head_seq) > 0)
+        {
+            return ERROR;
+        }
+        if ((int32_t)(iter->seq - Mod_Record_State.tail_seq) < 0)
+        {
+            Mod_Record_Begin(iter);
+        }
+        end = iter->seq == Mod_Record_State.head_seq ? Mod_Record_State.offset : MOD_FLASH_SECTOR_SIZE;
+        result = Mod_Record_Parse(iter->seq, iter->offset, end, record);
+        if (result == MOD_RECORD_PARSE_OK)
+        {
+            iter->offset += MOD_RECORD_HEADER_SIZE + record->len;
+            return SUCCESS;
+        }
+        if (result == MOD_RECORD_PARSE_CORRUPT)
+        {
+            ++Mod_Record_Stat.corrupt;
+        }
+        if (iter->seq == Mod_Record_State.head_seq)
+        {
+            return ERROR;
+        }
+        ++iter->seq;
+        iter->offset = sizeof(Mod_Record_Sector_Type);
+    }
+}
+
+/*
+ * @brief   读取记录存储的统计
+*/
+void Mod_Record_Get_Stat(Mod_Record_Stat_Type *const stat)
+{
+    *stat = Mod_Record_Stat;
+}
@@ -23,9 +23,11 @@
 /* USER CODE BEGIN Includes */
 #include "lib_spi.h"
 #include "mod_flash.h"
+#include "mod_ftl.h"
 #include "lib_usart.h"
 #include "lib_rtc.h"
 #include "ff.h"
+#include "lib_tool.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -35,6 +37,11 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define BENCH_SPI_EN        0     // 是否用 DWT 比较 SPI 读取 FLASH 的速度
+#define BENCH_SPI_SIZE      1024  // 每种方式读取的字节数
+#define BENCH_ERASE_EN      0     // 是否比较逐扇区擦除和 Mod_Flash_Erase_Range() 的时间, 会破坏该范围的数据
+#define BENCH_ERASE_ADDR    (MOD_FLASH_FATFS_SIZE + MOD_FLASH_RECORD_SIZE - MOD_FLASH_BLOCK_64K_SIZE)   // 记录存储的最后一个 64 KB 块, 不破坏配置存储
+#define BENCH_WRITE_EN      0     // 是否比较逐扇区擦除写入和 Mod_Flash_Write_Sectors() 的速度, 会破坏 BENCH_ERASE_ADDR 的 64 KB 块的数据
 
 /* USER CODE END PD */
 
@@ -72,6 +79,144 @@ void check_time(const char* const str)
   Lib_USART_Send_fString("The file is created on %d-%d-%d, %d:%d:%d\n", dt.year, dt.month, dt.day, 
                                                                   dt.hour, dt.minute, dt.second);
 }
+
+#if BENCH_SPI_EN
+static uint8_t bench_buffer[BENCH_SPI_SIZE];
+
+// 发送 READ_DATA 和地址 0, 之后 FLASH 连续输出数据
+static void Bench_SPI_Read_Start(void)
+{
+  Mod_Flash_COM_Start();
+  Mod_Flash_Send_Byte(MOD_FLASH_W25Q64_READ_DATA);
+  Mod_Flash_Send_Byte(0);
+  Mod_Flash_Send_Byte(0);
+  Mod_Flash_Send_Byte(0);
+}
+
+// 输出一种方式的结果: 周期数和速度 (kB/s = 字节数 * (f_AHB / 1000) / 周期数)
+static void Bench_SPI_Report(const char *const name, const uint32_t cycles)
+{
+  Lib_USART_Send_fString("%s: %u cycles, %u kB/s\n", name, cycles,
+                         BENCH_SPI_SIZE * (LIB_TOOL_AHB_FREQUENCY / 1000) / cycles);
+}
+
+/*
+ * @brief   用 DWT 比较 SPI 读取 FLASH 数据阶段的速度, 结果通过 USART 输出
+ * @note    f_SCK = 36 MHz 时理论上限为 4500 kB/s
+*/
+static void Bench_SPI(void)
+{
+  uint32_t start = 0, cycles = 0;
+  ErrorStatus res = SUCCESS;
+
+  Lib_Tool_DWT_Init();
+  Mod_Flash_COM_Init();
+  Lib_USART_Send_fString("SPI read %u bytes:\n", BENCH_SPI_SIZE);
+
+  // 原来的方式: 每个字节等待 TXE 和 RXNE
+  Bench_SPI_Read_Start();
+  start = Lib_Tool_DWT_Timer_Start();
+  for (uint32_t i = 0; i < BENCH_SPI_SIZE; ++i)
+  {
+    bench_buffer[i] = Mod_Flash_Receive_Byte();
+  }
+  cycles = DWT->CYCCNT - start;
+  Mod_Flash_COM_Stop();
+  Bench_SPI_Report("Send_Byte loop", cycles);
+
+  // 发送提前一个字节
+  Bench_SPI_Read_Start();
+  start = Lib_Tool_DWT_Timer_Start();
+  res = Lib_SPI_Burst(MOD_FLASH_SPI, (void *)0, bench_buffer, BENCH_SPI_SIZE);
+  cycles = DWT->CYCCNT - start;
+  Mod_Flash_COM_Stop();
+  Bench_SPI_Report(res == SUCCESS ? "Burst" : "Burst (OVR)", cycles);
+
+  // 16 位帧
+  Bench_SPI_Read_Start();
+  start = Lib_Tool_DWT_Timer_Start();
+  res = Lib_SPI_Burst16(MOD_FLASH_SPI, (void *)0, bench_buffer, BENCH_SPI_SIZE);
+  cycles = DWT->CYCCNT - start;
+  Mod_Flash_COM_Stop();
+  Bench_SPI_Report(res == SUCCESS ? "Burst16" : "Burst16 (OVR)", cycles);
+
+  // DMA (实例不使用 DMA 时与 Burst 相同)
+  Bench_SPI_Read_Start();
+  start = Lib_Tool_DWT_Timer_Start();
+  Lib_SPI_Receive_Data(MOD_FLASH_SPI, bench_buffer, BENCH_SPI_SIZE);
+  cycles = DWT->CYCCNT - start;
+  Mod_Flash_COM_Stop();
+  Bench_SPI_Report("DMA", cycles);
+}
+#endif
+
+#if BENCH_ERASE_EN
+/*
+ * @brief   比较擦除 64 KB 的时间: 16 次扇区擦除, 一次块擦除, 以及不对齐的 36 KB (32 KB + 4 KB)
+ * @note    FLASH 的擦除时间与内容无关, 每种方式之前不需要写入数据
+*/
+static void Bench_Erase(void)
+{
+  uint32_t start = 0;
+
+  Mod_Flash_COM_Init();
+
+  start = Lib_Tool_DWT_Timer_Start();
+  for (uint32_t i = 0; i < MOD_FLASH_BLOCK_64K_SIZE; i += MOD_FLASH_SECTOR_SIZE)
+  {
+    Mod_Flash_Erase_Sector(BENCH_ERASE_ADDR + i);
+  }
+  Lib_USART_Send_fString("Erase 64 KB by sector: %u ms\n", Lib_Tool_DWT_Timer_End(start, 0));
+
+  start = Lib_Tool_DWT_Timer_Start();
+  Mod_Flash_Erase_Range(BENCH_ERASE_ADDR, MOD_FLASH_BLOCK_64K_SIZE);
+  Lib_USART_Send_fString("Erase 64 KB by range: %u ms\n", Lib_Tool_DWT_Timer_End(start, 0));
+
+  start = Lib_Tool_DWT_Timer_Start();
+  Mod_Flash_Erase_Range(BENCH_ERASE_ADDR + MOD_FLASH_BLOCK_32K_SIZE - MOD_FLASH_SECTOR_SIZE,
+                        MOD_FLASH_BLOCK_32K_SIZE + MOD_FLASH_SECTOR_SIZE);
+  Lib_USART_Send_fString("Erase 36 KB by range: %u ms\n", Lib_Tool_DWT_Timer_End(start, 0));
+}
+#endif
+
+#if BENCH_WRITE_EN
+// 输出一种方式的结果: 毫秒数和速度
+static void Bench_Write_Report(const char *const name, const uint32_t ms)
+{
+  Lib_USART_Send_fString("%s: %u ms, %u kB/s\n", name, ms, 64 * 1000 / (ms > 0 ? ms : 1));
+}
+
+/*
+ * @brief   比较写入 64 KB 的时间: 逐扇区擦除后编程, Mod_Flash_Write_Sectors() 写入新数据 (合并为块擦除),
+ *          以及再次写入相同的数据 (只比较和校验)
+ * @note    数据来自 MCU 自己的 FLASH (程序), 不占用 RAM, F103xB 有 128 KB
+*/
+static void Bench_Write(void)
+{
+  const uint8_t *const src = (const uint8_t *)FLASH_BASE;
+  uint32_t start = 0;
+
+  Mod_Flash_COM_Init();
+
+  start = Lib_Tool_DWT_Timer_Start();
+  for (uint32_t i = 0; i < MOD_FLASH_BLOCK_64K_SIZE; i += MOD_FLASH_SECTOR_SIZE)
+  {
+    Mod_Flash_Erase_Sector(BENCH_ERASE_ADDR + i);
+    Mod_Flash_Write(src + i, BENCH_ERASE_ADDR + i, MOD_FLASH_SECTOR_SIZE);
+  }
+  Mod_Flash_Sync();
+  Bench_Write_Report("Erase_Sector + Write", Lib_Tool_DWT_Timer_End(start, 0));
+
+  start = Lib_Tool_DWT_Timer_Start();
+  Mod_Flash_Write_Sectors(src + MOD_FLASH_BLOCK_64K_SIZE, BENCH_ERASE_ADDR, MOD_FLASH_BLOCK_64K_SIZE / MOD_FLASH_SECTOR_SIZE);
+  Mod_Flash_Sync();
+  Bench_Write_Report("Write_Sectors", Lib_Tool_DWT_Timer_End(start, 0));
+
+  start = Lib_Tool_DWT_Timer_Start();
+  Mod_Flash_Write_Sectors(src + MOD_FLASH_BLOCK_64K_SIZE, BENCH_ERASE_ADDR, MOD_FLASH_BLOCK_64K_SIZE / MOD_FLASH_SECTOR_SIZE);
+  Bench_Write_Report("Write_Sectors (same data)", Lib_Tool_DWT_Timer_End(start, 0));
+}
+#endif
 /* USER CODE END 0 */
 
 /**
@@ -122,6 +267,15 @@ int main(void)
   /* USER CODE BEGIN 2 */
   Lib_USART_Init();
   Lib_RTC_Init();
+#if BENCH_SPI_EN
+  Bench_SPI();
+#endif
+#if BENCH_ERASE_EN
+  Bench_Erase();
+#endif
+#if BENCH_WRITE_EN
+  Bench_Write();
+#endif
 
   // 文件系统格式化
   fres = f_mount(&fs, "0:", 1); // 将逻辑驱动器挂载到 FATFS
@@ -206,6 +360,7 @@ int main(void)
   
   while (1)
   {
+    Mod_FTL_Poll(); // 检查后台的擦除或编程是否完成, 空闲时预先擦除 FTL 的空闲扇区
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
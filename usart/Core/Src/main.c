@@ -22,6 +22,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "lib_usart.h"
+#include "lib_tool.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,7 +32,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+#define BENCH_FORMAT_EN     0     // 是否用 DWT 比较格式化函数的周期数
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -53,7 +54,132 @@ void SystemClock_Config(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+#if BENCH_FORMAT_EN
+// 旧版 Lib_USART_Int2Char_DEC: 逐位 %10 和 /10, 最后反转, 作为对比基准
+static void Bench_Int2Char_DEC_Old(const int num, uint8_t * const buffer)
+{
+  uint8_t p = 0, st = 0, tmp_ch = 0;
+  int tmp = num;
+
+  if (num < 0)
+  {
+    tmp = -tmp;
+    st = 1;
+    buffer[p++] = '-';
+  }
+  else if (num == 0)
+  {
+    buffer[0] = '0';
+    buffer[1] = '\0';
+    return;
+  }
+  while (tmp > 0)
+  {
+    buffer[p++] = tmp % 10 + '0';
+    tmp /= 10;
+  }
+  for (uint8_t p1 = st, p2 = p - 1; p1 < p2; ++p1, --p2)
+  {
+    tmp_ch = buffer[p1];
+    buffer[p1] = buffer[p2];
+    buffer[p2] = tmp_ch;
+  }
+  buffer[p] = '\0';
+}
+
+// 旧版 Lib_USART_Double2Char: 每一位小数都做一次 double 乘法和减法 (软件浮点)
+static void Bench_Double2Char_Old(const double num, uint8_t * const buffer, const uint8_t num_frac_bits)
+{
+  uint8_t p = 0;
+  uint32_t int_part = 0;
+  double frac_part = 0;
+
+  if (num < 0.0)
+  {
+    buffer[p++] = '-';
+    int_part = (uint32_t)(-num);
+    frac_part = (-num) - int_part;
+  }
+  else
+  {
+    int_part = (uint32_t)num;
+    frac_part = num - int_part;
+  }
+  Bench_Int2Char_DEC_Old((int)int_part, &buffer[p]);
+  while (buffer[p] != '\0')
+  {
+    ++p;
+  }
+  buffer[p++] = '.';
+  for (uint8_t i = 0; i < num_frac_bits + 1; ++i)
+  {
+    frac_part *= 10;
+    buffer[p++] = (uint8_t)frac_part + '0';
+    frac_part = frac_part - (uint8_t)frac_part;
+  }
+  if (buffer[p - 1] > '4') buffer[p - 2] += 1;
+  buffer[p - 1] = '\0';
+}
 
+/*
+ * @brief   比较新旧格式化函数的周期数, 结果通过 USART 输出
+*/
+static void Bench_Format(void)
+{
+  static const int samples[] = {0, 7, -42, 1234, -98765, 1000000000, 2147483647, -2147483647};
+  volatile uint8_t sink = 0;  // 防止调用被优化掉
+  uint8_t buffer[20] = {0};
+  uint32_t start = 0, cycles_old = 0, cycles_new = 0, sum_old = 0, sum_new = 0;
+
+  Lib_USART_Send_String("Int2Char_DEC cycles (old / new):\n");
+  for (uint8_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+  {
+    start = Lib_Tool_DWT_Timer_Start();
+    Bench_Int2Char_DEC_Old(samples[i], buffer);
+    cycles_old = DWT->CYCCNT - start;
+    sink = buffer[0];
+
+    start = Lib_Tool_DWT_Timer_Start();
+    Lib_USART_Int2Char_DEC(samples[i], buffer);
+    cycles_new = DWT->CYCCNT - start;
+    sink = buffer[0];
+
+    sum_old += cycles_old;
+    sum_new += cycles_new;
+    Lib_USART_Send_fString("%s: %d / %d\n", (const char *)buffer, (int)cycles_old, (int)cycles_new);
+  }
+  Lib_USART_Send_fString("total: %d / %d\n", (int)sum_old, (int)sum_new);
+
+  static const double samples_f[] = {0.0, 3.1415926, -3.1415926, 25.3, 1234.5678};
+  sum_old = 0;
+  sum_new = 0;
+  Lib_USART_Send_String("Double2Char(3) cycles (old / new):\n");
+  for (uint8_t i = 0; i < sizeof(samples_f) / sizeof(samples_f[0]); ++i)
+  {
+    start = Lib_Tool_DWT_Timer_Start();
+    Bench_Double2Char_Old(samples_f[i], buffer, 3);
+    cycles_old = DWT->CYCCNT - start;
+    sink = buffer[0];
+
+    start = Lib_Tool_DWT_Timer_Start();
+    Lib_USART_Double2Char(samples_f[i], buffer, 3);
+    cycles_new = DWT->CYCCNT - start;
+    sink = buffer[0];
+
+    sum_old += cycles_old;
+    sum_new += cycles_new;
+    Lib_USART_Send_fString("%s: %d / %d\n", (const char *)buffer, (int)cycles_old, (int)cycles_new);
+  }
+  Lib_USART_Send_fString("total: %d / %d\n", (int)sum_old, (int)sum_new);
+
+  // 预缩放整数 (DHT11 的 temp * 10) 不需要任何浮点运算
+  start = Lib_Tool_DWT_Timer_Start();
+  Lib_USART_Scaled2Char(-253, buffer, 1);
+  cycles_new = DWT->CYCCNT - start;
+  Lib_USART_Send_fString("Scaled2Char %s: %d\n", (const char *)buffer, (int)cycles_new);
+  (void)sink;
+}
+#endif
 /* USER CODE END 0 */
 
 /**
@@ -102,8 +228,13 @@ int main(void)
 
   Lib_USART_Send_String("This is a test on USART.\n1\n 2\n");
   Lib_USART_Send_fString("This ia a test for format string. %d arguments:\n", 6);
-  Lib_USART_Send_fString("%d; %d; %d; %x; %x; %x\n", 123, -123, 0, 1234, -1234, 0);
+  Lib_USART_Send_fString("%d; %d; %d; 0x%X; 0x%X; 0x%X\n", 123, -123, 0, 1234, -1234, 0);
   Lib_USART_Send_fString("%f; %f; %f; %f; %f\n", 0.0, 3.1415926, -3.1415926, 1.0 / 3, -1.0 / 3);
+  Lib_USART_Send_fString("[%-6s] [%6u] [%08.2f] [%+d] [%c] [%.3s] [%ld%%]\n", "left", 42U, -3.14159, 7, 'A', "truncated", 100L);
+#if BENCH_FORMAT_EN
+  Lib_Tool_DWT_Init();
+  Bench_Format();
+#endif
   /* USER CODE END 2 */
   // LIB_USART_DMA_CH_EN();
   /* Infinite loop */